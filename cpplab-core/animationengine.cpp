@@ -0,0 +1,523 @@
+#include "animationengine.hpp"
+
+namespace cpplab {
+    namespace {
+        using Clock = FrameClock::Clock;
+
+        constexpr uint32_t InvalidIndex = AnimationHandle::InvalidIndex;
+        //start times are moved to a new epoch past this, floats hold milliseconds well below it
+        constexpr double EpochRebaseSeconds = 1024.0;
+        //springs take fixed small steps so stiff ones stay stable, and skip ahead at most this much after a stall
+        constexpr float SpringStepsPerSecond = 240.f;
+        constexpr float MaxSpringFrameSeconds = 0.1f;
+
+        //in AnimProperty order
+        constexpr uint32_t PropertyChannels[AnimPropertyCount] = { 2, 2, 1, 1, 4, 4, 4 };
+        constexpr uint32_t PropertyOffsets[AnimPropertyCount] = { 0, 2, 4, 5, 6, 10, 14 };
+
+        uint32_t PropertyDirtyFlags(AnimProperty property) {
+            switch (property) {
+            case AnimProperty::POSITION:
+            case AnimProperty::DIMENSIONS:
+                return DIRTY_GEOMETRY;
+            case AnimProperty::DEPTH:
+                return DIRTY_DEPTH;
+            default:
+                return DIRTY_PAINT;
+            }
+        }
+
+        bool IsAnimatable(NodeType type, AnimProperty property) {
+            switch (property) {
+            case AnimProperty::BACKGROUND_COLOR:
+            case AnimProperty::TEXT_COLOR:
+                return type == NodeType::TEXT_AREA;
+            case AnimProperty::BORDER_COLOR:
+                return type == NodeType::TEXT_AREA || type == NodeType::IMAGE;
+            default:
+                return true;
+            }
+        }
+
+        //the colour field a colour property maps to, type and property were checked when the animation started
+        Color& AnimatedColor(NodeType type, ElementState& state, AnimProperty property) {
+            if (type == NodeType::IMAGE) return static_cast<ImageElementState&>(state).borderColor;
+            TextElementState& text = static_cast<TextElementState&>(state);
+            if (property == AnimProperty::BACKGROUND_COLOR) return text.backgroundColor;
+            if (property == AnimProperty::BORDER_COLOR) return text.borderColor;
+            return text.textColor;
+        }
+
+        void ReadProperty(NodeType type, const ElementState& state, AnimProperty property, float* out) {
+            switch (property) {
+            case AnimProperty::POSITION:
+                out[0] = state.posX;
+                out[1] = state.posY;
+                break;
+            case AnimProperty::DIMENSIONS:
+                out[0] = state.width;
+                out[1] = state.height;
+                break;
+            case AnimProperty::DEPTH:
+                out[0] = state.depth;
+                break;
+            case AnimProperty::OPACITY:
+                out[0] = state.opacity;
+                break;
+            default: {
+                const Color& color = AnimatedColor(type, const_cast<ElementState&>(state), property);
+                out[0] = color.r;
+                out[1] = color.g;
+                out[2] = color.b;
+                out[3] = color.a;
+                break;
+            }
+            }
+        }
+        void WriteProperties(NodeType type, ElementState& state, const float* values, uint32_t mask) {
+            if (mask & (1u << static_cast<uint32_t>(AnimProperty::POSITION))) {
+                state.posX = values[PropertyOffsets[0]];
+                state.posY = values[PropertyOffsets[0] + 1];
+            }
+            if (mask & (1u << static_cast<uint32_t>(AnimProperty::DIMENSIONS))) {
+                state.width = values[PropertyOffsets[1]];
+                state.height = values[PropertyOffsets[1] + 1];
+            }
+            if (mask & (1u << static_cast<uint32_t>(AnimProperty::DEPTH))) state.depth = values[PropertyOffsets[2]];
+            if (mask & (1u << static_cast<uint32_t>(AnimProperty::OPACITY))) state.opacity = values[PropertyOffsets[3]];
+            for (uint32_t p = static_cast<uint32_t>(AnimProperty::BACKGROUND_COLOR); p < AnimPropertyCount; ++p) {
+                if (!(mask & (1u << p))) continue;
+                const float* v = values + PropertyOffsets[p];
+                AnimatedColor(type, state, static_cast<AnimProperty>(p)) = Color(v[0], v[1], v[2], v[3]);
+            }
+        }
+
+        //one easing per loop so the loop body has no switch in it
+        void Ease(Easing easing, const float* progress, float* out, size_t count) {
+            switch (easing) {
+            case Easing::LINEAR:
+                for (size_t i = 0; i < count; ++i) out[i] = progress[i];
+                break;
+            case Easing::EASE_IN:
+                for (size_t i = 0; i < count; ++i) out[i] = progress[i] * progress[i] * progress[i];
+                break;
+            case Easing::EASE_OUT:
+                for (size_t i = 0; i < count; ++i) {
+                    const float inv = 1.f - progress[i];
+                    out[i] = 1.f - inv * inv * inv;
+                }
+                break;
+            case Easing::EASE_IN_OUT:
+                for (size_t i = 0; i < count; ++i) {
+                    const float t = progress[i];
+                    const float inv = 2.f - 2.f * t;
+                    out[i] = t < 0.5f ? 4.f * t * t * t : 1.f - 0.5f * inv * inv * inv;
+                }
+                break;
+            }
+        }
+
+        uint64_t MicrosecondsBetween(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+        }
+    }
+
+    //swap with the last, order within a batch does not matter
+    void AnimationEngine::TweenBatch::Remove(size_t i) {
+        const size_t last = this->Size() - 1;
+        this->from[i] = this->from[last];
+        this->delta[i] = this->delta[last];
+        this->start[i] = this->start[last];
+        this->inverseDuration[i] = this->inverseDuration[last];
+        this->valueIndex[i] = this->valueIndex[last];
+        this->animation[i] = this->animation[last];
+        this->from.pop_back();
+        this->delta.pop_back();
+        this->start.pop_back();
+        this->inverseDuration.pop_back();
+        this->valueIndex.pop_back();
+        this->animation.pop_back();
+    }
+    void AnimationEngine::SpringBatch::Remove(size_t i) {
+        const size_t last = this->Size() - 1;
+        this->value[i] = this->value[last];
+        this->velocity[i] = this->velocity[last];
+        this->target[i] = this->target[last];
+        this->stiffness[i] = this->stiffness[last];
+        this->damping[i] = this->damping[last];
+        this->inverseMass[i] = this->inverseMass[last];
+        this->restDistance[i] = this->restDistance[last];
+        this->valueIndex[i] = this->valueIndex[last];
+        this->animation[i] = this->animation[last];
+        this->value.pop_back();
+        this->velocity.pop_back();
+        this->target.pop_back();
+        this->stiffness.pop_back();
+        this->damping.pop_back();
+        this->inverseMass.pop_back();
+        this->restDistance.pop_back();
+        this->valueIndex.pop_back();
+        this->animation.pop_back();
+    }
+
+    AnimationEngine::AnimationEngine(FrameScheduler* frameScheduler) {
+        this->frameScheduler = frameScheduler;
+    }
+
+    float AnimationEngine::SecondsSinceEpoch(Clock::time_point time) {
+        if (!this->epochSet) {
+            this->epoch = time;
+            this->epochSet = true;
+        }
+        double seconds = std::chrono::duration<double>(time - this->epoch).count();
+        if (seconds > EpochRebaseSeconds) {
+            this->RebaseEpoch(time);
+            seconds = 0.0;
+        }
+        return static_cast<float>(seconds);
+    }
+    void AnimationEngine::RebaseEpoch(Clock::time_point time) {
+        const float shift = static_cast<float>(std::chrono::duration<double>(time - this->epoch).count());
+        for (TweenBatch& batch : this->tweens) {
+            for (float& start : batch.start) start -= shift;
+        }
+        this->epoch = time;
+    }
+
+    uint32_t AnimationEngine::AcquireRecord(ElementNode* element) {
+        const ElementHandle handle = element->getHandle();
+        if (handle.index >= this->recordByElement.size()) this->recordByElement.resize(handle.index + 1, InvalidIndex);
+
+        const uint32_t existing = this->recordByElement[handle.index];
+        if (existing != InvalidIndex) {
+            if (this->records[existing].element == handle) return existing;
+            //the element was deleted before its animations noticed and the slot went to a new one
+            for (uint32_t slot : this->records[existing].animations) {
+                if (slot != InvalidIndex) this->CancelSlot(slot);
+            }
+            this->records[existing].finishedMask = 0;
+            this->ReleaseRecordIfIdle(existing);
+        }
+
+        uint32_t record;
+        if (!this->freeRecords.empty()) {
+            record = this->freeRecords.back();
+            this->freeRecords.pop_back();
+        }
+        else {
+            record = static_cast<uint32_t>(this->records.size());
+            this->records.emplace_back();
+            this->elementValues.resize(this->elementValues.size() + ValuesPerElement, 0.f);
+        }
+        ElementRecord& entry = this->records[record];
+        entry.element = handle;
+        entry.type = element->getNodeType();
+        std::fill(std::begin(entry.animations), std::end(entry.animations), InvalidIndex);
+        entry.activeCount = 0;
+        entry.animatedMask = 0;
+        entry.finishedMask = 0;
+        entry.live = true;
+        this->recordByElement[handle.index] = record;
+        return record;
+    }
+    void AnimationEngine::ReleaseRecordIfIdle(uint32_t record) {
+        ElementRecord& entry = this->records[record];
+        if (!entry.live || entry.activeCount > 0 || entry.finishedMask != 0) return;
+        entry.live = false;
+        if (this->recordByElement[entry.element.index] == record) this->recordByElement[entry.element.index] = InvalidIndex;
+        this->freeRecords.push_back(record);
+    }
+
+    AnimationHandle AnimationEngine::AcquireSlot(uint32_t record, AnimProperty property, uint32_t channels) {
+        ElementRecord& entry = this->records[record];
+        const uint32_t previous = entry.animations[static_cast<size_t>(property)];
+        if (previous != InvalidIndex) this->CancelSlot(previous);
+
+        uint32_t slot;
+        if (!this->freeSlots.empty()) {
+            slot = this->freeSlots.back();
+            this->freeSlots.pop_back();
+        }
+        else {
+            slot = static_cast<uint32_t>(this->slots.size());
+            this->slots.emplace_back();
+        }
+        AnimationSlot& animation = this->slots[slot];
+        animation.record = record;
+        animation.liveChannels = channels;
+        animation.property = property;
+        animation.live = true;
+        animation.cancelled = false;
+
+        entry.animations[static_cast<size_t>(property)] = slot;
+        entry.animatedMask |= 1u << static_cast<uint32_t>(property);
+        ++entry.activeCount;
+        ++this->activeAnimations;
+        ++this->stats.animationsStarted;
+        this->frameScheduler->RequestFrame();
+        return AnimationHandle{ slot, animation.generation };
+    }
+    void AnimationEngine::CancelSlot(uint32_t slot) {
+        AnimationSlot& animation = this->slots[slot];
+        if (!animation.live || animation.cancelled) return;
+        animation.cancelled = true;
+        ++this->cancelledSlots;
+
+        ElementRecord& entry = this->records[animation.record];
+        entry.animations[static_cast<size_t>(animation.property)] = InvalidIndex;
+        entry.animatedMask &= ~(1u << static_cast<uint32_t>(animation.property));
+        --entry.activeCount;
+        --this->activeAnimations;
+    }
+    void AnimationEngine::FinishChannel(uint32_t slot) {
+        AnimationSlot& animation = this->slots[slot];
+        if (--animation.liveChannels > 0) return;
+
+        ElementRecord& entry = this->records[animation.record];
+        const uint32_t bit = 1u << static_cast<uint32_t>(animation.property);
+        entry.animations[static_cast<size_t>(animation.property)] = InvalidIndex;
+        entry.animatedMask &= ~bit;
+        entry.finishedMask |= bit;
+        --entry.activeCount;
+        --this->activeAnimations;
+        ++this->stats.animationsFinished;
+
+        animation.live = false;
+        ++animation.generation;
+        this->freeSlots.push_back(slot);
+        //the record goes once its last values were written back
+    }
+
+    AnimationHandle AnimationEngine::Tween(ElementNode* element, AnimProperty property, AnimValue to, Clock::duration duration, Easing easing) {
+        const NodeType type = element->getNodeType();
+        if (!IsAnimatable(type, property)) {
+            throw std::runtime_error("[Cpplab Animation] Property can not be animated on this element type");
+        }
+        const uint32_t record = this->AcquireRecord(element);
+        const uint32_t channels = PropertyChannels[static_cast<size_t>(property)];
+        const AnimationHandle handle = this->AcquireSlot(record, property, channels);
+
+        float current[4];
+        ReadProperty(type, *element->loadState<ElementState>(), property, current);
+        const double seconds = std::chrono::duration<double>(duration).count();
+        const float inverseDuration = seconds > 0.0 ? static_cast<float>(1.0 / seconds) : (std::numeric_limits<float>::max)();
+        const float start = this->SecondsSinceEpoch(this->frameScheduler->Now());
+
+        TweenBatch& batch = this->tweens[static_cast<size_t>(easing)];
+        const uint32_t base = record * ValuesPerElement + PropertyOffsets[static_cast<size_t>(property)];
+        for (uint32_t c = 0; c < channels; ++c) {
+            batch.from.push_back(current[c]);
+            batch.delta.push_back(to.v[c] - current[c]);
+            batch.start.push_back(start);
+            batch.inverseDuration.push_back(inverseDuration);
+            batch.valueIndex.push_back(base + c);
+            batch.animation.push_back(handle.index);
+            this->elementValues[base + c] = current[c];
+        }
+        return handle;
+    }
+    AnimationHandle AnimationEngine::Spring(ElementNode* element, AnimProperty property, AnimValue target, const SpringConfig& config) {
+        const NodeType type = element->getNodeType();
+        if (!IsAnimatable(type, property)) {
+            throw std::runtime_error("[Cpplab Animation] Property can not be animated on this element type");
+        }
+        if (!(config.mass > 0.f)) {
+            throw std::runtime_error("[Cpplab Animation] Spring mass must be positive");
+        }
+        const uint32_t record = this->AcquireRecord(element);
+        const uint32_t channels = PropertyChannels[static_cast<size_t>(property)];
+        const AnimationHandle handle = this->AcquireSlot(record, property, channels);
+
+        float current[4];
+        ReadProperty(type, *element->loadState<ElementState>(), property, current);
+        //the first frame after a quiet spell steps one refresh interval instead of the whole gap
+        if (this->springs.Size() == 0) this->lastFrameSet = false;
+
+        const uint32_t base = record * ValuesPerElement + PropertyOffsets[static_cast<size_t>(property)];
+        for (uint32_t c = 0; c < channels; ++c) {
+            this->springs.value.push_back(current[c]);
+            this->springs.velocity.push_back(0.f);
+            this->springs.target.push_back(target.v[c]);
+            this->springs.stiffness.push_back(config.stiffness);
+            this->springs.damping.push_back(config.damping);
+            this->springs.inverseMass.push_back(1.f / config.mass);
+            this->springs.restDistance.push_back(config.restDistance);
+            this->springs.valueIndex.push_back(base + c);
+            this->springs.animation.push_back(handle.index);
+            this->elementValues[base + c] = current[c];
+        }
+        return handle;
+    }
+
+    void AnimationEngine::Cancel(AnimationHandle animation) {
+        if (!this->IsActive(animation)) return;
+        const uint32_t record = this->slots[animation.index].record;
+        this->CancelSlot(animation.index);
+        this->ReleaseRecordIfIdle(record);
+    }
+    void AnimationEngine::CancelElement(ElementNode* element) {
+        const ElementHandle handle = element->getHandle();
+        if (handle.index >= this->recordByElement.size()) return;
+        const uint32_t record = this->recordByElement[handle.index];
+        if (record == InvalidIndex || this->records[record].element != handle) return;
+        for (uint32_t slot : this->records[record].animations) {
+            if (slot != InvalidIndex) this->CancelSlot(slot);
+        }
+        this->ReleaseRecordIfIdle(record);
+    }
+    bool AnimationEngine::IsActive(AnimationHandle animation) const {
+        if (!animation.IsValid() || animation.index >= this->slots.size()) return false;
+        const AnimationSlot& slot = this->slots[animation.index];
+        return slot.live && !slot.cancelled && slot.generation == animation.generation;
+    }
+
+    void AnimationEngine::DropCancelledChannels() {
+        if (this->cancelledSlots == 0) return;
+        for (TweenBatch& batch : this->tweens) {
+            for (size_t i = batch.Size(); i-- > 0;) {
+                if (this->slots[batch.animation[i]].cancelled) batch.Remove(i);
+            }
+        }
+        for (size_t i = this->springs.Size(); i-- > 0;) {
+            if (this->slots[this->springs.animation[i]].cancelled) this->springs.Remove(i);
+        }
+        for (uint32_t slot = 0; slot < this->slots.size(); ++slot) {
+            AnimationSlot& animation = this->slots[slot];
+            if (!animation.cancelled) continue;
+            animation.cancelled = false;
+            animation.live = false;
+            ++animation.generation;
+            this->freeSlots.push_back(slot);
+        }
+        this->cancelledSlots = 0;
+    }
+
+    void AnimationEngine::EvaluateTweens(float now) {
+        float* values = this->elementValues.data();
+        for (size_t e = 0; e < EasingCount; ++e) {
+            TweenBatch& batch = this->tweens[e];
+            const size_t count = batch.Size();
+            if (count == 0) continue;
+            batch.progress.resize(count);
+            batch.eased.resize(count);
+
+            const float* start = batch.start.data();
+            const float* inverseDuration = batch.inverseDuration.data();
+            float* progress = batch.progress.data();
+            for (size_t i = 0; i < count; ++i) {
+                const float t = (now - start[i]) * inverseDuration[i];
+                progress[i] = t < 0.f ? 0.f : (t > 1.f ? 1.f : t);
+            }
+            float* eased = batch.eased.data();
+            Ease(static_cast<Easing>(e), progress, eased, count);
+            const float* from = batch.from.data();
+            const float* delta = batch.delta.data();
+            const uint32_t* valueIndex = batch.valueIndex.data();
+            for (size_t i = 0; i < count; ++i) values[valueIndex[i]] = from[i] + delta[i] * eased[i];
+            //backwards, so the channel swapped into a removed one was already checked
+            for (size_t i = count; i-- > 0;) {
+                if (progress[i] < 1.f) continue;
+                this->FinishChannel(batch.animation[i]);
+                batch.Remove(i);
+            }
+        }
+    }
+    void AnimationEngine::EvaluateSprings(float seconds) {
+        const size_t count = this->springs.Size();
+        if (count == 0 || seconds <= 0.f) return;
+
+        const int steps = (std::max)(1, static_cast<int>(std::ceil(seconds * SpringStepsPerSecond)));
+        const float step = seconds / static_cast<float>(steps);
+        float* value = this->springs.value.data();
+        float* velocity = this->springs.velocity.data();
+        const float* target = this->springs.target.data();
+        const float* stiffness = this->springs.stiffness.data();
+        const float* damping = this->springs.damping.data();
+        const float* inverseMass = this->springs.inverseMass.data();
+        //semi implicit euler, the velocity is updated first and moves the value in the same step
+        for (int s = 0; s < steps; ++s) {
+            for (size_t i = 0; i < count; ++i) {
+                const float acceleration = (stiffness[i] * (target[i] - value[i]) - damping[i] * velocity[i]) * inverseMass[i];
+                velocity[i] += acceleration * step;
+                value[i] += velocity[i] * step;
+            }
+        }
+
+        float* values = this->elementValues.data();
+        const float* restDistance = this->springs.restDistance.data();
+        for (size_t i = count; i-- > 0;) {
+            const bool resting = std::fabs(target[i] - value[i]) < restDistance[i] && std::fabs(velocity[i]) < restDistance[i];
+            values[this->springs.valueIndex[i]] = resting ? target[i] : value[i];
+            if (!resting) continue;
+            this->FinishChannel(this->springs.animation[i]);
+            this->springs.Remove(i);
+        }
+    }
+
+    void AnimationEngine::WriteBack() {
+        ElementStore& store = ElementStore::Instance();
+        size_t written = 0;
+        for (uint32_t record = 0; record < this->records.size(); ++record) {
+            ElementRecord& entry = this->records[record];
+            const uint32_t mask = entry.animatedMask | entry.finishedMask;
+            if (!entry.live || mask == 0) continue;
+            entry.finishedMask = 0;
+
+            ElementNode* element = store.Resolve(entry.element);
+            if (element == nullptr) {
+                //deleted while animated
+                for (uint32_t slot : entry.animations) {
+                    if (slot != InvalidIndex) this->CancelSlot(slot);
+                }
+            }
+            else {
+                uint32_t dirtyFlags = DIRTY_NONE;
+                for (uint32_t p = 0; p < AnimPropertyCount; ++p) {
+                    if (mask & (1u << p)) dirtyFlags |= PropertyDirtyFlags(static_cast<AnimProperty>(p));
+                }
+                const NodeType type = entry.type;
+                const float* values = &this->elementValues[static_cast<size_t>(record) * ValuesPerElement];
+                element->updateState<ElementState>(dirtyFlags, [type, values, mask](ElementState& state) {
+                    WriteProperties(type, state, values, mask);
+                });
+                ++written;
+            }
+            this->ReleaseRecordIfIdle(record);
+        }
+        this->stats.lastElementsWritten = written;
+    }
+
+    void AnimationEngine::RunFrame() {
+        if (this->activeAnimations == 0 && this->cancelledSlots == 0) return;
+        const auto started = std::chrono::steady_clock::now();
+
+        const FrameInfo& frame = this->frameScheduler->GetCurrentFrame();
+        float springSeconds = std::chrono::duration<float>(this->frameScheduler->GetRefreshInterval()).count();
+        if (this->lastFrameSet) {
+            springSeconds = std::chrono::duration<float>(frame.frameTime - this->lastFrameTime).count();
+        }
+        springSeconds = (std::min)((std::max)(springSeconds, 0.f), MaxSpringFrameSeconds);
+        this->lastFrameTime = frame.frameTime;
+        this->lastFrameSet = true;
+
+        this->DropCancelledChannels();
+        this->EvaluateTweens(this->SecondsSinceEpoch(frame.frameTime));
+        this->EvaluateSprings(springSeconds);
+        this->WriteBack();
+        if (this->activeAnimations > 0) this->frameScheduler->RequestFrame();
+
+        ++this->stats.framesEvaluated;
+        const uint64_t elapsed = MicrosecondsBetween(started, std::chrono::steady_clock::now());
+        this->stats.lastEvaluateMicroseconds = elapsed;
+        this->stats.maxEvaluateMicroseconds = (std::max)(this->stats.maxEvaluateMicroseconds, elapsed);
+    }
+
+    AnimationStats AnimationEngine::GetStats() const {
+        AnimationStats result = this->stats;
+        result.activeAnimations = this->activeAnimations;
+        size_t channels = this->springs.Size();
+        for (const TweenBatch& batch : this->tweens) channels += batch.Size();
+        result.activeChannels = channels;
+        return result;
+    }
+}
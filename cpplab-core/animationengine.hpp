@@ -0,0 +1,215 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "framescheduler.hpp"
+#include "engineelements.hpp"
+
+namespace cpplab {
+    enum class AnimProperty : uint8_t {
+        POSITION, DIMENSIONS, DEPTH, OPACITY,
+        //text elements only
+        BACKGROUND_COLOR,
+        //text and image elements
+        BORDER_COLOR,
+        //text elements only
+        TEXT_COLOR
+    };
+    constexpr size_t AnimPropertyCount = 7;
+
+    //cubic curves, the easing is picked per animation and decides which batch it is evaluated in
+    enum class Easing : uint8_t {
+        LINEAR, EASE_IN, EASE_OUT, EASE_IN_OUT
+    };
+    constexpr size_t EasingCount = 4;
+
+    //up to four floats, one per channel of the property animated
+    struct AnimValue {
+        float v[4] = { 0.f, 0.f, 0.f, 0.f };
+
+        AnimValue() {}
+        AnimValue(float value) {
+            this->v[0] = value;
+        }
+        AnimValue(vec2 value) {
+            this->v[0] = value.x;
+            this->v[1] = value.y;
+        }
+        AnimValue(Color value) {
+            this->v[0] = value.r;
+            this->v[1] = value.g;
+            this->v[2] = value.b;
+            this->v[3] = value.a;
+        }
+        vec2 AsVec2() const {
+            return vec2(this->v[0], this->v[1]);
+        }
+        Color AsColor() const {
+            return Color(this->v[0], this->v[1], this->v[2], this->v[3]);
+        }
+    };
+
+    //a damped spring, defaults settle in about half a second without overshooting much
+    struct SpringConfig {
+        float stiffness = 170.f;
+        float damping = 26.f;
+        float mass = 1.f;
+        //the spring stops once every channel is this close to the target and slower than this per second
+        float restDistance = 0.01f;
+    };
+
+    struct AnimationHandle {
+        static constexpr uint32_t InvalidIndex = 0xffffffffu;
+        uint32_t index = InvalidIndex;
+        uint32_t generation = 0;
+
+        bool IsValid() const {
+            return this->index != InvalidIndex;
+        }
+    };
+
+    struct AnimationStats {
+        size_t activeAnimations = 0;
+        //floats evaluated per frame, a colour animation is four
+        size_t activeChannels = 0;
+        uint64_t animationsStarted = 0;
+        uint64_t animationsFinished = 0;
+        uint64_t framesEvaluated = 0;
+        //elements written back by the last frame, one state swap each however many of their properties move
+        size_t lastElementsWritten = 0;
+        uint64_t lastEvaluateMicroseconds = 0;
+        uint64_t maxEvaluateMicroseconds = 0;
+    };
+
+    //tweens and springs on element properties, evaluated once per frame in batches
+    //every channel of every running animation lives in flat arrays, one set per easing and one for springs
+    //so a frame is a few straight loops over floats the compiler can vectorize, followed by one state swap per element moved
+    //the write back walks the element records in order, not the channels, so no loop marks what it touched
+    //starting an animation on a property that already runs one replaces it, the new one starts from the current value
+    //ui thread only, elements must stay alive while animated or be deleted on the ui thread, which ends their animations
+    class AnimationEngine {
+    private:
+        //floats kept per animated element, in AnimProperty order: position 2, dimensions 2, depth, opacity, three colours of 4
+        static constexpr size_t ValuesPerElement = 18;
+
+        struct TweenBatch {
+            std::vector<float> from;
+            std::vector<float> delta;
+            //seconds since the engine epoch
+            std::vector<float> start;
+            std::vector<float> inverseDuration;
+            //index into elementValues
+            std::vector<uint32_t> valueIndex;
+            std::vector<uint32_t> animation;
+            //scratch, linear progress then eased
+            std::vector<float> progress;
+            std::vector<float> eased;
+
+            size_t Size() const {
+                return this->from.size();
+            }
+            void Remove(size_t i);
+        };
+        struct SpringBatch {
+            std::vector<float> value;
+            std::vector<float> velocity;
+            std::vector<float> target;
+            std::vector<float> stiffness;
+            std::vector<float> damping;
+            std::vector<float> inverseMass;
+            std::vector<float> restDistance;
+            std::vector<uint32_t> valueIndex;
+            std::vector<uint32_t> animation;
+
+            size_t Size() const {
+                return this->value.size();
+            }
+            void Remove(size_t i);
+        };
+        struct AnimationSlot {
+            uint32_t generation = 0;
+            uint32_t record = AnimationHandle::InvalidIndex;
+            //channels still running, the animation finishes when the last one does
+            uint32_t liveChannels = 0;
+            AnimProperty property = AnimProperty::POSITION;
+            bool live = false;
+            //cancelled or replaced, its channels are dropped at the start of the next frame
+            bool cancelled = false;
+        };
+        //one per animated element
+        struct ElementRecord {
+            ElementHandle element;
+            NodeType type = NodeType::BASE_ELEMENT;
+            uint32_t animations[AnimPropertyCount];
+            uint32_t activeCount = 0;
+            //bit per AnimProperty, running ones are written every frame
+            uint32_t animatedMask = 0;
+            //finished this frame, their last value is still to be written
+            uint32_t finishedMask = 0;
+            bool live = false;
+        };
+
+        FrameScheduler* frameScheduler;
+        //start times are floats relative to this so they keep their precision, moved forward now and then
+        FrameClock::Clock::time_point epoch;
+        bool epochSet = false;
+        FrameClock::Clock::time_point lastFrameTime;
+        bool lastFrameSet = false;
+
+        TweenBatch tweens[EasingCount];
+        SpringBatch springs;
+
+        std::vector<AnimationSlot> slots;
+        std::vector<uint32_t> freeSlots;
+        std::vector<ElementRecord> records;
+        std::vector<uint32_t> freeRecords;
+        std::vector<float> elementValues;
+        //element store index to record, grown on demand
+        std::vector<uint32_t> recordByElement;
+        size_t cancelledSlots = 0;
+        size_t activeAnimations = 0;
+
+        AnimationStats stats;
+
+        float SecondsSinceEpoch(FrameClock::Clock::time_point time);
+        void RebaseEpoch(FrameClock::Clock::time_point time);
+        uint32_t AcquireRecord(ElementNode* element);
+        void ReleaseRecordIfIdle(uint32_t record);
+        AnimationHandle AcquireSlot(uint32_t record, AnimProperty property, uint32_t channels);
+        void CancelSlot(uint32_t slot);
+        void FinishChannel(uint32_t slot);
+        void DropCancelledChannels();
+        void EvaluateTweens(float now);
+        void EvaluateSprings(float seconds);
+        void WriteBack();
+
+    public:
+        AnimationEngine(FrameScheduler* frameScheduler);
+        AnimationEngine(const AnimationEngine&) = delete;
+        AnimationEngine& operator=(const AnimationEngine&) = delete;
+
+        //moves the property from its current value to the target over the duration, starting now
+        AnimationHandle Tween(ElementNode* element, AnimProperty property, AnimValue to, FrameClock::Clock::duration duration, Easing easing = Easing::EASE_IN_OUT);
+        //pulls the property towards the target until it rests there
+        AnimationHandle Spring(ElementNode* element, AnimProperty property, AnimValue target, const SpringConfig& config = SpringConfig());
+        //stops the animation where it is, a finished or replaced handle is ignored
+        void Cancel(AnimationHandle animation);
+        //stops every animation on the element
+        void CancelElement(ElementNode* element);
+        bool IsActive(AnimationHandle animation) const;
+
+        //ui thread, once per frame after the tasks and coroutines ran, before the tree is collected
+        //evaluates every animation at the frame time and writes each moved element back in one state swap
+        //asks the frame scheduler for another frame while anything is still running
+        void RunFrame();
+        bool HasAnimations() const {
+            return this->activeAnimations > 0;
+        }
+        AnimationStats GetStats() const;
+    };
+}
@@ -0,0 +1,235 @@
+#include "d2drenderdevice.hpp"
+#include "windowrenderer.hpp"
+
+namespace cpplab {
+    static D2D1_COLOR_F ToD2D1Color(Color cpplabColor) {
+        D2D1_COLOR_F tempColor = { };
+        tempColor.r = cpplabColor.r;
+        tempColor.g = cpplabColor.g;
+        tempColor.b = cpplabColor.b;
+        tempColor.a = cpplabColor.a;
+        return tempColor;
+    }
+    static D2D1_RECT_F ToD2D1Rect(const RectF& rect) {
+        return D2D1::RectF(rect.left, rect.top, rect.right, rect.bottom);
+    }
+
+    D2DBitmap::~D2DBitmap() {
+        SafeRelease(&this->bitmap);
+    }
+    vec2 D2DBitmap::GetSize() const {
+        const D2D1_SIZE_F size = this->bitmap->GetSize();
+        return vec2(size.width, size.height);
+    }
+    D2DTextFormat::~D2DTextFormat() {
+        SafeRelease(&this->textFormat);
+    }
+
+    D2DRenderDevice::D2DRenderDevice(HWND windowHandle) {
+        this->windowHandle = windowHandle;
+        this->d2dFactory = NULL;
+        this->renderTarget = NULL;
+        this->solidColorBrush = NULL;
+        this->dwriteFactory = NULL;
+
+        //d2d factory
+        HRESULT hr = D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, &this->d2dFactory);
+        if (FAILED(hr)) {
+            throw std::runtime_error("[Cpplab Renderer] During D2D Initialization: Failure creating D2D Factory!");
+        }
+
+        //dwrite factory
+        hr = DWriteCreateFactory(DWRITE_FACTORY_TYPE_SHARED,
+            __uuidof(IDWriteFactory),
+            reinterpret_cast<IUnknown**>(&dwriteFactory));
+        if (FAILED(hr)) {
+            throw std::runtime_error("[Cpplab Renderer] During D2D Initialization: Failure creating DWrite Factory!");
+        }
+
+        this->BuildTargetResources();
+    }
+    D2DRenderDevice::~D2DRenderDevice() {
+        this->FreeTargetResources();
+        SafeRelease(&this->dwriteFactory);
+        SafeRelease(&this->d2dFactory);
+    }
+
+    void D2DRenderDevice::BuildTargetResources() {
+        //d2d render target
+        RECT rc;
+        GetClientRect(windowHandle, &rc);
+
+        D2D1_SIZE_U size = D2D1::SizeU(
+            static_cast<UINT32>(rc.right), static_cast<UINT32>(rc.bottom)
+        );
+
+        HRESULT hr = this->d2dFactory->CreateHwndRenderTarget(
+            D2D1::RenderTargetProperties(),
+            D2D1::HwndRenderTargetProperties(windowHandle, size),
+            &this->renderTarget
+        );
+        if (FAILED(hr)) {
+            throw std::runtime_error("[Cpplab Renderer] During D2D Initialization: Failure creating Render Target!");
+        }
+
+        //d2d brush
+        //any color will do, we just change later when needed
+        const D2D1_COLOR_F color = D2D1::ColorF(0.0f, 0.0f, 0.0f);
+        hr = this->renderTarget->CreateSolidColorBrush(color, &this->solidColorBrush);
+        if (FAILED(hr)) {
+            this->FreeTargetResources();
+            throw std::runtime_error("[Cpplab Renderer] During D2D Initialization: Failure creating color brush!");
+        }
+    }
+    void D2DRenderDevice::FreeTargetResources() {
+        SafeRelease(&this->solidColorBrush);
+        SafeRelease(&this->renderTarget);
+    }
+    void D2DRenderDevice::RecreateTarget() {
+        this->FreeTargetResources();
+        this->BuildTargetResources();
+    }
+
+    void D2DRenderDevice::BeginFrame() {
+        this->renderTarget->BeginDraw();
+        this->renderTarget->SetTransform(D2D1::Matrix3x2F::Identity());
+    }
+    bool D2DRenderDevice::EndFrame() {
+        HRESULT hr = this->renderTarget->EndDraw();
+        if (FAILED(hr) || hr == D2DERR_RECREATE_TARGET) {
+            this->RecreateTarget();
+            return false;
+        }
+        return true;
+    }
+    vec2 D2DRenderDevice::GetSize() const {
+        const D2D1_SIZE_F size = this->renderTarget->GetSize();
+        return vec2(size.width, size.height);
+    }
+
+    void D2DRenderDevice::Clear(const Color& color) {
+        this->renderTarget->Clear(ToD2D1Color(color));
+    }
+    void D2DRenderDevice::SetTransform(const Transform2D& transform) {
+        this->renderTarget->SetTransform(D2D1::Matrix3x2F(
+            transform.m11, transform.m12,
+            transform.m21, transform.m22,
+            transform.dx, transform.dy
+        ));
+    }
+    Transform2D D2DRenderDevice::GetTransform() const {
+        D2D1_MATRIX_3X2_F matrix;
+        this->renderTarget->GetTransform(&matrix);
+        Transform2D transform;
+        transform.m11 = matrix._11;
+        transform.m12 = matrix._12;
+        transform.m21 = matrix._21;
+        transform.m22 = matrix._22;
+        transform.dx = matrix._31;
+        transform.dy = matrix._32;
+        return transform;
+    }
+
+    void D2DRenderDevice::PushClip(const RectF& rect) {
+        this->renderTarget->PushAxisAlignedClip(ToD2D1Rect(rect), D2D1_ANTIALIAS_MODE_ALIASED);
+    }
+    void D2DRenderDevice::PopClip() {
+        this->renderTarget->PopAxisAlignedClip();
+    }
+
+    void D2DRenderDevice::FillRoundedRect(const RoundedRectF& rect, const Color& color) {
+        this->solidColorBrush->SetColor(ToD2D1Color(color));
+        this->renderTarget->FillRoundedRectangle(
+            D2D1::RoundedRect(ToD2D1Rect(rect.rect), rect.radiusX, rect.radiusY),
+            this->solidColorBrush
+        );
+    }
+    void D2DRenderDevice::StrokeRoundedRect(const RoundedRectF& rect, const Color& color, float strokeWidth) {
+        this->solidColorBrush->SetColor(ToD2D1Color(color));
+        this->renderTarget->DrawRoundedRectangle(
+            D2D1::RoundedRect(ToD2D1Rect(rect.rect), rect.radiusX, rect.radiusY),
+            this->solidColorBrush,
+            strokeWidth
+        );
+    }
+
+    RenderBitmap* D2DRenderDevice::CreateBitmap(const PixelBuffer& pixels) {
+        D2DBitmap* bitmap = new D2DBitmap();
+        HRESULT hr = this->renderTarget->CreateBitmap(
+            D2D1::SizeU(pixels.width, pixels.height),
+            pixels.pixels.data(),
+            pixels.width * 4,
+            D2D1::BitmapProperties(D2D1::PixelFormat(DXGI_FORMAT_R8G8B8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED)),
+            &bitmap->bitmap
+        );
+        if (FAILED(hr)) {
+            delete bitmap;
+            throw std::runtime_error("[Cpplab Renderer] During Bitmap Creation: Failed to create D2D bitmap from decoded pixels!");
+        }
+        return bitmap;
+    }
+    void D2DRenderDevice::UpdateBitmap(RenderBitmap* bitmap, const PixelRegion& region, const uint8_t* pixels, uint32_t stride) {
+        const D2D1_RECT_U destination = D2D1::RectU(region.x, region.y, region.x + region.width, region.y + region.height);
+        HRESULT hr = static_cast<D2DBitmap*>(bitmap)->bitmap->CopyFromMemory(&destination, pixels, stride);
+        if (FAILED(hr)) {
+            throw std::runtime_error("[Cpplab Renderer] During Bitmap Update: Failed to copy pixels into D2D bitmap!");
+        }
+    }
+    void D2DRenderDevice::DrawBitmap(RenderBitmap* bitmap, const RectF& destination, float opacity) {
+        this->renderTarget->DrawBitmap(
+            static_cast<D2DBitmap*>(bitmap)->bitmap,
+            ToD2D1Rect(destination),
+            opacity,
+            D2D1_BITMAP_INTERPOLATION_MODE_LINEAR
+        );
+    }
+
+    RenderTextFormat* D2DRenderDevice::CreateTextFormat(const TextFormatDesc& desc) {
+        D2DTextFormat* format = new D2DTextFormat();
+        HRESULT hr = this->dwriteFactory->CreateTextFormat(
+            FontStyleToString(desc.fontStyle),
+            NULL,
+            DWRITE_FONT_WEIGHT_NORMAL,
+            DWRITE_FONT_STYLE_NORMAL,
+            DWRITE_FONT_STRETCH_NORMAL,
+            desc.size,
+            L"en-us",
+            &format->textFormat
+        );
+        if (FAILED(hr)) {
+            delete format;
+            throw std::runtime_error("[Cpplab Renderer] During Text Format Creation: Failed to create DWrite text format!");
+        }
+
+        if (desc.hAlign == HAlign::LEFT) {
+            format->textFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_LEADING);
+        } else if (desc.hAlign == HAlign::CENTER) {
+            format->textFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_CENTER);
+        } else if (desc.hAlign == HAlign::RIGHT) {
+            format->textFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_TRAILING);
+        } else if (desc.hAlign == HAlign::JUSTIFY) {
+            format->textFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_JUSTIFIED);
+        }
+
+        if (desc.vAlign == VAlign::TOP) {
+            format->textFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_NEAR);
+        } else if (desc.vAlign == VAlign::CENTER) {
+            format->textFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_CENTER);
+        } else if (desc.vAlign == VAlign::BOTTOM) {
+            format->textFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_FAR);
+        }
+        return format;
+    }
+    void D2DRenderDevice::DrawString(const std::wstring& text, RenderTextFormat* format, const RectF& layoutBox, const Color& color) {
+        this->solidColorBrush->SetColor(ToD2D1Color(color));
+        this->renderTarget->DrawTextW(
+            text.c_str(),
+            static_cast<UINT32>(text.length()),
+            static_cast<D2DTextFormat*>(format)->textFormat,
+            ToD2D1Rect(layoutBox),
+            this->solidColorBrush,
+            D2D1_DRAW_TEXT_OPTIONS_NONE,
+            DWRITE_MEASURING_MODE_NATURAL
+        );
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "renderdevice.hpp"
+#include <Windows.h>
+#include <d2d1.h>
+#include <dwrite.h>
+
+namespace cpplab {
+    class D2DBitmap : public RenderBitmap {
+    public:
+        ID2D1Bitmap* bitmap = nullptr;
+        ~D2DBitmap();
+        vec2 GetSize() const override;
+    };
+    class D2DTextFormat : public RenderTextFormat {
+    public:
+        IDWriteTextFormat* textFormat = nullptr;
+        ~D2DTextFormat();
+    };
+
+    //direct2d backend drawing into a window
+    class D2DRenderDevice : public RenderDevice {
+    private:
+        HWND windowHandle;
+
+        ID2D1Factory* d2dFactory;
+        ID2D1HwndRenderTarget* renderTarget;
+        ID2D1SolidColorBrush* solidColorBrush;
+
+        IDWriteFactory* dwriteFactory;
+
+        void BuildTargetResources();
+        void FreeTargetResources();
+    public:
+        D2DRenderDevice(HWND windowHandle);
+        ~D2DRenderDevice();
+
+        //recreates the render target at the current client size, bitmaps made before are no longer valid
+        void RecreateTarget();
+
+        void BeginFrame() override;
+        bool EndFrame() override;
+        vec2 GetSize() const override;
+
+        void Clear(const Color& color) override;
+        void SetTransform(const Transform2D& transform) override;
+        Transform2D GetTransform() const override;
+
+        void PushClip(const RectF& rect) override;
+        void PopClip() override;
+
+        void FillRoundedRect(const RoundedRectF& rect, const Color& color) override;
+        void StrokeRoundedRect(const RoundedRectF& rect, const Color& color, float strokeWidth) override;
+
+        RenderBitmap* CreateBitmap(const PixelBuffer& pixels) override;
+        void UpdateBitmap(RenderBitmap* bitmap, const PixelRegion& region, const uint8_t* pixels, uint32_t stride) override;
+        void DrawBitmap(RenderBitmap* bitmap, const RectF& destination, float opacity) override;
+
+        RenderTextFormat* CreateTextFormat(const TextFormatDesc& desc) override;
+        void DrawString(const std::wstring& text, RenderTextFormat* format, const RectF& layoutBox, const Color& color) override;
+    };
+}
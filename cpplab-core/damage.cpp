@@ -0,0 +1,96 @@
+#include "damage.hpp"
+
+namespace cpplab {
+    void DamageTracker::InvalidateAll() {
+        this->fullDamage = true;
+        this->rects.clear();
+    }
+    void DamageTracker::AddRect(const RectF& rect) {
+        if (this->fullDamage || rect.IsEmpty()) return;
+
+        //fold every overlapping rect into the new one so the stored rects stay disjoint
+        RectF merged = rect;
+        for (size_t i = 0; i < this->rects.size();) {
+            if (this->rects[i].Intersects(merged)) {
+                merged = merged.Union(this->rects[i]);
+                this->rects[i] = this->rects.back();
+                this->rects.pop_back();
+                i = 0;
+                continue;
+            }
+            ++i;
+        }
+        this->rects.push_back(merged);
+        if (this->rects.size() > MaxRects) this->MergeClosestPair();
+    }
+    void DamageTracker::MergeClosestPair() {
+        //merge the pair that grows the least when unioned
+        size_t bestA = 0, bestB = 1;
+        float bestGrowth = -1.f;
+        for (size_t a = 0; a < this->rects.size(); ++a) {
+            for (size_t b = a + 1; b < this->rects.size(); ++b) {
+                const float growth = this->rects[a].Union(this->rects[b]).Area() - this->rects[a].Area() - this->rects[b].Area();
+                if (bestGrowth < 0.f || growth < bestGrowth) {
+                    bestGrowth = growth;
+                    bestA = a;
+                    bestB = b;
+                }
+            }
+        }
+        const RectF merged = this->rects[bestA].Union(this->rects[bestB]);
+        this->rects.erase(this->rects.begin() + bestB);
+        this->rects.erase(this->rects.begin() + bestA);
+        this->AddRect(merged);
+    }
+
+    bool DamageTracker::TrackElement(uint32_t id, uint32_t generation, const RectF& bounds, bool modified) {
+        if (id >= this->tracked.size()) this->tracked.resize(static_cast<size_t>(id) + 1);
+        TrackedBounds& entry = this->tracked[id];
+
+        const bool sameElement = entry.valid && entry.generation == generation;
+        if (sameElement && !modified && entry.bounds == bounds) return false;
+
+        if (entry.valid) this->AddRect(entry.bounds);
+        this->AddRect(bounds);
+        entry.bounds = bounds;
+        entry.generation = generation;
+        entry.valid = true;
+        return true;
+    }
+    void DamageTracker::ForgetElement(uint32_t id) {
+        if (id >= this->tracked.size() || !this->tracked[id].valid) return;
+        this->AddRect(this->tracked[id].bounds);
+        this->tracked[id].valid = false;
+    }
+    RectF DamageTracker::GetTrackedBounds(uint32_t id) const {
+        if (id >= this->tracked.size() || !this->tracked[id].valid) return RectF();
+        return this->tracked[id].bounds;
+    }
+
+    RectF DamageTracker::Bounds() const {
+        RectF bounds;
+        for (const RectF& rect : this->rects) {
+            bounds = bounds.Union(rect);
+        }
+        return bounds;
+    }
+    float DamageTracker::Area() const {
+        float area = 0.f;
+        for (const RectF& rect : this->rects) {
+            area += rect.Area();
+        }
+        return area;
+    }
+    bool DamageTracker::Intersects(const RectF& rect) const {
+        if (this->fullDamage) return true;
+        for (const RectF& damaged : this->rects) {
+            if (damaged.Intersects(rect)) return true;
+        }
+        return false;
+    }
+
+    void DamageTracker::ResetRegion() {
+        this->fullDamage = false;
+        this->rects.clear();
+    }
+}
\ No newline at end of file
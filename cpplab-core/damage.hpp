@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "engineelements.hpp"
+
+namespace cpplab {
+    struct FrameDamageStats {
+        bool fullRedraw = true;
+        float damagedArea = 0.f;
+        size_t damageRects = 0;
+        size_t elementsDrawn = 0;
+        size_t elementsSkipped = 0;
+        //elements whose display list commands had to be recorded again, the rest were replayed
+        size_t elementsRecorded = 0;
+        //elements measured for damage since the last frame, the changed ones unless the tree's structure changed
+        size_t elementsChecked = 0;
+    };
+
+    //collects the regions of the window that need repainting
+    //remembers the last bounds of every element (by element store index) so a change damages both the old and new area
+    //has no dependency on the render backend so it can be tested without a window
+    class DamageTracker {
+    public:
+        static constexpr size_t MaxRects = 8;
+
+    private:
+        struct TrackedBounds {
+            RectF bounds;
+            uint32_t generation = 0;
+            bool valid = false;
+        };
+
+        std::vector<TrackedBounds> tracked;
+        std::vector<RectF> rects;
+        bool fullDamage = true;
+
+        void MergeClosestPair();
+
+    public:
+        //damages the whole window, used on resize, background change and lost targets
+        void InvalidateAll();
+        void AddRect(const RectF& rect);
+
+        //compares the bounds with the ones seen last time, damaging old and new bounds if they differ or the element was modified
+        //returns true if anything was damaged
+        bool TrackElement(uint32_t id, uint32_t generation, const RectF& bounds, bool modified);
+        void ForgetElement(uint32_t id);
+        RectF GetTrackedBounds(uint32_t id) const;
+
+        bool IsFullDamage() const {
+            return this->fullDamage;
+        }
+        bool HasDamage() const {
+            return this->fullDamage || !this->rects.empty();
+        }
+        const std::vector<RectF>& Rects() const {
+            return this->rects;
+        }
+        RectF Bounds() const;
+        float Area() const;
+        bool Intersects(const RectF& rect) const;
+
+        //clears the collected region, tracked element bounds are kept
+        void ResetRegion();
+    };
+}
\ No newline at end of file
@@ -0,0 +1,402 @@
+#include <cstdio>
+#include "displaylist.hpp"
+
+namespace cpplab {
+    namespace {
+        constexpr uint32_t FileMagic = 0x4C445043; //"CPDL"
+        constexpr uint32_t FileVersion = 2;
+        constexpr uint32_t MaxFileCount = 1u << 24;
+        constexpr uint32_t InitialSegmentCapacity = 8;
+
+        bool WriteU32(FILE* file, uint32_t value) {
+            return std::fwrite(&value, sizeof(value), 1, file) == 1;
+        }
+        bool WriteF32(FILE* file, float value) {
+            return std::fwrite(&value, sizeof(value), 1, file) == 1;
+        }
+        bool WriteWString(FILE* file, const std::wstring& text) {
+            //wchar_t is 2 bytes on windows and 4 elsewhere, store every character as 4
+            bool ok = WriteU32(file, static_cast<uint32_t>(text.size()));
+            for (wchar_t character : text) {
+                ok = ok && WriteU32(file, static_cast<uint32_t>(character));
+            }
+            return ok;
+        }
+        bool WriteColor(FILE* file, const Color& color) {
+            return WriteF32(file, color.r) && WriteF32(file, color.g) && WriteF32(file, color.b) && WriteF32(file, color.a);
+        }
+        bool ReadU32(FILE* file, uint32_t& value) {
+            return std::fread(&value, sizeof(value), 1, file) == 1;
+        }
+        bool ReadF32(FILE* file, float& value) {
+            return std::fread(&value, sizeof(value), 1, file) == 1;
+        }
+        bool ReadWString(FILE* file, std::wstring& text) {
+            uint32_t size = 0;
+            if (!ReadU32(file, size) || size > MaxFileCount) return false;
+            text.resize(size);
+            for (uint32_t i = 0; i < size; ++i) {
+                uint32_t character = 0;
+                if (!ReadU32(file, character)) return false;
+                text[i] = static_cast<wchar_t>(character);
+            }
+            return true;
+        }
+        bool ReadColor(FILE* file, Color& color) {
+            return ReadF32(file, color.r) && ReadF32(file, color.g) && ReadF32(file, color.b) && ReadF32(file, color.a);
+        }
+    }
+
+    DisplayList::~DisplayList() {
+        this->Clear();
+    }
+
+    DisplayList::Segment& DisplayList::GetSegment(uint32_t id) {
+        if (id >= this->segments.size()) this->segments.resize(static_cast<size_t>(id) + 1);
+        return this->segments[id];
+    }
+
+    void DisplayList::BeginElement(uint32_t id) {
+        Segment& segment = this->GetSegment(id);
+        segment.present = true;
+        segment.count = 0;
+        this->recordingId = id;
+    }
+    void DisplayList::EndElement() {
+        this->recordingId = UINT32_MAX;
+        //relocated segments leave holes behind, squeeze them out once they dominate the buffer
+        if (this->garbageCommands > 256 && this->garbageCommands > this->commands.size() / 2) {
+            this->Compact();
+        }
+    }
+    void DisplayList::Emit(const DisplayCommand& command) {
+        Segment& segment = this->segments[this->recordingId];
+        if (segment.count == segment.capacity) {
+            //out of room, move the segment to the end with twice the space
+            const uint32_t newCapacity = segment.capacity == 0 ? InitialSegmentCapacity : segment.capacity * 2;
+            const size_t newOffset = this->commands.size();
+            this->commands.resize(newOffset + newCapacity);
+            for (uint32_t i = 0; i < segment.count; ++i) {
+                this->commands[newOffset + i] = this->commands[segment.offset + i];
+            }
+            this->garbageCommands += segment.capacity;
+            segment.offset = newOffset;
+            segment.capacity = newCapacity;
+        }
+        this->commands[segment.offset + segment.count++] = command;
+    }
+    void DisplayList::Compact() {
+        std::vector<DisplayCommand> compacted;
+        compacted.reserve(this->commands.size() - this->garbageCommands);
+        for (Segment& segment : this->segments) {
+            if (!segment.present) continue;
+            const size_t newOffset = compacted.size();
+            compacted.insert(
+                compacted.end(),
+                this->commands.begin() + segment.offset,
+                this->commands.begin() + segment.offset + segment.capacity
+            );
+            segment.offset = newOffset;
+        }
+        this->commands.swap(compacted);
+        this->garbageCommands = 0;
+    }
+
+    void DisplayList::SetTransform(const Transform2D& transform) {
+        DisplayCommand command;
+        command.op = DisplayOp::SET_TRANSFORM;
+        command.values[0] = transform.m11;
+        command.values[1] = transform.m12;
+        command.values[2] = transform.m21;
+        command.values[3] = transform.m22;
+        command.values[4] = transform.dx;
+        command.values[5] = transform.dy;
+        this->Emit(command);
+    }
+    void DisplayList::PushClip(const RectF& rect) {
+        DisplayCommand command;
+        command.op = DisplayOp::PUSH_CLIP;
+        command.values[0] = rect.left;
+        command.values[1] = rect.top;
+        command.values[2] = rect.right;
+        command.values[3] = rect.bottom;
+        this->Emit(command);
+    }
+    void DisplayList::PopClip() {
+        DisplayCommand command;
+        command.op = DisplayOp::POP_CLIP;
+        this->Emit(command);
+    }
+    void DisplayList::FillRoundedRect(const RoundedRectF& rect, const Color& color) {
+        DisplayCommand command;
+        command.op = DisplayOp::FILL_ROUNDED_RECT;
+        command.values[0] = rect.rect.left;
+        command.values[1] = rect.rect.top;
+        command.values[2] = rect.rect.right;
+        command.values[3] = rect.rect.bottom;
+        command.values[4] = rect.radiusX;
+        command.values[5] = rect.radiusY;
+        command.color = color;
+        this->Emit(command);
+    }
+    void DisplayList::StrokeRoundedRect(const RoundedRectF& rect, const Color& color, float strokeWidth) {
+        DisplayCommand command;
+        command.op = DisplayOp::STROKE_ROUNDED_RECT;
+        command.values[0] = rect.rect.left;
+        command.values[1] = rect.rect.top;
+        command.values[2] = rect.rect.right;
+        command.values[3] = rect.rect.bottom;
+        command.values[4] = rect.radiusX;
+        command.values[5] = rect.radiusY;
+        command.values[6] = strokeWidth;
+        command.color = color;
+        this->Emit(command);
+    }
+    void DisplayList::DrawBitmap(const RectF& destination, float opacity) {
+        DisplayCommand command;
+        command.op = DisplayOp::DRAW_BITMAP;
+        command.values[0] = destination.left;
+        command.values[1] = destination.top;
+        command.values[2] = destination.right;
+        command.values[3] = destination.bottom;
+        command.values[4] = opacity;
+        this->Emit(command);
+    }
+    void DisplayList::DrawString(const RectF& layoutBox, const Color& color) {
+        DisplayCommand command;
+        command.op = DisplayOp::DRAW_STRING;
+        command.values[0] = layoutBox.left;
+        command.values[1] = layoutBox.top;
+        command.values[2] = layoutBox.right;
+        command.values[3] = layoutBox.bottom;
+        command.color = color;
+        this->Emit(command);
+    }
+
+    void DisplayList::SetElementText(uint32_t id, const std::wstring& text) {
+        this->GetSegment(id).text = text;
+    }
+    void DisplayList::SetElementTextFormat(uint32_t id, const TextFormatKey& key, RenderDevice& device) {
+        Segment& segment = this->GetSegment(id);
+        if (segment.textFormat && segment.formatKey == key) return;
+
+        //acquire before releasing so a format only this element used is not deleted and recreated
+        RenderTextFormat* format = this->textFormats.Acquire(key, device);
+        if (segment.textFormat) this->textFormats.Release(segment.formatKey);
+        segment.textFormat = format;
+        segment.formatKey = key;
+    }
+    RenderTextFormat* DisplayList::GetElementTextFormat(uint32_t id) const {
+        return id < this->segments.size() ? this->segments[id].textFormat : nullptr;
+    }
+    void DisplayList::SetElementBitmap(uint32_t id, RenderBitmap* bitmap, const std::wstring& source, ImageType type) {
+        Segment& segment = this->GetSegment(id);
+        if (segment.bitmap != bitmap) delete segment.bitmap;
+        segment.bitmap = bitmap;
+        segment.bitmapSource = source;
+        segment.bitmapType = type;
+    }
+    RenderBitmap* DisplayList::GetElementBitmap(uint32_t id) const {
+        return id < this->segments.size() ? this->segments[id].bitmap : nullptr;
+    }
+
+    void DisplayList::ReleaseSegmentResources(Segment& segment) {
+        if (segment.textFormat) this->textFormats.Release(segment.formatKey);
+        segment.textFormat = nullptr;
+        delete segment.bitmap;
+        segment.bitmap = nullptr;
+    }
+    void DisplayList::RemoveElement(uint32_t id) {
+        if (id >= this->segments.size() || !this->segments[id].present) return;
+        Segment& segment = this->segments[id];
+        this->ReleaseSegmentResources(segment);
+        this->garbageCommands += segment.capacity;
+        segment = Segment();
+    }
+    void DisplayList::Clear() {
+        for (Segment& segment : this->segments) {
+            this->ReleaseSegmentResources(segment);
+        }
+        this->segments.clear();
+        this->commands.clear();
+        this->garbageCommands = 0;
+        this->recordingId = UINT32_MAX;
+    }
+    void DisplayList::ReleaseDeviceResources() {
+        //the whole cache goes with the device, references are dropped instead of released one by one
+        for (Segment& segment : this->segments) {
+            segment.textFormat = nullptr;
+            delete segment.bitmap;
+            segment.bitmap = nullptr;
+        }
+        this->textFormats.Clear();
+    }
+
+    void DisplayList::ReplaySegment(RenderDevice& device, const Segment& segment) const {
+        for (size_t i = segment.offset; i < segment.offset + segment.count; ++i) {
+            const DisplayCommand& command = this->commands[i];
+            const float* v = command.values;
+            switch (command.op) {
+            case DisplayOp::SET_TRANSFORM: {
+                Transform2D transform;
+                transform.m11 = v[0];
+                transform.m12 = v[1];
+                transform.m21 = v[2];
+                transform.m22 = v[3];
+                transform.dx = v[4];
+                transform.dy = v[5];
+                device.SetTransform(transform);
+                break;
+            }
+            case DisplayOp::PUSH_CLIP:
+                device.PushClip(RectF(v[0], v[1], v[2], v[3]));
+                break;
+            case DisplayOp::POP_CLIP:
+                device.PopClip();
+                break;
+            case DisplayOp::FILL_ROUNDED_RECT:
+                device.FillRoundedRect(RoundedRectF(RectF(v[0], v[1], v[2], v[3]), v[4], v[5]), command.color);
+                break;
+            case DisplayOp::STROKE_ROUNDED_RECT:
+                device.StrokeRoundedRect(RoundedRectF(RectF(v[0], v[1], v[2], v[3]), v[4], v[5]), command.color, v[6]);
+                break;
+            case DisplayOp::DRAW_BITMAP:
+                if (segment.bitmap) device.DrawBitmap(segment.bitmap, RectF(v[0], v[1], v[2], v[3]), v[4]);
+                break;
+            case DisplayOp::DRAW_STRING:
+                if (segment.textFormat) device.DrawString(segment.text, segment.textFormat, RectF(v[0], v[1], v[2], v[3]), command.color);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    void DisplayList::ReplayElement(RenderDevice& device, uint32_t id) const {
+        if (id >= this->segments.size() || !this->segments[id].present) return;
+        this->ReplaySegment(device, this->segments[id]);
+    }
+    void DisplayList::Replay(RenderDevice& device, const std::vector<uint32_t>& order) const {
+        for (uint32_t id : order) {
+            this->ReplayElement(device, id);
+        }
+    }
+
+    size_t DisplayList::CommandCount() const {
+        size_t count = 0;
+        for (const Segment& segment : this->segments) {
+            count += segment.count;
+        }
+        return count;
+    }
+
+    bool DisplayList::Save(const std::string& path, const std::vector<uint32_t>& order, const Color& clearColor) const {
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) return false;
+
+        uint32_t segmentCount = 0;
+        for (uint32_t id : order) {
+            if (id < this->segments.size() && this->segments[id].present) ++segmentCount;
+        }
+        bool ok = WriteU32(file, FileMagic) && WriteU32(file, FileVersion) && WriteColor(file, clearColor) && WriteU32(file, segmentCount);
+        for (uint32_t id : order) {
+            if (!ok) break;
+            if (id >= this->segments.size() || !this->segments[id].present) continue;
+            const Segment& segment = this->segments[id];
+
+            ok = WriteU32(file, id) && WriteWString(file, segment.text);
+            //the format key is written even without a live format, load recreates it
+            const TextFormatKey& key = segment.formatKey;
+            ok = ok && WriteU32(file, static_cast<uint32_t>(key.fontStyle)) && WriteF32(file, key.pointSize) && WriteU32(file, key.dpi) &&
+                WriteU32(file, static_cast<uint32_t>(key.hAlign)) && WriteU32(file, static_cast<uint32_t>(key.vAlign));
+            ok = ok && WriteWString(file, segment.bitmapSource) && WriteU32(file, static_cast<uint32_t>(segment.bitmapType));
+
+            ok = ok && WriteU32(file, segment.count);
+            for (size_t i = segment.offset; ok && i < segment.offset + segment.count; ++i) {
+                const DisplayCommand& command = this->commands[i];
+                ok = WriteU32(file, static_cast<uint32_t>(command.op));
+                for (float value : command.values) {
+                    ok = ok && WriteF32(file, value);
+                }
+                ok = ok && WriteColor(file, command.color);
+            }
+        }
+        return std::fclose(file) == 0 && ok;
+    }
+
+    bool DisplayList::Load(const std::string& path, RenderDevice& device, ImageDecoder* decoder, std::vector<uint32_t>& order, Color& clearColor) {
+        this->Clear();
+        order.clear();
+        FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) return false;
+
+        uint32_t magic = 0, version = 0, segmentCount = 0;
+        bool ok = ReadU32(file, magic) && magic == FileMagic && ReadU32(file, version) && version == FileVersion &&
+            ReadColor(file, clearColor) && ReadU32(file, segmentCount) && segmentCount <= MaxFileCount;
+        for (uint32_t s = 0; ok && s < segmentCount; ++s) {
+            uint32_t id = 0;
+            ok = ReadU32(file, id) && id < MaxFileCount;
+            if (!ok) break;
+            Segment& segment = this->GetSegment(id);
+            if (segment.present) {
+                ok = false;
+                break;
+            }
+
+            TextFormatKey key;
+            uint32_t fontStyle = 0, hAlign = 0, vAlign = 0, bitmapType = 0, commandCount = 0;
+            ok = ReadWString(file, segment.text) && ReadU32(file, fontStyle) && ReadF32(file, key.pointSize) && ReadU32(file, key.dpi) &&
+                key.dpi != 0 && ReadU32(file, hAlign) && ReadU32(file, vAlign) && ReadWString(file, segment.bitmapSource) &&
+                ReadU32(file, bitmapType) && ReadU32(file, commandCount) && commandCount <= MaxFileCount;
+            if (!ok) break;
+            key.fontStyle = static_cast<FontStyle>(fontStyle);
+            key.hAlign = static_cast<HAlign>(hAlign);
+            key.vAlign = static_cast<VAlign>(vAlign);
+            segment.formatKey = key;
+            segment.bitmapType = static_cast<ImageType>(bitmapType);
+
+            this->BeginElement(id);
+            bool drawsText = false, drawsBitmap = false;
+            for (uint32_t c = 0; ok && c < commandCount; ++c) {
+                DisplayCommand command;
+                uint32_t op = 0;
+                ok = ReadU32(file, op) && op <= static_cast<uint32_t>(DisplayOp::DRAW_STRING);
+                for (float& value : command.values) {
+                    ok = ok && ReadF32(file, value);
+                }
+                ok = ok && ReadColor(file, command.color);
+                command.op = static_cast<DisplayOp>(op);
+                drawsText = drawsText || command.op == DisplayOp::DRAW_STRING;
+                drawsBitmap = drawsBitmap || command.op == DisplayOp::DRAW_BITMAP;
+                if (ok) this->Emit(command);
+            }
+            this->EndElement();
+            if (!ok) break;
+            order.push_back(id);
+
+            //recreate what the commands reference on the replaying device
+            try {
+                if (drawsText) {
+                    this->SetElementTextFormat(id, key, device);
+                }
+                //pixel buffer elements have no source to decode from, they draw nothing until fed again
+                if (drawsBitmap && decoder != nullptr && !segment.bitmapSource.empty()) {
+                    PixelBuffer pixels;
+                    decoder->Decode(segment.bitmapSource, segment.bitmapType, pixels);
+                    segment.bitmap = device.CreateBitmap(pixels);
+                }
+            }
+            catch (...) {
+                std::fclose(file);
+                this->Clear();
+                order.clear();
+                throw;
+            }
+        }
+        std::fclose(file);
+        if (!ok) {
+            this->Clear();
+            order.clear();
+        }
+        return ok;
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "renderdevice.hpp"
+#include "imagedecoder.hpp"
+#include "textformatcache.hpp"
+
+namespace cpplab {
+    enum class DisplayOp : uint8_t {
+        NOP, SET_TRANSFORM, PUSH_CLIP, POP_CLIP, FILL_ROUNDED_RECT, STROKE_ROUNDED_RECT, DRAW_BITMAP, DRAW_STRING
+    };
+
+    //one recorded draw call, everything is already dpi scaled and in device units
+    struct DisplayCommand {
+        DisplayOp op = DisplayOp::NOP;
+        //transform: m11 m12 m21 m22 dx dy
+        //rect ops: left top right bottom radiusX radiusY strokeWidth
+        //bitmap: left top right bottom opacity
+        float values[7] = {};
+        Color color;
+    };
+
+    //flat buffer of draw commands grouped into one segment per element (element store index)
+    //re-recording an element overwrites its segment in place, other segments are left alone
+    //bitmaps, text formats and strings are kept per element so commands stay plain data
+    class DisplayList {
+    private:
+        struct Segment {
+            size_t offset = 0;
+            uint32_t count = 0;
+            uint32_t capacity = 0;
+            bool present = false;
+
+            std::wstring text;
+            //holds a cache reference while not null
+            RenderTextFormat* textFormat = nullptr;
+            TextFormatKey formatKey;
+            RenderBitmap* bitmap = nullptr;
+            std::wstring bitmapSource;
+            ImageType bitmapType = ImageType::FILE;
+        };
+
+        std::vector<DisplayCommand> commands;
+        std::vector<Segment> segments;
+        TextFormatCache textFormats;
+        size_t garbageCommands = 0;
+        uint32_t recordingId = UINT32_MAX;
+
+        Segment& GetSegment(uint32_t id);
+        void ReleaseSegmentResources(Segment& segment);
+        void Emit(const DisplayCommand& command);
+        void Compact();
+        void ReplaySegment(RenderDevice& device, const Segment& segment) const;
+
+    public:
+        DisplayList() = default;
+        DisplayList(const DisplayList&) = delete;
+        DisplayList& operator=(const DisplayList&) = delete;
+        ~DisplayList();
+
+        //recording, commands between BeginElement and EndElement replace the element's old commands
+        void BeginElement(uint32_t id);
+        void EndElement();
+        void SetTransform(const Transform2D& transform);
+        void PushClip(const RectF& rect);
+        void PopClip();
+        void FillRoundedRect(const RoundedRectF& rect, const Color& color);
+        void StrokeRoundedRect(const RoundedRectF& rect, const Color& color, float strokeWidth);
+        //draws the element's bitmap
+        void DrawBitmap(const RectF& destination, float opacity);
+        //draws the element's text with its text format
+        void DrawString(const RectF& layoutBox, const Color& color);
+
+        //per element resources, the list takes ownership of bitmaps
+        void SetElementText(uint32_t id, const std::wstring& text);
+        //elements with the same key share one format from the cache, setting the current key again does nothing
+        void SetElementTextFormat(uint32_t id, const TextFormatKey& key, RenderDevice& device);
+        RenderTextFormat* GetElementTextFormat(uint32_t id) const;
+        void SetElementBitmap(uint32_t id, RenderBitmap* bitmap, const std::wstring& source, ImageType type);
+        RenderBitmap* GetElementBitmap(uint32_t id) const;
+
+        void RemoveElement(uint32_t id);
+        void Clear();
+        //deletes bitmaps and text formats, descriptions are kept
+        void ReleaseDeviceResources();
+
+        void ReplayElement(RenderDevice& device, uint32_t id) const;
+        void Replay(RenderDevice& device, const std::vector<uint32_t>& order) const;
+
+        //binary file with the elements in the given order, bitmaps are stored by source and decoded again on load
+        bool Save(const std::string& path, const std::vector<uint32_t>& order, const Color& clearColor) const;
+        //replaces the contents, resources are created on the device, the decoder may be null to skip bitmaps
+        bool Load(const std::string& path, RenderDevice& device, ImageDecoder* decoder, std::vector<uint32_t>& order, Color& clearColor);
+
+        const TextFormatCache& GetTextFormatCache() const {
+            return this->textFormats;
+        }
+        TextFormatCache& GetTextFormatCache() {
+            return this->textFormats;
+        }
+
+        size_t CommandCount() const;
+        size_t BufferSize() const {
+            return this->commands.size();
+        }
+    };
+}
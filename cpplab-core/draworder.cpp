@@ -0,0 +1,119 @@
+#include "draworder.hpp"
+#include <algorithm>
+#include <iterator>
+
+namespace cpplab {
+    namespace {
+        //bits of DrawOrderList::idState that only the implementation needs
+        constexpr uint8_t InEntries = 8;
+        constexpr uint8_t InPending = 16;
+        constexpr uint8_t DepthQueued = 32;
+    }
+
+    uint8_t& DrawOrderList::State(uint32_t id) {
+        if (id >= this->idState.size()) this->idState.resize(static_cast<size_t>(id) + 1, 0);
+        return this->idState[id];
+    }
+
+    void DrawOrderList::Insert(uint32_t id, float depth) {
+        uint8_t& state = this->State(id);
+        if (state & Contained) return;
+
+        //a removed but not yet committed copy may still sit in entries, Commit drops it
+        state |= Contained | InPending;
+        this->pending.push_back(Entry{ depth, this->nextSequence++, id });
+        ++this->queuedChanges;
+    }
+    void DrawOrderList::Remove(uint32_t id) {
+        if (!this->Contains(id)) return;
+        uint8_t& state = this->State(id);
+        state &= ~Contained;
+
+        if (state & InPending) {
+            for (size_t i = 0; i < this->pending.size(); ++i) {
+                if (this->pending[i].id == id) {
+                    this->pending.erase(this->pending.begin() + i);
+                    break;
+                }
+            }
+            state &= ~InPending;
+        }
+        else {
+            state |= RemoveQueued;
+        }
+        ++this->queuedChanges;
+    }
+    void DrawOrderList::SetDepthAt(size_t position, float depth) {
+        Entry& entry = this->entries[position];
+        if (entry.depth == depth) return;
+        entry.depth = depth;
+        this->State(entry.id) |= RepositionQueued;
+        ++this->queuedChanges;
+    }
+
+    void DrawOrderList::SetDepth(uint32_t id, float depth) {
+        if (!this->Contains(id)) return;
+        uint8_t& state = this->State(id);
+        //not sorted in yet, Commit places it with the new depth
+        if (state & InPending) {
+            for (Entry& entry : this->pending) {
+                if (entry.id == id) {
+                    entry.depth = depth;
+                    break;
+                }
+            }
+            return;
+        }
+        if (id >= this->queuedDepth.size()) this->queuedDepth.resize(static_cast<size_t>(id) + 1, 0.f);
+        this->queuedDepth[id] = depth;
+        state |= RepositionQueued | DepthQueued;
+        ++this->queuedChanges;
+    }
+
+    void DrawOrderList::Commit() {
+        if (this->queuedChanges == 0) return;
+
+        //one pass drops removed entries and pulls out the ones that need to move
+        size_t kept = 0;
+        for (size_t i = 0; i < this->entries.size(); ++i) {
+            Entry entry = this->entries[i];
+            uint8_t& state = this->idState[entry.id];
+            if (state & RemoveQueued) {
+                state &= ~(RemoveQueued | RepositionQueued | DepthQueued | InEntries);
+                continue;
+            }
+            if (state & RepositionQueued) {
+                if (state & DepthQueued) entry.depth = this->queuedDepth[entry.id];
+                state &= ~(RepositionQueued | DepthQueued);
+                this->pending.push_back(entry);
+                continue;
+            }
+            this->entries[kept++] = entry;
+        }
+        this->entries.resize(kept);
+
+        //sort the batch and merge it in, O(n + k log k) instead of one scan per insert
+        for (const Entry& entry : this->pending) {
+            uint8_t& state = this->idState[entry.id];
+            state = (state & ~InPending) | InEntries;
+        }
+        std::sort(this->pending.begin(), this->pending.end(), &DrawOrderList::DrawsBefore);
+        this->scratch.clear();
+        this->scratch.reserve(this->entries.size() + this->pending.size());
+        std::merge(
+            this->entries.begin(), this->entries.end(),
+            this->pending.begin(), this->pending.end(),
+            std::back_inserter(this->scratch),
+            &DrawOrderList::DrawsBefore
+        );
+        this->entries.swap(this->scratch);
+        this->pending.clear();
+        this->queuedChanges = 0;
+    }
+    void DrawOrderList::Clear() {
+        this->entries.clear();
+        this->pending.clear();
+        this->idState.clear();
+        this->queuedChanges = 0;
+    }
+}
\ No newline at end of file
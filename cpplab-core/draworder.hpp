@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace cpplab {
+    //depth sorted draw order kept in one contiguous array
+    //entries are sorted by depth, equal depths keep insertion order through a sequence number
+    //inserts, removes and depth changes are queued and applied together by Commit
+    class DrawOrderList {
+    public:
+        struct Entry {
+            float depth;
+            uint64_t sequence;
+            uint32_t id;
+        };
+
+    private:
+        std::vector<Entry> entries;
+        std::vector<Entry> pending;
+        std::vector<Entry> scratch;
+
+        //per id state, ids are element store indices so these stay dense
+        enum : uint8_t {
+            Contained = 1,
+            RemoveQueued = 2,
+            RepositionQueued = 4
+        };
+        std::vector<uint8_t> idState;
+        //depths set by id, applied to the entry when Commit moves it
+        std::vector<float> queuedDepth;
+        size_t queuedChanges = 0;
+        uint64_t nextSequence = 0;
+
+        uint8_t& State(uint32_t id);
+        static bool DrawsBefore(const Entry& lhs, const Entry& rhs) {
+            if (lhs.depth != rhs.depth) return lhs.depth < rhs.depth;
+            return lhs.sequence < rhs.sequence;
+        }
+
+    public:
+        void Insert(uint32_t id, float depth);
+        void Remove(uint32_t id);
+        //changes the depth of the entry at a position, it moves on the next Commit
+        void SetDepthAt(size_t position, float depth);
+        //same by id, for callers that only know which entries changed
+        void SetDepth(uint32_t id, float depth);
+        void Commit();
+        void Clear();
+
+        bool Contains(uint32_t id) const {
+            return id < this->idState.size() && (this->idState[id] & Contained) != 0;
+        }
+        bool HasQueuedChanges() const {
+            return this->queuedChanges != 0;
+        }
+        const std::vector<Entry>& Entries() const {
+            return this->entries;
+        }
+        size_t Size() const {
+            return this->entries.size();
+        }
+    };
+}
\ No newline at end of file
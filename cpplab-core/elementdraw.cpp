@@ -1,478 +1,300 @@
-#include "windowrenderer.hpp"
+#include "scenerenderer.hpp"
 
 namespace cpplab {
+    static Color Faded(Color color, float opacity) {
+        color.a *= opacity;
+        return color;
+    }
 
-    std::string wstr_to_utf8(const std::wstring& wstr)
-    {
-        int wstr_len = (int)wcslen(wstr.c_str());
-        int num_chars = WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), wstr_len, NULL, 0, NULL, NULL);
-        CHAR* strTo = (CHAR*)malloc((num_chars + 1) * sizeof(CHAR));
-        if (strTo)
-        {
-            WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), wstr_len, strTo, num_chars, NULL, NULL);
-            strTo[num_chars] = '\0';
+    void SceneRenderer::PrepareElementResources(NodeRenderData* element) {
+        //published blocks never change, so they are read without locking
+        ElementStore& store = ElementStore::Instance();
+        const uint32_t id = element->handle.index;
+        const uint32_t stale = element->staleResources;
+        const NodeType type = store.Type(id);
+        if (type == NodeType::TEXT_AREA) {
+            const TextElementState& text = static_cast<const TextElementState&>(*store.State(id));
+            //build text, the format comes from the shared cache and is only looked up again when the key changed
+            if (stale & DIRTY_TEXT_FORMAT) {
+                TextFormatKey formatKey;
+                formatKey.fontStyle = text.fontStyle;
+                formatKey.pointSize = text.textPointSize;
+                formatKey.dpi = this->dpi;
+                formatKey.hAlign = text.textHAlign;
+                formatKey.vAlign = text.textVAlign;
+                this->displayList.SetElementTextFormat(id, formatKey, *this->device);
+                ++this->rebuildStats.textFormatUpdates;
+                this->profiler.Count(ProfileCounter::RESOURCES_CREATED);
+            }
+            if (stale & DIRTY_TEXT_CONTENT) {
+                this->displayList.SetElementText(id, *text.text);
+                ++this->rebuildStats.textContentUpdates;
+                this->profiler.Count(ProfileCounter::RESOURCES_CREATED);
+            }
         }
-
-        std::string ret(strTo);
-        free(strTo);
-        return ret;
+        else if (type == NodeType::IMAGE) {
+            const ImageElementState& image = static_cast<const ImageElementState&>(*store.State(id));
+
+            //decoded pixels come from the shared cache at the size the image is shown at
+            //only ask again when the source changed, the bitmap was released or the element crossed a decode size step
+            if (this->imageCache != nullptr && (stale & (DIRTY_IMAGE_SOURCE | DIRTY_GEOMETRY))) {
+                ImageKey key;
+                key.source = image.imageName;
+                key.type = image.imgType;
+                key.size.width = QuantizeDecodeExtent(image.width);
+                key.size.height = QuantizeDecodeExtent(image.height);
+                key.size.fillMode = image.fillMode;
+
+                if ((stale & DIRTY_IMAGE_SOURCE) || key != element->imageKey) {
+                    const bool sourceChanged = key.source != element->imageKey.source || key.type != element->imageKey.type;
+                    std::shared_ptr<const PixelBuffer> pixels;
+                    const ImageRequestState state = this->imageCache->Request(key, pixels);
+                    if (state == ImageRequestState::READY) {
+                        //drop the old bitmap before making its replacement
+                        this->displayList.SetElementBitmap(id, nullptr, key.source, key.type);
+                        this->displayList.SetElementBitmap(id, this->device->CreateSharedBitmap(pixels), key.source, key.type);
+                        ++this->rebuildStats.bitmapUploads;
+                        this->profiler.Count(ProfileCounter::RESOURCES_CREATED);
+                        this->profiler.Count(ProfileCounter::BYTES_UPLOADED, pixels->pixels.size());
+                    }
+                    else if (state == ImageRequestState::FAILED || sourceChanged) {
+                        this->displayList.SetElementBitmap(id, nullptr, key.source, key.type);
+                    }
+                    //a pending resize keeps showing the old size until the new one is ready
+                    if (state == ImageRequestState::PENDING) {
+                        this->pendingImages.push_back(element->handle);
+                    }
+                    element->imagePending = state == ImageRequestState::PENDING;
+                    element->imageKey = key;
+                }
+            }
+        }
+        else if (type == NodeType::PIXEL_BUFFER) {
+            if (stale & DIRTY_PIXELS) this->UploadPixelBuffer(element);
+        }
+        element->staleResources = DIRTY_NONE;
     }
 
-    D2D1_COLOR_F ToD2D1Color(Color cpplabColor) {
-        D2D1_COLOR_F tempColor = { };
-        tempColor.r = cpplabColor.r;
-        tempColor.g = cpplabColor.g;
-        tempColor.b = cpplabColor.b;
-        tempColor.a = cpplabColor.a;
-        return tempColor;
+    void SceneRenderer::UploadPixelBuffer(NodeRenderData* element) {
+        const uint32_t id = element->handle.index;
+        PixelBufferElement* pixelElement = static_cast<PixelBufferElement*>(element->elementNode);
+        const PixelRegion region = pixelElement->ConsumeFrame();
+        const PixelBuffer& pixels = pixelElement->ReadBuffer();
+
+        RenderBitmap* bitmap = this->displayList.GetElementBitmap(id);
+        if (bitmap == nullptr) {
+            //first frame or the device was lost, the whole buffer goes up once
+            this->displayList.SetElementBitmap(id, this->device->CreateBitmap(pixels), L"", ImageType::FILE);
+            pixelElement->CountUpload(pixels.pixels.size());
+            ++this->rebuildStats.bitmapUploads;
+            this->profiler.Count(ProfileCounter::RESOURCES_CREATED);
+            this->profiler.Count(ProfileCounter::BYTES_UPLOADED, pixels.pixels.size());
+            return;
+        }
+        if (region.IsEmpty()) return;
+
+        const uint32_t stride = pixels.width * 4;
+        this->device->UpdateBitmap(bitmap, region, &pixels.pixels[(static_cast<size_t>(region.y) * pixels.width + region.x) * 4], stride);
+        const uint64_t bytes = static_cast<uint64_t>(region.width) * region.height * 4;
+        pixelElement->CountUpload(bytes);
+        ++this->rebuildStats.pixelRegionUploads;
+        this->rebuildStats.pixelBytesUploaded += bytes;
+        this->profiler.Count(ProfileCounter::BYTES_UPLOADED, bytes);
+
+        //map the region through the same centered box RecordElement draws the bitmap into, clipped to the element
+        ElementStore& store = ElementStore::Instance();
+        const PixelBufferState& state = static_cast<const PixelBufferState&>(*store.State(id));
+        const vec2 pos = vec2(store.WorldX(id), store.WorldY(id));
+        const vec2 dim = vec2(state.width, state.height);
+        const RectF imgrect = GenImageBox(dim, vec2(static_cast<float>(pixels.width), static_cast<float>(pixels.height)), state.fillMode);
+        const float scaleX = imgrect.right / pixels.width;
+        const float scaleY = imgrect.bottom / pixels.height;
+        const float left = pos.x + dim.x / 2 - imgrect.right / 2;
+        const float top = pos.y + dim.y / 2 - imgrect.bottom / 2;
+        const RectF changed = RectF(
+            left + region.x * scaleX, top + region.y * scaleY,
+            left + (region.x + region.width) * scaleX, top + (region.y + region.height) * scaleY
+        );
+        const RectF visible = changed.Intersection(RectF(pos.x, pos.y, pos.x + dim.x, pos.y + dim.y));
+        //filtering reads a pixel past the edge
+        if (!visible.IsEmpty()) this->damage.AddRect(visible.Inflate(1.f));
     }
 
-    void WindowD2DRenderer::PerformElementDraw(NodeRenderData* element) {
-        if (element->elementNode->getNodeType() == NodeType::TEXT_AREA) {
-            TextElementNodeRenderData* elementData = static_cast<TextElementNodeRenderData*>(element);
-            TextElement* textElement = (TextElement*)elementData->elementNode;
-            if (textElement->modified) {
-                //build shapes
-                elementData->boxShape = D2D1::RoundedRect(
-                    D2D1::RectF(0.0f, 0.0f, scaleDPI(textElement->getDimensions().x), scaleDPI(textElement->getDimensions().y)),
-                    scaleDPI(textElement->getRoundedEdge()),
-                    scaleDPI(textElement->getRoundedEdge())
-                );
-
-                //build text
-                this->dwriteFactory->CreateTextFormat(
-                    FontStyleToString(textElement->getFontStyle()),
-                    NULL,
-                    DWRITE_FONT_WEIGHT_NORMAL,
-                    DWRITE_FONT_STYLE_NORMAL,
-                    DWRITE_FONT_STRETCH_NORMAL,
-                    scaleDPI(textElement->getTextPointSize()),
-                    L"en-us",
-                    &(elementData->textFormat)
-                );
-                if (textElement->getTextHAlign() == HAlign::LEFT) {
-                    elementData->textFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_LEADING);
-                } else if (textElement->getTextHAlign() == HAlign::CENTER) {
-                    elementData->textFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_CENTER);
-                } else if (textElement->getTextHAlign() == HAlign::RIGHT) {
-                    elementData->textFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_TRAILING);
-                } else if (textElement->getTextHAlign() == HAlign::JUSTIFY) {
-                    elementData->textFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_JUSTIFIED);
-                }
-
-                if (textElement->getTextVAlign() == VAlign::TOP) {
-                    elementData->textFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_NEAR);
-                } else if (textElement->getTextVAlign() == VAlign::CENTER) {
-                    elementData->textFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_CENTER);
-                } else if (textElement->getTextVAlign() == VAlign::BOTTOM) {
-                    elementData->textFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_FAR);
-                }
-                
+    void SceneRenderer::RecordElement(NodeRenderData* element) {
+        //all the state reads, branching and dpi scaling happen here once, frames after replay the commands
+        ElementStore& store = ElementStore::Instance();
+        const uint32_t id = element->handle.index;
+        if (element->staleResources != DIRTY_NONE) this->PrepareElementResources(element);
+        this->displayList.BeginElement(id);
+        const NodeType type = store.Type(id);
+        //world position cached at publish
+        const vec2 truePos = vec2(store.WorldX(id), store.WorldY(id));
+        if (type == NodeType::TEXT_AREA) {
+            const TextElementState& text = static_cast<const TextElementState&>(*store.State(id));
+
+            //build shapes
+            const vec2 textDimensions = vec2(text.width, text.height);
+            const float textMargin = text.textMarginPx;
+            const RoundedRectF boxShape = RoundedRectF(
+                RectF(0.0f, 0.0f, scaleDPI(textDimensions.x), scaleDPI(textDimensions.y)),
+                scaleDPI(text.roundedEdgePx),
+                scaleDPI(text.roundedEdgePx)
+            );
 
-                //build textbox
-                elementData->textboxShape = D2D1::RectF(
-                    0.f, 0.f,
-                    scaleDPI(textElement->getDimensions().x - 2 * (textElement->getTextMargin())),
-                    scaleDPI(textElement->getDimensions().y - 2 * (textElement->getTextMargin()))
-                );
-            }
-            
-            this->renderTarget->SetTransform(D2D1::Matrix3x2F::Translation(
-                scaleDPI(textElement->getTruePosition().x),
-                scaleDPI(textElement->getTruePosition().y)
+            const vec2 textTruePos = truePos;
+            this->displayList.SetTransform(Transform2D::Translation(
+                scaleDPI(textTruePos.x),
+                scaleDPI(textTruePos.y)
             ));
 
             //draw fill then outline
             //bg box
-            this->solidColorBrush->SetColor(ToD2D1Color(textElement->getBackgroundColor()));
-            this->renderTarget->FillRoundedRectangle(elementData->boxShape, this->solidColorBrush);
-            this->solidColorBrush->SetColor(ToD2D1Color(textElement->getBorderColor()));
-            this->renderTarget->DrawRoundedRectangle(elementData->boxShape, this->solidColorBrush, textElement->getBorderWidth());
+            this->displayList.FillRoundedRect(boxShape, Faded(text.backgroundColor, text.opacity));
+            this->displayList.StrokeRoundedRect(boxShape, Faded(text.borderColor, text.opacity), text.borderWidthPx);
 
             //draw text
-            this->renderTarget->SetTransform(D2D1::Matrix3x2F::Translation(
-                scaleDPI(textElement->getTruePosition().x + textElement->getTextMargin()),
-                scaleDPI(textElement->getTruePosition().y + textElement->getTextMargin())
+            this->displayList.SetTransform(Transform2D::Translation(
+                scaleDPI(textTruePos.x + textMargin),
+                scaleDPI(textTruePos.y + textMargin)
             ));
-            this->solidColorBrush->SetColor(ToD2D1Color(textElement->getTextColor()));
-            this->renderTarget->DrawTextW(
-                textElement->getText().c_str(),
-                textElement->getText().length(),
-                elementData->textFormat,
-                elementData->textboxShape,
-                this->solidColorBrush,
-                D2D1_DRAW_TEXT_OPTIONS_NONE,
-                DWRITE_MEASURING_MODE_NATURAL
+            this->displayList.DrawString(
+                RectF(
+                    0.f, 0.f,
+                    scaleDPI(textDimensions.x - 2 * textMargin),
+                    scaleDPI(textDimensions.y - 2 * textMargin)
+                ),
+                Faded(text.textColor, text.opacity)
             );
         }
-        else if (element->elementNode->getNodeType() == NodeType::IMAGE) {
-            ImageElementNodeRenderData* elementData = static_cast<ImageElementNodeRenderData*>(element);
-            ImageElement* imgElement = static_cast<ImageElement*>(elementData->elementNode);
-
-            //rebuilding image resources is expensive so only do that sometimes
-            if (imgElement->imgModified) {
-                if (imgElement->imgType == ImageType::FILE) {
-                    IWICBitmapDecoder* decoder = nullptr;
-                    HRESULT hr = this->wicImgFactory->CreateDecoderFromFilename(
-                        imgElement->getImageFileName().c_str(),
-                        NULL,
-                        GENERIC_READ,
-                        WICDecodeMetadataCacheOnLoad,
-                        &decoder
-                    );
-                    if (FAILED(hr)) {
-                        std::stringstream ss;
-                        ss << "[Cpplab Renderer] During WIC Image Decoder Creation: Failed to create image decoder for file " <<
-                            wstr_to_utf8(imgElement->imageName);
-                        SafeRelease(&decoder);
-                        throw std::runtime_error(ss.str());
-                    }
-
-                    IWICBitmapFrameDecode* decFrame;
-                    hr = decoder->GetFrame(0, &decFrame);
-                    if (FAILED(hr)) {
-                        std::stringstream ss;
-                        ss << "[Cpplab Renderer] During WIC Image Decoder Frame Retrieval: Failed to retrieve image frame for file " <<
-                            wstr_to_utf8(imgElement->imageName);
-                        SafeRelease(&decoder);
-                        SafeRelease(&decFrame);
-                        throw std::runtime_error(ss.str());
-                    }
-
-                    IWICFormatConverter* converter = nullptr;
-                    hr = wicImgFactory->CreateFormatConverter(&converter);
-                    if (FAILED(hr)) {
-                        SafeRelease(&decoder);
-                        SafeRelease(&decFrame);
-                        SafeRelease(&converter);
-                        throw std::runtime_error("[Cpplab Renderer] During WIC Format Converter creation: Failed to create WICFormatConverter!");
-                    }
-
-                    hr = converter->Initialize(
-                        decFrame,
-                        GUID_WICPixelFormat32bppPBGRA,
-                        WICBitmapDitherTypeNone,
-                        NULL,
-                        0.f,
-                        WICBitmapPaletteTypeMedianCut
-                    );
-                    if (FAILED(hr)) {
-                        std::stringstream ss;
-                        ss << "[Cpplab Renderer] During WIC Format Converter creation: Failed to initialize WICFormatConverter for file" <<
-                            wstr_to_utf8(imgElement->imageName);
-                        SafeRelease(&decoder);
-                        SafeRelease(&decFrame);
-                        SafeRelease(&converter);
-                        throw std::runtime_error(ss.str());
-                    }
-
-                    hr = this->renderTarget->CreateBitmapFromWicBitmap(
-                        converter,
-                        NULL,
-                        &(elementData->image)
-                    );
-                    if (FAILED(hr)) {
-                        std::stringstream ss;
-                        ss << "[Cpplab Renderer] During WicBitmap to D2D Bitmap: Failed to create D2D bitmap for file " <<
-                            wstr_to_utf8(imgElement->imageName);
-                        SafeRelease(&decoder);
-                        SafeRelease(&decFrame);
-                        SafeRelease(&converter);
-                        throw std::runtime_error(ss.str());
-                    }
-                    SafeRelease(&decoder);
-                    SafeRelease(&decFrame);
-                    SafeRelease(&converter);
-                }
-                else if (imgElement->imgType == ImageType::RESOURCE) {
-                    // Locate the resource.
-                    HRSRC imageResHandle = FindResourceW(NULL,
-                        imgElement->imageName.c_str(),
-                        RT_BITMAP
-                    );
-                    if (!imageResHandle) {
-                        std::stringstream ss;
-                        ss << "[Cpplab Renderer] When finding resource named " <<
-                            wstr_to_utf8(imgElement->imageName) << ": Could not create resource handle.";
-                        throw std::runtime_error(ss.str());
-                    }
-
-                    HGLOBAL imageResDataHandle = LoadResource(NULL, imageResHandle);
-                    if (!imageResDataHandle) {
-                        std::stringstream ss;
-                        ss << "[Cpplab Renderer] When loading resource named " <<
-                            wstr_to_utf8(imgElement->imageName) << ": Could not create resource handle.";
-                        throw std::runtime_error(ss.str());
-                    }
-
-                    void* imgfile = LockResource(imageResDataHandle);
-                    if (!imgfile) {
-                        std::stringstream ss;
-                        ss << "[Cpplab Renderer] When locking resource named " <<
-                            wstr_to_utf8(imgElement->imageName) << ": Could not lock resource.";
-                        throw std::runtime_error(ss.str());
-                    }
-
-                    DWORD imgFileSize = SizeofResource(NULL, imageResHandle);
-                    if (!imgFileSize) {
-                        std::stringstream ss;
-                        ss << "[Cpplab Renderer] When retrieving resource size named " <<
-                            wstr_to_utf8(imgElement->imageName) << ": Could not get resource size.";
-                        throw std::runtime_error(ss.str());
-                    }
-
-                    IWICStream* wicstream = nullptr;
-                    HRESULT hr = this->wicImgFactory->CreateStream(&wicstream);
-                    if (FAILED(hr)) {
-                        std::stringstream ss;
-                        ss << "[Cpplab Renderer] When creating WICStream for resource named " <<
-                            wstr_to_utf8(imgElement->imageName) << ": Could not create stream.";
-                        throw std::runtime_error(ss.str());
-                    }
-
-                    hr = wicstream->InitializeFromMemory(
-                        reinterpret_cast<BYTE*>(imgfile),
-                        imgFileSize
-                    );
-                    if (FAILED(hr)) {
-                        std::stringstream ss;
-                        ss << "[Cpplab Renderer] When initializing WICStream for resource named " <<
-                            wstr_to_utf8(imgElement->imageName) << ": Could not initialize resource stream.";
-                        throw std::runtime_error(ss.str());
-                    }
-
-                    IWICBitmapDecoder* decoder = nullptr;
-                    hr = this->wicImgFactory->CreateDecoderFromStream(
-                        wicstream,
-                        NULL,
-                        WICDecodeMetadataCacheOnLoad,
-                        &decoder
-                    );
-                    if (FAILED(hr)) {
-                        std::stringstream ss;
-                        ss << "[Cpplab Renderer] During WIC Image Decoder Creation: Failed to create image decoder for resource " <<
-                            wstr_to_utf8(imgElement->imageName);
-                        SafeRelease(&decoder);
-                        throw std::runtime_error(ss.str());
-                    }
-
-                    IWICBitmapFrameDecode* decFrame;
-                    hr = decoder->GetFrame(0, &decFrame);
-                    if (FAILED(hr)) {
-                        std::stringstream ss;
-                        ss << "[Cpplab Renderer] During WIC Image Decoder Frame Retrieval: Failed to retrieve image frame for resource " <<
-                            wstr_to_utf8(imgElement->imageName);
-                        SafeRelease(&decoder);
-                        SafeRelease(&decFrame);
-                        throw std::runtime_error(ss.str());
-                    }
-
-                    IWICFormatConverter* converter = nullptr;
-                    hr = wicImgFactory->CreateFormatConverter(&converter);
-                    if (FAILED(hr)) {
-                        SafeRelease(&decoder);
-                        SafeRelease(&decFrame);
-                        SafeRelease(&converter);
-                        throw std::runtime_error("[Cpplab Renderer] During WIC Format Converter creation: Failed to create WICFormatConverter!");
-                    }
-
-                    hr = converter->Initialize(
-                        decFrame,
-                        GUID_WICPixelFormat32bppPBGRA,
-                        WICBitmapDitherTypeNone,
-                        NULL,
-                        0.f,
-                        WICBitmapPaletteTypeMedianCut
-                    );
-                    if (FAILED(hr)) {
-                        std::stringstream ss;
-                        ss << "[Cpplab Renderer] During WIC Format Converter creation: Failed to initialize WICFormatConverter for resource" <<
-                            wstr_to_utf8(imgElement->imageName);
-                        SafeRelease(&decoder);
-                        SafeRelease(&decFrame);
-                        SafeRelease(&converter);
-                        throw std::runtime_error(ss.str());
-                    }
-
-                    hr = this->renderTarget->CreateBitmapFromWicBitmap(
-                        converter,
-                        NULL,
-                        &(elementData->image)
-                    );
-                    if (FAILED(hr)) {
-                        std::stringstream ss;
-                        ss << "[Cpplab Renderer] During WicBitmap to D2D Bitmap: Failed to create D2D bitmap for resource " <<
-                            wstr_to_utf8(imgElement->imageName);
-                        SafeRelease(&decoder);
-                        SafeRelease(&decFrame);
-                        SafeRelease(&converter);
-                        throw std::runtime_error(ss.str());
-                    }
-                    SafeRelease(&decoder);
-                    SafeRelease(&decFrame);
-                    SafeRelease(&converter);
-                }
-            }
-
-            auto GenImageBox = [](vec2 dimensions, D2D1_SIZE_F imageDimensions, ImageFillMode mode) -> D2D1_RECT_F {
-                if (mode == ImageFillMode::FILL) { //stretch image to fill entire bounding box
-                    return D2D1::RectF(
-                        0.f, 0.f,
-                        dimensions.x, dimensions.y
-                    );
-                }
-                else if (mode == ImageFillMode::COVER) {  //image maintains aspect ratio and is guaranteed to cover all pixels of the bounding box
-                    //calculate ratio of image side lengths to box sides lengths
-                    vec2 imToBoxRatio = vec2(
-                        imageDimensions.width / dimensions.x,
-                        imageDimensions.height / dimensions.y
-                    );
-
-                    //scale by forcing the smaller ratio to reach one
-                    float recipr = imToBoxRatio.x < imToBoxRatio.y ?
-                        dimensions.x / imageDimensions.width :
-                        dimensions.y / imageDimensions.height;
-
-                    return D2D1::RectF(
-                        0.f, 0.f,
-                        imageDimensions.width * recipr, imageDimensions.height * recipr
-                    );
-                }
-                else if (mode == ImageFillMode::CONTAIN) { //image maintains aspect ratio and all pixels of the image are guaranteed to be present in the bounding box
-                    //calculate ratio of image side lengths to box sides lengths
-                    vec2 imToBoxRatio = vec2(
-                        imageDimensions.width / dimensions.x,
-                        imageDimensions.height / dimensions.y
-                    );
-                    //scale by forcing the larger ratio to reach one
-                    float recipr = imToBoxRatio.x > imToBoxRatio.y ?
-                        dimensions.x / imageDimensions.width :
-                        dimensions.y / imageDimensions.height;
-                    imToBoxRatio.x = imToBoxRatio.x * recipr;
-                    imToBoxRatio.y = imToBoxRatio.y * recipr;
-
-                    return D2D1::RectF(
-                        0.f, 0.f,
-                        imageDimensions.width*recipr, imageDimensions.height* recipr
-                    );
-                }
-            };
-
-
-            D2D1_RECT_F imgrect = GenImageBox(imgElement->dimensions, elementData->image->GetSize(), imgElement->getFillMode());
+        else if (type == NodeType::IMAGE) {
+            const ImageElementState& imgState = static_cast<const ImageElementState&>(*store.State(id));
+            RenderBitmap* image = this->displayList.GetElementBitmap(id);
+
+            //without a bitmap the image box is treated like a stretched image
+            const vec2 imgDimensions = vec2(imgState.width, imgState.height);
+            const vec2 imageSize = image != nullptr ? image->GetSize() : imgDimensions;
+            RectF imgrect = GenImageBox(imgDimensions, imageSize, imgState.fillMode);
             //calculate image position
+            const vec2 imgTruePos = truePos;
             vec2 imgpos = vec2(
-                (imgElement->getTruePosition().x + (imgElement->getDimensions().x / 2)) - (imgrect.right / 2),
-                (imgElement->getTruePosition().y + (imgElement->getDimensions().y / 2)) - (imgrect.bottom / 2)
+                (imgTruePos.x + (imgDimensions.x / 2)) - (imgrect.right / 2),
+                (imgTruePos.y + (imgDimensions.y / 2)) - (imgrect.bottom / 2)
             );
 
-            //other things
-            if (imgElement->modified) {
-                //building the box
-                if (imgElement->getBorderWrapMode() == BorderWrapMode::FIT_TO_BOUNDING_BOX) {
-                    elementData->boxShape = D2D1::RoundedRect(
-                        D2D1::RectF(0.f, 0.f,
-                            scaleDPI(imgElement->getDimensions().x), scaleDPI(imgElement->getDimensions().y)
-                        ),
-                        scaleDPI(imgElement->getRoundedEdgePx()), scaleDPI(imgElement->getRoundedEdgePx())
-                    );
-                }
-                else if (imgElement->getBorderWrapMode() == BorderWrapMode::FIT_TO_IMAGE) {
-                    elementData->boxShape = D2D1::RoundedRect(
-                        imgrect,
-                        scaleDPI(imgElement->getRoundedEdgePx()), scaleDPI(imgElement->getRoundedEdgePx())
-                    );
-                }
-
-                //building the clip mask
-                HRESULT hr = this->d2dFactory->CreatePathGeometry(&elementData->clipMask);
-                ID2D1GeometrySink* gmSink = nullptr;
-                if (SUCCEEDED(hr)) hr = elementData->clipMask->Open(&gmSink);
-                if (SUCCEEDED(hr)) {
-                    gmSink->SetFillMode(D2D1_FILL_MODE_WINDING);
-
-                    D2D1_POINT_2F tl = D2D1::Point2F(0.f, 0.f);
-                    D2D1_POINT_2F tr = D2D1::Point2F(elementData->boxShape.rect.right, 0.f);
-                    D2D1_POINT_2F br = D2D1::Point2F(elementData->boxShape.rect.right, elementData->boxShape.rect.bottom);
-                    D2D1_POINT_2F bl = D2D1::Point2F(0.f, elementData->boxShape.rect.bottom);
-
-                    gmSink->BeginFigure(tl, D2D1_FIGURE_BEGIN_FILLED);
-                    gmSink->AddLine(tr);
-                    gmSink->AddLine(br);
-                    gmSink->AddLine(bl);
-                    gmSink->EndFigure(D2D1_FIGURE_END_CLOSED);
-                    hr = gmSink->Close();
-                }
-                SafeRelease(&gmSink);
-                if (FAILED(hr)) {
-                    throw std::runtime_error("[Cpplab Renderer] During Image Clip Mask Generation: Failed to create clip mask!");
-                }
+            //building the box
+            RoundedRectF boxShape;
+            if (imgState.borderMode == BorderWrapMode::FIT_TO_BOUNDING_BOX) {
+                boxShape = RoundedRectF(
+                    RectF(0.f, 0.f,
+                        scaleDPI(imgDimensions.x), scaleDPI(imgDimensions.y)
+                    ),
+                    scaleDPI(imgState.roundedEdgePx), scaleDPI(imgState.roundedEdgePx)
+                );
+            }
+            else if (imgState.borderMode == BorderWrapMode::FIT_TO_IMAGE) {
+                boxShape = RoundedRectF(
+                    imgrect,
+                    scaleDPI(imgState.roundedEdgePx), scaleDPI(imgState.roundedEdgePx)
+                );
             }
+
             //draw
             //draw image then draw border on top
-            
-            vec2 imgTruePos = imgElement->getTruePosition();
-
-            this->renderTarget->SetTransform(D2D1::Matrix3x2F::Translation(
-                scaleDPI(imgpos.x),
-                scaleDPI(imgpos.y)
+            this->displayList.SetTransform(Transform2D::Translation(
+                scaleDPI(imgTruePos.x),
+                scaleDPI(imgTruePos.y)
             ));
 
-            this->renderTarget->PushLayer(
-                D2D1::LayerParameters(
-                    D2D1::InfiniteRect(),
-                    elementData->clipMask,
-                    D2D1_ANTIALIAS_MODE_PER_PRIMITIVE,
-                    D2D1::Matrix3x2F::Translation(
-                        scaleDPI(imgTruePos.x - imgpos.x), scaleDPI(imgTruePos.y - imgpos.y)
-                    ),
-                    1.0f,
-                    nullptr
-                ),
-                this->clipLayer
-            );
-            
-            
-            this->renderTarget->DrawBitmap(
-                elementData->image,
-                scaleDPI(imgrect),
-                1.0,
-                D2D1_BITMAP_INTERPOLATION_MODE_LINEAR
-            );
-            this->renderTarget->PopLayer();
+            if (image == nullptr && element->imagePending) {
+                this->displayList.FillRoundedRect(boxShape, Faded(this->imagePlaceholderColor, imgState.opacity));
+            }
+            else if (image != nullptr) {
+                //clip to the box, a cover image would spill out otherwise
+                this->displayList.PushClip(RectF(0.f, 0.f, boxShape.rect.right, boxShape.rect.bottom));
+                this->displayList.SetTransform(Transform2D::Translation(
+                    scaleDPI(imgpos.x),
+                    scaleDPI(imgpos.y)
+                ));
+                this->displayList.DrawBitmap(
+                    scaleDPI(imgrect),
+                    imgState.opacity
+                );
+                this->displayList.PopClip();
 
-            this->renderTarget->SetTransform(D2D1::Matrix3x2F::Translation(
-                scaleDPI(imgElement->getTruePosition().x),
-                scaleDPI(imgElement->getTruePosition().y)
-            ));
-            this->solidColorBrush->SetColor(ToD2D1Color(imgElement->getBorderColor()));
-            this->renderTarget->DrawRoundedRectangle(
-                D2D1::RoundedRect(
-                    elementData->boxShape.rect,
-                    elementData->boxShape.radiusX,
-                    elementData->boxShape.radiusY
-                ),
-                this->solidColorBrush,
-                imgElement->getBorderWidthPx()
+                this->displayList.SetTransform(Transform2D::Translation(
+                    scaleDPI(imgTruePos.x),
+                    scaleDPI(imgTruePos.y)
+                ));
+            }
+            this->displayList.StrokeRoundedRect(
+                boxShape,
+                Faded(imgState.borderColor, imgState.opacity),
+                imgState.borderWidthPx
             );
         }
+        else if (type == NodeType::PIXEL_BUFFER) {
+            PixelBufferElement* pixelElement = static_cast<PixelBufferElement*>(element->elementNode);
+            const PixelBufferState& state = static_cast<const PixelBufferState&>(*store.State(id));
+
+            //the bitmap is updated in place, so the commands stay valid while new frames come in
+            const vec2 dimensions = vec2(state.width, state.height);
+            const vec2 bufferSize = vec2(static_cast<float>(pixelElement->getPixelWidth()), static_cast<float>(pixelElement->getPixelHeight()));
+            const RectF imgrect = GenImageBox(dimensions, bufferSize, state.fillMode);
+
+            this->displayList.SetTransform(Transform2D::Translation(
+                scaleDPI(truePos.x),
+                scaleDPI(truePos.y)
+            ));
+            this->displayList.PushClip(RectF(0.f, 0.f, scaleDPI(dimensions.x), scaleDPI(dimensions.y)));
+            this->displayList.SetTransform(Transform2D::Translation(
+                scaleDPI(truePos.x + dimensions.x / 2 - imgrect.right / 2),
+                scaleDPI(truePos.y + dimensions.y / 2 - imgrect.bottom / 2)
+            ));
+            this->displayList.DrawBitmap(scaleDPI(imgrect), state.opacity);
+            this->displayList.PopClip();
+        }
+        this->displayList.EndElement();
+        element->commandsStale = false;
+        ++this->rebuildStats.elementsRecorded;
     }
 
-    float WindowD2DRenderer::scaleDPI(float val) {
-        return (val * 96.f)/this->dpi;
-    }
-    D2D1_RECT_F WindowD2DRenderer::scaleDPI(D2D1_RECT_F rect) {
-        return D2D1::RectF(
-            (rect.left * 96.f) / this->dpi,
-            (rect.top * 96.f) / this->dpi,
-            (rect.right * 96.f) / this->dpi,
-            (rect.bottom * 96.f) / this->dpi
-        );
-    }
-    D2D1_POINT_2F WindowD2DRenderer::scaleDPI(D2D1_POINT_2F point) {
-        return D2D1::Point2F(
-            scaleDPI(point.x),
-            scaleDPI(point.y)
-        );
+    RectF SceneRenderer::GetElementVisualBounds(NodeRenderData* element) {
+        ElementStore& store = ElementStore::Instance();
+        const uint32_t id = element->handle.index;
+        const NodeType type = store.Type(id);
+        if (type == NodeType::BASE_ELEMENT) return RectF(); //draws nothing
+
+        const vec2 pos = vec2(store.WorldX(id), store.WorldY(id));
+        const vec2 dim = vec2(store.Width(id), store.Height(id));
+        RectF bounds = RectF(pos.x, pos.y, pos.x + dim.x, pos.y + dim.y);
+
+        //strokes are centered on the box edge, pad by the full width plus a pixel for antialiasing
+        const float pxPerDip = this->dpi / 96.f;
+        if (type == NodeType::TEXT_AREA) {
+            return bounds.Inflate(static_cast<const TextElementState*>(store.State(id))->borderWidthPx * pxPerDip + 1.f);
+        }
+        if (type == NodeType::IMAGE) {
+            const ImageElementState& imgState = static_cast<const ImageElementState&>(*store.State(id));
+            RenderBitmap* image = this->displayList.GetElementBitmap(id);
+            //a cover image can spill out of the box, it is centered the same way RecordElement does
+            if (image != nullptr) {
+                const RectF imgrect = GenImageBox(dim, image->GetSize(), imgState.fillMode);
+                const vec2 center = vec2(pos.x + dim.x / 2, pos.y + dim.y / 2);
+                bounds = bounds.Union(RectF(
+                    center.x - imgrect.right / 2, center.y - imgrect.bottom / 2,
+                    center.x + imgrect.right / 2, center.y + imgrect.bottom / 2
+                ));
+                //a border fit to the image uses the unscaled image box, so it grows with the dpi
+                if (imgState.borderMode == BorderWrapMode::FIT_TO_IMAGE) {
+                    bounds = bounds.Union(RectF(pos.x, pos.y, pos.x + imgrect.right * pxPerDip, pos.y + imgrect.bottom * pxPerDip));
+                }
+            }
+            return bounds.Inflate(imgState.borderWidthPx * pxPerDip + 1.f);
+        }
+        if (type == NodeType::PIXEL_BUFFER) {
+            //clipped to the box and without a border
+            return bounds.Inflate(1.f);
+        }
+        return bounds;
     }
-}
\ No newline at end of file
+}
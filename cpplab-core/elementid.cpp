@@ -0,0 +1,135 @@
+#include <bit>
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include "elementid.hpp"
+
+namespace cpplab {
+    ElementIdTable::ElementIdTable() {
+        //atom 0 is the empty id
+        this->chunks[0] = std::make_unique<std::string[]>(ChunkSize);
+        this->count = 1;
+    }
+    ElementIdTable& ElementIdTable::Instance() {
+        static ElementIdTable table;
+        return table;
+    }
+
+    ElementId ElementIdTable::Find(std::string_view name) const {
+        if (name.empty()) return ElementId();
+        std::shared_lock<std::shared_mutex> guard(this->lock);
+        auto atom = this->atoms.find(name);
+        return atom == this->atoms.end() ? ElementId() : ElementId{ atom->second };
+    }
+    ElementId ElementIdTable::Intern(std::string_view name) {
+        if (name.empty()) return ElementId();
+        const ElementId found = this->Find(name);
+        if (found.IsValid()) return found;
+
+        std::unique_lock<std::shared_mutex> guard(this->lock);
+        //interned by another thread between the two locks
+        auto atom = this->atoms.find(name);
+        if (atom != this->atoms.end()) return ElementId{ atom->second };
+
+        const uint32_t next = this->count;
+        if ((next >> ChunkShift) >= MaxChunks) {
+            throw std::runtime_error("[Cpplab Elements] During ID Interning: Element id table is full!");
+        }
+        std::unique_ptr<std::string[]>& chunk = this->chunks[next >> ChunkShift];
+        if (!chunk) chunk = std::make_unique<std::string[]>(ChunkSize);
+        std::string& stored = chunk[next & ChunkMask];
+        stored.assign(name);
+        this->atoms.emplace(std::string_view(stored), next);
+        ++this->count;
+        return ElementId{ next };
+    }
+    size_t ElementIdTable::Size() const {
+        std::shared_lock<std::shared_mutex> guard(this->lock);
+        return this->count - 1;
+    }
+
+    size_t ChildTable::FindSlot(ElementId id) const {
+        const size_t mask = this->slots.size() - 1;
+        for (size_t slot = this->Home(id);; slot = (slot + 1) & mask) {
+            const uint32_t stored = this->slots[slot];
+            if (stored == EmptySlot) return this->slots.size();
+            if (this->entries[stored - 1].id == id) return slot;
+        }
+    }
+    size_t ChildTable::FindPosition(ElementId id) const {
+        if (this->slots.empty()) {
+            for (size_t i = 0; i < this->entries.size(); ++i) {
+                if (this->entries[i].id == id) return i;
+            }
+            return this->entries.size();
+        }
+        const size_t slot = this->FindSlot(id);
+        return slot == this->slots.size() ? this->entries.size() : this->slots[slot] - 1;
+    }
+    void ChildTable::Place(uint32_t position) {
+        const size_t mask = this->slots.size() - 1;
+        size_t slot = this->Home(this->entries[position].id);
+        while (this->slots[slot] != EmptySlot) slot = (slot + 1) & mask;
+        this->slots[slot] = position + 1;
+    }
+    void ChildTable::Rehash(size_t capacity) {
+        //kept at most half full so probes stay short
+        capacity = std::bit_ceil((std::max)(capacity, LinearLimit * 4));
+        this->slots.assign(capacity, EmptySlot);
+        this->shift = 32 - static_cast<uint32_t>(std::countr_zero(capacity));
+        for (uint32_t position = 0; position < this->entries.size(); ++position) {
+            this->Place(position);
+        }
+    }
+
+    ElementNode* ChildTable::Find(ElementId id) const {
+        const size_t position = this->FindPosition(id);
+        return position == this->entries.size() ? nullptr : this->entries[position].element;
+    }
+    bool ChildTable::Insert(ElementId id, ElementNode* element) {
+        if (this->Contains(id)) return false;
+        this->entries.push_back(ChildEntry{ id, element });
+        if (this->slots.empty()) {
+            if (this->entries.size() > LinearLimit) this->Rehash(this->entries.size() * 2);
+        }
+        else if (this->entries.size() * 2 > this->slots.size()) {
+            this->Rehash(this->slots.size() * 2);
+        }
+        else {
+            this->Place(static_cast<uint32_t>(this->entries.size() - 1));
+        }
+        return true;
+    }
+    ElementNode* ChildTable::Erase(ElementId id) {
+        const size_t position = this->FindPosition(id);
+        if (position == this->entries.size()) return nullptr;
+        ElementNode* removed = this->entries[position].element;
+        const size_t last = this->entries.size() - 1;
+
+        if (!this->slots.empty()) {
+            const size_t mask = this->slots.size() - 1;
+            //backward shift, every entry after the hole that may live earlier moves into it, no tombstones
+            size_t hole = this->FindSlot(id);
+            for (size_t next = (hole + 1) & mask; this->slots[next] != EmptySlot; next = (next + 1) & mask) {
+                const size_t home = this->Home(this->entries[this->slots[next] - 1].id);
+                if (((next - home) & mask) >= ((next - hole) & mask)) {
+                    this->slots[hole] = this->slots[next];
+                    hole = next;
+                }
+            }
+            this->slots[hole] = EmptySlot;
+            //the last entry moves into the gap, its slot follows
+            if (position != last) {
+                size_t slot = this->FindSlot(this->entries[last].id);
+                this->slots[slot] = static_cast<uint32_t>(position + 1);
+            }
+        }
+        this->entries[position] = this->entries[last];
+        this->entries.pop_back();
+        return removed;
+    }
+    void ChildTable::Reserve(size_t count) {
+        this->entries.reserve(count);
+        if (count > LinearLimit && count * 2 > this->slots.size()) this->Rehash(count * 2);
+    }
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <span>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace cpplab {
+    class ElementNode;
+
+    //an interned element id, compared and hashed as one integer
+    //the same name always interns to the same id, the empty id is no name
+    struct ElementId {
+        uint32_t atom = 0;
+
+        bool IsValid() const {
+            return this->atom != 0;
+        }
+        bool operator==(const ElementId& rhs) const {
+            return this->atom == rhs.atom;
+        }
+        bool operator!=(const ElementId& rhs) const {
+            return this->atom != rhs.atom;
+        }
+    };
+
+    //every id name ever used, names are never freed so an id stays valid for the life of the program
+    //names live in chunks that never move, so reading a name takes no lock
+    class ElementIdTable {
+    public:
+        static constexpr uint32_t ChunkShift = 12;
+        static constexpr uint32_t ChunkSize = 1u << ChunkShift;
+        static constexpr uint32_t ChunkMask = ChunkSize - 1;
+        static constexpr uint32_t MaxChunks = 4096;
+
+    private:
+        mutable std::shared_mutex lock;
+        //views into the chunks
+        std::unordered_map<std::string_view, uint32_t> atoms;
+        std::unique_ptr<std::string[]> chunks[MaxChunks];
+        uint32_t count = 0;
+
+    public:
+        ElementIdTable();
+        ElementIdTable(const ElementIdTable&) = delete;
+        ElementIdTable& operator=(const ElementIdTable&) = delete;
+
+        static ElementIdTable& Instance();
+
+        //any thread, the id of the name, interning it the first time
+        //throws std::runtime_error once the table is full
+        ElementId Intern(std::string_view name);
+        //any thread, the id of the name or the empty id if it was never interned, never adds to the table
+        ElementId Find(std::string_view name) const;
+        //any thread, the empty string for the empty id
+        const std::string& Name(ElementId id) const {
+            return this->chunks[id.atom >> ChunkShift][id.atom & ChunkMask];
+        }
+        size_t Size() const;
+    };
+
+    struct ChildEntry {
+        ElementId id;
+        ElementNode* element;
+    };
+
+    //children of one element by id
+    //entries are dense and keep insertion order until a removal moves the last entry into the gap
+    //small tables are searched linearly, from LinearLimit children on an open addressed index over the ids is kept
+    class ChildTable {
+    private:
+        static constexpr size_t LinearLimit = 8;
+        static constexpr uint32_t EmptySlot = 0;
+
+        std::vector<ChildEntry> entries;
+        //position in entries plus one, EmptySlot when free, linear probing with backward shift removal
+        std::vector<uint32_t> slots;
+        uint32_t shift = 32;
+
+        size_t Home(ElementId id) const {
+            return static_cast<size_t>((id.atom * 0x9E3779B9u) >> this->shift);
+        }
+        //the slot holding id, or slots.size() when it is not there
+        size_t FindSlot(ElementId id) const;
+        size_t FindPosition(ElementId id) const;
+        void Rehash(size_t capacity);
+        void Place(uint32_t position);
+
+    public:
+        ElementNode* Find(ElementId id) const;
+        bool Contains(ElementId id) const {
+            return this->FindPosition(id) != this->entries.size();
+        }
+        //false and nothing changed when the id is taken
+        bool Insert(ElementId id, ElementNode* element);
+        //the element removed, null when there was none
+        ElementNode* Erase(ElementId id);
+        void Reserve(size_t count);
+        size_t Size() const {
+            return this->entries.size();
+        }
+        std::span<const ChildEntry> Entries() const {
+            return std::span<const ChildEntry>(this->entries.data(), this->entries.size());
+        }
+    };
+}
@@ -0,0 +1,88 @@
+#include <bit>
+#include <algorithm>
+#include "elementpathindex.hpp"
+
+namespace cpplab {
+    ElementPathIndex::ElementPathIndex(ElementNode* root) : root(root), store(ElementStore::Instance()) {
+        if (root == nullptr) {
+            throw std::runtime_error("[Cpplab Elements] During Path Index Creation: A root element is required!");
+        }
+    }
+
+    void ElementPathIndex::Insert(uint64_t hash, uint32_t index) {
+        const size_t mask = this->slots.size() - 1;
+        size_t slot = static_cast<size_t>(hash) & mask;
+        while (this->slots[slot].index != EmptySlot) slot = (slot + 1) & mask;
+        this->slots[slot] = Slot{ hash, index };
+    }
+
+    void ElementPathIndex::Rebuild() {
+        const ElementIdTable& ids = ElementIdTable::Instance();
+        const uint32_t rootIndex = this->root->getHandle().index;
+        this->collected.clear();
+        //edits made while walking are seen by the next lookup
+        this->builtEdits = this->store.StructureEdits();
+        this->store.VisitStagedSubtree(rootIndex, [this, rootIndex, &ids](uint32_t index, uint32_t parent) {
+            if (index >= this->pathHashes.size()) {
+                const size_t size = (std::max)(static_cast<size_t>(index) + 1, this->pathHashes.size() * 2);
+                this->pathHashes.resize(size);
+                this->indexed.resize(size);
+            }
+            if (parent == ElementStore::InvalidIndex) {
+                this->pathHashes[index] = EmptyPathHash;
+                this->indexed[index] = true;
+                return;
+            }
+            //parents come before their children, so the parent's entries were written by this walk
+            const ElementId id{ this->store.IdAtom(index) };
+            this->indexed[index] = this->indexed[parent] && id.IsValid();
+            if (!this->indexed[index]) return;
+            uint64_t hash = this->pathHashes[parent];
+            if (parent != rootIndex) hash = HashBytes(hash, "/");
+            hash = HashBytes(hash, ids.Name(id));
+            this->pathHashes[index] = hash;
+            this->collected.push_back(Slot{ hash, index });
+        });
+
+        const size_t capacity = std::bit_ceil((std::max)(this->collected.size() * 2, size_t(16)));
+        this->slots.assign(capacity, Slot{ 0, EmptySlot });
+        for (const Slot& entry : this->collected) {
+            this->Insert(entry.hash, entry.index);
+        }
+        this->stats.entries = this->collected.size();
+        ++this->stats.rebuilds;
+        this->built = true;
+    }
+
+    ElementNode* ElementPathIndex::Resolve(std::string_view path) {
+        if (!this->built || this->builtEdits != this->store.StructureEdits()) this->Rebuild();
+        ++this->stats.lookups;
+        if (path.empty()) return this->root;
+
+        //one pass over the path, keeping the hash of everything before the last segment
+        uint64_t hash = EmptyPathHash;
+        uint64_t parentHash = EmptyPathHash;
+        size_t lastSegment = 0;
+        for (size_t i = 0; i < path.size(); ++i) {
+            if (path[i] == '/') {
+                parentHash = hash;
+                lastSegment = i + 1;
+            }
+            hash = (hash ^ static_cast<uint8_t>(path[i])) * HashPrime;
+        }
+        const std::string_view name = path.substr(lastSegment);
+        if (name.empty()) return nullptr;
+
+        const ElementIdTable& ids = ElementIdTable::Instance();
+        const size_t mask = this->slots.size() - 1;
+        for (size_t slot = static_cast<size_t>(hash) & mask;; slot = (slot + 1) & mask) {
+            const Slot& entry = this->slots[slot];
+            if (entry.index == EmptySlot) return nullptr;
+            if (entry.hash == hash && ids.Name(ElementId{ this->store.IdAtom(entry.index) }) == name &&
+                this->pathHashes[this->store.Parent(entry.index)] == parentHash) {
+                return this->store.Owner(entry.index);
+            }
+            ++this->stats.extraProbes;
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+#include "engineelements.hpp"
+
+namespace cpplab {
+    struct ElementPathIndexStats {
+        size_t entries = 0;
+        uint64_t rebuilds = 0;
+        uint64_t lookups = 0;
+        //slots looked at past the first, collisions of the table, not of paths
+        uint64_t extraProbes = 0;
+    };
+
+    //resolves a path of ids below a root, "sidebar/list/row42", with one probe of a hash table over the whole subtree
+    //a path is keyed by a 64 bit hash built segment by segment, a child's hash carries on from its parent's
+    //a hit is checked by comparing the last segment with the node's id and the rest of the path with the parent's hash
+    //the table is rebuilt on the next lookup after any node of any tree gained or lost a child, see ElementStore::StructureEdits
+    //nodes without an id are left out along with everything below them
+    //use it from the thread that adds and removes the elements, the element returned is only good until the next edit
+    class ElementPathIndex {
+    private:
+        static constexpr uint64_t EmptyPathHash = 14695981039346656037ull;
+        static constexpr uint64_t HashPrime = 1099511628211ull;
+        static constexpr uint32_t EmptySlot = ElementStore::InvalidIndex;
+
+        struct Slot {
+            uint64_t hash;
+            uint32_t index;
+        };
+
+        ElementNode* root;
+        ElementStore& store;
+        //slots sized to a power of two at most half full
+        std::vector<Slot> slots;
+        //path hash of every store slot visited by the last rebuild, by store index, and whether it was indexed
+        std::vector<uint64_t> pathHashes;
+        std::vector<uint8_t> indexed;
+        //kept between rebuilds so a rebuild of a tree no larger than before allocates nothing
+        std::vector<Slot> collected;
+        uint64_t builtEdits = 0;
+        bool built = false;
+        ElementPathIndexStats stats;
+
+        static uint64_t HashBytes(uint64_t hash, std::string_view bytes) {
+            for (const char c : bytes) {
+                hash = (hash ^ static_cast<uint8_t>(c)) * HashPrime;
+            }
+            return hash;
+        }
+        void Rebuild();
+        void Insert(uint64_t hash, uint32_t index);
+
+    public:
+        ElementPathIndex(ElementNode* root);
+        ElementPathIndex(const ElementPathIndex&) = delete;
+        ElementPathIndex& operator=(const ElementPathIndex&) = delete;
+
+        //segments are the ids the elements were added under, separated by '/', the empty path is the root
+        //null when nothing is at that path, never allocates once the table has been built for the current tree
+        ElementNode* Resolve(std::string_view path);
+        ElementPathIndexStats GetStats() const {
+            return this->stats;
+        }
+    };
+}
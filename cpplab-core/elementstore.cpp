@@ -0,0 +1,508 @@
+#include "elementstore.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <iterator>
+
+namespace cpplab {
+    ElementStore::~ElementStore() {
+        for (uint32_t c = 0; c < this->chunkCount; ++c) {
+            delete this->chunks[c];
+        }
+    }
+
+    ElementStore& ElementStore::Instance() {
+        static ElementStore store;
+        return store;
+    }
+
+    ElementHandle ElementStore::Allocate(ElementNode* owner, NodeType type) {
+        std::lock_guard<std::mutex> guard(this->structureLock);
+
+        uint32_t index;
+        if (!this->freeSlots.empty()) {
+            index = this->freeSlots.back();
+            this->freeSlots.pop_back();
+        }
+        else {
+            if ((this->slotHighWater >> ChunkShift) >= this->chunkCount) {
+                if (this->chunkCount == MaxChunks) {
+                    throw std::runtime_error("[Cpplab Element Store] During slot allocation: Element store is full!");
+                }
+                Chunk* chunk = new Chunk();
+                std::fill(std::begin(chunk->publishedRoot), std::end(chunk->publishedRoot), InvalidIndex);
+                this->chunks[this->chunkCount] = chunk;
+                ++this->chunkCount;
+            }
+            index = this->slotHighWater++;
+        }
+
+        //the published fields keep describing the previous occupant until the next publish
+        Chunk& chunk = *this->GetChunk(index);
+        const uint32_t slot = index & ChunkMask;
+        chunk.stagedState[slot].Store(nullptr);
+        chunk.dirtyMask[slot] = DIRTY_ALL;
+        chunk.subtreeDirty[slot] = true;
+        chunk.worldStale[slot] = true;
+        chunk.transformPending[slot] = true;
+        chunk.boundsStale[slot] = false;
+        chunk.parent[slot] = InvalidIndex;
+        chunk.firstChild[slot] = InvalidIndex;
+        chunk.lastChild[slot] = InvalidIndex;
+        chunk.nextSibling[slot] = InvalidIndex;
+        chunk.prevSibling[slot] = InvalidIndex;
+        chunk.root[slot] = index;
+        chunk.idAtom[slot].store(0, std::memory_order_relaxed);
+        chunk.type[slot] = type;
+        chunk.live[slot] = true;
+        chunk.owner[slot] = owner;
+        this->JournalStructure(index);
+
+        return ElementHandle{ index, chunk.generation[slot] };
+    }
+    void ElementStore::Free(ElementHandle handle) {
+        std::lock_guard<std::mutex> guard(this->structureLock);
+        if (!handle.IsValid() || handle.index >= this->slotHighWater) return;
+
+        Chunk& chunk = *this->GetChunk(handle.index);
+        const uint32_t slot = handle.index & ChunkMask;
+        if (!chunk.live[slot] || chunk.generation[slot] != handle.generation) return;
+
+        //unlink from the parent and orphan every child, children become their own roots
+        this->Unlink(handle.index);
+        uint32_t child = chunk.firstChild[slot];
+        while (child != InvalidIndex) {
+            Chunk& childChunk = *this->GetChunk(child);
+            const uint32_t next = childChunk.nextSibling[child & ChunkMask];
+            childChunk.parent[child & ChunkMask] = InvalidIndex;
+            childChunk.nextSibling[child & ChunkMask] = InvalidIndex;
+            childChunk.prevSibling[child & ChunkMask] = InvalidIndex;
+            childChunk.worldStale[child & ChunkMask] = true;
+            childChunk.transformPending[child & ChunkMask] = true;
+            this->RelabelSubtreeRoot(child, child);
+            child = next;
+        }
+
+        chunk.live[slot] = false;
+        chunk.owner[slot] = nullptr;
+        chunk.stagedState[slot].Store(nullptr);
+        chunk.firstChild[slot] = InvalidIndex;
+        chunk.lastChild[slot] = InvalidIndex;
+        ++chunk.generation[slot];
+        this->structureEdits.fetch_add(1, std::memory_order_release);
+        this->freeSlots.push_back(handle.index);
+        this->JournalStructure(handle.index);
+    }
+    ElementNode* ElementStore::Resolve(ElementHandle handle) {
+        std::lock_guard<std::mutex> guard(this->structureLock);
+        if (!handle.IsValid() || handle.index >= this->slotHighWater) return nullptr;
+
+        Chunk& chunk = *this->GetChunk(handle.index);
+        const uint32_t slot = handle.index & ChunkMask;
+        if (!chunk.live[slot] || chunk.generation[slot] != handle.generation) return nullptr;
+        return chunk.owner[slot];
+    }
+
+    void ElementStore::RelabelSubtreeRoot(uint32_t subtreeIndex, uint32_t newRoot) {
+        this->WalkSubtreeLocked(subtreeIndex, [this, newRoot](uint32_t index) {
+            Chunk& chunk = *this->GetChunk(index);
+            const uint32_t slot = index & ChunkMask;
+            //the published trees learn about the move on the next publish
+            if (chunk.root[slot] != newRoot) this->JournalStructure(index);
+            chunk.root[slot] = newRoot;
+        });
+    }
+    void ElementStore::Unlink(uint32_t index) {
+        Chunk& chunk = *this->GetChunk(index);
+        const uint32_t slot = index & ChunkMask;
+        const uint32_t parent = chunk.parent[slot];
+        if (parent == InvalidIndex) return;
+
+        Chunk& parentChunk = *this->GetChunk(parent);
+        const uint32_t prev = chunk.prevSibling[slot];
+        const uint32_t next = chunk.nextSibling[slot];
+        if (prev != InvalidIndex) this->GetChunk(prev)->nextSibling[prev & ChunkMask] = next;
+        else parentChunk.firstChild[parent & ChunkMask] = next;
+        if (next != InvalidIndex) this->GetChunk(next)->prevSibling[next & ChunkMask] = prev;
+        else parentChunk.lastChild[parent & ChunkMask] = prev;
+
+        chunk.parent[slot] = InvalidIndex;
+        chunk.prevSibling[slot] = InvalidIndex;
+        chunk.nextSibling[slot] = InvalidIndex;
+        chunk.worldStale[slot] = true;
+        chunk.transformPending[slot] = true;
+        this->RelabelSubtreeRoot(index, index);
+        this->structureEdits.fetch_add(1, std::memory_order_release);
+    }
+
+    AttachResult ElementStore::Attach(uint32_t parentIndex, uint32_t childIndex, uint32_t idAtom) {
+        std::lock_guard<std::mutex> guard(this->structureLock);
+        if (this->Parent(childIndex) != InvalidIndex) return AttachResult::ALREADY_PARENTED;
+        if (this->IsAncestorLocked(childIndex, parentIndex)) return AttachResult::CYCLE;
+
+        Chunk& parentChunk = *this->GetChunk(parentIndex);
+        Chunk& childChunk = *this->GetChunk(childIndex);
+        const uint32_t parentSlot = parentIndex & ChunkMask;
+        const uint32_t childSlot = childIndex & ChunkMask;
+
+        this->LinkLast(parentIndex, childIndex);
+        childChunk.idAtom[childSlot].store(idAtom, std::memory_order_release);
+        this->structureEdits.fetch_add(1, std::memory_order_release);
+
+        this->RelabelSubtreeRoot(childIndex, parentChunk.root[parentSlot]);
+        if (childChunk.subtreeDirty[childSlot]) this->PropagateSubtreeDirty(parentIndex);
+        childChunk.worldStale[childSlot] = true;
+        childChunk.transformPending[childSlot] = true;
+        this->PropagateTransformPending(parentIndex);
+        return AttachResult::ATTACHED;
+    }
+    AttachResult ElementStore::AttachBatch(uint32_t targetIndex, const std::vector<uint32_t>& parents, const std::vector<uint32_t>& children, const std::vector<uint32_t>& idAtoms) {
+        std::lock_guard<std::mutex> guard(this->structureLock);
+        for (const uint32_t child : children) {
+            if (this->Parent(child) != InvalidIndex) return AttachResult::ALREADY_PARENTED;
+        }
+        //every child is unparented, so one that is an ancestor of target has to be the top of target's chain
+        uint32_t top = targetIndex;
+        while (this->Parent(top) != InvalidIndex) top = this->Parent(top);
+        for (const uint32_t child : children) {
+            if (child == top) return AttachResult::CYCLE;
+        }
+        if (children.empty()) return AttachResult::ATTACHED;
+
+        for (size_t i = 0; i < children.size(); ++i) {
+            this->LinkLast(parents[i], children[i]);
+            Chunk& childChunk = *this->GetChunk(children[i]);
+            childChunk.idAtom[children[i] & ChunkMask].store(idAtoms[i], std::memory_order_release);
+            childChunk.worldStale[children[i] & ChunkMask] = true;
+        }
+        this->structureEdits.fetch_add(1, std::memory_order_release);
+
+        const uint32_t targetRoot = this->GetChunk(targetIndex)->root[targetIndex & ChunkMask];
+        //children come after their parents, walking backwards carries the bits of a subtree up before its root is seen
+        bool subtreeDirty = false;
+        for (size_t i = children.size(); i-- > 0;) {
+            const uint32_t child = children[i];
+            Chunk& childChunk = *this->GetChunk(child);
+            const uint32_t childSlot = child & ChunkMask;
+            childChunk.transformPending[childSlot] = true;
+            const bool dirty = childChunk.subtreeDirty[childSlot];
+            if (parents[i] == targetIndex) {
+                this->RelabelSubtreeRoot(child, targetRoot);
+                subtreeDirty = subtreeDirty || dirty;
+            }
+            else if (dirty) {
+                this->GetChunk(parents[i])->subtreeDirty[parents[i] & ChunkMask] = true;
+            }
+        }
+        if (subtreeDirty) this->PropagateSubtreeDirty(targetIndex);
+        this->PropagateTransformPending(targetIndex);
+        return AttachResult::ATTACHED;
+    }
+    void ElementStore::LinkLast(uint32_t parentIndex, uint32_t childIndex) {
+        Chunk& parentChunk = *this->GetChunk(parentIndex);
+        Chunk& childChunk = *this->GetChunk(childIndex);
+        const uint32_t parentSlot = parentIndex & ChunkMask;
+        const uint32_t childSlot = childIndex & ChunkMask;
+
+        //append so children keep insertion order
+        const uint32_t last = parentChunk.lastChild[parentSlot];
+        childChunk.parent[childSlot] = parentIndex;
+        childChunk.prevSibling[childSlot] = last;
+        childChunk.nextSibling[childSlot] = InvalidIndex;
+        if (last != InvalidIndex) this->GetChunk(last)->nextSibling[last & ChunkMask] = childIndex;
+        else parentChunk.firstChild[parentSlot] = childIndex;
+        parentChunk.lastChild[parentSlot] = childIndex;
+    }
+    void ElementStore::Detach(uint32_t childIndex) {
+        std::lock_guard<std::mutex> guard(this->structureLock);
+        this->Unlink(childIndex);
+    }
+    bool ElementStore::IsAncestor(uint32_t ancestorIndex, uint32_t index) {
+        std::lock_guard<std::mutex> guard(this->structureLock);
+        return this->IsAncestorLocked(ancestorIndex, index);
+    }
+    bool ElementStore::IsAncestorLocked(uint32_t ancestorIndex, uint32_t index) {
+        for (uint32_t current = index; current != InvalidIndex; current = this->Parent(current)) {
+            if (current == ancestorIndex) return true;
+        }
+        return false;
+    }
+
+    size_t ElementStore::CountTree(uint32_t rootIndex) {
+        std::lock_guard<std::mutex> guard(this->structureLock);
+        if (this->Root(rootIndex) != rootIndex) return 0;
+        size_t count = 0;
+        this->WalkSubtreeLocked(rootIndex, [&count](uint32_t) { ++count; });
+        return count;
+    }
+    size_t ElementStore::CountSubtree(uint32_t index) {
+        std::lock_guard<std::mutex> guard(this->structureLock);
+        size_t count = 0;
+        this->WalkSubtreeLocked(index, [&count](uint32_t) { ++count; });
+        return count;
+    }
+    void ElementStore::CollectTree(uint32_t rootIndex, std::vector<ElementNode*>& out) {
+        std::lock_guard<std::mutex> guard(this->structureLock);
+        out.clear();
+        if (this->Root(rootIndex) != rootIndex) return;
+        this->WalkSubtreeLocked(rootIndex, [this, &out](uint32_t index) { out.push_back(this->Owner(index)); });
+    }
+    void ElementStore::CollectTreeIndices(uint32_t rootIndex, std::vector<uint32_t>& out) {
+        //chunks created after the last publish are not looked at, so no lock is needed
+        out.clear();
+        for (uint32_t c = 0; c < this->publishedChunkCount; ++c) {
+            const Chunk& chunk = *this->chunks[c];
+            for (uint32_t slot = 0; slot < ChunkSize; ++slot) {
+                if (chunk.publishedRoot[slot] == rootIndex) {
+                    out.push_back((c << ChunkShift) | slot);
+                }
+            }
+        }
+    }
+    void ElementStore::CollectChildren(uint32_t parentIndex, std::vector<ElementNode*>& out) {
+        std::lock_guard<std::mutex> guard(this->structureLock);
+        out.clear();
+        for (uint32_t child = this->FirstChild(parentIndex); child != InvalidIndex; child = this->NextSibling(child)) {
+            out.push_back(this->Owner(child));
+        }
+    }
+    void ElementStore::CollectChildHandles(uint32_t parentIndex, std::vector<ElementHandle>& out) {
+        std::lock_guard<std::mutex> guard(this->structureLock);
+        out.clear();
+        for (uint32_t child = this->FirstChild(parentIndex); child != InvalidIndex; child = this->NextSibling(child)) {
+            out.push_back(ElementHandle{ child, this->Generation(child) });
+        }
+    }
+
+    void ElementStore::PropagateSubtreeDirty(uint32_t index) {
+        uint64_t writes = 0;
+        for (uint32_t current = index; current != InvalidIndex; current = this->Parent(current)) {
+            //once an ancestor is marked everything above it is marked as well
+            if (this->GetChunk(current)->subtreeDirty[current & ChunkMask].exchange(true)) break;
+            ++writes;
+        }
+        this->dirtyMarkSlotWrites.fetch_add(writes, std::memory_order_relaxed);
+    }
+    void ElementStore::MarkModified(uint32_t index, uint32_t dirtyFlags) {
+        this->GetChunk(index)->dirtyMask[index & ChunkMask].fetch_or(dirtyFlags);
+        this->PropagateSubtreeDirty(index);
+    }
+    bool ElementStore::IsSubtreeDirty(uint32_t index) {
+        this->dirtyChecks.fetch_add(1, std::memory_order_relaxed);
+        this->dirtyCheckSlotReads.fetch_add(1, std::memory_order_relaxed);
+        return this->GetChunk(index)->subtreeDirty[index & ChunkMask];
+    }
+    void ElementStore::JournalStructure(uint32_t index) {
+        bool& journaled = this->GetChunk(index)->structureJournaled[index & ChunkMask];
+        if (journaled) return;
+        journaled = true;
+        this->structureJournal.push_back(index);
+    }
+
+    bool ElementStore::Publish(uint32_t rootIndex) {
+        std::lock_guard<std::mutex> guard(this->structureLock);
+        this->publishedCapacity = this->slotHighWater;
+        this->publishedChunkCount = this->chunkCount;
+
+        //states first so a node joining the tree is published together with its membership
+        const size_t published = this->PublishDirtySubtree(rootIndex);
+        const bool structureChanged = this->PublishStructure(rootIndex);
+        this->UpdateWorldTransforms(rootIndex);
+        if (structureChanged) ++this->structureVersion;
+        return published > 0 || structureChanged;
+    }
+    size_t ElementStore::PublishDirtySubtree(uint32_t rootIndex) {
+        size_t visited = 0;
+        size_t published = 0;
+
+        //only descend into children that are marked, clean subtrees are skipped entirely
+        //the subtree bit is cleared before the mask is taken, a setter racing with this marks the tree again for the next publish
+        this->clearStack.clear();
+        if (this->GetChunk(rootIndex)->subtreeDirty[rootIndex & ChunkMask]) this->clearStack.push_back(rootIndex);
+        while (!this->clearStack.empty()) {
+            const uint32_t current = this->clearStack.back();
+            this->clearStack.pop_back();
+            ++visited;
+
+            Chunk& chunk = *this->GetChunk(current);
+            const uint32_t slot = current & ChunkMask;
+            chunk.subtreeDirty[slot] = false;
+            const uint32_t dirty = chunk.dirtyMask[slot].exchange(DIRTY_NONE);
+            if (dirty != DIRTY_NONE) {
+                chunk.publishedDirty[slot] |= dirty;
+                //a move or resize is journaled by the world update, anything else here
+                if (!this->PublishState(current)) this->JournalBounds(rootIndex, current);
+                ++published;
+            }
+            for (uint32_t child = chunk.firstChild[slot]; child != InvalidIndex; child = this->NextSibling(child)) {
+                if (this->GetChunk(child)->subtreeDirty[child & ChunkMask]) this->clearStack.push_back(child);
+            }
+        }
+        this->dirtyClearSlotVisits.fetch_add(visited, std::memory_order_relaxed);
+        this->statesPublished.fetch_add(published, std::memory_order_relaxed);
+        return published;
+    }
+    bool ElementStore::PublishState(uint32_t index) {
+        Chunk& chunk = *this->GetChunk(index);
+        const uint32_t slot = index & ChunkMask;
+        std::shared_ptr<const ElementState> state = chunk.stagedState[slot].Load();
+        if (!state) return false;
+
+        //moves and resizes are found by comparing against the last published block
+        const ElementState* previous = chunk.publishedState[slot].get();
+        bool boundsChanged = false;
+        const bool resized = previous == nullptr || previous->width != state->width || previous->height != state->height;
+        //visibility and clip changes reach the whole subtree, like a move, a clipping node's size clips its children
+        if (previous == nullptr || previous->posX != state->posX || previous->posY != state->posY ||
+            previous->hidden != state->hidden || previous->clipChildren != state->clipChildren || (resized && state->clipChildren)) {
+            this->MarkTransformStale(index);
+            boundsChanged = true;
+        }
+        if (resized) {
+            this->MarkBoundsStale(index);
+            boundsChanged = true;
+        }
+        chunk.posX[slot] = state->posX;
+        chunk.posY[slot] = state->posY;
+        chunk.width[slot] = state->width;
+        chunk.height[slot] = state->height;
+        chunk.depth[slot] = state->depth;
+        chunk.hidden[slot] = state->hidden;
+        chunk.clipChildren[slot] = state->clipChildren;
+        chunk.publishedState[slot] = std::move(state);
+        return boundsChanged;
+    }
+    bool ElementStore::PublishStructure(uint32_t rootIndex) {
+        //entries belonging to other trees stay until their own tree publishes, settled ones are dropped
+        bool changed = false;
+        size_t kept = 0;
+        for (uint32_t index : this->structureJournal) {
+            Chunk& chunk = *this->GetChunk(index);
+            const uint32_t slot = index & ChunkMask;
+            const uint32_t stagedRoot = chunk.live[slot] ? chunk.root[slot] : InvalidIndex;
+            const uint32_t publishedRoot = chunk.publishedRoot[slot];
+            if (stagedRoot == publishedRoot && chunk.publishedGeneration[slot] == chunk.generation[slot]) {
+                chunk.structureJournaled[slot] = false;
+                continue;
+            }
+            if (stagedRoot != rootIndex && publishedRoot != rootIndex) {
+                this->structureJournal[kept++] = index;
+                continue;
+            }
+
+            chunk.structureJournaled[slot] = false;
+            //the tree it left drops it from its journal consumer, the tree it joined sees it through the world update
+            if (publishedRoot != InvalidIndex && publishedRoot != stagedRoot) this->JournalBounds(publishedRoot, index);
+            chunk.publishedRoot[slot] = stagedRoot;
+            chunk.publishedGeneration[slot] = chunk.generation[slot];
+            chunk.publishedOwner[slot] = chunk.live[slot] ? chunk.owner[slot] : nullptr;
+            if (!chunk.live[slot]) chunk.publishedState[slot].reset();
+            changed = true;
+        }
+        this->structureJournal.resize(kept);
+        return changed;
+    }
+
+    DirtyTrackingStats ElementStore::GetDirtyStats() const {
+        DirtyTrackingStats stats;
+        stats.checks = this->dirtyChecks.load(std::memory_order_relaxed);
+        stats.checkSlotReads = this->dirtyCheckSlotReads.load(std::memory_order_relaxed);
+        stats.markSlotWrites = this->dirtyMarkSlotWrites.load(std::memory_order_relaxed);
+        stats.clearSlotVisits = this->dirtyClearSlotVisits.load(std::memory_order_relaxed);
+        return stats;
+    }
+    void ElementStore::ResetDirtyStats() {
+        this->dirtyChecks = 0;
+        this->dirtyCheckSlotReads = 0;
+        this->dirtyMarkSlotWrites = 0;
+        this->dirtyClearSlotVisits = 0;
+    }
+
+    void ElementStore::PropagateTransformPending(uint32_t index) {
+        for (uint32_t current = index; current != InvalidIndex; current = this->Parent(current)) {
+            if (this->GetChunk(current)->transformPending[current & ChunkMask].exchange(true)) break;
+        }
+    }
+    void ElementStore::MarkTransformStale(uint32_t index) {
+        this->GetChunk(index)->worldStale[index & ChunkMask] = true;
+        this->PropagateTransformPending(index);
+    }
+    void ElementStore::UpdateWorldTransforms(uint32_t rootIndex) {
+        //fast path, nothing moved since the last update
+        if (!this->GetChunk(rootIndex)->transformPending[rootIndex & ChunkMask]) return;
+
+        //each entry carries whether an ancestor was recomputed, which forces the whole subtree
+        this->transformStack.clear();
+        this->transformStack.push_back({ rootIndex, false });
+        while (!this->transformStack.empty()) {
+            const auto [current, forced] = this->transformStack.back();
+            this->transformStack.pop_back();
+
+            Chunk& chunk = *this->GetChunk(current);
+            const uint32_t slot = current & ChunkMask;
+            chunk.transformPending[slot] = false;
+            const bool recompute = chunk.worldStale[slot].exchange(false) || forced;
+            const bool boundsChanged = chunk.boundsStale[slot].exchange(false);
+            if (recompute || boundsChanged) this->JournalBounds(rootIndex, current);
+            if (recompute) {
+                const uint32_t parent = chunk.parent[slot];
+                if (parent != InvalidIndex) {
+                    Chunk& parentChunk = *this->GetChunk(parent);
+                    const uint32_t parentSlot = parent & ChunkMask;
+                    chunk.worldX[slot] = parentChunk.worldX[parentSlot] + chunk.posX[slot];
+                    chunk.worldY[slot] = parentChunk.worldY[parentSlot] + chunk.posY[slot];
+                    chunk.worldHidden[slot] = chunk.hidden[slot] || parentChunk.worldHidden[parentSlot];
+                    chunk.clipAncestor[slot] = parentChunk.clipChildren[parentSlot] ? parent : parentChunk.clipAncestor[parentSlot];
+                }
+                else {
+                    chunk.worldX[slot] = chunk.posX[slot];
+                    chunk.worldY[slot] = chunk.posY[slot];
+                    chunk.worldHidden[slot] = chunk.hidden[slot];
+                    chunk.clipAncestor[slot] = InvalidIndex;
+                }
+            }
+
+            for (uint32_t child = chunk.firstChild[slot]; child != InvalidIndex; child = this->NextSibling(child)) {
+                if (recompute || this->GetChunk(child)->transformPending[child & ChunkMask]) {
+                    this->transformStack.push_back({ child, recompute });
+                }
+            }
+        }
+    }
+
+    void ElementStore::JournalBounds(uint32_t rootIndex, uint32_t index) {
+        for (auto& [id, journal] : this->boundsJournals) {
+            if (journal.rootIndex != rootIndex || journal.overflowed) continue;
+            if (journal.changed.size() >= MaxBoundsJournalLength) {
+                journal.changed.clear();
+                journal.overflowed = true;
+                continue;
+            }
+            journal.changed.push_back(index);
+        }
+    }
+    void ElementStore::MarkBoundsStale(uint32_t index) {
+        this->GetChunk(index)->boundsStale[index & ChunkMask] = true;
+        this->PropagateTransformPending(index);
+    }
+    uint32_t ElementStore::RegisterBoundsJournal(uint32_t rootIndex) {
+        //starts overflowed so the first drain makes the consumer do a full build
+        const uint32_t journalId = this->nextBoundsJournal++;
+        this->boundsJournals[journalId].rootIndex = rootIndex;
+        return journalId;
+    }
+    void ElementStore::UnregisterBoundsJournal(uint32_t journalId) {
+        this->boundsJournals.erase(journalId);
+    }
+    bool ElementStore::DrainBoundsJournal(uint32_t journalId, std::vector<uint32_t>& out) {
+        out.clear();
+        auto journal = this->boundsJournals.find(journalId);
+        if (journal == this->boundsJournals.end()) return false;
+        if (journal->second.overflowed) {
+            journal->second.overflowed = false;
+            return false;
+        }
+        out.swap(journal->second.changed);
+        journal->second.changed.clear();
+        return true;
+    }
+}
\ No newline at end of file
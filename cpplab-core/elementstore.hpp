@@ -0,0 +1,422 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+#include <atomic>
+#include <utility>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+
+namespace cpplab {
+    class ElementNode;
+    enum class NodeType;
+
+    //generational handle into the element store
+    //a handle goes stale once its slot is freed and reused
+    struct ElementHandle {
+        uint32_t index = 0xffffffff;
+        uint32_t generation = 0;
+
+        bool IsValid() const {
+            return this->index != 0xffffffff;
+        }
+        bool operator==(const ElementHandle& rhs) const {
+            return this->index == rhs.index && this->generation == rhs.generation;
+        }
+        bool operator!=(const ElementHandle& rhs) const {
+            return !(this->operator==(rhs));
+        }
+    };
+
+    //what a setter changed, renderers use these to rebuild only the affected resources
+    enum DirtyFlags : uint32_t {
+        DIRTY_NONE = 0,
+        //position, size, border width, corner radius, margins, fill and wrap modes
+        DIRTY_GEOMETRY = 1u << 0,
+        //colors only
+        DIRTY_PAINT = 1u << 1,
+        DIRTY_TEXT_CONTENT = 1u << 2,
+        //font, point size and alignment
+        DIRTY_TEXT_FORMAT = 1u << 3,
+        DIRTY_IMAGE_SOURCE = 1u << 4,
+        DIRTY_VISIBILITY = 1u << 5,
+        DIRTY_DEPTH = 1u << 6,
+        DIRTY_CHILDREN = 1u << 7,
+        //new pixels written into a pixel buffer element
+        DIRTY_PIXELS = 1u << 8,
+        DIRTY_ALL = 0x1ffu
+    };
+
+    //core properties of one element as an immutable block
+    //setters copy the block, change the copy and swap it in, so a published block never changes while the renderer reads it
+    //element types with more properties derive from it and override Clone
+    struct ElementState {
+        float posX = 0.f;
+        float posY = 0.f;
+        float width = 0.f;
+        float height = 0.f;
+        float depth = 0.f;
+        //multiplies the alpha of everything the element draws, not inherited by children
+        float opacity = 1.f;
+        //hides the element and everything below it from drawing and hit testing
+        bool hidden = false;
+        //children draw and take mouse events only inside the element's box
+        bool clipChildren = false;
+
+        virtual ~ElementState() = default;
+        virtual std::shared_ptr<ElementState> Clone() const {
+            return std::make_shared<ElementState>(*this);
+        }
+    };
+
+    //shared pointer to a state block that is swapped as a whole from any thread
+    //a one bit spinlock covers only the pointer copy, never the copy of the block itself
+    //std::atomic<std::shared_ptr> does the same internally, but not every standard library orders it in a way thread sanitizers can follow
+    class StateSlot {
+    private:
+        mutable std::atomic_flag busy;
+        std::shared_ptr<const ElementState> state;
+
+        void Lock() const {
+            while (this->busy.test_and_set(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+        }
+        void Unlock() const {
+            this->busy.clear(std::memory_order_release);
+        }
+
+    public:
+        std::shared_ptr<const ElementState> Load() const {
+            this->Lock();
+            std::shared_ptr<const ElementState> copy = this->state;
+            this->Unlock();
+            return copy;
+        }
+        //the replaced block is released after unlocking
+        void Store(std::shared_ptr<const ElementState> next) {
+            this->Lock();
+            this->state.swap(next);
+            this->Unlock();
+        }
+        //swaps in desired if the slot still holds expected, otherwise loads the current block into expected
+        bool CompareExchange(std::shared_ptr<const ElementState>& expected, std::shared_ptr<const ElementState> desired) {
+            this->Lock();
+            if (this->state == expected) {
+                this->state.swap(desired);
+                this->Unlock();
+                return true;
+            }
+            std::shared_ptr<const ElementState> stale = std::move(expected);
+            expected = this->state;
+            this->Unlock();
+            return false;
+        }
+    };
+
+    enum class AttachResult {
+        ATTACHED, ALREADY_PARENTED, CYCLE
+    };
+
+    //counters for the dirty tracking, check reads should stay at one slot per check no matter the tree size
+    struct DirtyTrackingStats {
+        uint64_t checks = 0;
+        uint64_t checkSlotReads = 0;
+        uint64_t markSlotWrites = 0;
+        uint64_t clearSlotVisits = 0;
+    };
+
+    //flat storage for the core data of every element node
+    //data lives in struct-of-arrays chunks so tree walks become linear scans
+    //chunks never move once allocated, so slot references stay valid while the store grows
+    //
+    //element properties are staged and published
+    //setters on any thread swap a new state block into the staged slot and mark it dirty, they never wait on the renderer
+    //Publish copies the dirty blocks of one tree into the published arrays once per frame, together with structure changes and world positions
+    //the renderer and the hit test read only the published side, so they see the tree as of the last publish and never lock
+    //Publish and every published read belong to one thread, the ui thread
+    class ElementStore {
+    public:
+        static constexpr uint32_t InvalidIndex = 0xffffffff;
+        static constexpr uint32_t ChunkShift = 12;
+        static constexpr uint32_t ChunkSize = 1u << ChunkShift;
+        static constexpr uint32_t ChunkMask = ChunkSize - 1;
+        static constexpr uint32_t MaxChunks = 1024;
+
+    private:
+        struct Chunk {
+            //published, hot data touched by scans and draw
+            float posX[ChunkSize];
+            float posY[ChunkSize];
+            float width[ChunkSize];
+            float height[ChunkSize];
+            float depth[ChunkSize];
+            bool hidden[ChunkSize];
+            bool clipChildren[ChunkSize];
+            //dirty flags published but not taken by the renderer yet
+            uint32_t publishedDirty[ChunkSize];
+            //InvalidIndex while the slot is not part of a published tree
+            uint32_t publishedRoot[ChunkSize];
+            uint32_t publishedGeneration[ChunkSize];
+            ElementNode* publishedOwner[ChunkSize];
+            std::shared_ptr<const ElementState> publishedState[ChunkSize];
+
+            //staged, written by setters on any thread
+            StateSlot stagedState[ChunkSize];
+            std::atomic<uint32_t> dirtyMask[ChunkSize];
+            std::atomic_bool subtreeDirty[ChunkSize];
+
+            //cached absolute position, worldStale forces a recompute of this node and everything below
+            //transformPending marks the path from a stale node up to its root
+            float worldX[ChunkSize];
+            float worldY[ChunkSize];
+            //visibility and clipping are inherited, so they are resolved together with the world position
+            bool worldHidden[ChunkSize];
+            uint32_t clipAncestor[ChunkSize];
+            std::atomic_bool worldStale[ChunkSize];
+            std::atomic_bool transformPending[ChunkSize];
+            std::atomic_bool boundsStale[ChunkSize];
+
+            //staged hierarchy, changed under the structure lock
+            //parent is atomic because dirty marking climbs it without the lock
+            std::atomic<uint32_t> parent[ChunkSize];
+            uint32_t firstChild[ChunkSize];
+            uint32_t lastChild[ChunkSize];
+            uint32_t nextSibling[ChunkSize];
+            uint32_t prevSibling[ChunkSize];
+            uint32_t root[ChunkSize];
+            //interned id the node was added under, see ElementId, atomic so it is read without the lock
+            std::atomic<uint32_t> idAtom[ChunkSize];
+
+            //bookkeeping
+            NodeType type[ChunkSize];
+            bool live[ChunkSize];
+            //set while the slot waits in the structure journal
+            bool structureJournaled[ChunkSize];
+            uint32_t generation[ChunkSize];
+            ElementNode* owner[ChunkSize];
+        };
+
+        std::mutex structureLock;
+        Chunk* chunks[MaxChunks] = {};
+        uint32_t chunkCount = 0;
+        uint32_t slotHighWater = 0;
+        std::vector<uint32_t> freeSlots;
+        std::vector<uint32_t> clearStack;
+        std::vector<std::pair<uint32_t, bool>> transformStack;
+
+        //slots whose tree membership changed since they were last published
+        std::vector<uint32_t> structureJournal;
+        //bumped by every link, unlink and free, staged side
+        std::atomic<uint64_t> structureEdits = 0;
+        //published side, only touched by the publishing thread
+        uint32_t publishedCapacity = 0;
+        uint32_t publishedChunkCount = 0;
+        uint64_t structureVersion = 0;
+
+        //per consumer list of slots of one tree whose published state or world bounds changed
+        struct BoundsJournal {
+            uint32_t rootIndex = InvalidIndex;
+            std::vector<uint32_t> changed;
+            bool overflowed = true;
+        };
+        static constexpr size_t MaxBoundsJournalLength = 1u << 16;
+        //keyed by the id RegisterBoundsJournal handed out, a tree may have several consumers
+        std::unordered_map<uint32_t, BoundsJournal> boundsJournals;
+        uint32_t nextBoundsJournal = 0;
+
+        std::atomic<uint64_t> dirtyChecks = 0;
+        std::atomic<uint64_t> dirtyCheckSlotReads = 0;
+        std::atomic<uint64_t> dirtyMarkSlotWrites = 0;
+        std::atomic<uint64_t> dirtyClearSlotVisits = 0;
+        std::atomic<uint64_t> statesPublished = 0;
+
+        void PropagateSubtreeDirty(uint32_t index);
+        void PropagateTransformPending(uint32_t index);
+        void JournalBounds(uint32_t rootIndex, uint32_t index);
+        void JournalStructure(uint32_t index);
+
+        Chunk* GetChunk(uint32_t index) const {
+            return this->chunks[index >> ChunkShift];
+        }
+        void RelabelSubtreeRoot(uint32_t subtreeIndex, uint32_t newRoot);
+        //preorder walk over the child links of the subtree of index, expects the structure lock to be held
+        template <class Visit>
+        void WalkSubtreeLocked(uint32_t index, Visit&& visit) {
+            uint32_t current = index;
+            while (current != InvalidIndex) {
+                visit(current);
+                if (this->FirstChild(current) != InvalidIndex) {
+                    current = this->FirstChild(current);
+                    continue;
+                }
+                while (current != index && this->NextSibling(current) == InvalidIndex) {
+                    current = this->Parent(current);
+                }
+                current = current == index ? InvalidIndex : this->NextSibling(current);
+            }
+        }
+        //appends child to the children of parent, expects the structure lock to be held and the child to be unparented
+        void LinkLast(uint32_t parentIndex, uint32_t childIndex);
+        void Unlink(uint32_t index);
+        bool IsAncestorLocked(uint32_t ancestorIndex, uint32_t index);
+
+        //expect the structure lock to be held
+        size_t PublishDirtySubtree(uint32_t rootIndex);
+        //returns true if the node's world update was forced, see UpdateWorldTransforms
+        bool PublishState(uint32_t index);
+        bool PublishStructure(uint32_t rootIndex);
+        void UpdateWorldTransforms(uint32_t rootIndex);
+        void MarkTransformStale(uint32_t index);
+        void MarkBoundsStale(uint32_t index);
+
+    public:
+        ElementStore() = default;
+        ElementStore(ElementStore&&) = delete;
+        ElementStore(const ElementStore&) = delete;
+        ~ElementStore();
+
+        static ElementStore& Instance();
+
+        //slot lifetime, the owner sets the slot's first state right after allocating
+        ElementHandle Allocate(ElementNode* owner, NodeType type);
+        void Free(ElementHandle handle);
+        ElementNode* Resolve(ElementHandle handle);
+
+        //staged hierarchy, all indices must be live
+        //attaching checks and links under one lock, so two threads can not give a node two parents
+        //the child takes the id atom in the same step, an id is kept after the node is detached
+        AttachResult Attach(uint32_t parentIndex, uint32_t childIndex, uint32_t idAtom);
+        //links a whole forest under target in one lock, checking every child before linking any
+        //parents[i] is target or a child linked before i, children are distinct and stay in the order given
+        //each subtree is relabeled once and the dirty bits climb from target once, so n links cost O(n)
+        AttachResult AttachBatch(uint32_t targetIndex, const std::vector<uint32_t>& parents, const std::vector<uint32_t>& children, const std::vector<uint32_t>& idAtoms);
+        void Detach(uint32_t childIndex);
+        bool IsAncestor(uint32_t ancestorIndex, uint32_t index);
+
+        //staged state, safe from any thread
+        StateSlot& StagedState(uint32_t index) {
+            return this->GetChunk(index)->stagedState[index & ChunkMask];
+        }
+        //calls visit with every node of the subtree of index and its parent, parents before their children, under the structure lock
+        //visit may read slot fields but must not lock elements or call anything here that takes the structure lock
+        template <class Visit>
+        void VisitStagedSubtree(uint32_t index, Visit&& visit) {
+            std::lock_guard<std::mutex> guard(this->structureLock);
+            uint32_t current = index;
+            while (current != InvalidIndex) {
+                visit(current, current == index ? InvalidIndex : this->Parent(current));
+                if (this->FirstChild(current) != InvalidIndex) {
+                    current = this->FirstChild(current);
+                    continue;
+                }
+                while (current != index && this->NextSibling(current) == InvalidIndex) {
+                    current = this->Parent(current);
+                }
+                current = current == index ? InvalidIndex : this->NextSibling(current);
+            }
+        }
+        //calls visit with the staged state of index and then of every ancestor
+        template <class Visit>
+        void VisitStagedPath(uint32_t index, Visit&& visit) {
+            std::lock_guard<std::mutex> guard(this->structureLock);
+            for (uint32_t current = index; current != InvalidIndex; current = this->Parent(current)) {
+                const std::shared_ptr<const ElementState> state = this->StagedState(current).Load();
+                if (state) visit(*state);
+            }
+        }
+
+        //dirty tracking
+        //setters mark the node and every ancestor as subtree dirty, stopping at the first ancestor already marked
+        //so checking a whole tree is one flag read and publishing only visits dirty subtrees
+        //the flags are or'ed into the node's dirty mask
+        //Publish clears the subtree bits first and then takes each mask, so a setter on another thread is never lost in between
+        void MarkModified(uint32_t index, uint32_t dirtyFlags);
+        bool IsSubtreeDirty(uint32_t index);
+        DirtyTrackingStats GetDirtyStats() const;
+        void ResetDirtyStats();
+
+        //publishing
+        //copies the dirty states and structure changes of the tree of rootIndex to the published side and resolves world positions
+        //returns true if anything in the tree was published
+        bool Publish(uint32_t rootIndex);
+        //bumped by Publish whenever a slot joined or left a published tree
+        uint64_t StructureVersion() const {
+            return this->structureVersion;
+        }
+        //any thread, changes whenever a parent gained or lost a child, before anything is published
+        uint64_t StructureEdits() const {
+            return this->structureEdits.load(std::memory_order_acquire);
+        }
+        //one past the highest slot index seen by the last publish
+        uint32_t Capacity() const {
+            return this->publishedCapacity;
+        }
+        //returns the published dirty flags of a slot and resets them
+        uint32_t TakePublishedDirty(uint32_t index) {
+            uint32_t& dirty = this->GetChunk(index)->publishedDirty[index & ChunkMask];
+            const uint32_t taken = dirty;
+            dirty = DIRTY_NONE;
+            return taken;
+        }
+        uint64_t GetStatesPublished() const {
+            return this->statesPublished.load(std::memory_order_relaxed);
+        }
+
+        //bounds journals let a consumer (the hit test index, the renderer's damage) follow changes of one tree incrementally
+        //a published state or a dimension change only journals the node itself, a move journals the whole moved subtree
+        //a slot may show up more than once, filled by Publish, so they are drained on the publishing thread
+        //each consumer registers its own journal and gets back the id to drain it with
+        uint32_t RegisterBoundsJournal(uint32_t rootIndex);
+        void UnregisterBoundsJournal(uint32_t journalId);
+        //returns false when the journal overflowed, the consumer must then rebuild from CollectTreeIndices
+        bool DrainBoundsJournal(uint32_t journalId, std::vector<uint32_t>& out);
+
+        //staged walks under the structure lock over the child links, the cost follows the tree and not the store
+        //the tree scans take a root, for any other index they find nothing
+        size_t CountTree(uint32_t rootIndex);
+        size_t CountSubtree(uint32_t index);
+        void CollectTree(uint32_t rootIndex, std::vector<ElementNode*>& out);
+        void CollectChildren(uint32_t parentIndex, std::vector<ElementNode*>& out);
+        void CollectChildHandles(uint32_t parentIndex, std::vector<ElementHandle>& out);
+
+        //published scans
+        void CollectTreeIndices(uint32_t rootIndex, std::vector<uint32_t>& out);
+        bool IsInTree(uint32_t index, uint32_t rootIndex) {
+            return index < this->publishedCapacity && this->GetChunk(index)->publishedRoot[index & ChunkMask] == rootIndex;
+        }
+
+        //published per slot field access
+        float PosX(uint32_t index) { return this->GetChunk(index)->posX[index & ChunkMask]; }
+        float PosY(uint32_t index) { return this->GetChunk(index)->posY[index & ChunkMask]; }
+        float Width(uint32_t index) { return this->GetChunk(index)->width[index & ChunkMask]; }
+        float Height(uint32_t index) { return this->GetChunk(index)->height[index & ChunkMask]; }
+        float Depth(uint32_t index) { return this->GetChunk(index)->depth[index & ChunkMask]; }
+        bool Hidden(uint32_t index) { return this->GetChunk(index)->hidden[index & ChunkMask]; }
+        float WorldX(uint32_t index) { return this->GetChunk(index)->worldX[index & ChunkMask]; }
+        float WorldY(uint32_t index) { return this->GetChunk(index)->worldY[index & ChunkMask]; }
+        //hidden itself or below a hidden ancestor
+        bool WorldHidden(uint32_t index) { return this->GetChunk(index)->worldHidden[index & ChunkMask]; }
+        //nearest ancestor that clips its children, InvalidIndex if none does
+        uint32_t ClipAncestor(uint32_t index) { return this->GetChunk(index)->clipAncestor[index & ChunkMask]; }
+        const ElementState* State(uint32_t index) { return this->GetChunk(index)->publishedState[index & ChunkMask].get(); }
+        ElementNode* PublishedOwner(uint32_t index) { return this->GetChunk(index)->publishedOwner[index & ChunkMask]; }
+        uint32_t PublishedGeneration(uint32_t index) { return this->GetChunk(index)->publishedGeneration[index & ChunkMask]; }
+
+        //staged per slot field access, the type is fixed once the owner is constructed
+        uint32_t DirtyMask(uint32_t index) { return this->GetChunk(index)->dirtyMask[index & ChunkMask]; }
+        bool Modified(uint32_t index) { return this->DirtyMask(index) != DIRTY_NONE; }
+        NodeType& Type(uint32_t index) { return this->GetChunk(index)->type[index & ChunkMask]; }
+        uint32_t Parent(uint32_t index) { return this->GetChunk(index)->parent[index & ChunkMask]; }
+        uint32_t FirstChild(uint32_t index) { return this->GetChunk(index)->firstChild[index & ChunkMask]; }
+        uint32_t NextSibling(uint32_t index) { return this->GetChunk(index)->nextSibling[index & ChunkMask]; }
+        uint32_t Root(uint32_t index) { return this->GetChunk(index)->root[index & ChunkMask]; }
+        uint32_t IdAtom(uint32_t index) { return this->GetChunk(index)->idAtom[index & ChunkMask].load(std::memory_order_acquire); }
+        //for tree roots, which are never added under an id
+        void SetIdAtom(uint32_t index, uint32_t idAtom) { this->GetChunk(index)->idAtom[index & ChunkMask].store(idAtom, std::memory_order_release); }
+        ElementNode* Owner(uint32_t index) { return this->GetChunk(index)->owner[index & ChunkMask]; }
+        uint32_t Generation(uint32_t index) { return this->GetChunk(index)->generation[index & ChunkMask]; }
+    };
+}
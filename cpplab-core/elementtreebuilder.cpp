@@ -0,0 +1,158 @@
+#include <sstream>
+#include <string_view>
+#include <unordered_set>
+#include <unordered_map>
+#include "elementtreebuilder.hpp"
+
+namespace cpplab {
+    void ElementTreeBuilder::CheckEntry(uint32_t entry, bool allowTarget, const char* what) const {
+        if (entry < this->entries.size() || (allowTarget && entry == Target)) return;
+        std::stringstream errmsg;
+        errmsg << "[Cpplab Elements] During Tree Build: Attempted to " << what << " entry " << entry <<
+            ", but the builder only holds " << this->entries.size() << " entries.";
+        throw std::runtime_error(errmsg.str());
+    }
+
+    void ElementTreeBuilder::Reserve(size_t elements) {
+        this->entries.reserve(elements);
+    }
+    uint32_t ElementTreeBuilder::Add(uint32_t parent, ElementId id, ElementNode* element) {
+        this->CheckEntry(parent, true, "add an element under");
+        if (element == nullptr) {
+            throw std::runtime_error("[Cpplab Elements] During Tree Build: Attempted to add a null element!");
+        }
+        this->entries.push_back(Entry{ element, parent, id });
+        return static_cast<uint32_t>(this->entries.size() - 1);
+    }
+    void ElementTreeBuilder::AddClickListener(uint32_t entry, const std::string& listenerId, IMouseEventListener* listener) {
+        this->CheckEntry(entry, false, "add a click listener to");
+        this->listeners.push_back(Listener{ entry, listenerId, listener });
+    }
+    void ElementTreeBuilder::Clear() {
+        this->entries.clear();
+        this->listeners.clear();
+    }
+    void ElementTreeBuilder::Truncate(uint32_t entry) {
+        if (entry >= this->entries.size()) return;
+        this->entries.resize(entry);
+        std::erase_if(this->listeners, [entry](const Listener& listener) { return listener.entry >= entry; });
+    }
+
+    void ElementTreeBuilder::AttachTo(ElementNode* target) {
+        if (target == nullptr) {
+            throw std::runtime_error("[Cpplab Elements] During Tree Attach: Attempted to attach a batch to a null element!");
+        }
+        const uint32_t count = static_cast<uint32_t>(this->entries.size());
+        ElementStore& store = ElementStore::Instance();
+        //held until the batch is linked, so no other add to the target can slip in between the checks and the link
+        std::lock_guard<std::mutex> guard(target->elementLock);
+        const auto parentOf = [this, target](const Entry& entry) {
+            return entry.parent == Target ? target : this->entries[entry.parent].element;
+        };
+        const auto nameOf = [](ElementId id) {
+            return id.IsValid() ? ElementIdTable::Instance().Name(id) : std::string("<unnamed>");
+        };
+
+        if (ElementNode::DoElementErrorChecking) {
+            //one bit per store slot marks the elements seen, cheaper than hashing pointers
+            std::vector<uint64_t> seen;
+            for (const Entry& entry : this->entries) {
+                const uint32_t index = entry.element->handle.index;
+                if (seen.size() <= (index >> 6)) seen.resize((static_cast<size_t>(index) >> 6) + 1, 0);
+                const uint64_t bit = uint64_t(1) << (index & 63);
+                //the parent is read without the lock, an element being added to another parent right now is caught by the store
+                if (entry.element == target || (seen[index >> 6] & bit) != 0 ||
+                    store.Parent(index) != ElementStore::InvalidIndex) {
+                    std::stringstream errmsg;
+                    errmsg << "[Cpplab Elements] During Tree Attach: Double add detected! The element with specified id \"" << nameOf(entry.id) <<
+                        "\" is added twice, is the target itself or already has a parent element.";
+                    throw std::runtime_error(errmsg.str());
+                }
+                seen[index >> 6] |= bit;
+            }
+
+            struct ListenerCheck {
+                std::unordered_set<std::string_view> ids;
+                std::unordered_set<const IMouseEventListener*> pointers;
+            };
+            std::unordered_map<const ElementNode*, ListenerCheck> listenerChecks;
+            for (const Listener& listener : this->listeners) {
+                ElementNode* element = this->entries[listener.entry].element;
+                auto [check, added] = listenerChecks.try_emplace(element);
+                if (added) {
+                    //listeners the element got before it joined the batch
+                    for (const auto& existing : element->clickListeners) {
+                        check->second.ids.insert(existing.first);
+                        check->second.pointers.insert(existing.second);
+                    }
+                }
+                if (!check->second.ids.insert(listener.id).second || !check->second.pointers.insert(listener.listener).second) {
+                    std::stringstream errmsg;
+                    errmsg << "[Cpplab Elements] During Tree Attach: Listener collision detected! The click listener with specified id \"" << listener.id <<
+                        "\" on element \"" << nameOf(this->entries[listener.entry].id) << "\" repeats the id or the pointer of another listener of that element.";
+                    throw std::runtime_error(errmsg.str());
+                }
+            }
+        }
+
+        //each parent's table grows once, then the ids go straight in, a collision is the insert that finds its key taken
+        std::vector<uint32_t> childCounts(static_cast<size_t>(count) + 1, 0);
+        for (const Entry& entry : this->entries) {
+            ++childCounts[entry.parent == Target ? count : entry.parent];
+        }
+        for (uint32_t i = 0; i <= count; ++i) {
+            if (childCounts[i] == 0) continue;
+            ElementNode* parentNode = i == count ? target : this->entries[i].element;
+            parentNode->childNodes.Reserve(parentNode->childNodes.Size() + childCounts[i]);
+        }
+        //takes the ids inserted so far out again, the target is still locked and the rest are ours
+        const auto rollback = [this, &parentOf](uint32_t inserted) {
+            for (uint32_t i = 0; i < inserted; ++i) {
+                parentOf(this->entries[i])->childNodes.Erase(this->entries[i].id);
+            }
+        };
+        for (uint32_t i = 0; i < count; ++i) {
+            const Entry& entry = this->entries[i];
+            ElementNode* parentNode = parentOf(entry);
+            if (parentNode->childNodes.Insert(entry.id, entry.element)) continue;
+            rollback(i);
+            if (!ElementNode::DoElementErrorChecking) return;
+            std::stringstream errmsg;
+            errmsg << "[Cpplab Elements] During Tree Attach: ID collision detected! The element with specified id \"" << nameOf(entry.id) <<
+                "\" would be added to element \"" << nameOf(entry.parent == Target ? target->getSelfElementId() : this->entries[entry.parent].id) <<
+                "\", but that element already has a child node of that id.";
+            throw std::runtime_error(errmsg.str());
+        }
+
+        //one lock for the whole batch, the store checks parents and cycles again before linking anything
+        std::vector<uint32_t> parents(count);
+        std::vector<uint32_t> children(count);
+        std::vector<uint32_t> ids(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            parents[i] = parentOf(this->entries[i])->handle.index;
+            children[i] = this->entries[i].element->handle.index;
+            ids[i] = this->entries[i].id.atom;
+        }
+        //the ids are set in the store along with the links
+        const AttachResult attached = store.AttachBatch(target->handle.index, parents, children, ids);
+        if (attached != AttachResult::ATTACHED) rollback(count);
+        if (ElementNode::DoElementErrorChecking && attached == AttachResult::ALREADY_PARENTED) {
+            throw std::runtime_error("[Cpplab Elements] During Tree Attach: Double add detected! An element of the batch was given a parent element while the batch was checked.");
+        }
+        if (ElementNode::DoElementErrorChecking && attached == AttachResult::CYCLE) {
+            std::stringstream errmsg;
+            errmsg << "[Cpplab Elements] During Tree Attach: Cyclic add detected! Attempted to attach a batch to element \"" << nameOf(target->getSelfElementId()) <<
+                "\" but the batch holds that element's topmost ancestor.";
+            throw std::runtime_error(errmsg.str());
+        }
+        if (attached != AttachResult::ATTACHED) return;
+
+        //the elements of the batch are ours until this returns, only the target is shared
+        for (const Listener& listener : this->listeners) {
+            this->entries[listener.entry].element->clickListeners.insert({ listener.id, listener.listener });
+        }
+        //new elements are dirty from their construction, only the target learns about its new children
+        if (count > 0) target->markModified(DIRTY_CHILDREN);
+        this->Clear();
+    }
+}
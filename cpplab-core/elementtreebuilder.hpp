@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+#include "engineelements.hpp"
+
+namespace cpplab {
+    //collects a subtree of new elements, their ids and click listeners off the tree and attaches it in one step
+    //nothing is checked or linked while adding, AttachTo checks the whole batch and then links it
+    //duplicate elements are caught with one bit per store slot and ids by inserting into the parents' child tables, grown once, which are rolled back on failure
+    //the store links every element under one lock and the target is marked dirty once, so n elements cost O(n)
+    //elements in the batch must not be used by other threads until attached, they are not locked while it is built
+    class ElementTreeBuilder {
+    public:
+        //parent of the elements attached straight to the target
+        static constexpr uint32_t Target = 0xffffffffu;
+
+    private:
+        struct Entry {
+            ElementNode* element;
+            uint32_t parent;
+            ElementId id;
+        };
+        struct Listener {
+            uint32_t entry;
+            std::string id;
+            IMouseEventListener* listener;
+        };
+        std::vector<Entry> entries;
+        std::vector<Listener> listeners;
+
+        //throws if entry is not an entry of this batch, or Target where that is not allowed
+        void CheckEntry(uint32_t entry, bool allowTarget, const char* what) const;
+
+    public:
+        void Reserve(size_t elements);
+
+        //adds the element under parent, an entry returned by an earlier Add or Target, and returns its entry
+        //the builder does not own the element, it is deleted by whoever would delete it once added to the tree
+        //the id is interned here, AttachTo never touches the id table
+        uint32_t Add(uint32_t parent, ElementId id, ElementNode* element);
+        uint32_t Add(uint32_t parent, const std::string& id, ElementNode* element) {
+            return this->Add(parent, ElementIdTable::Instance().Intern(id), element);
+        }
+        //constructs the element from the arguments, a configuration struct for instance, and adds it
+        template <class Element, class... Args>
+        uint32_t Create(uint32_t parent, const std::string& id, Args&&... args) {
+            this->CheckEntry(parent, true, "create an element under");
+            return this->Add(parent, id, new Element(std::forward<Args>(args)...));
+        }
+        void AddClickListener(uint32_t entry, const std::string& listenerId, IMouseEventListener* listener);
+
+        ElementNode* GetElement(uint32_t entry) const {
+            this->CheckEntry(entry, false, "access");
+            return this->entries[entry].element;
+        }
+        size_t Size() const {
+            return this->entries.size();
+        }
+
+        //checks every id, element and listener of the batch and attaches it under target
+        //throws std::runtime_error before anything was attached if a check fails, the batch is kept
+        //on success the builder is empty and can be reused
+        void AttachTo(ElementNode* target);
+        //forgets the batch without deleting its elements
+        void Clear();
+        //forgets the entries from entry on and their click listeners, without deleting the elements
+        void Truncate(uint32_t entry);
+    };
+}
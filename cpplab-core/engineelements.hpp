@@ -1,15 +1,17 @@
 #pragma once
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <mutex>
 #include <vector>
 #include <atomic>
+#include <memory>
 #include <sstream>
 #include <exception>
 
 #include "fonts.hpp"
-
-#define max(a, b) (((a) > (b)) ? (a) : (b))
+#include "elementstore.hpp"
+#include "elementid.hpp"
 
 namespace cpplab {
     struct vec2 {
@@ -64,6 +66,65 @@ namespace cpplab {
         }
     };
 
+    struct RectF {
+        float left, top, right, bottom;
+        RectF() { this->left = 0.f; this->top = 0.f; this->right = 0.f; this->bottom = 0.f; };
+        RectF(float left_, float top_, float right_, float bottom_) : left{ left_ }, top{ top_ }, right{ right_ }, bottom{ bottom_ } {};
+
+        bool IsEmpty() const {
+            return this->right <= this->left || this->bottom <= this->top;
+        }
+        float Area() const {
+            return this->IsEmpty() ? 0.f : (this->right - this->left) * (this->bottom - this->top);
+        }
+        bool Intersects(const RectF& rhs) const {
+            return this->left < rhs.right && rhs.left < this->right &&
+                   this->top < rhs.bottom && rhs.top < this->bottom;
+        }
+        RectF Union(const RectF& rhs) const {
+            if (this->IsEmpty()) return rhs;
+            if (rhs.IsEmpty()) return *this;
+            return RectF(
+                this->left < rhs.left ? this->left : rhs.left,
+                this->top < rhs.top ? this->top : rhs.top,
+                this->right > rhs.right ? this->right : rhs.right,
+                this->bottom > rhs.bottom ? this->bottom : rhs.bottom
+            );
+        }
+        RectF Intersection(const RectF& rhs) const {
+            return RectF(
+                this->left > rhs.left ? this->left : rhs.left,
+                this->top > rhs.top ? this->top : rhs.top,
+                this->right < rhs.right ? this->right : rhs.right,
+                this->bottom < rhs.bottom ? this->bottom : rhs.bottom
+            );
+        }
+        RectF Inflate(float amount) const {
+            return RectF(this->left - amount, this->top - amount, this->right + amount, this->bottom + amount);
+        }
+        bool operator==(const RectF& rhs) const {
+            return this->left == rhs.left && this->top == rhs.top && this->right == rhs.right && this->bottom == rhs.bottom;
+        }
+        bool operator!=(const RectF& rhs) const {
+            return !(this->operator==(rhs));
+        }
+    };
+
+    //the boxes of every ancestor clipping an element intersected, in world pixels, read from the published side
+    //returns false when no ancestor clips it
+    inline bool GetPublishedClip(uint32_t index, RectF& clip) {
+        ElementStore& store = ElementStore::Instance();
+        bool clipped = false;
+        for (uint32_t ancestor = store.ClipAncestor(index); ancestor != ElementStore::InvalidIndex; ancestor = store.ClipAncestor(ancestor)) {
+            const float left = store.WorldX(ancestor);
+            const float top = store.WorldY(ancestor);
+            const RectF box(left, top, left + store.Width(ancestor), top + store.Height(ancestor));
+            clip = clipped ? clip.Intersection(box) : box;
+            clipped = true;
+        }
+        return clipped;
+    }
+
     class IMouseEventListener {
     public:
         enum class Button {
@@ -78,7 +139,7 @@ namespace cpplab {
     };
 
     enum class NodeType {
-        BASE_ELEMENT, TEXT_AREA, IMAGE // add more elements cause its kinda lacking rn
+        BASE_ELEMENT, TEXT_AREA, IMAGE, PIXEL_BUFFER // add more elements cause its kinda lacking rn
     };
 
     struct ElementNodeConfiguration {
@@ -91,7 +152,7 @@ namespace cpplab {
             this->depth = 0.0f;
             this->relativePos = vec2(0.f, 0.f);
             this->dimensions = vec2(0.f, 0.f);
-            this->hidden = true;
+            this->hidden = false;
         }
         ElementNodeConfiguration& SetDepth(float depth) {
             this->depth = depth;
@@ -112,30 +173,77 @@ namespace cpplab {
     };
     class ElementNode {
         friend class WindowD2DRenderer;
+        friend class SceneRenderer;
         friend class WindowData;
+        friend class HeadlessEngine;
+        friend class AnimationEngine;
+        friend class LayoutEngine;
+        friend class ScrollListElement;
+        friend class ElementTreeBuilder;
+        friend class SceneFile;
     protected:
         static const bool DoElementErrorChecking = true;
 
+        //only guards the child id table and the listeners, properties are copy on write blocks in the element store
         std::mutex elementLock;
-        std::atomic_bool modified = true;
 
-        float depth = 0.0f;
-        vec2 relativePos = vec2(0, 0);
-        vec2 dimensions = vec2(0, 0);
+        //core data (state blocks, type, hierarchy, the id this node was added under) lives in the element store
+        ElementHandle handle;
+        ChildTable childNodes;
 
-        ElementNode* parentNode = NULL;
-        std::map<std::string, ElementNode*> childNodes;
-
-        bool hidden = true;
-        std::string selfId;
+        std::map<std::string, IMouseEventListener*> clickListeners;
 
-        NodeType type = NodeType::BASE_ELEMENT;
+        ElementStore& store() const {
+            return ElementStore::Instance();
+        }
+        //constructors only, before the node is shared with other threads
+        void setNodeType(NodeType type) {
+            this->store().Type(this->handle.index) = type;
+        }
+        void setInitialState(std::shared_ptr<const ElementState> state) {
+            this->store().StagedState(this->handle.index).Store(std::move(state));
+        }
+        //a derived constructor builds its own block type on top of what the base constructor set
+        template <class State>
+        std::shared_ptr<State> extendState() {
+            std::shared_ptr<State> state = std::make_shared<State>();
+            static_cast<ElementState&>(*state) = *this->store().StagedState(this->handle.index).Load();
+            return state;
+        }
 
-        std::map<std::string, IMouseEventListener*> clickListeners;
+        template <class State>
+        std::shared_ptr<const State> loadState() const {
+            return std::static_pointer_cast<const State>(this->store().StagedState(this->handle.index).Load());
+        }
+        //copies the current block, applies change and swaps the copy in
+        //if another thread swapped in a block meanwhile the change is applied again on top of that one, so no write is lost
+        template <class State, class Change>
+        void updateState(uint32_t dirtyFlags, Change&& change) {
+            StateSlot& staged = this->store().StagedState(this->handle.index);
+            std::shared_ptr<const ElementState> current = staged.Load();
+            std::shared_ptr<ElementState> next;
+            do {
+                next = current->Clone();
+                change(static_cast<State&>(*next));
+            } while (!staged.CompareExchange(current, next));
+            this->markModified(dirtyFlags);
+        }
+        //dirtyFlags says what changed, see DirtyFlags
+        void markModified(uint32_t dirtyFlags) {
+            this->store().MarkModified(this->handle.index, dirtyFlags);
+        }
+        bool isModified() {
+            return this->store().Modified(this->handle.index);
+        }
+        uint32_t getDirtyMask() {
+            return this->store().DirtyMask(this->handle.index);
+        }
 
+        //tests against the published frame, the one on screen
         virtual bool MouseOverCheck(vec2 windowMousePosition) {
-            const vec2 bbox_tl = this->getTruePosition();
-            const vec2 bbox_br = this->getDimensions() + bbox_tl;
+            ElementStore& s = this->store();
+            vec2 bbox_tl = vec2(s.WorldX(this->handle.index), s.WorldY(this->handle.index));
+            const vec2 bbox_br = bbox_tl + vec2(s.Width(this->handle.index), s.Height(this->handle.index));
 
             return windowMousePosition.x > bbox_tl.x &&
                    windowMousePosition.x < bbox_br.x &&
@@ -144,138 +252,201 @@ namespace cpplab {
         }
 
     private:
-        bool RecursiveCheckModification() {
-            if (this->modified) return true;
-            if (this->childNodes.size() == 0) return false;
+        //one flag read, setters keep the subtree dirty bits of every ancestor up to date
+        bool CheckSubtreeModification() {
+            return this->store().IsSubtreeDirty(this->handle.index);
+        }
+        //makes everything changed below this node visible to the renderer and the hit test, see ElementStore::Publish
+        bool PublishSubtree() {
+            return this->store().Publish(this->handle.index);
+        }
 
+        void DeleteChildElement(ElementId id, const std::string& name) {
             std::lock_guard<std::mutex> guard(this->elementLock);
-            for (auto& childNodePair : this->childNodes) {
-                if (childNodePair.second->RecursiveCheckModification()) return true;
+            ElementNode* child = this->childNodes.Erase(id);
+            if (ElementNode::DoElementErrorChecking && child == nullptr) {
+                std::stringstream errmsg;
+                errmsg << "Invalid element deletion detected! " <<
+                    "Attempted to delete an element of id \"" << name <<
+                    "\" from the element \"" << this->getSelfId() <<
+                    "\", but the parent element does not contain a child element with the specified id.";
+                throw std::runtime_error(errmsg.str());
             }
-            return false;
+            if (child == nullptr) return;
+            this->store().Detach(child->handle.index);
+            this->markModified(DIRTY_CHILDREN);
         }
-        void ResetModification() {
+        ElementNode* GetChildElement(ElementId id, const std::string& name) {
             std::lock_guard<std::mutex> guard(this->elementLock);
-            this->modified = false;
+            ElementNode* child = this->childNodes.Find(id);
+            if (ElementNode::DoElementErrorChecking && child == nullptr) {
+                std::stringstream errmsg;
+                errmsg << "Invalid element access detected! " <<
+                    "Attempted to access an element of id \"" << name <<
+                    "\" from the element \"" << this->getSelfId() <<
+                    "\", but the parent element does not contain a child element with the specified id.";
+                throw std::runtime_error(errmsg.str());
+            }
+            return child;
         }
-
-        void setSelfId(const std::string& id) {
+        //called by a child that is being destroyed while still attached
+        void ForgetChildElement(ElementNode* element) {
             std::lock_guard<std::mutex> guard(this->elementLock);
-            this->selfId = id;
+            //the child is found by the id it was added under, deleting every child of a large parent stays linear
+            const ElementId id = element->getSelfElementId();
+            if (this->childNodes.Find(id) == element) {
+                this->childNodes.Erase(id);
+            }
+            this->store().Detach(element->handle.index);
+            this->markModified(DIRTY_CHILDREN);
         }
     public:
-        ElementNode() = default;
+        ElementNode() {
+            this->handle = this->store().Allocate(this, NodeType::BASE_ELEMENT);
+            this->setInitialState(std::make_shared<ElementState>());
+        }
         ElementNode(const ElementNodeConfiguration& config) {
-            this->depth = config.depth;
-            this->relativePos = config.relativePos;
-            this->dimensions = config.dimensions;
-            this->hidden = config.hidden;
+            this->handle = this->store().Allocate(this, NodeType::BASE_ELEMENT);
+            std::shared_ptr<ElementState> state = std::make_shared<ElementState>();
+            state->depth = config.depth;
+            state->posX = config.relativePos.x;
+            state->posY = config.relativePos.y;
+            state->width = config.dimensions.x;
+            state->height = config.dimensions.y;
+            state->hidden = config.hidden;
+            this->setInitialState(std::move(state));
         }
         ElementNode(ElementNode&&) = delete;
         ElementNode(const ElementNode&) = delete;
-        virtual ~ElementNode() {};
+        //delete elements on the ui thread, the renderer keeps using the published side of a slot until the next publish
+        virtual ~ElementNode() {
+            const uint32_t parentIndex = this->store().Parent(this->handle.index);
+            if (parentIndex != ElementStore::InvalidIndex) {
+                this->store().Owner(parentIndex)->ForgetChildElement(this);
+            }
+            this->store().Free(this->handle);
+        };
 
+        ElementHandle getHandle() const {
+            return this->handle;
+        }
         NodeType getNodeType() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            return this->type;
+            return this->store().Type(this->handle.index);
         }
-        std::string getSelfId() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            return this->selfId;
+        //the id this node was last added under, kept after it is removed, empty for roots that were never named
+        ElementId getSelfElementId() const {
+            return ElementId{ this->store().IdAtom(this->handle.index) };
+        }
+        const std::string& getSelfId() const {
+            return ElementIdTable::Instance().Name(this->getSelfElementId());
+        }
+        //for roots, which are never added under an id, a node that has a parent keeps the id it was added under
+        void setRootId(const std::string& id) {
+            if (this->store().Parent(this->handle.index) != ElementStore::InvalidIndex) return;
+            this->store().SetIdAtom(this->handle.index, ElementIdTable::Instance().Intern(id).atom);
         }
 
+        //getters return the staged values, what was set last from any thread
         virtual void setDepth(float depth) {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            this->depth = depth;
-            this->modified = true;
+            this->updateState<ElementState>(DIRTY_DEPTH, [depth](ElementState& state) { state.depth = depth; });
         }
         virtual float getDepth() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            return this->depth;
+            return this->loadState<ElementState>()->depth;
         }
 
         virtual vec2 getRelativePosition() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            return this->relativePos;
+            const std::shared_ptr<const ElementState> state = this->loadState<ElementState>();
+            return vec2(state->posX, state->posY);
         }
         virtual void setRelativePosition(vec2 pos) {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            this->relativePos = pos;
-            this->modified = true;
+            this->updateState<ElementState>(DIRTY_GEOMETRY, [pos](ElementState& state) {
+                state.posX = pos.x;
+                state.posY = pos.y;
+            });
         }
         
+        //sums the staged positions up the parent chain, the renderer uses the world positions cached at publish instead
         virtual vec2 getTruePosition() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            if (parentNode != NULL) {
-                return parentNode->getTruePosition() + this->relativePos;
-            }
-            else {
-                return this->relativePos;
-            }
+            vec2 position;
+            this->store().VisitStagedPath(this->handle.index, [&position](const ElementState& state) {
+                position = position + vec2(state.posX, state.posY);
+            });
+            return position;
         }
 
         virtual void setDimensions(vec2 dim) {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            this->dimensions = dim;
-            this->modified = true;
+            this->updateState<ElementState>(DIRTY_GEOMETRY, [dim](ElementState& state) {
+                state.width = dim.x;
+                state.height = dim.y;
+            });
         }
         virtual vec2 getDimensions() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            return this->dimensions;
+            const std::shared_ptr<const ElementState> state = this->loadState<ElementState>();
+            return vec2(state->width, state->height);
+        }
+
+        virtual void setOpacity(float opacity) {
+            this->updateState<ElementState>(DIRTY_PAINT, [opacity](ElementState& state) { state.opacity = opacity; });
+        }
+        virtual float getOpacity() {
+            return this->loadState<ElementState>()->opacity;
         }
 
         virtual void show() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            this->hidden = false;
-            this->modified = true;
+            this->updateState<ElementState>(DIRTY_VISIBILITY, [](ElementState& state) { state.hidden = false; });
         }
         virtual void hide() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            this->hidden = true;
-            this->modified = true;
+            this->updateState<ElementState>(DIRTY_VISIBILITY, [](ElementState& state) { state.hidden = true; });
         }
         virtual bool isHidden() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            return this->hidden;
+            return this->loadState<ElementState>()->hidden;
+        }
+        //children outside this element's box are cut off when drawing and do not take mouse events there
+        virtual void setClipChildren(bool clip) {
+            this->updateState<ElementState>(DIRTY_VISIBILITY, [clip](ElementState& state) { state.clipChildren = clip; });
+        }
+        virtual bool getClipChildren() {
+            return this->loadState<ElementState>()->clipChildren;
         }
 
         virtual void AddChildElement(const std::string& strId, ElementNode* element) {
+            this->AddChildElement(ElementIdTable::Instance().Intern(strId), element);
+        }
+        void AddChildElement(ElementId id, ElementNode* element) {
             std::lock_guard<std::mutex> guard(this->elementLock);
-            if (ElementNode::DoElementErrorChecking && this->childNodes.contains(strId)) {
+            if (ElementNode::DoElementErrorChecking && this->childNodes.Contains(id)) {
                 std::stringstream errmsg;
-                errmsg << "ID collision detected! Attempted to add element with specified id \"" << strId
-                    << "\" to element \"" << this->selfId << "\", but the parent element already contains a child node of that id.";
+                errmsg << "ID collision detected! Attempted to add element with specified id \"" << ElementIdTable::Instance().Name(id)
+                    << "\" to element \"" << this->getSelfId() << "\", but the parent element already contains a child node of that id.";
                 throw std::runtime_error(errmsg.str());
             }
-            if (ElementNode::DoElementErrorChecking) {
-                for (const auto& elemt : this->childNodes) {
-                    if (elemt.second == element) {
-                        std::stringstream errmsg;
-                        errmsg << "Double add detected! Attempeted to add element with specified id \"" <<
-                            strId << "\" to element \"" <<
-                            this->selfId << "\" but a child element with the same pointer was detected.";
-                        throw std::runtime_error(errmsg.str());
-                    }
-                }
+            //a node can only have one parent, the store checks that and cycles in the same step as linking
+            //so two threads adding the same element can not both succeed
+            const AttachResult attached = this->store().Attach(this->handle.index, element->handle.index, id.atom);
+            if (ElementNode::DoElementErrorChecking && attached == AttachResult::ALREADY_PARENTED) {
+                std::stringstream errmsg;
+                errmsg << "Double add detected! Attempeted to add element with specified id \"" <<
+                    ElementIdTable::Instance().Name(id) << "\" to element \"" <<
+                    this->getSelfId() << "\" but the element already has a parent element.";
+                throw std::runtime_error(errmsg.str());
             }
-            this->childNodes.insert({ {strId, element} });
-            element->parentNode = this;
-            element->setSelfId(strId);
-            this->modified = true;
-        }
-        //users are responsible for their own memory cleanup! keep track of your pointers
-        virtual void DeleteChildElement(const std::string& strId) {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            if (ElementNode::DoElementErrorChecking && !this->childNodes.contains(strId)) {
+            if (ElementNode::DoElementErrorChecking && attached == AttachResult::CYCLE) {
                 std::stringstream errmsg;
-                errmsg << "Invalid element deletion detected! " <<
-                    "Attempted to delete an element of id \"" << strId <<
-                    "\" from the element \"" << this->selfId <<
-                    "\", but the parent element does not contain a child element with the specified id.";
+                errmsg << "Cyclic add detected! Attempted to add element with specified id \"" <<
+                    ElementIdTable::Instance().Name(id) << "\" to element \"" <<
+                    this->getSelfId() << "\" but the element is the parent element itself or one of its ancestors.";
                 throw std::runtime_error(errmsg.str());
             }
-            this->childNodes.erase(strId);
-            this->modified = true;
+            if (attached != AttachResult::ATTACHED) return;
+            this->childNodes.Insert(id, element);
+            this->markModified(DIRTY_CHILDREN);
+        }
+        //users are responsible for their own memory cleanup! keep track of your pointers
+        virtual void DeleteChildElement(const std::string& strId) {
+            this->DeleteChildElement(ElementIdTable::Instance().Find(strId), strId);
+        }
+        void DeleteChildElement(ElementId id) {
+            this->DeleteChildElement(id, ElementIdTable::Instance().Name(id));
         }
 
         virtual void AddClickListener(const std::string& listenerId, IMouseEventListener* listener) {
@@ -284,7 +455,7 @@ namespace cpplab {
             if (ElementNode::DoElementErrorChecking && this->clickListeners.contains(listenerId)) {
                 std::stringstream errmsg;
                 errmsg << "ID collision detected! Attempted to add listener with specified id \"" << listenerId
-                    << "\" to element \"" << this->selfId << "\", but the parent element already contains a click listener of that id.";
+                    << "\" to element \"" << this->getSelfId() << "\", but the parent element already contains a click listener of that id.";
                 throw std::runtime_error(errmsg.str());
             }
             //check listener exists
@@ -294,7 +465,7 @@ namespace cpplab {
                         std::stringstream errmsg;
                         errmsg << "Double add detected! Attempeted to add listener with specified id \"" <<
                             listenerId << "\" to element \"" <<
-                            this->selfId << "\" but an existing click listener with the same pointer was detected.";
+                            this->getSelfId() << "\" but an existing click listener with the same pointer was detected.";
                         throw std::runtime_error(errmsg.str());
                     }
                 }
@@ -308,42 +479,44 @@ namespace cpplab {
                 std::stringstream errmsg;
                 errmsg << "Invalid click listener deletion detected! " <<
                     "Attempted to delete a click listener of id \"" << listenerId <<
-                    "\" from the element \"" << this->selfId << "\", but the element does not contain a click listener with the specified id.";
+                    "\" from the element \"" << this->getSelfId() << "\", but the element does not contain a click listener with the specified id.";
                 throw std::runtime_error(errmsg.str());
             }
             this->clickListeners.erase(listenerId);
         }
 
+        //a name that was never interned is no child of anything, looking it up adds nothing to the id table
         virtual ElementNode* GetChildElement(const std::string& strId) {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            if (this->childNodes.contains(strId)) {
-                return this->childNodes[strId];
-            }
-            else if (ElementNode::DoElementErrorChecking) {
-                std::stringstream errmsg;
-                errmsg << "Invalid element access detected! " <<
-                    "Attempted to access an element of id \"" << strId <<
-                    "\" from the element \"" << this->selfId <<
-                    "\", but the parent element does not contain a child element with the specified id.";
-                throw std::runtime_error(errmsg.str());
-            }
-            else return nullptr;
+            return this->GetChildElement(ElementIdTable::Instance().Find(strId), strId);
+        }
+        ElementNode* GetChildElement(ElementId id) {
+            return this->GetChildElement(id, ElementIdTable::Instance().Name(id));
         }
         virtual std::vector<std::string> GetAllChildElements() {
             std::lock_guard<std::mutex> guard(this->elementLock);
             std::vector<std::string> childElementsIds;
-            for (auto& elmt : this->childNodes) {
-                childElementsIds.push_back(elmt.first);
+            childElementsIds.reserve(this->childNodes.Size());
+            for (const ChildEntry& child : this->childNodes.Entries()) {
+                childElementsIds.push_back(ElementIdTable::Instance().Name(child.id));
             }
             return childElementsIds;
         }
-        virtual size_t RecursiveCountAllChildNodes() {
-            size_t count = 0;
-            count += this->childNodes.size();
-            for (auto& node : this->childNodes) {
-                count += node.second->RecursiveCountAllChildNodes();
+        //calls visit(ElementId, ElementNode*) for every child without allocating, under the element lock
+        //visit must not call anything of this element that takes its lock, adding, removing or getting children included
+        template <class Visit>
+        void ForEachChildElement(Visit&& visit) {
+            std::lock_guard<std::mutex> guard(this->elementLock);
+            for (const ChildEntry& child : this->childNodes.Entries()) {
+                visit(child.id, child.element);
             }
-            return count;
+        }
+        //the children as they are stored, no lock is taken, only for the thread that adds and removes this element's children
+        //invalidated by the next add or remove
+        std::span<const ChildEntry> GetChildren() const {
+            return this->childNodes.Entries();
+        }
+        virtual size_t RecursiveCountAllChildNodes() {
+            return this->store().CountSubtree(this->handle.index) - 1;
         }
     };
 
@@ -386,7 +559,7 @@ namespace cpplab {
 
         void setPolygonSides(int sides) {
             std::lock_guard<std::mutex> guard(this->elementLock);
-            this->polygon_sides = max(sides, 3);
+            this->polygon_sides = (std::max)(sides, 3);
             this->modified = true;
         }
         int getPolygonSides() {
@@ -396,7 +569,7 @@ namespace cpplab {
 
         void setStarVertices(int vertices) {
             std::lock_guard<std::mutex> guard(this->elementLock);
-            this->star_vertices = max(4, vertices);
+            this->star_vertices = (std::max)(4, vertices);
             this->modified = true;
         }
         int getStarVertices() {
@@ -405,7 +578,7 @@ namespace cpplab {
         }
         void setStarInnerRadius(int px) {
             std::lock_guard<std::mutex> guard(this->elementLock);
-            this->star_innerRD = max(px, 1);
+            this->star_innerRD = (std::max)(px, 1);
             this->modified = true;
         }
         int getStarInnerRadius() {
@@ -493,176 +666,135 @@ namespace cpplab {
         }
     };
 
-    class TextElement : public ElementNode {
-    private:
-        // text color
-        // background color
-        // border color
-        // border width
-        // rounded edge radius
-        // text margin
-        // font style
-        // text alignment
-        //
+    struct TextElementState : public ElementState {
+        Color textColor = Color(0.0f);
+        Color backgroundColor = Color(1.0f, 0.0f);
+        Color borderColor = Color(0.0f);
+        float borderWidthPx = 0.f;
+        float roundedEdgePx = 0.f;
+        float textMarginPx = 0.f;
 
-        Color textColor, backgroundColor, borderColor;
-        float borderWidthPx;
-        float roundedEdgePx;
-        float textMarginPx;
+        FontStyle fontStyle = FontStyle::Arial;
+        HAlign textHAlign = HAlign::LEFT;
+        VAlign textVAlign = VAlign::TOP;
+        float textPointSize = 12.f;
 
-        FontStyle fontStyle;
-        HAlign textHAlign;
-        VAlign textVAlign;
-        float textPointSize;
+        //shared between blocks so changing a color does not copy the text
+        std::shared_ptr<const std::wstring> text;
 
-        std::wstring text;
+        std::shared_ptr<ElementState> Clone() const override {
+            return std::make_shared<TextElementState>(*this);
+        }
+    };
+
+    class TextElement : public ElementNode {
     public:
         TextElement() {
-            this->textColor = Color(0.0f);
-            this->backgroundColor = Color(1.0f, 0.0f);
-            this->borderColor = Color(0.0f);
-            this->borderWidthPx = 0.f;
-            this->roundedEdgePx = 0.f;
-            this->textMarginPx = 0.f;
-
-            this->fontStyle = FontStyle::Arial;
-            this->textHAlign = HAlign::LEFT;
-            this->textVAlign = VAlign::TOP;
-            this->textPointSize = 12.f;
-
-            this->type = NodeType::TEXT_AREA;
-            this->text = L"Use setText to set element text.";
+            std::shared_ptr<TextElementState> state = this->extendState<TextElementState>();
+            state->text = std::make_shared<const std::wstring>(L"Use setText to set element text.");
+            this->setInitialState(std::move(state));
+            this->setNodeType(NodeType::TEXT_AREA);
         }
         TextElement(const TextElementConfiguration& config) : 
         ElementNode(reinterpret_cast<const ElementNodeConfiguration&>(config)) {
-            this->textColor = config.textColor;
-            this->backgroundColor = config.backgroundColor;
-            this->borderColor = config.borderColor;
-            this->borderWidthPx = config.borderWidthPx;
-            this->roundedEdgePx = config.roundedEdgePx;
-            this->textMarginPx = config.textMarginPx;
-
-            this->fontStyle = config.fontStyle;
-            this->textHAlign = config.textHorizontalAlignment;
-            this->textVAlign = config.textVerticalAlignment;
-            this->textPointSize = config.textPtSize;
-
-            this->text = config.startingText;
-
-            this->type = NodeType::TEXT_AREA;
+            std::shared_ptr<TextElementState> state = this->extendState<TextElementState>();
+            state->textColor = config.textColor;
+            state->backgroundColor = config.backgroundColor;
+            state->borderColor = config.borderColor;
+            state->borderWidthPx = config.borderWidthPx;
+            state->roundedEdgePx = config.roundedEdgePx;
+            state->textMarginPx = config.textMarginPx;
+
+            state->fontStyle = config.fontStyle;
+            state->textHAlign = config.textHorizontalAlignment;
+            state->textVAlign = config.textVerticalAlignment;
+            state->textPointSize = config.textPtSize;
+
+            state->text = std::make_shared<const std::wstring>(config.startingText);
+            this->setInitialState(std::move(state));
+
+            this->setNodeType(NodeType::TEXT_AREA);
             
         }
 
         void setText(const std::wstring& text) {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            this->text = text;
-            this->modified = true;
+            std::shared_ptr<const std::wstring> shared = std::make_shared<const std::wstring>(text);
+            this->updateState<TextElementState>(DIRTY_TEXT_CONTENT, [&shared](TextElementState& state) { state.text = shared; });
         }
         std::wstring getText() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            return this->text;
+            return *this->loadState<TextElementState>()->text;
         }
             
         
         Color getTextColor() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            return this->textColor;
+            return this->loadState<TextElementState>()->textColor;
         }
         void setTextColor(Color color) {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            this->textColor = color;
-            this->modified = true;
+            this->updateState<TextElementState>(DIRTY_PAINT, [color](TextElementState& state) { state.textColor = color; });
         }
 
         Color getBackgroundColor() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            return this->backgroundColor;
+            return this->loadState<TextElementState>()->backgroundColor;
         }
         void setBackgroundColor(Color color) {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            this->backgroundColor = color;
-            this->modified = true;
+            this->updateState<TextElementState>(DIRTY_PAINT, [color](TextElementState& state) { state.backgroundColor = color; });
         }
 
         Color getBorderColor() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            return this->borderColor;
+            return this->loadState<TextElementState>()->borderColor;
         }
         void setBorderColor(Color color) {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            this->borderColor = color;
-            this->modified = true;
+            this->updateState<TextElementState>(DIRTY_PAINT, [color](TextElementState& state) { state.borderColor = color; });
         }
 
         float getBorderWidth() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            return this->borderWidthPx;
+            return this->loadState<TextElementState>()->borderWidthPx;
         }
         void setBorderWidth(float width) {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            this->borderWidthPx = width;
-            this->modified = true;
+            this->updateState<TextElementState>(DIRTY_GEOMETRY, [width](TextElementState& state) { state.borderWidthPx = width; });
         }
 
 
         float getRoundedEdge() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            return this->roundedEdgePx;
+            return this->loadState<TextElementState>()->roundedEdgePx;
         }
         void setRoundedEdge(float radius) {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            this->roundedEdgePx = radius;
-            this->modified = true;
+            this->updateState<TextElementState>(DIRTY_GEOMETRY, [radius](TextElementState& state) { state.roundedEdgePx = radius; });
         }
 
         float getTextMargin() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            return this->textMarginPx;
+            return this->loadState<TextElementState>()->textMarginPx;
         }
         void setTextMargin(float margin) {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            this->textMarginPx = margin;
-            this->modified = true;
+            this->updateState<TextElementState>(DIRTY_GEOMETRY, [margin](TextElementState& state) { state.textMarginPx = margin; });
         }
 
         float getTextPointSize() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            return this->textPointSize;
+            return this->loadState<TextElementState>()->textPointSize;
         }
         void setTextPointSize(float pt) {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            this->textPointSize = pt;
-            this->modified = true;
+            this->updateState<TextElementState>(DIRTY_TEXT_FORMAT, [pt](TextElementState& state) { state.textPointSize = pt; });
         }
 
         FontStyle getFontStyle() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            return this->fontStyle;
+            return this->loadState<TextElementState>()->fontStyle;
         }
         void setFontStyle(FontStyle style) {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            this->fontStyle = style;
-            this->modified = true;
+            this->updateState<TextElementState>(DIRTY_TEXT_FORMAT, [style](TextElementState& state) { state.fontStyle = style; });
         }
 
         HAlign getTextHAlign() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            return this->textHAlign;
+            return this->loadState<TextElementState>()->textHAlign;
         }
         void setTextHAlign(HAlign align) {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            this->textHAlign = align;
-            this->modified = true;
+            this->updateState<TextElementState>(DIRTY_TEXT_FORMAT, [align](TextElementState& state) { state.textHAlign = align; });
         }
 
         VAlign getTextVAlign() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            return this->textVAlign;
+            return this->loadState<TextElementState>()->textVAlign;
         }
         void setTextVAlign(VAlign align) {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            this->textVAlign = align;
-            this->modified = true;
+            this->updateState<TextElementState>(DIRTY_TEXT_FORMAT, [align](TextElementState& state) { state.textVAlign = align; });
         }
     };
     
@@ -676,92 +808,130 @@ namespace cpplab {
         FIT_TO_IMAGE, FIT_TO_BOUNDING_BOX
     };
 
-    class ImageElement : public ElementNode {
-        friend class WindowD2DRenderer;
-    private:
+    struct ImageElementState : public ElementState {
+        Color borderColor = Color(0.0f);
+        float borderWidthPx = 0.f;
+        float roundedEdgePx = 0.f;
+        ImageFillMode fillMode = ImageFillMode::CONTAIN;
+        BorderWrapMode borderMode = BorderWrapMode::FIT_TO_IMAGE;
+
+        std::wstring imageName;
+        ImageType imgType = ImageType::FILE;
+
+        std::shared_ptr<ElementState> Clone() const override {
+            return std::make_shared<ImageElementState>(*this);
+        }
+    };
+
+    struct ImageElementConfiguration : public ElementNodeConfiguration {
+    public:
         Color borderColor;
-        float borderWidthPx;
-        float roundedEdgePx;
+        float borderWidthPx, roundedEdgePx;
         ImageFillMode fillMode;
         BorderWrapMode borderMode;
 
         std::wstring imageName;
         ImageType imgType;
-        bool imgModified;
-    public:
-        ImageElement() {
+
+        ImageElementConfiguration() {
             this->borderColor = Color(0.0f);
-            this->fillMode = ImageFillMode::CONTAIN;
             this->borderWidthPx = 0.f;
             this->roundedEdgePx = 0.f;
-            this->type = NodeType::IMAGE;
-            this->imageName = L"";
-            this->imgType = ImageType::FILE;
-            this->imgModified = true;
+            this->fillMode = ImageFillMode::CONTAIN;
             this->borderMode = BorderWrapMode::FIT_TO_IMAGE;
+            this->imgType = ImageType::FILE;
+        }
+        ImageElementConfiguration& setBorderColor(Color c) {
+            this->borderColor = c;
+            return *this;
+        }
+        ImageElementConfiguration& setBorderWidth(float px) {
+            this->borderWidthPx = px;
+            return *this;
+        }
+        ImageElementConfiguration& setRoundedEdgeRadius(float px) {
+            this->roundedEdgePx = px;
+            return *this;
+        }
+        ImageElementConfiguration& setFillMode(ImageFillMode mode) {
+            this->fillMode = mode;
+            return *this;
+        }
+        ImageElementConfiguration& setBorderWrapMode(BorderWrapMode mode) {
+            this->borderMode = mode;
+            return *this;
+        }
+        ImageElementConfiguration& setImageFile(const std::wstring& file, ImageType type) {
+            this->imageName = file;
+            this->imgType = type;
+            return *this;
+        }
+    };
+
+    class ImageElement : public ElementNode {
+    public:
+        ImageElement() {
+            this->setInitialState(this->extendState<ImageElementState>());
+            this->setNodeType(NodeType::IMAGE);
+        }
+        ImageElement(const ImageElementConfiguration& config) :
+        ElementNode(static_cast<const ElementNodeConfiguration&>(config)) {
+            std::shared_ptr<ImageElementState> state = this->extendState<ImageElementState>();
+            state->borderColor = config.borderColor;
+            state->borderWidthPx = config.borderWidthPx;
+            state->roundedEdgePx = config.roundedEdgePx;
+            state->fillMode = config.fillMode;
+            state->borderMode = config.borderMode;
+            state->imageName = config.imageName;
+            state->imgType = config.imgType;
+            this->setInitialState(std::move(state));
+            this->setNodeType(NodeType::IMAGE);
         }
 
         void setBorderWrapMode(BorderWrapMode mode) {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            this->borderMode = mode;
-            this->modified = true;
+            this->updateState<ImageElementState>(DIRTY_GEOMETRY, [mode](ImageElementState& state) { state.borderMode = mode; });
         }
 
         BorderWrapMode getBorderWrapMode() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            return this->borderMode;
+            return this->loadState<ImageElementState>()->borderMode;
         }
 
         std::wstring getImageFileName() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            return this->imageName;
+            return this->loadState<ImageElementState>()->imageName;
         }
         void setImageFile(const std::wstring& file, ImageType type) {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            this->imageName = file;
-            this->imgType = type;
-            this->modified = true;
-            this->imgModified = true;
+            this->updateState<ImageElementState>(DIRTY_IMAGE_SOURCE, [&file, type](ImageElementState& state) {
+                state.imageName = file;
+                state.imgType = type;
+            });
         }
 
         Color getBorderColor() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            return this->borderColor;
+            return this->loadState<ImageElementState>()->borderColor;
         }
         void setBorderColor(const Color& color) {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            this->borderColor = color;
-            this->modified = true;
+            this->updateState<ImageElementState>(DIRTY_PAINT, [&color](ImageElementState& state) { state.borderColor = color; });
         }
 
         float getBorderWidthPx() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            return this->borderWidthPx;
+            return this->loadState<ImageElementState>()->borderWidthPx;
         }
         void setBorderWidthPx(float width) {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            this->borderWidthPx = width;
-            this->modified = true;
+            this->updateState<ImageElementState>(DIRTY_GEOMETRY, [width](ImageElementState& state) { state.borderWidthPx = width; });
         }
 
         float getRoundedEdgePx() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            return this->roundedEdgePx;
+            return this->loadState<ImageElementState>()->roundedEdgePx;
         }
         void setRoundedEdgePx(float radius) {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            this->roundedEdgePx = radius;
-            this->modified = true;
+            this->updateState<ImageElementState>(DIRTY_GEOMETRY, [radius](ImageElementState& state) { state.roundedEdgePx = radius; });
         }
 
         ImageFillMode getFillMode() {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            return this->fillMode;
+            return this->loadState<ImageElementState>()->fillMode;
         }
         void setFillMode(ImageFillMode mode) {
-            std::lock_guard<std::mutex> guard(this->elementLock);
-            this->fillMode = mode;
-            this->modified = true;
+            this->updateState<ImageElementState>(DIRTY_GEOMETRY, [mode](ImageElementState& state) { state.fillMode = mode; });
         }
     };
 }
\ No newline at end of file
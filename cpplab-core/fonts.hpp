@@ -4,8 +4,9 @@ namespace cpplab {
 	enum class FontStyle {
 		Arial, Calibri
 	};
-	static const wchar_t* FontStyleToString(FontStyle style) {
+	inline const wchar_t* FontStyleToString(FontStyle style) {
 		if (style == FontStyle::Arial) return L"Arial";
 		if (style == FontStyle::Calibri) return L"Calibri";
+		return L"Arial";
 	}
 }
\ No newline at end of file
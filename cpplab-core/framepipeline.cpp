@@ -0,0 +1,294 @@
+#include <chrono>
+#include <cstring>
+#include "framepipeline.hpp"
+
+namespace cpplab {
+    namespace {
+        //a few seconds of frames, the window renderer takes them before every frame
+        constexpr size_t ReplayTimeCapacity = 256;
+    }
+
+    SnapshotBitmap::~SnapshotBitmap() {
+        this->pipeline->ReleaseBitmap(this->id);
+    }
+    vec2 SnapshotBitmap::GetSize() const {
+        return this->size;
+    }
+    SnapshotTextFormat::~SnapshotTextFormat() {
+        this->pipeline->ReleaseTextFormat(this->id);
+    }
+
+    FramePipeline::FramePipeline(RenderDevice* target, size_t maxQueuedFrames, std::function<void()> recreateTarget) :
+        submitted(maxQueuedFrames), recycled(maxQueuedFrames + 1), replayTimes(ReplayTimeCapacity) {
+        this->target = target;
+        this->recreateTarget = std::move(recreateTarget);
+        this->size = target->GetSize();
+        this->recording = new FrameSnapshot();
+        this->renderThread = std::thread(&FramePipeline::RenderLoop, this);
+    }
+    FramePipeline::~FramePipeline() {
+        this->stopping.store(true, std::memory_order_release);
+        this->submitSignal.fetch_add(1, std::memory_order_release);
+        this->submitSignal.notify_all();
+        this->renderThread.join();
+
+        //frames still queued are dropped, the device resources go with the replayer
+        FrameSnapshot* snapshot = nullptr;
+        while (this->submitted.TryPop(snapshot)) delete snapshot;
+        while (this->recycled.TryPop(snapshot)) delete snapshot;
+        delete this->recording;
+    }
+
+    void FramePipeline::RenderLoop() {
+        for (;;) {
+            //read the count before looking at the queue so a push in between wakes the wait
+            const uint64_t seenSubmits = this->submitSignal.load(std::memory_order_acquire);
+            FrameSnapshot* snapshot = nullptr;
+            if (!this->submitted.TryPop(snapshot)) {
+                if (this->stopping.load(std::memory_order_acquire)) return;
+                this->submitSignal.wait(seenSubmits, std::memory_order_acquire);
+                continue;
+            }
+
+            if (this->recreateRequested.exchange(false, std::memory_order_acq_rel)) {
+                this->replayer.ReleaseAll();
+                if (this->recreateTarget) this->recreateTarget();
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            if (!this->replayer.Replay(*snapshot, *this->target)) {
+                //the ui recreates everything once it sees the flag, draws until then skip the missing resources
+                this->replayer.ReleaseAll();
+                this->targetLosses.fetch_add(1, std::memory_order_relaxed);
+                this->targetLost.store(true, std::memory_order_release);
+            }
+            const uint64_t elapsed = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start
+            ).count());
+            this->replayMicroseconds.fetch_add(elapsed, std::memory_order_relaxed);
+            if (elapsed > this->maxReplayMicroseconds.load(std::memory_order_relaxed)) {
+                this->maxReplayMicroseconds.store(elapsed, std::memory_order_relaxed);
+            }
+
+            this->replayTimes.TryPush(FrameReplayTime{ snapshot->frameTag, elapsed });
+
+            const bool presented = snapshot->drawsFrame;
+            snapshot->Clear();
+            if (!this->recycled.TryPush(snapshot)) delete snapshot;
+            if (presented) this->framesPresented.fetch_add(1, std::memory_order_relaxed);
+            this->snapshotsReplayed.fetch_add(1, std::memory_order_release);
+            this->snapshotsReplayed.notify_all();
+            if (presented && this->presentCallback) this->presentCallback();
+        }
+    }
+
+    FrameSnapshot* FramePipeline::NextSnapshot() {
+        FrameSnapshot* snapshot = nullptr;
+        if (this->recycled.TryPop(snapshot)) return snapshot;
+        return new FrameSnapshot();
+    }
+    void FramePipeline::Submit() {
+        this->bytesSubmitted.fetch_add(this->recording->CopiedBytes(), std::memory_order_relaxed);
+        this->recording->frameTag = this->frameTag;
+        for (;;) {
+            const uint64_t seenReplays = this->snapshotsReplayed.load(std::memory_order_acquire);
+            if (this->submitted.TryPush(this->recording)) break;
+            //backpressure, only reached when the caller did not check CanSubmitFrame
+            this->submitWaits.fetch_add(1, std::memory_order_relaxed);
+            this->snapshotsReplayed.wait(seenReplays, std::memory_order_acquire);
+        }
+        this->snapshotsSubmitted.fetch_add(1, std::memory_order_relaxed);
+        this->submitSignal.fetch_add(1, std::memory_order_release);
+        this->submitSignal.notify_one();
+        this->recording = this->NextSnapshot();
+    }
+    SnapshotCommand& FramePipeline::Record(SnapshotOp op) {
+        this->recording->commands.emplace_back();
+        SnapshotCommand& command = this->recording->commands.back();
+        command.op = op;
+        return command;
+    }
+
+    void FramePipeline::ReleaseBitmap(uint32_t id) {
+        this->Record(SnapshotOp::RELEASE_BITMAP).resource = id;
+        this->freeBitmapIds.push_back(id);
+    }
+    void FramePipeline::ReleaseTextFormat(uint32_t id) {
+        this->Record(SnapshotOp::RELEASE_TEXT_FORMAT).resource = id;
+        this->freeTextFormatIds.push_back(id);
+    }
+
+    void FramePipeline::RecreateTarget() {
+        this->recreateRequested.store(true, std::memory_order_release);
+    }
+    void FramePipeline::Flush() {
+        if (this->recording->commands.empty()) return;
+        this->Submit();
+    }
+    void FramePipeline::WaitIdle() {
+        const uint64_t target = this->snapshotsSubmitted.load(std::memory_order_relaxed);
+        for (;;) {
+            const uint64_t replayed = this->snapshotsReplayed.load(std::memory_order_acquire);
+            if (replayed == target) return;
+            this->snapshotsReplayed.wait(replayed, std::memory_order_acquire);
+        }
+    }
+    void FramePipeline::SetSize(vec2 size) {
+        this->size = size;
+    }
+    void FramePipeline::SetPresentCallback(std::function<void()> callback) {
+        this->presentCallback = std::move(callback);
+    }
+    FramePipelineStats FramePipeline::GetStats() const {
+        FramePipelineStats stats;
+        stats.framesSubmitted = this->framesSubmitted.load(std::memory_order_relaxed);
+        stats.framesPresented = this->framesPresented.load(std::memory_order_relaxed);
+        stats.framesDeferred = this->framesDeferred.load(std::memory_order_relaxed);
+        stats.submitWaits = this->submitWaits.load(std::memory_order_relaxed);
+        stats.targetLosses = this->targetLosses.load(std::memory_order_relaxed);
+        stats.bytesSubmitted = this->bytesSubmitted.load(std::memory_order_relaxed);
+        stats.replayMicroseconds = this->replayMicroseconds.load(std::memory_order_relaxed);
+        stats.maxReplayMicroseconds = this->maxReplayMicroseconds.load(std::memory_order_relaxed);
+        stats.queuedFrames = this->submitted.Size();
+        stats.maxQueuedFrames = this->submitted.Capacity();
+        return stats;
+    }
+
+    void FramePipeline::BeginFrame() {
+        this->recording->drawsFrame = true;
+        this->recording->frameNumber = this->nextFrameNumber++;
+        this->transform = Transform2D::Identity();
+        this->Record(SnapshotOp::BEGIN_FRAME);
+    }
+    bool FramePipeline::EndFrame() {
+        this->framesSubmitted.fetch_add(1, std::memory_order_relaxed);
+        this->Submit();
+        return true;
+    }
+    vec2 FramePipeline::GetSize() const {
+        return this->size;
+    }
+
+    void FramePipeline::Clear(const Color& color) {
+        this->Record(SnapshotOp::CLEAR).color = color;
+    }
+    void FramePipeline::SetTransform(const Transform2D& transform) {
+        this->transform = transform;
+        SnapshotCommand& command = this->Record(SnapshotOp::SET_TRANSFORM);
+        command.values[0] = transform.m11;
+        command.values[1] = transform.m12;
+        command.values[2] = transform.m21;
+        command.values[3] = transform.m22;
+        command.values[4] = transform.dx;
+        command.values[5] = transform.dy;
+    }
+    Transform2D FramePipeline::GetTransform() const {
+        return this->transform;
+    }
+
+    void FramePipeline::PushClip(const RectF& rect) {
+        SnapshotCommand& command = this->Record(SnapshotOp::PUSH_CLIP);
+        command.values[0] = rect.left;
+        command.values[1] = rect.top;
+        command.values[2] = rect.right;
+        command.values[3] = rect.bottom;
+    }
+    void FramePipeline::PopClip() {
+        this->Record(SnapshotOp::POP_CLIP);
+    }
+
+    void FramePipeline::FillRoundedRect(const RoundedRectF& rect, const Color& color) {
+        SnapshotCommand& command = this->Record(SnapshotOp::FILL_ROUNDED_RECT);
+        command.values[0] = rect.rect.left;
+        command.values[1] = rect.rect.top;
+        command.values[2] = rect.rect.right;
+        command.values[3] = rect.rect.bottom;
+        command.values[4] = rect.radiusX;
+        command.values[5] = rect.radiusY;
+        command.color = color;
+    }
+    void FramePipeline::StrokeRoundedRect(const RoundedRectF& rect, const Color& color, float strokeWidth) {
+        SnapshotCommand& command = this->Record(SnapshotOp::STROKE_ROUNDED_RECT);
+        command.values[0] = rect.rect.left;
+        command.values[1] = rect.rect.top;
+        command.values[2] = rect.rect.right;
+        command.values[3] = rect.rect.bottom;
+        command.values[4] = rect.radiusX;
+        command.values[5] = rect.radiusY;
+        command.values[6] = strokeWidth;
+        command.color = color;
+    }
+
+    RenderBitmap* FramePipeline::CreateBitmap(const PixelBuffer& pixels) {
+        //the caller may reuse its buffer, so take a copy the render thread can read later
+        return this->CreateSharedBitmap(std::make_shared<const PixelBuffer>(pixels));
+    }
+    RenderBitmap* FramePipeline::CreateSharedBitmap(const std::shared_ptr<const PixelBuffer>& pixels) {
+        SnapshotBitmap* bitmap = new SnapshotBitmap();
+        bitmap->pipeline = this;
+        bitmap->size = vec2(static_cast<float>(pixels->width), static_cast<float>(pixels->height));
+        if (!this->freeBitmapIds.empty()) {
+            bitmap->id = this->freeBitmapIds.back();
+            this->freeBitmapIds.pop_back();
+        }
+        else bitmap->id = this->nextBitmapId++;
+
+        SnapshotCommand& command = this->Record(SnapshotOp::CREATE_BITMAP);
+        command.resource = bitmap->id;
+        command.payload = static_cast<uint32_t>(this->recording->bitmaps.size());
+        this->recording->bitmaps.push_back(pixels);
+        return bitmap;
+    }
+    void FramePipeline::UpdateBitmap(RenderBitmap* bitmap, const PixelRegion& region, const uint8_t* pixels, uint32_t stride) {
+        //only the region is copied, tightly packed
+        SnapshotRegionUpdate update;
+        update.region = region;
+        update.offset = this->recording->pixelData.size();
+        const size_t rowBytes = static_cast<size_t>(region.width) * 4;
+        this->recording->pixelData.resize(update.offset + rowBytes * region.height);
+        for (uint32_t row = 0; row < region.height; ++row) {
+            std::memcpy(&this->recording->pixelData[update.offset + row * rowBytes], pixels + static_cast<size_t>(row) * stride, rowBytes);
+        }
+
+        SnapshotCommand& command = this->Record(SnapshotOp::UPDATE_BITMAP);
+        command.resource = static_cast<SnapshotBitmap*>(bitmap)->id;
+        command.payload = static_cast<uint32_t>(this->recording->regionUpdates.size());
+        this->recording->regionUpdates.push_back(update);
+    }
+    void FramePipeline::DrawBitmap(RenderBitmap* bitmap, const RectF& destination, float opacity) {
+        SnapshotCommand& command = this->Record(SnapshotOp::DRAW_BITMAP);
+        command.resource = static_cast<SnapshotBitmap*>(bitmap)->id;
+        command.values[0] = destination.left;
+        command.values[1] = destination.top;
+        command.values[2] = destination.right;
+        command.values[3] = destination.bottom;
+        command.values[4] = opacity;
+    }
+
+    RenderTextFormat* FramePipeline::CreateTextFormat(const TextFormatDesc& desc) {
+        SnapshotTextFormat* format = new SnapshotTextFormat();
+        format->pipeline = this;
+        if (!this->freeTextFormatIds.empty()) {
+            format->id = this->freeTextFormatIds.back();
+            this->freeTextFormatIds.pop_back();
+        }
+        else format->id = this->nextTextFormatId++;
+
+        SnapshotCommand& command = this->Record(SnapshotOp::CREATE_TEXT_FORMAT);
+        command.resource = format->id;
+        command.payload = static_cast<uint32_t>(this->recording->textFormats.size());
+        this->recording->textFormats.push_back(desc);
+        return format;
+    }
+    void FramePipeline::DrawString(const std::wstring& text, RenderTextFormat* format, const RectF& layoutBox, const Color& color) {
+        SnapshotCommand& command = this->Record(SnapshotOp::DRAW_STRING);
+        command.resource = static_cast<SnapshotTextFormat*>(format)->id;
+        command.payload = static_cast<uint32_t>(this->recording->strings.size());
+        command.values[0] = layoutBox.left;
+        command.values[1] = layoutBox.top;
+        command.values[2] = layoutBox.right;
+        command.values[3] = layoutBox.bottom;
+        command.color = color;
+        this->recording->strings.push_back(text);
+    }
+}
@@ -0,0 +1,173 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <vector>
+#include "framesnapshot.hpp"
+#include "spscqueue.hpp"
+
+namespace cpplab {
+    class FramePipeline;
+
+    //stand ins handed to the scene on the ui thread, the real resources live on the render thread under the same id
+    class SnapshotBitmap : public RenderBitmap {
+    public:
+        FramePipeline* pipeline = nullptr;
+        uint32_t id = 0;
+        vec2 size;
+        ~SnapshotBitmap();
+        vec2 GetSize() const override;
+    };
+    class SnapshotTextFormat : public RenderTextFormat {
+    public:
+        FramePipeline* pipeline = nullptr;
+        uint32_t id = 0;
+        ~SnapshotTextFormat();
+    };
+
+    struct FramePipelineStats {
+        uint64_t framesSubmitted = 0;
+        uint64_t framesPresented = 0;
+        //frames the ui thread held back because the queue was full
+        uint64_t framesDeferred = 0;
+        //submits that had to wait for a free slot, zero while the ui checks CanSubmitFrame first
+        uint64_t submitWaits = 0;
+        uint64_t targetLosses = 0;
+        uint64_t bytesSubmitted = 0;
+        uint64_t replayMicroseconds = 0;
+        uint64_t maxReplayMicroseconds = 0;
+        size_t queuedFrames = 0;
+        size_t maxQueuedFrames = 0;
+    };
+
+    //how long the render thread took for one snapshot, tagged with the frame tag it was submitted under
+    struct FrameReplayTime {
+        uint64_t frameTag = 0;
+        uint64_t microseconds = 0;
+    };
+
+    //runs the device on its own render thread, the ui thread only records
+    //a scene renderer draws into the pipeline as its device, every finished frame becomes an immutable snapshot
+    //snapshots go through a bounded lock free queue and come back through a second one to be reused
+    //create the pipeline before the scene drawing into it and destroy it after, the scene's resources release through it
+    class FramePipeline : public RenderDevice {
+        friend class SnapshotBitmap;
+        friend class SnapshotTextFormat;
+    private:
+        RenderDevice* target;
+        std::function<void()> recreateTarget;
+
+        //ui side
+        FrameSnapshot* recording = nullptr;
+        vec2 size;
+        Transform2D transform;
+        uint64_t nextFrameNumber = 1;
+        uint64_t frameTag = 0;
+        std::vector<uint32_t> freeBitmapIds;
+        std::vector<uint32_t> freeTextFormatIds;
+        uint32_t nextBitmapId = 0;
+        uint32_t nextTextFormatId = 0;
+
+        SpscQueue<FrameSnapshot*> submitted;
+        SpscQueue<FrameSnapshot*> recycled;
+        //replay times on their way back, dropped while the ui does not take them
+        SpscQueue<FrameReplayTime> replayTimes;
+        //bumped on every submit and on shutdown, the render thread sleeps on it
+        std::atomic<uint64_t> submitSignal = 0;
+        std::atomic<uint64_t> snapshotsSubmitted = 0;
+        //bumped after every replayed snapshot, a ui thread waiting for room or idle sleeps on it
+        std::atomic<uint64_t> snapshotsReplayed = 0;
+
+        //render side
+        SnapshotReplayer replayer;
+        std::thread renderThread;
+        std::atomic<bool> stopping = false;
+        std::atomic<bool> recreateRequested = false;
+        std::atomic<bool> targetLost = false;
+        std::function<void()> presentCallback;
+
+        std::atomic<uint64_t> framesSubmitted = 0;
+        std::atomic<uint64_t> framesPresented = 0;
+        std::atomic<uint64_t> framesDeferred = 0;
+        std::atomic<uint64_t> submitWaits = 0;
+        std::atomic<uint64_t> targetLosses = 0;
+        std::atomic<uint64_t> bytesSubmitted = 0;
+        std::atomic<uint64_t> replayMicroseconds = 0;
+        std::atomic<uint64_t> maxReplayMicroseconds = 0;
+
+        void RenderLoop();
+        FrameSnapshot* NextSnapshot();
+        void Submit();
+        SnapshotCommand& Record(SnapshotOp op);
+        void ReleaseBitmap(uint32_t id);
+        void ReleaseTextFormat(uint32_t id);
+
+    public:
+        //maxQueuedFrames bounds how far the ui can run ahead of the render thread
+        //recreateTarget runs on the render thread after RecreateTarget was called, it may be empty
+        FramePipeline(RenderDevice* target, size_t maxQueuedFrames, std::function<void()> recreateTarget);
+        FramePipeline(const FramePipeline&) = delete;
+        FramePipeline& operator=(const FramePipeline&) = delete;
+        ~FramePipeline();
+
+        //ui thread
+        //false while the queue is full, hold the frame back and try again once one was presented
+        bool CanSubmitFrame() const {
+            return !this->submitted.IsFull();
+        }
+        void DeferFrame() {
+            this->framesDeferred.fetch_add(1, std::memory_order_relaxed);
+        }
+        //true once after the render thread lost its target, release the scene's device resources and redraw everything
+        bool TakeTargetLost() {
+            return this->targetLost.exchange(false, std::memory_order_acq_rel);
+        }
+        bool IsTargetLost() const {
+            return this->targetLost.load(std::memory_order_acquire);
+        }
+        //the render thread drops its resources and calls recreateTarget before the next snapshot
+        void RecreateTarget();
+        //sends resource changes recorded outside a frame without waiting for the next one
+        void Flush();
+        //blocks until every submitted snapshot was replayed
+        void WaitIdle();
+        void SetSize(vec2 size);
+        //snapshots submitted from now on carry the tag, the window renderer passes the profiler frame about to be measured
+        void SetFrameTag(uint64_t tag) {
+            this->frameTag = tag;
+        }
+        //the replay time of the oldest snapshot not taken yet, false when there is none
+        bool TakeReplayTime(FrameReplayTime& time) {
+            return this->replayTimes.TryPop(time);
+        }
+        //called on the render thread after every presented frame, set it before the first frame
+        void SetPresentCallback(std::function<void()> callback);
+        FramePipelineStats GetStats() const;
+
+        //recording device, only used by the ui thread
+        void BeginFrame() override;
+        //hands the frame to the render thread, always true, losses are reported through TakeTargetLost
+        bool EndFrame() override;
+        vec2 GetSize() const override;
+
+        void Clear(const Color& color) override;
+        void SetTransform(const Transform2D& transform) override;
+        Transform2D GetTransform() const override;
+
+        void PushClip(const RectF& rect) override;
+        void PopClip() override;
+
+        void FillRoundedRect(const RoundedRectF& rect, const Color& color) override;
+        void StrokeRoundedRect(const RoundedRectF& rect, const Color& color, float strokeWidth) override;
+
+        RenderBitmap* CreateBitmap(const PixelBuffer& pixels) override;
+        RenderBitmap* CreateSharedBitmap(const std::shared_ptr<const PixelBuffer>& pixels) override;
+        void UpdateBitmap(RenderBitmap* bitmap, const PixelRegion& region, const uint8_t* pixels, uint32_t stride) override;
+        void DrawBitmap(RenderBitmap* bitmap, const RectF& destination, float opacity) override;
+
+        RenderTextFormat* CreateTextFormat(const TextFormatDesc& desc) override;
+        void DrawString(const std::wstring& text, RenderTextFormat* format, const RectF& layoutBox, const Color& color) override;
+    };
+}
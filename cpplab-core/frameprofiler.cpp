@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <iterator>
+#include "frameprofiler.hpp"
+
+namespace cpplab {
+    namespace {
+        //phases measured off the ui thread, their time arrives after the frame ended
+        bool IsLatePhase(size_t phase) {
+            return phase == static_cast<size_t>(ProfilePhase::PRESENT);
+        }
+    }
+
+    FrameProfiler::FrameProfiler(size_t windowFrames) {
+        this->windowFrames = (std::max)(windowFrames, size_t(1));
+        this->samples.assign(this->windowFrames * ProfilePhaseCount, 0.f);
+    }
+
+    void FrameProfiler::SetEnabled(bool enabled) {
+        //times gathered before a pause would otherwise land in the first frame after it
+        std::fill(std::begin(this->phaseNanoseconds), std::end(this->phaseNanoseconds), 0);
+        std::fill(std::begin(this->counters), std::end(this->counters), 0);
+        this->enabled = enabled;
+    }
+
+    void FrameProfiler::EndFrame() {
+        if (!this->enabled) return;
+        for (size_t phase = 0; phase < ProfilePhaseCount; ++phase) {
+            const float microseconds = static_cast<float>(this->phaseNanoseconds[phase]) / 1000.f;
+            this->phaseNanoseconds[phase] = 0;
+            if (IsLatePhase(phase)) {
+                this->samples[phase * this->windowFrames + this->nextSample] = -1.f;
+                continue;
+            }
+            this->samples[phase * this->windowFrames + this->nextSample] = microseconds;
+            this->lastFrame[phase] = microseconds;
+        }
+        for (size_t counter = 0; counter < ProfileCounterCount; ++counter) {
+            this->lastCounters[counter] = this->counters[counter];
+            this->totalCounters[counter] += this->counters[counter];
+            this->counters[counter] = 0;
+        }
+        this->nextSample = (this->nextSample + 1) % this->windowFrames;
+        this->filledSamples = (std::min)(this->filledSamples + 1, this->windowFrames);
+        ++this->frames;
+    }
+    void FrameProfiler::AddLateTime(uint64_t frame, ProfilePhase phase, std::chrono::steady_clock::duration time) {
+        if (!this->enabled || frame >= this->frames) return;
+        const uint64_t age = this->frames - frame;
+        if (age > this->filledSamples) return;
+        const size_t slot = (this->nextSample + this->windowFrames - static_cast<size_t>(age)) % this->windowFrames;
+        float& sample = this->samples[static_cast<size_t>(phase) * this->windowFrames + slot];
+        //a frame may be replayed in more than one snapshot
+        const float microseconds = static_cast<float>(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count()) / 1000.f;
+        sample = (sample < 0.f ? 0.f : sample) + microseconds;
+        this->lastFrame[static_cast<size_t>(phase)] = sample;
+    }
+    void FrameProfiler::Reset() {
+        const bool enabled = this->enabled;
+        *this = FrameProfiler(this->windowFrames);
+        this->enabled = enabled;
+    }
+
+    FrameProfileReport FrameProfiler::GetReport() const {
+        FrameProfileReport report;
+        report.frames = this->frames;
+        report.windowFrames = this->filledSamples;
+        std::copy(std::begin(this->lastFrame), std::end(this->lastFrame), report.lastFrame);
+        std::copy(std::begin(this->lastCounters), std::end(this->lastCounters), report.lastCounters);
+        std::copy(std::begin(this->totalCounters), std::end(this->totalCounters), report.totalCounters);
+        if (this->filledSamples == 0) return report;
+
+        std::vector<float> sorted;
+        sorted.reserve(this->filledSamples);
+        for (size_t phase = 0; phase < ProfilePhaseCount; ++phase) {
+            const float* first = &this->samples[phase * this->windowFrames];
+            sorted.clear();
+            std::copy_if(first, first + this->filledSamples, std::back_inserter(sorted), [](float sample) { return sample >= 0.f; });
+            if (sorted.empty()) continue;
+            std::sort(sorted.begin(), sorted.end());
+            const size_t count = sorted.size();
+            //nearest rank, the sample at or above the wanted fraction of the window
+            const auto rank = [count](float fraction) {
+                return (std::min)(static_cast<size_t>(fraction * static_cast<float>(count)), count - 1);
+            };
+            ProfilePercentiles& percentiles = report.phases[phase];
+            percentiles.p50 = sorted[rank(0.50f)];
+            percentiles.p95 = sorted[rank(0.95f)];
+            percentiles.p99 = sorted[rank(0.99f)];
+            percentiles.max = sorted[count - 1];
+        }
+        return report;
+    }
+
+    const char* FrameProfiler::PhaseName(ProfilePhase phase) {
+        switch (phase) {
+        case ProfilePhase::DIRTY_CHECK: return "dirty check";
+        case ProfilePhase::COLLECT_DAMAGE: return "collect damage";
+        case ProfilePhase::BUILD_NODE_LIST: return "build node list";
+        case ProfilePhase::DRAW_BASE: return "draw base";
+        case ProfilePhase::DRAW_TEXT: return "draw text";
+        case ProfilePhase::DRAW_IMAGE: return "draw image";
+        case ProfilePhase::DRAW_PIXEL_BUFFER: return "draw pixel buffer";
+        case ProfilePhase::END_FRAME: return "end frame";
+        case ProfilePhase::PRESENT: return "present";
+        case ProfilePhase::HIT_TEST: return "hit test";
+        case ProfilePhase::FRAME: return "frame";
+        default: return "unknown";
+        }
+    }
+    const char* FrameProfiler::CounterName(ProfileCounter counter) {
+        switch (counter) {
+        case ProfileCounter::ELEMENTS_DRAWN: return "elements drawn";
+        case ProfileCounter::ELEMENTS_RECORDED: return "elements recorded";
+        case ProfileCounter::ELEMENTS_SKIPPED: return "elements skipped";
+        case ProfileCounter::RESOURCES_CREATED: return "resources created";
+        case ProfileCounter::BYTES_UPLOADED: return "bytes uploaded";
+        case ProfileCounter::HIT_TEST_CANDIDATES: return "hit test candidates";
+        default: return "unknown";
+        }
+    }
+}
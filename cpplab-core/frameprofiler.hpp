@@ -0,0 +1,141 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <vector>
+
+namespace cpplab {
+    //phases may nest, a frame's time for a phase is the sum of every scope of it since the last frame ended
+    enum class ProfilePhase : uint8_t {
+        //checking the tree for changes, also between frames, counted toward the next frame drawn
+        DIRTY_CHECK,
+        //publishing and turning changes into damage, includes BUILD_NODE_LIST
+        COLLECT_DAMAGE,
+        BUILD_NODE_LIST,
+        //recording and replaying the elements of one type
+        DRAW_BASE,
+        DRAW_TEXT,
+        DRAW_IMAGE,
+        DRAW_PIXEL_BUFFER,
+        //ending the frame on the device, presenting headless or handing the frame to the render thread
+        END_FRAME,
+        //render thread replay and present of the frame, window only
+        //it finishes after the frame ended and is added to it later through AddLateTime, pending until then
+        PRESENT,
+        //mouse events, between frames, counted toward the next frame drawn
+        HIT_TEST,
+        //all of RenderFrame
+        FRAME,
+        COUNT
+    };
+    constexpr size_t ProfilePhaseCount = static_cast<size_t>(ProfilePhase::COUNT);
+
+    enum class ProfileCounter : uint8_t {
+        ELEMENTS_DRAWN,
+        ELEMENTS_RECORDED,
+        ELEMENTS_SKIPPED,
+        //bitmaps, text formats and text layouts built for changed elements
+        RESOURCES_CREATED,
+        //bitmap and pixel buffer bytes sent to the device
+        BYTES_UPLOADED,
+        //elements the hit test index returned for an exact check
+        HIT_TEST_CANDIDATES,
+        COUNT
+    };
+    constexpr size_t ProfileCounterCount = static_cast<size_t>(ProfileCounter::COUNT);
+
+    //in microseconds, over the frames in the window
+    struct ProfilePercentiles {
+        float p50 = 0.f;
+        float p95 = 0.f;
+        float p99 = 0.f;
+        float max = 0.f;
+    };
+    struct FrameProfileReport {
+        uint64_t frames = 0;
+        //frames the percentiles are taken over
+        size_t windowFrames = 0;
+        ProfilePercentiles phases[ProfilePhaseCount];
+        float lastFrame[ProfilePhaseCount] = {};
+        uint64_t lastCounters[ProfileCounterCount] = {};
+        uint64_t totalCounters[ProfileCounterCount] = {};
+    };
+
+    //per frame timings of the renderer's phases over a rolling window of frames, plus counters
+    //disabled it reads no clock, a scope costs one flag test on entry and a null test on exit
+    //ui thread only, like the renderer that owns it
+    class FrameProfiler {
+    public:
+        static constexpr size_t DefaultWindowFrames = 240;
+
+    private:
+        bool enabled = false;
+        //the frame being measured
+        uint64_t phaseNanoseconds[ProfilePhaseCount] = {};
+        uint64_t counters[ProfileCounterCount] = {};
+
+        //windowFrames samples per phase, in microseconds, oldest overwritten first, negative while a late phase is pending
+        std::vector<float> samples;
+        size_t windowFrames;
+        size_t nextSample = 0;
+        size_t filledSamples = 0;
+
+        uint64_t frames = 0;
+        float lastFrame[ProfilePhaseCount] = {};
+        uint64_t lastCounters[ProfileCounterCount] = {};
+        uint64_t totalCounters[ProfileCounterCount] = {};
+
+    public:
+        FrameProfiler(size_t windowFrames = DefaultWindowFrames);
+
+        //the window is kept while disabled, so pausing does not lose it
+        void SetEnabled(bool enabled);
+        bool IsEnabled() const {
+            return this->enabled;
+        }
+        void AddTime(ProfilePhase phase, std::chrono::steady_clock::duration time) {
+            if (!this->enabled) return;
+            this->phaseNanoseconds[static_cast<size_t>(phase)] += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+        }
+        void Count(ProfileCounter counter, uint64_t amount = 1) {
+            if (!this->enabled) return;
+            this->counters[static_cast<size_t>(counter)] += amount;
+        }
+        //the times and counts gathered since the last call become one frame of the window
+        void EndFrame();
+        //time for a frame that already ended, frame is what FrameCount returned while it was measured
+        //dropped once the frame left the window
+        void AddLateTime(uint64_t frame, ProfilePhase phase, std::chrono::steady_clock::duration time);
+        void Reset();
+
+        //frames ended while enabled
+        uint64_t FrameCount() const {
+            return this->frames;
+        }
+        //sorts a copy of the window, meant for a few calls a second, pending samples are left out
+        FrameProfileReport GetReport() const;
+        static const char* PhaseName(ProfilePhase phase);
+        static const char* CounterName(ProfileCounter counter);
+    };
+
+    //times the enclosing block as one scope of a phase
+    class ProfileScope {
+    private:
+        FrameProfiler* profiler;
+        ProfilePhase phase;
+        std::chrono::steady_clock::time_point start;
+
+    public:
+        ProfileScope(FrameProfiler& profiler, ProfilePhase phase) : profiler(nullptr), phase(phase) {
+            if (profiler.IsEnabled()) {
+                this->profiler = &profiler;
+                this->start = std::chrono::steady_clock::now();
+            }
+        }
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+        ~ProfileScope() {
+            if (this->profiler) this->profiler->AddTime(this->phase, std::chrono::steady_clock::now() - this->start);
+        }
+    };
+}
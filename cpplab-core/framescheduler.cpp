@@ -0,0 +1,64 @@
+#include "framescheduler.hpp"
+#include <algorithm>
+
+namespace cpplab {
+    using TimePoint = FrameClock::Clock::time_point;
+
+    FrameScheduler::FrameScheduler(FrameClock* clock, FrameClock::Clock::duration refreshInterval) {
+        this->clock = clock;
+        this->refreshInterval = refreshInterval;
+    }
+
+    void FrameScheduler::SetRefreshInterval(FrameClock::Clock::duration interval) {
+        this->refreshInterval = interval;
+    }
+    void FrameScheduler::SetMode(FrameMode mode) {
+        this->mode = mode;
+    }
+
+    void FrameScheduler::RequestFrame() {
+        ++this->stats.requests;
+        if (this->frameRequested) ++this->stats.coalescedRequests;
+        this->frameRequested = true;
+    }
+    void FrameScheduler::RequestFrameAt(TimePoint time) {
+        ++this->stats.requests;
+        this->timedRequest = (std::min)(this->timedRequest, time);
+    }
+
+    TimePoint FrameScheduler::NextFrameTime() const {
+        //never two frames in one interval
+        const TimePoint earliest = this->frameStarted ? this->currentFrame.frameTime + this->refreshInterval : (TimePoint::min)();
+        if (this->frameRequested || this->mode == FrameMode::CONTINUOUS) return earliest;
+        if (this->timedRequest != (TimePoint::max)()) return (std::max)(earliest, this->timedRequest);
+        return (TimePoint::max)();
+    }
+
+    const FrameInfo& FrameScheduler::BeginFrame() {
+        const TimePoint now = this->clock->Now();
+        TimePoint frameTime = now;
+        if (this->frameStarted && this->refreshInterval > FrameClock::Clock::duration::zero()) {
+            const TimePoint slot = this->currentFrame.frameTime + this->refreshInterval;
+            if (now >= slot) {
+                //on the grid of the previous frames so animations see even steps, a late wake does not shift it
+                //after an idle gap on demand the grid starts over, only continuous frames count the gap as missed
+                const int64_t late = (now - slot) / this->refreshInterval;
+                if (late == 0 || this->mode == FrameMode::CONTINUOUS) {
+                    frameTime = slot + late * this->refreshInterval;
+                    this->stats.missedIntervals += static_cast<uint64_t>(late);
+                }
+            }
+        }
+
+        this->frameRequested = false;
+        if (this->timedRequest <= now) this->timedRequest = (TimePoint::max)();
+        this->frameStarted = true;
+        ++this->stats.framesRun;
+
+        this->currentFrame.number = this->stats.framesRun;
+        this->currentFrame.frameTime = frameTime;
+        this->currentFrame.deadline = frameTime + this->refreshInterval;
+        this->currentFrame.interval = this->refreshInterval;
+        return this->currentFrame;
+    }
+}
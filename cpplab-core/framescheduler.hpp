@@ -0,0 +1,112 @@
+#pragma once
+#include <cstdint>
+#include <chrono>
+
+namespace cpplab {
+    //where frame pacing gets its time from, tests drive a ManualFrameClock instead of waiting
+    class FrameClock {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        virtual ~FrameClock() = default;
+        virtual Clock::time_point Now() const = 0;
+    };
+    class SteadyFrameClock : public FrameClock {
+    public:
+        Clock::time_point Now() const override {
+            return Clock::now();
+        }
+    };
+    //only moves when told to
+    class ManualFrameClock : public FrameClock {
+    private:
+        Clock::time_point now;
+    public:
+        Clock::time_point Now() const override {
+            return this->now;
+        }
+        void Advance(Clock::duration duration) {
+            this->now += duration;
+        }
+        void Set(Clock::time_point time) {
+            this->now = time;
+        }
+    };
+
+    enum class FrameMode {
+        //frames only run when something asked for one, the loop sleeps otherwise
+        ON_DEMAND,
+        //a frame every refresh interval whether asked for or not, for animations
+        CONTINUOUS
+    };
+
+    struct FrameInfo {
+        uint64_t number = 0;
+        //start of the frame's refresh slot, steps by whole intervals while frames keep coming
+        FrameClock::Clock::time_point frameTime;
+        //start of the next slot, work for this frame should be done by then
+        FrameClock::Clock::time_point deadline;
+        FrameClock::Clock::duration interval = FrameClock::Clock::duration::zero();
+    };
+
+    struct FrameSchedulerStats {
+        uint64_t framesRun = 0;
+        uint64_t requests = 0;
+        //requests made while a frame was already pending, each one a repaint saved
+        uint64_t coalescedRequests = 0;
+        //whole refresh intervals that passed without a frame while frames were wanted
+        uint64_t missedIntervals = 0;
+    };
+
+    //decides when the ui loop runs a frame, at most one per refresh interval however many invalidations came in
+    //knows nothing about windows or messages, the loop asks it when to wake and tells it when a frame starts
+    //ui thread only
+    class FrameScheduler {
+    private:
+        FrameClock* clock;
+        FrameClock::Clock::duration refreshInterval;
+        FrameMode mode = FrameMode::ON_DEMAND;
+
+        bool frameRequested = false;
+        //earliest time a frame was asked for at, max when none
+        FrameClock::Clock::time_point timedRequest = (FrameClock::Clock::time_point::max)();
+        bool frameStarted = false;
+        FrameInfo currentFrame;
+        FrameSchedulerStats stats;
+
+    public:
+        FrameScheduler(FrameClock* clock, FrameClock::Clock::duration refreshInterval);
+
+        FrameClock::Clock::time_point Now() const {
+            return this->clock->Now();
+        }
+        void SetRefreshInterval(FrameClock::Clock::duration interval);
+        FrameClock::Clock::duration GetRefreshInterval() const {
+            return this->refreshInterval;
+        }
+        void SetMode(FrameMode mode);
+        FrameMode GetMode() const {
+            return this->mode;
+        }
+
+        //asks for a frame as soon as the current interval is over, requests before it runs all go into that one frame
+        void RequestFrame();
+        //asks for a frame once the time is reached, used for timers
+        void RequestFrameAt(FrameClock::Clock::time_point time);
+
+        //when the next frame should start, max when nothing wants one
+        FrameClock::Clock::time_point NextFrameTime() const;
+        bool IsFrameDue() const {
+            return this->NextFrameTime() <= this->Now();
+        }
+        //starts a frame now and takes the requests it covers, the loop calls it whether or not the frame was due
+        const FrameInfo& BeginFrame();
+        //the frame last started, its deadline is what app code paces its work against
+        const FrameInfo& GetCurrentFrame() const {
+            return this->currentFrame;
+        }
+        FrameSchedulerStats GetStats() const {
+            return this->stats;
+        }
+    };
+}
@@ -0,0 +1,121 @@
+#include "framesnapshot.hpp"
+
+namespace cpplab {
+    void FrameSnapshot::Clear() {
+        this->commands.clear();
+        this->strings.clear();
+        this->bitmaps.clear();
+        this->textFormats.clear();
+        this->regionUpdates.clear();
+        this->pixelData.clear();
+        this->frameNumber = 0;
+        this->frameTag = 0;
+        this->drawsFrame = false;
+    }
+    size_t FrameSnapshot::CopiedBytes() const {
+        size_t bytes = this->commands.size() * sizeof(SnapshotCommand) + this->pixelData.size();
+        for (const std::wstring& text : this->strings) {
+            bytes += text.size() * sizeof(wchar_t);
+        }
+        return bytes;
+    }
+
+    SnapshotReplayer::~SnapshotReplayer() {
+        this->ReleaseAll();
+    }
+
+    template <class T>
+    void SnapshotReplayer::Store(std::vector<T*>& resources, uint32_t id, T* resource) {
+        if (id >= resources.size()) resources.resize(static_cast<size_t>(id) + 1, nullptr);
+        delete resources[id];
+        resources[id] = resource;
+    }
+
+    bool SnapshotReplayer::Replay(const FrameSnapshot& snapshot, RenderDevice& device) {
+        for (const SnapshotCommand& command : snapshot.commands) {
+            const float* v = command.values;
+            switch (command.op) {
+            case SnapshotOp::BEGIN_FRAME:
+                device.BeginFrame();
+                break;
+            case SnapshotOp::CLEAR:
+                device.Clear(command.color);
+                break;
+            case SnapshotOp::SET_TRANSFORM: {
+                Transform2D transform;
+                transform.m11 = v[0];
+                transform.m12 = v[1];
+                transform.m21 = v[2];
+                transform.m22 = v[3];
+                transform.dx = v[4];
+                transform.dy = v[5];
+                device.SetTransform(transform);
+                break;
+            }
+            case SnapshotOp::PUSH_CLIP:
+                device.PushClip(RectF(v[0], v[1], v[2], v[3]));
+                break;
+            case SnapshotOp::POP_CLIP:
+                device.PopClip();
+                break;
+            case SnapshotOp::FILL_ROUNDED_RECT:
+                device.FillRoundedRect(RoundedRectF(RectF(v[0], v[1], v[2], v[3]), v[4], v[5]), command.color);
+                break;
+            case SnapshotOp::STROKE_ROUNDED_RECT:
+                device.StrokeRoundedRect(RoundedRectF(RectF(v[0], v[1], v[2], v[3]), v[4], v[5]), command.color, v[6]);
+                break;
+            case SnapshotOp::DRAW_BITMAP: {
+                RenderBitmap* bitmap = Lookup(this->bitmaps, command.resource);
+                if (bitmap) device.DrawBitmap(bitmap, RectF(v[0], v[1], v[2], v[3]), v[4]);
+                break;
+            }
+            case SnapshotOp::DRAW_STRING: {
+                RenderTextFormat* format = Lookup(this->textFormats, command.resource);
+                if (format) device.DrawString(snapshot.strings[command.payload], format, RectF(v[0], v[1], v[2], v[3]), command.color);
+                break;
+            }
+            case SnapshotOp::CREATE_BITMAP:
+                Store(this->bitmaps, command.resource, device.CreateBitmap(*snapshot.bitmaps[command.payload]));
+                break;
+            case SnapshotOp::UPDATE_BITMAP: {
+                RenderBitmap* bitmap = Lookup(this->bitmaps, command.resource);
+                const SnapshotRegionUpdate& update = snapshot.regionUpdates[command.payload];
+                if (bitmap) device.UpdateBitmap(bitmap, update.region, &snapshot.pixelData[update.offset], update.region.width * 4);
+                break;
+            }
+            case SnapshotOp::RELEASE_BITMAP:
+                if (command.resource < this->bitmaps.size()) Store<RenderBitmap>(this->bitmaps, command.resource, nullptr);
+                break;
+            case SnapshotOp::CREATE_TEXT_FORMAT:
+                Store(this->textFormats, command.resource, device.CreateTextFormat(snapshot.textFormats[command.payload]));
+                break;
+            case SnapshotOp::RELEASE_TEXT_FORMAT:
+                if (command.resource < this->textFormats.size()) Store<RenderTextFormat>(this->textFormats, command.resource, nullptr);
+                break;
+            }
+        }
+        return snapshot.drawsFrame ? device.EndFrame() : true;
+    }
+
+    void SnapshotReplayer::ReleaseAll() {
+        for (RenderBitmap* bitmap : this->bitmaps) {
+            delete bitmap;
+        }
+        for (RenderTextFormat* format : this->textFormats) {
+            delete format;
+        }
+        this->bitmaps.clear();
+        this->textFormats.clear();
+    }
+
+    size_t SnapshotReplayer::LiveResources() const {
+        size_t live = 0;
+        for (RenderBitmap* bitmap : this->bitmaps) {
+            if (bitmap) ++live;
+        }
+        for (RenderTextFormat* format : this->textFormats) {
+            if (format) ++live;
+        }
+        return live;
+    }
+}
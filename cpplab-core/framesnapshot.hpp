@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+#include "renderdevice.hpp"
+
+namespace cpplab {
+    enum class SnapshotOp : uint8_t {
+        BEGIN_FRAME, CLEAR, SET_TRANSFORM, PUSH_CLIP, POP_CLIP, FILL_ROUNDED_RECT, STROKE_ROUNDED_RECT, DRAW_BITMAP, DRAW_STRING,
+        CREATE_BITMAP, UPDATE_BITMAP, RELEASE_BITMAP, CREATE_TEXT_FORMAT, RELEASE_TEXT_FORMAT
+    };
+
+    //one recorded device call, resources are referred to by the id the recording side gave them
+    struct SnapshotCommand {
+        SnapshotOp op = SnapshotOp::CLEAR;
+        uint32_t resource = 0;
+        //index into the snapshot's strings, bitmaps, text formats or region updates
+        uint32_t payload = 0;
+        //same layout as DisplayCommand values
+        float values[7] = {};
+        Color color;
+    };
+    //pixels of a partial bitmap update, stored tightly packed in the snapshot's pixel data
+    struct SnapshotRegionUpdate {
+        PixelRegion region;
+        size_t offset = 0;
+    };
+
+    //everything one frame needs from the ui thread as plain data, it is never written again once submitted
+    //resources created or released since the last frame travel in the same stream in the order they happened
+    struct FrameSnapshot {
+        std::vector<SnapshotCommand> commands;
+        std::vector<std::wstring> strings;
+        std::vector<std::shared_ptr<const PixelBuffer>> bitmaps;
+        std::vector<TextFormatDesc> textFormats;
+        std::vector<SnapshotRegionUpdate> regionUpdates;
+        std::vector<uint8_t> pixelData;
+        uint64_t frameNumber = 0;
+        //set by the ui through FramePipeline::SetFrameTag, handed back with the replay time
+        uint64_t frameTag = 0;
+        //false while the snapshot only carries resource changes
+        bool drawsFrame = false;
+
+        //keeps the capacity so recycled snapshots do not allocate again
+        void Clear();
+        //bytes copied into the snapshot, shared bitmaps are not counted
+        size_t CopiedBytes() const;
+    };
+
+    //turns snapshots back into device calls on the render thread
+    //owns the device resources, looked up by the ids the snapshots use
+    class SnapshotReplayer {
+    private:
+        std::vector<RenderBitmap*> bitmaps;
+        std::vector<RenderTextFormat*> textFormats;
+
+        template <class T>
+        static T* Lookup(const std::vector<T*>& resources, uint32_t id) {
+            return id < resources.size() ? resources[id] : nullptr;
+        }
+        template <class T>
+        static void Store(std::vector<T*>& resources, uint32_t id, T* resource);
+
+    public:
+        SnapshotReplayer() = default;
+        SnapshotReplayer(const SnapshotReplayer&) = delete;
+        SnapshotReplayer& operator=(const SnapshotReplayer&) = delete;
+        ~SnapshotReplayer();
+
+        //returns the device's EndFrame result, snapshots without a frame return true
+        //draws using a resource lost with the target are skipped until the ui side creates it again
+        bool Replay(const FrameSnapshot& snapshot, RenderDevice& device);
+        //deletes every device resource, done when the target is lost or recreated
+        void ReleaseAll();
+
+        size_t LiveResources() const;
+    };
+}
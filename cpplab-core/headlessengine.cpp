@@ -0,0 +1,118 @@
+#include "headlessengine.hpp"
+
+namespace cpplab {
+    namespace {
+        constexpr size_t ImageCacheBudgetBytes = 64u << 20;
+        constexpr unsigned int ImageDecodeWorkers = 2;
+        constexpr std::chrono::microseconds RefreshInterval(16667);
+    }
+
+    HeadlessEngine::HeadlessEngine(uint32_t width, uint32_t height, unsigned int dpi, FrameClock* clock) :
+        rootNode(new ElementNode()), device(width, height),
+        imageCache(&imageDecoder, ImageCacheBudgetBytes, ImageDecodeWorkers),
+        scene(rootNode, &device, &imageCache, dpi),
+        frameScheduler(clock ? clock : &steadyClock, RefreshInterval), layout(&frameScheduler), animations(&frameScheduler),
+        scheduler(&uiTasks, &frameScheduler, &imageCache) {
+        this->device.SetDpi(dpi);
+        this->rootNode->setRootId("Headless Root Node");
+        this->layout.SetRoot(this->rootNode);
+        this->layout.SetViewport(vec2(static_cast<float>(width), static_cast<float>(height)));
+        this->uiTasks.SetWakeCallback([this]() { this->Wake(); });
+        this->imageCache.SetCompletionCallback([this]() { this->Wake(); });
+    }
+    HeadlessEngine::~HeadlessEngine() {
+        delete this->profilerOverlay;
+        delete this->rootNode;
+    }
+
+    void HeadlessEngine::Wake() {
+        {
+            std::lock_guard<std::mutex> guard(this->wakeLock);
+            this->wakeRequested = true;
+        }
+        this->wakeSignal.notify_one();
+    }
+
+    void HeadlessEngine::Post(std::function<void()> task) {
+        this->uiTasks.Post(std::move(task));
+    }
+    void HeadlessEngine::PostForFrame(std::function<void()> task) {
+        this->uiTasks.PostForFrame(std::move(task));
+    }
+
+    bool HeadlessEngine::RunFrame() {
+        this->frameScheduler.BeginFrame();
+        ++this->frameStats.frames;
+        //tasks first so everything they change is published and painted in this frame
+        this->uiTasks.Drain();
+        this->scheduler.RunFrame();
+        this->layout.RunFrame();
+        this->scrollLists.RunFrame();
+        this->animations.RunFrame();
+        if (this->profilerOverlay) this->profilerOverlay->Refresh();
+        if (this->scene.CheckNodeModification()) {
+            this->scene.CollectDamage();
+        }
+        if (!this->scene.GetDamage().HasDamage()) {
+            ++this->frameStats.idleFrames;
+            return false;
+        }
+
+        this->scene.RenderFrame(RectF(0.f, 0.f, static_cast<float>(this->device.GetWidth()), static_cast<float>(this->device.GetHeight())));
+        ++this->frameStats.framesRendered;
+        return true;
+    }
+
+    void HeadlessEngine::ShowProfilerOverlay(bool show) {
+        if (show == (this->profilerOverlay != nullptr)) return;
+        if (!show) {
+            //the destructor unlinks it from the root
+            delete this->profilerOverlay;
+            this->profilerOverlay = nullptr;
+            return;
+        }
+        this->scene.GetProfiler().SetEnabled(true);
+        this->profilerOverlay = new ProfilerOverlayElement(this->scene.GetProfiler());
+        this->rootNode->AddChildElement("cpplab profiler overlay", this->profilerOverlay);
+    }
+
+    bool HeadlessEngine::Tick() {
+        if (this->uiTasks.Depth() > 0 || this->scheduler.NeedsFrame() || this->scene.CheckNodeModification()) {
+            this->frameScheduler.RequestFrame();
+        }
+        if (!this->frameScheduler.IsFrameDue()) return false;
+        this->RunFrame();
+        return true;
+    }
+
+    void HeadlessEngine::RunLoop() {
+        for (;;) {
+            this->Tick();
+
+            //measured on the frame clock, which need not be the one the wait runs on
+            const FrameClock::Clock::time_point frameTime = this->frameScheduler.NextFrameTime();
+            const FrameClock::Clock::time_point now = this->frameScheduler.Now();
+            std::unique_lock<std::mutex> lock(this->wakeLock);
+            const auto woken = [this]() { return this->wakeRequested || this->stopRequested; };
+            if (frameTime == (FrameClock::Clock::time_point::max)()) {
+                this->wakeSignal.wait(lock, woken);
+            }
+            else if (frameTime > now) {
+                this->wakeSignal.wait_for(lock, frameTime - now, woken);
+            }
+            if (this->stopRequested) {
+                //a stop before the loop started still ends it, the next RunLoop starts fresh
+                this->stopRequested = false;
+                return;
+            }
+            this->wakeRequested = false;
+        }
+    }
+    void HeadlessEngine::Stop() {
+        {
+            std::lock_guard<std::mutex> guard(this->wakeLock);
+            this->stopRequested = true;
+        }
+        this->wakeSignal.notify_one();
+    }
+}
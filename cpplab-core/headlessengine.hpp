@@ -0,0 +1,126 @@
+#pragma once
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "uitaskqueue.hpp"
+#include "framescheduler.hpp"
+#include "uischeduler.hpp"
+#include "animationengine.hpp"
+#include "layoutengine.hpp"
+#include "scrolllistelement.hpp"
+#include "profileroverlayelement.hpp"
+#include "engineelements.hpp"
+#include "scenerenderer.hpp"
+#include "softwarerenderdevice.hpp"
+#include "ppmimagedecoder.hpp"
+
+namespace cpplab {
+    struct HeadlessFrameStats {
+        uint64_t frames = 0;
+        //frames that found nothing to repaint after their tasks ran
+        uint64_t idleFrames = 0;
+        uint64_t framesRendered = 0;
+    };
+
+    //the window engine's loop without a window, renders into a software device so it runs on any platform
+    //the thread calling RunFrame, Tick or RunLoop is the ui thread, other threads post work to it
+    class HeadlessEngine {
+    private:
+        //declared first, image decode workers may still wake the loop while the cache shuts down
+        std::mutex wakeLock;
+        std::condition_variable wakeSignal;
+        bool wakeRequested = false;
+        bool stopRequested = false;
+
+        ElementNode* rootNode;
+        SoftwareRenderDevice device;
+        PPMImageDecoder imageDecoder;
+        ImageCache imageCache;
+        SceneRenderer scene;
+        SteadyFrameClock steadyClock;
+        FrameScheduler frameScheduler;
+        LayoutEngine layout;
+        ScrollListSet scrollLists;
+        AnimationEngine animations;
+        //before the task queue so resumes still queued are dropped before the tasks they would resume
+        UiScheduler scheduler;
+        UiTaskQueue uiTasks;
+
+        HeadlessFrameStats frameStats;
+        //owned by the engine while shown, a child of the root node
+        ProfilerOverlayElement* profilerOverlay = nullptr;
+
+        void Wake();
+
+    public:
+        //frames are paced by the clock given, or the steady clock when it is null
+        HeadlessEngine(uint32_t width, uint32_t height, unsigned int dpi = 96, FrameClock* clock = nullptr);
+        HeadlessEngine(const HeadlessEngine&) = delete;
+        HeadlessEngine& operator=(const HeadlessEngine&) = delete;
+        ~HeadlessEngine();
+
+        ElementNode* GetRootNode() {
+            return this->rootNode;
+        }
+        SceneRenderer& GetScene() {
+            return this->scene;
+        }
+        const SoftwareRenderDevice& GetDevice() const {
+            return this->device;
+        }
+        UiScheduler& GetScheduler() {
+            return this->scheduler;
+        }
+        FrameScheduler& GetFrameScheduler() {
+            return this->frameScheduler;
+        }
+        //the root node fills the device, in device pixels like every element coordinate
+        LayoutEngine& GetLayout() {
+            return this->layout;
+        }
+        ScrollListSet& GetScrollLists() {
+            return this->scrollLists;
+        }
+        AnimationEngine& GetAnimations() {
+            return this->animations;
+        }
+
+        //phase timings of every frame rendered, off until enabled or the overlay is shown
+        FrameProfiler& GetProfiler() {
+            return this->scene.GetProfiler();
+        }
+        //showing enables the profiler, hiding deletes the overlay and leaves the profiler on
+        void ShowProfilerOverlay(bool show);
+
+        //any thread, see UiTaskQueue
+        void Post(std::function<void()> task);
+        void PostForFrame(std::function<void()> task);
+
+        //ui thread, starts a frame now whether or not one was due
+        //runs the posted tasks, resumes due coroutines, lays out and steps animations then repaints whatever they and other changes damaged
+        //returns true if a frame was drawn
+        bool RunFrame();
+        //one pass of the loop, asks for a frame if work is waiting and runs it if the frame scheduler says it is due
+        //returns true if a frame ran
+        bool Tick();
+        //ticks whenever work arrives or a frame is due and sleeps in between, until Stop
+        void RunLoop();
+        //any thread, RunLoop returns after the frame it is in
+        void Stop();
+
+        UiTaskQueueStats GetTaskStats() const {
+            return this->uiTasks.GetStats();
+        }
+        HeadlessFrameStats GetFrameStats() const {
+            return this->frameStats;
+        }
+        ImageCacheStats GetImageCacheStats() {
+            return this->imageCache.GetStats();
+        }
+        void GetImageMemoryReport(std::vector<ImageMemoryReportEntry>& out) {
+            this->imageCache.GetMemoryReport(out);
+        }
+    };
+}
@@ -0,0 +1,220 @@
+#include <exception>
+#include "imagecache.hpp"
+
+namespace cpplab {
+    size_t ImageKeyHash::operator()(const ImageKey& key) const {
+        size_t hash = std::hash<std::wstring>()(key.source);
+        const size_t parts[4] = {
+            static_cast<size_t>(key.type), key.size.width, key.size.height, static_cast<size_t>(key.size.fillMode)
+        };
+        for (size_t part : parts) {
+            hash ^= part + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        }
+        return hash;
+    }
+
+    ImageCache::ImageCache(ImageDecoder* decoder, size_t memoryBudgetBytes, unsigned int workerCount) {
+        this->decoder = decoder;
+        this->memoryBudget = memoryBudgetBytes;
+        for (unsigned int i = 0; i < workerCount; ++i) {
+            this->workers.emplace_back(&ImageCache::WorkerLoop, this);
+        }
+    }
+    ImageCache::~ImageCache() {
+        {
+            std::lock_guard<std::mutex> guard(this->cacheLock);
+            this->stopping = true;
+        }
+        this->queueSignal.notify_all();
+        for (std::thread& worker : this->workers) {
+            worker.join();
+        }
+    }
+
+    void ImageCache::WorkerLoop() {
+        for (;;) {
+            ImageKey key;
+            {
+                std::unique_lock<std::mutex> lock(this->cacheLock);
+                this->queueSignal.wait(lock, [this]() { return this->stopping || !this->decodeQueue.empty(); });
+                if (this->stopping) return;
+                key = std::move(this->decodeQueue.front());
+                this->decodeQueue.pop_front();
+                ++this->activeDecodes;
+            }
+
+            this->DecodeEntry(key);
+
+            std::lock_guard<std::mutex> guard(this->cacheLock);
+            --this->activeDecodes;
+            if (this->decodeQueue.empty() && this->activeDecodes == 0) this->idleSignal.notify_all();
+        }
+    }
+    void ImageCache::DecodeEntry(const ImageKey& key) {
+        std::shared_ptr<PixelBuffer> buffer = std::make_shared<PixelBuffer>();
+        ImageDecodeInfo info;
+        bool decoded = true;
+        try {
+            this->decoder->DecodeToSize(key.source, key.type, key.size, *buffer, info);
+        }
+        catch (const std::exception&) {
+            decoded = false;
+        }
+
+        std::function<void()> callback;
+        {
+            std::lock_guard<std::mutex> guard(this->cacheLock);
+            //the entry is gone if it was invalidated or cleared while decoding, the result is dropped then
+            auto found = this->entries.find(key);
+            if (found != this->entries.end() && found->second.state == ImageRequestState::PENDING) {
+                Entry& entry = found->second;
+                ++this->stats.decodes;
+                if (decoded) {
+                    entry.state = ImageRequestState::READY;
+                    entry.info = info;
+                    entry.bytes = buffer->pixels.size();
+                    entry.pixels = std::move(buffer);
+                    this->stats.bytesUsed += entry.bytes;
+                }
+                else {
+                    entry.state = ImageRequestState::FAILED;
+                    ++this->stats.failures;
+                }
+                this->lru.push_front(key);
+                entry.lruPosition = this->lru.begin();
+                this->EvictOverBudget(key);
+            }
+            callback = this->completionCallback;
+        }
+        this->completionVersion.fetch_add(1, std::memory_order_acq_rel);
+        if (callback) callback();
+    }
+    void ImageCache::Touch(Entry& entry) {
+        this->lru.splice(this->lru.begin(), this->lru, entry.lruPosition);
+    }
+    void ImageCache::EvictOverBudget(const ImageKey& keep) {
+        //the newest image always stays, even when it alone is over budget
+        while (this->stats.bytesUsed > this->memoryBudget && !this->lru.empty() && this->lru.back() != keep) {
+            auto victim = this->entries.find(this->lru.back());
+            this->stats.bytesUsed -= victim->second.bytes;
+            this->entries.erase(victim);
+            this->lru.pop_back();
+            ++this->stats.evictions;
+        }
+    }
+
+    ImageRequestState ImageCache::Request(const ImageKey& key, std::shared_ptr<const PixelBuffer>& pixels) {
+        pixels.reset();
+        {
+            std::lock_guard<std::mutex> guard(this->cacheLock);
+            ++this->stats.requests;
+            auto found = this->entries.find(key);
+            if (found != this->entries.end()) {
+                Entry& entry = found->second;
+                if (entry.state == ImageRequestState::READY) {
+                    ++this->stats.hits;
+                    this->Touch(entry);
+                    pixels = entry.pixels;
+                }
+                else if (entry.state == ImageRequestState::FAILED) {
+                    this->Touch(entry);
+                }
+                return entry.state;
+            }
+
+            ++this->stats.misses;
+            this->entries.emplace(key, Entry());
+            if (!this->workers.empty()) {
+                this->decodeQueue.push_back(key);
+                this->queueSignal.notify_one();
+                return ImageRequestState::PENDING;
+            }
+        }
+
+        //no workers, decode right here
+        this->DecodeEntry(key);
+        std::lock_guard<std::mutex> guard(this->cacheLock);
+        auto found = this->entries.find(key);
+        if (found == this->entries.end()) return ImageRequestState::FAILED;
+        pixels = found->second.pixels;
+        return found->second.state;
+    }
+    void ImageCache::Invalidate(const ImageKey& key) {
+        std::lock_guard<std::mutex> guard(this->cacheLock);
+        auto found = this->entries.find(key);
+        if (found == this->entries.end()) return;
+        if (found->second.state != ImageRequestState::PENDING) {
+            this->stats.bytesUsed -= found->second.bytes;
+            this->lru.erase(found->second.lruPosition);
+        }
+        this->entries.erase(found);
+    }
+    void ImageCache::Clear() {
+        {
+            std::lock_guard<std::mutex> guard(this->cacheLock);
+            this->entries.clear();
+            this->lru.clear();
+            this->decodeQueue.clear();
+            this->stats.bytesUsed = 0;
+            if (this->activeDecodes == 0) this->idleSignal.notify_all();
+        }
+        //anyone waiting on a dropped decode has to request again
+        this->completionVersion.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    void ImageCache::SetCompletionCallback(std::function<void()> callback) {
+        std::lock_guard<std::mutex> guard(this->cacheLock);
+        this->completionCallback = std::move(callback);
+    }
+    void ImageCache::WaitIdle() {
+        std::unique_lock<std::mutex> lock(this->cacheLock);
+        this->idleSignal.wait(lock, [this]() { return this->decodeQueue.empty() && this->activeDecodes == 0; });
+    }
+
+    void ImageCache::GetMemoryReport(std::vector<ImageMemoryReportEntry>& out) {
+        std::lock_guard<std::mutex> guard(this->cacheLock);
+        out.clear();
+        out.reserve(this->entries.size());
+        for (const ImageKey& key : this->lru) {
+            const Entry& entry = this->entries.find(key)->second;
+            ImageMemoryReportEntry report;
+            report.key = key;
+            report.state = entry.state;
+            if (entry.pixels) {
+                report.width = entry.pixels->width;
+                report.height = entry.pixels->height;
+            }
+            report.sourceWidth = entry.info.sourceWidth;
+            report.sourceHeight = entry.info.sourceHeight;
+            report.bytes = entry.bytes;
+            report.nativeBytes = static_cast<size_t>(entry.info.sourceWidth) * entry.info.sourceHeight * 4;
+            out.push_back(report);
+        }
+        for (const auto& [key, entry] : this->entries) {
+            if (entry.state != ImageRequestState::PENDING) continue;
+            ImageMemoryReportEntry report;
+            report.key = key;
+            out.push_back(report);
+        }
+    }
+
+    void ImageCache::SetMemoryBudget(size_t bytes) {
+        std::lock_guard<std::mutex> guard(this->cacheLock);
+        this->memoryBudget = bytes;
+        this->EvictOverBudget(ImageKey());
+    }
+    ImageCacheStats ImageCache::GetStats() {
+        std::lock_guard<std::mutex> guard(this->cacheLock);
+        ImageCacheStats current = this->stats;
+        current.memoryBudget = this->memoryBudget;
+        current.entries = this->entries.size();
+        current.queuedDecodes = this->decodeQueue.size() + this->activeDecodes;
+        return current;
+    }
+    void ImageCache::ResetStats() {
+        std::lock_guard<std::mutex> guard(this->cacheLock);
+        const size_t bytesUsed = this->stats.bytesUsed;
+        this->stats = ImageCacheStats();
+        this->stats.bytesUsed = bytesUsed;
+    }
+}
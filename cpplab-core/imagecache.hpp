@@ -0,0 +1,134 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+#include "imagedecoder.hpp"
+
+namespace cpplab {
+    //identifies one decoded image, the same source shown at different sizes is decoded once per size
+    struct ImageKey {
+        std::wstring source;
+        ImageType type = ImageType::FILE;
+        ImageDecodeSize size;
+
+        bool operator==(const ImageKey& rhs) const {
+            return this->type == rhs.type && this->size == rhs.size && this->source == rhs.source;
+        }
+        bool operator!=(const ImageKey& rhs) const {
+            return !(this->operator==(rhs));
+        }
+    };
+    struct ImageKeyHash {
+        size_t operator()(const ImageKey& key) const;
+    };
+
+    enum class ImageRequestState {
+        READY, PENDING, FAILED
+    };
+
+    //memory held by one cached image next to what decoding it at native size would take
+    struct ImageMemoryReportEntry {
+        ImageKey key;
+        ImageRequestState state = ImageRequestState::PENDING;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t sourceWidth = 0;
+        uint32_t sourceHeight = 0;
+        size_t bytes = 0;
+        size_t nativeBytes = 0;
+    };
+
+    struct ImageCacheStats {
+        uint64_t requests = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t decodes = 0;
+        uint64_t failures = 0;
+        uint64_t evictions = 0;
+        size_t bytesUsed = 0;
+        size_t memoryBudget = 0;
+        size_t entries = 0;
+        size_t queuedDecodes = 0;
+    };
+
+    //decoded pixels shared by every element showing the same image
+    //misses are decoded on a pool of worker threads, ready images are kept in least recently used order and evicted past the memory budget
+    //pixels are handed out as shared pointers, so evicting an image still in use only drops the cache's reference
+    class ImageCache {
+    private:
+        struct Entry {
+            ImageRequestState state = ImageRequestState::PENDING;
+            std::shared_ptr<const PixelBuffer> pixels;
+            ImageDecodeInfo info;
+            size_t bytes = 0;
+            //position in the lru list, only valid once the entry left the pending state
+            std::list<ImageKey>::iterator lruPosition;
+        };
+
+        ImageDecoder* decoder;
+
+        std::mutex cacheLock;
+        std::unordered_map<ImageKey, Entry, ImageKeyHash> entries;
+        //most recently used at the front
+        std::list<ImageKey> lru;
+        size_t memoryBudget;
+        ImageCacheStats stats;
+
+        std::condition_variable queueSignal;
+        std::condition_variable idleSignal;
+        std::deque<ImageKey> decodeQueue;
+        size_t activeDecodes = 0;
+        bool stopping = false;
+        std::vector<std::thread> workers;
+
+        std::atomic<uint64_t> completionVersion = 0;
+        std::function<void()> completionCallback;
+
+        void WorkerLoop();
+        //decodes outside the lock and stores the result
+        void DecodeEntry(const ImageKey& key);
+        //expects cacheLock to be held
+        void Touch(Entry& entry);
+        void EvictOverBudget(const ImageKey& keep);
+
+    public:
+        //workerCount 0 decodes synchronously inside Request
+        ImageCache(ImageDecoder* decoder, size_t memoryBudgetBytes, unsigned int workerCount);
+        ImageCache(const ImageCache&) = delete;
+        ImageCache& operator=(const ImageCache&) = delete;
+        ~ImageCache();
+
+        //returns READY with the pixels, or queues a decode and returns PENDING until it finished
+        //failed images stay FAILED until Invalidate is called for them
+        ImageRequestState Request(const ImageKey& key, std::shared_ptr<const PixelBuffer>& pixels);
+        //drops the image so the next request decodes it again
+        void Invalidate(const ImageKey& key);
+        void Clear();
+
+        //bumped every time a decode finished, renderers compare it to know when to ask for pending images again
+        uint64_t CompletionVersion() const {
+            return this->completionVersion.load(std::memory_order_acquire);
+        }
+        //called on a worker thread after each finished decode, set before requesting images
+        void SetCompletionCallback(std::function<void()> callback);
+        //blocks until no decodes are queued or running
+        void WaitIdle();
+
+        //one entry per cached image, most recently used first, pending decodes last
+        void GetMemoryReport(std::vector<ImageMemoryReportEntry>& out);
+
+        void SetMemoryBudget(size_t bytes);
+        ImageCacheStats GetStats();
+        void ResetStats();
+    };
+}
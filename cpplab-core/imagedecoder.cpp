@@ -0,0 +1,124 @@
+#include <cmath>
+#include <vector>
+#include "imagedecoder.hpp"
+
+namespace cpplab {
+    RectF GenImageBox(vec2 dimensions, vec2 imageDimensions, ImageFillMode mode) {
+        if (mode == ImageFillMode::FILL) { //stretch image to fill entire bounding box
+            return RectF(
+                0.f, 0.f,
+                dimensions.x, dimensions.y
+            );
+        }
+        else if (mode == ImageFillMode::COVER) {  //image maintains aspect ratio and is guaranteed to cover all pixels of the bounding box
+            //calculate ratio of image side lengths to box sides lengths
+            vec2 imToBoxRatio = vec2(
+                imageDimensions.x / dimensions.x,
+                imageDimensions.y / dimensions.y
+            );
+
+            //scale by forcing the smaller ratio to reach one
+            float recipr = imToBoxRatio.x < imToBoxRatio.y ?
+                dimensions.x / imageDimensions.x :
+                dimensions.y / imageDimensions.y;
+
+            return RectF(
+                0.f, 0.f,
+                imageDimensions.x * recipr, imageDimensions.y * recipr
+            );
+        }
+        else if (mode == ImageFillMode::CONTAIN) { //image maintains aspect ratio and all pixels of the image are guaranteed to be present in the bounding box
+            //calculate ratio of image side lengths to box sides lengths
+            vec2 imToBoxRatio = vec2(
+                imageDimensions.x / dimensions.x,
+                imageDimensions.y / dimensions.y
+            );
+            //scale by forcing the larger ratio to reach one
+            float recipr = imToBoxRatio.x > imToBoxRatio.y ?
+                dimensions.x / imageDimensions.x :
+                dimensions.y / imageDimensions.y;
+            imToBoxRatio.x = imToBoxRatio.x * recipr;
+            imToBoxRatio.y = imToBoxRatio.y * recipr;
+
+            return RectF(
+                0.f, 0.f,
+                imageDimensions.x*recipr, imageDimensions.y* recipr
+            );
+        }
+        return RectF(0.f, 0.f, dimensions.x, dimensions.y);
+    }
+
+    void GetScaledDecodeSize(uint32_t sourceWidth, uint32_t sourceHeight, const ImageDecodeSize& size, uint32_t& width, uint32_t& height) {
+        width = sourceWidth;
+        height = sourceHeight;
+        if (size.IsNative() || sourceWidth == 0 || sourceHeight == 0) return;
+
+        const RectF fitted = GenImageBox(
+            vec2(static_cast<float>(size.width), static_cast<float>(size.height)),
+            vec2(static_cast<float>(sourceWidth), static_cast<float>(sourceHeight)),
+            size.fillMode
+        );
+        //round up so the decoded image never has fewer pixels than the screen shows
+        const uint32_t fittedWidth = static_cast<uint32_t>(std::ceil(fitted.right));
+        const uint32_t fittedHeight = static_cast<uint32_t>(std::ceil(fitted.bottom));
+        if (fittedWidth >= 1 && fittedWidth < sourceWidth) width = fittedWidth;
+        if (fittedHeight >= 1 && fittedHeight < sourceHeight) height = fittedHeight;
+    }
+
+    uint32_t QuantizeDecodeExtent(float extent) {
+        if (extent <= 1.f) return 1;
+        const float step = std::ceil(2.f * std::log2(extent));
+        return static_cast<uint32_t>(std::ceil(std::exp2(step * 0.5f)));
+    }
+
+    void DownscalePixels(const PixelBuffer& source, uint32_t width, uint32_t height, PixelBuffer& out) {
+        //separable box filter, every source pixel lands in exactly one destination pixel per axis
+        //premultiplied channels average without fringes
+        std::vector<float> rows(static_cast<size_t>(width) * source.height * 4, 0.f);
+        for (uint32_t y = 0; y < source.height; ++y) {
+            const uint8_t* srcRow = &source.pixels[static_cast<size_t>(y) * source.width * 4];
+            float* dstRow = &rows[static_cast<size_t>(y) * width * 4];
+            for (uint32_t x = 0; x < width; ++x) {
+                const uint32_t begin = static_cast<uint32_t>(static_cast<uint64_t>(x) * source.width / width);
+                const uint32_t end = static_cast<uint32_t>(static_cast<uint64_t>(x + 1) * source.width / width);
+                float sum[4] = {};
+                for (uint32_t sx = begin; sx < end; ++sx) {
+                    for (int c = 0; c < 4; ++c) sum[c] += srcRow[sx * 4 + c];
+                }
+                const float count = static_cast<float>(end - begin);
+                for (int c = 0; c < 4; ++c) dstRow[x * 4 + c] = sum[c] / count;
+            }
+        }
+
+        PixelBuffer scaled;
+        scaled.width = width;
+        scaled.height = height;
+        scaled.pixels.resize(static_cast<size_t>(width) * height * 4);
+        for (uint32_t y = 0; y < height; ++y) {
+            const uint32_t begin = static_cast<uint32_t>(static_cast<uint64_t>(y) * source.height / height);
+            const uint32_t end = static_cast<uint32_t>(static_cast<uint64_t>(y + 1) * source.height / height);
+            const float count = static_cast<float>(end - begin);
+            uint8_t* dstRow = &scaled.pixels[static_cast<size_t>(y) * width * 4];
+            for (uint32_t x = 0; x < width * 4; ++x) {
+                float sum = 0.f;
+                for (uint32_t sy = begin; sy < end; ++sy) {
+                    sum += rows[static_cast<size_t>(sy) * width * 4 + x];
+                }
+                dstRow[x] = static_cast<uint8_t>(sum / count + 0.5f);
+            }
+        }
+        out = std::move(scaled);
+    }
+
+    void ImageDecoder::DecodeToSize(const std::wstring& imageName, ImageType type, const ImageDecodeSize& size, PixelBuffer& out, ImageDecodeInfo& info) {
+        this->Decode(imageName, type, out);
+        info.sourceWidth = out.width;
+        info.sourceHeight = out.height;
+
+        uint32_t width, height;
+        GetScaledDecodeSize(out.width, out.height, size, width, height);
+        if (width != out.width || height != out.height) {
+            DownscalePixels(out, width, height, out);
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "renderdevice.hpp"
+
+namespace cpplab {
+    //box an image element shows its image in, with the fill mode deciding how the image is fit into it
+    //a zero width or height means native size
+    struct ImageDecodeSize {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        ImageFillMode fillMode = ImageFillMode::FILL;
+
+        bool IsNative() const {
+            return this->width == 0 || this->height == 0;
+        }
+        bool operator==(const ImageDecodeSize& rhs) const {
+            return this->width == rhs.width && this->height == rhs.height && this->fillMode == rhs.fillMode;
+        }
+        bool operator!=(const ImageDecodeSize& rhs) const {
+            return !(this->operator==(rhs));
+        }
+    };
+    struct ImageDecodeInfo {
+        uint32_t sourceWidth = 0;
+        uint32_t sourceHeight = 0;
+    };
+
+    //fits an image into a box of the given dimensions, the result is positioned at the origin
+    RectF GenImageBox(vec2 dimensions, vec2 imageDimensions, ImageFillMode mode);
+    //pixel size an image of sourceWidth x sourceHeight should be decoded at for the box, never larger than the source
+    void GetScaledDecodeSize(uint32_t sourceWidth, uint32_t sourceHeight, const ImageDecodeSize& size, uint32_t& width, uint32_t& height);
+    //decode sizes step in powers of the square root of two, so resizing only decodes again after crossing a step
+    //and a zoom animation finds the few sizes it passes through in the image cache
+    uint32_t QuantizeDecodeExtent(float extent);
+    //area averaging downscale of premultiplied pixels, the target must not be larger than the source
+    void DownscalePixels(const PixelBuffer& source, uint32_t width, uint32_t height, PixelBuffer& out);
+
+    //turns an image file or resource into premultiplied RGBA pixels
+    //throws std::runtime_error if the image can not be loaded
+    //the image cache calls Decode from several worker threads at once
+    class ImageDecoder {
+    public:
+        virtual ~ImageDecoder() = default;
+        virtual void Decode(const std::wstring& imageName, ImageType type, PixelBuffer& out) = 0;
+        //decodes at the size the image is shown at, decoders that can scale while decoding override this
+        //the default decodes at native size and downscales afterwards
+        virtual void DecodeToSize(const std::wstring& imageName, ImageType type, const ImageDecodeSize& size, PixelBuffer& out, ImageDecodeInfo& info);
+    };
+}
@@ -0,0 +1,439 @@
+#include "layoutengine.hpp"
+#include <chrono>
+
+namespace cpplab {
+    namespace {
+        float Clamp(float value, float low, float high) {
+            return value < low ? low : (value > high ? high : value);
+        }
+        float AlignOffset(LayoutAlign align, float space, float size) {
+            if (align == LayoutAlign::CENTER) return (space - size) * 0.5f;
+            if (align == LayoutAlign::END) return space - size;
+            return 0.f;
+        }
+        //the axis helpers let the stacks share one implementation
+        float Along(vec2 v, bool horizontal) {
+            return horizontal ? v.x : v.y;
+        }
+        float MarginBefore(const LayoutInsets& insets, bool horizontal) {
+            return horizontal ? insets.left : insets.top;
+        }
+        float MarginAfter(const LayoutInsets& insets, bool horizontal) {
+            return horizontal ? insets.right : insets.bottom;
+        }
+    }
+
+    LayoutEngine::LayoutEngine(FrameScheduler* frameScheduler) {
+        this->frameScheduler = frameScheduler;
+    }
+
+    LayoutEngine::LayoutNode& LayoutEngine::Acquire(ElementNode* element) {
+        const ElementHandle handle = element->getHandle();
+        if (handle.index >= this->nodes.size()) this->nodes.resize(handle.index + 1);
+        if (this->nodes[handle.index].known) {
+            if (this->nodes[handle.index].element == handle) return this->nodes[handle.index];
+            //the slot went to a new element after the old one was deleted
+            this->Forget(handle.index);
+        }
+
+        LayoutNode& node = this->nodes[handle.index];
+        node = LayoutNode();
+        node.element = handle;
+        node.owner = element;
+        node.known = true;
+        node.intrinsic = element->getDimensions();
+        ++this->stats.nodes;
+        return node;
+    }
+    LayoutEngine::LayoutNode* LayoutEngine::Find(ElementHandle handle) {
+        if (handle.index >= this->nodes.size()) return nullptr;
+        LayoutNode& node = this->nodes[handle.index];
+        return node.known && node.element == handle ? &node : nullptr;
+    }
+    void LayoutEngine::Forget(uint32_t index) {
+        LayoutNode& node = this->nodes[index];
+        if (!node.known) return;
+        if (node.hasContainer) {
+            this->containers.erase(std::find(this->containers.begin(), this->containers.end(), index));
+        }
+        for (uint32_t child : node.children) {
+            if (this->nodes[child].parent == index) this->nodes[child].parent = InvalidIndex;
+        }
+        if (index == this->rootIndex) this->rootIndex = InvalidIndex;
+        node = LayoutNode();
+        --this->stats.nodes;
+        this->structureDirty = true;
+    }
+
+    void LayoutEngine::Invalidate(uint32_t index) {
+        LayoutNode& node = this->nodes[index];
+        node.measureDirty = true;
+        node.arrangeDirty = true;
+        //the container re-places its children even if this node's size comes out the same, a margin may have changed
+        //above it only the measure flags go up, everything above an already dirty node is dirty too
+        uint32_t current = node.parent;
+        if (current != InvalidIndex) this->nodes[current].arrangeDirty = true;
+        while (current != InvalidIndex && !this->nodes[current].measureDirty) {
+            this->nodes[current].measureDirty = true;
+            current = this->nodes[current].parent;
+        }
+        this->frameScheduler->RequestFrame();
+    }
+
+    void LayoutEngine::SetRoot(ElementNode* root) {
+        const uint32_t index = this->Acquire(root).element.index;
+        this->rootIndex = index;
+        this->Invalidate(index);
+    }
+    void LayoutEngine::SetViewport(vec2 size) {
+        if (this->viewport == size) return;
+        this->viewport = size;
+        this->frameScheduler->RequestFrame();
+    }
+
+    void LayoutEngine::SetContainer(ElementNode* element, const LayoutContainer& container) {
+        LayoutNode& node = this->Acquire(element);
+        const uint32_t index = node.element.index;
+        if (!node.hasContainer) {
+            node.hasContainer = true;
+            this->containers.push_back(index);
+            this->structureDirty = true;
+        }
+        node.container = container;
+        this->Invalidate(index);
+    }
+    void LayoutEngine::SetItem(ElementNode* element, const LayoutItem& item) {
+        LayoutNode& node = this->Acquire(element);
+        node.item = item;
+        node.intrinsic = element->getDimensions();
+        this->Invalidate(node.element.index);
+    }
+    void LayoutEngine::Remove(ElementNode* element) {
+        LayoutNode* node = this->Find(element->getHandle());
+        if (node == nullptr) return;
+        const uint32_t index = node->element.index;
+        if (node->hasContainer) {
+            node->hasContainer = false;
+            this->containers.erase(std::find(this->containers.begin(), this->containers.end(), index));
+            for (uint32_t child : node->children) {
+                if (this->nodes[child].parent == index) this->nodes[child].parent = InvalidIndex;
+            }
+            node->children.clear();
+        }
+        node->item = LayoutItem();
+        node->intrinsic = element->getDimensions();
+        this->Invalidate(index);
+    }
+
+    void LayoutEngine::RefreshStructure() {
+        ElementStore& store = ElementStore::Instance();
+        const uint64_t edits = store.StructureEdits();
+        if (!this->structureDirty && edits == this->seenStructureEdits) return;
+        this->seenStructureEdits = edits;
+        this->structureDirty = false;
+
+        if (this->rootIndex != InvalidIndex && store.Resolve(this->nodes[this->rootIndex].element) == nullptr) {
+            this->Forget(this->rootIndex);
+        }
+        //only containers are compared, a resize with no children added or removed never gets here
+        for (size_t k = 0; k < this->containers.size();) {
+            const uint32_t container = this->containers[k];
+            if (store.Resolve(this->nodes[container].element) == nullptr) {
+                this->Forget(container);
+                continue;
+            }
+            store.CollectChildHandles(container, this->handleScratch);
+            this->childScratch.clear();
+            for (const ElementHandle& handle : this->handleScratch) {
+                if (this->Find(handle) == nullptr) {
+                    ElementNode* owner = store.Resolve(handle);
+                    if (owner == nullptr) continue;
+                    this->Acquire(owner);
+                }
+                this->childScratch.push_back(handle.index);
+            }
+            ++k;
+            if (this->childScratch == this->nodes[container].children) continue;
+
+            for (uint32_t child : this->nodes[container].children) {
+                if (this->nodes[child].parent != container) continue;
+                this->nodes[child].parent = InvalidIndex;
+                //children that left because they were deleted are dropped, moved ones are picked up by their new container
+                //deleted containers are left to this loop, forgetting them here would shift the list under it
+                if (!this->nodes[child].hasContainer && store.Resolve(this->nodes[child].element) == nullptr) this->Forget(child);
+            }
+            for (uint32_t child : this->childScratch) {
+                this->nodes[child].parent = container;
+                //a child moved in from elsewhere still has the rectangle of its old place
+                this->nodes[child].placed = false;
+            }
+            this->nodes[container].children.swap(this->childScratch);
+            this->Invalidate(container);
+        }
+    }
+
+    vec2 LayoutEngine::Measure(uint32_t index) {
+        LayoutNode& node = this->nodes[index];
+        if (!node.measureDirty) return node.measured;
+        ++this->stats.lastMeasured;
+
+        vec2 content;
+        if (node.hasContainer) {
+            const LayoutContainer& container = node.container;
+            const size_t count = node.children.size();
+            if (container.kind == LayoutKind::GRID) {
+                const uint32_t columns = (std::max)(container.columns, 1u);
+                float cellWidth = 0.f;
+                float rowHeight = 0.f;
+                for (size_t i = 0; i < count; ++i) {
+                    const LayoutNode& child = this->nodes[node.children[i]];
+                    const vec2 size = this->Measure(node.children[i]);
+                    cellWidth = (std::max)(cellWidth, size.x + child.item.margin.left + child.item.margin.right);
+                    rowHeight = (std::max)(rowHeight, size.y + child.item.margin.top + child.item.margin.bottom);
+                    //a row ends at its last column or the last child
+                    if ((i + 1) % columns == 0 || i + 1 == count) {
+                        content.y += (container.rowHeight > 0.f ? container.rowHeight : rowHeight);
+                        if (i + 1 != count) content.y += container.gap;
+                        rowHeight = 0.f;
+                    }
+                }
+                const uint32_t usedColumns = static_cast<uint32_t>((std::min)(static_cast<size_t>(columns), count));
+                if (usedColumns > 0) content.x = cellWidth * usedColumns + container.gap * (usedColumns - 1);
+            }
+            else {
+                const bool stacked = container.kind != LayoutKind::ABSOLUTE;
+                const bool horizontal = container.kind == LayoutKind::HORIZONTAL_STACK;
+                for (uint32_t childIndex : node.children) {
+                    const vec2 size = this->Measure(childIndex);
+                    const LayoutInsets& margin = this->nodes[childIndex].item.margin;
+                    const float width = size.x + margin.left + margin.right;
+                    const float height = size.y + margin.top + margin.bottom;
+                    if (stacked && horizontal) {
+                        content.x += width;
+                        content.y = (std::max)(content.y, height);
+                    }
+                    else if (stacked) {
+                        content.x = (std::max)(content.x, width);
+                        content.y += height;
+                    }
+                    else {
+                        content.x = (std::max)(content.x, width);
+                        content.y = (std::max)(content.y, height);
+                    }
+                }
+                if (stacked && count > 1) {
+                    (horizontal ? content.x : content.y) += container.gap * (count - 1);
+                }
+            }
+            content.x += container.padding.left + container.padding.right;
+            content.y += container.padding.top + container.padding.bottom;
+            for (uint32_t childIndex : node.children) {
+                if (this->nodes[childIndex].arrangeDirty) node.arrangeDirty = true;
+            }
+        }
+        else {
+            content = node.intrinsic;
+        }
+
+        const LayoutItem& item = node.item;
+        vec2 size = vec2(
+            Clamp(item.size.x >= 0.f ? item.size.x : content.x, item.minSize.x, item.maxSize.x),
+            Clamp(item.size.y >= 0.f ? item.size.y : content.y, item.minSize.y, item.maxSize.y)
+        );
+        if (size != node.measured) {
+            node.measured = size;
+            if (node.parent != InvalidIndex) this->nodes[node.parent].arrangeDirty = true;
+        }
+        node.measureDirty = false;
+        return node.measured;
+    }
+
+    void LayoutEngine::Arrange(uint32_t index, float x, float y, float width, float height) {
+        LayoutNode& node = this->nodes[index];
+        const bool moved = !node.placed || x != node.x || y != node.y || width != node.width || height != node.height;
+        //the whole subtree is skipped when its space and children are the same as last pass
+        if (!moved && !node.arrangeDirty) return;
+        ++this->stats.lastArranged;
+
+        if (moved) {
+            node.x = x;
+            node.y = y;
+            node.width = width;
+            node.height = height;
+            node.placed = true;
+            //one state swap for position and size together
+            node.owner->updateState<ElementState>(DIRTY_GEOMETRY, [x, y, width, height](ElementState& state) {
+                state.posX = x;
+                state.posY = y;
+                state.width = width;
+                state.height = height;
+            });
+            ++this->stats.lastWritten;
+        }
+        if (node.hasContainer) {
+            switch (node.container.kind) {
+            case LayoutKind::ABSOLUTE:
+                this->ArrangeAbsolute(node);
+                break;
+            case LayoutKind::HORIZONTAL_STACK:
+                this->ArrangeStack(node, true);
+                break;
+            case LayoutKind::VERTICAL_STACK:
+                this->ArrangeStack(node, false);
+                break;
+            case LayoutKind::GRID:
+                this->ArrangeGrid(node);
+                break;
+            }
+        }
+        node.arrangeDirty = false;
+    }
+
+    void LayoutEngine::ArrangeChild(uint32_t child, float x, float y, float width, float height, LayoutAlign alignX, LayoutAlign alignY) {
+        const LayoutNode& node = this->nodes[child];
+        const LayoutItem& item = node.item;
+        const float spaceX = width - item.margin.left - item.margin.right;
+        const float spaceY = height - item.margin.top - item.margin.bottom;
+        const float childWidth = alignX == LayoutAlign::STRETCH && item.size.x < 0.f ? Clamp(spaceX, item.minSize.x, item.maxSize.x) : node.measured.x;
+        const float childHeight = alignY == LayoutAlign::STRETCH && item.size.y < 0.f ? Clamp(spaceY, item.minSize.y, item.maxSize.y) : node.measured.y;
+        this->Arrange(
+            child,
+            x + item.margin.left + AlignOffset(alignX, spaceX, childWidth),
+            y + item.margin.top + AlignOffset(alignY, spaceY, childHeight),
+            childWidth, childHeight
+        );
+    }
+
+    void LayoutEngine::ArrangeStack(LayoutNode& node, bool horizontal) {
+        const LayoutContainer& container = node.container;
+        const size_t count = node.children.size();
+        if (count == 0) return;
+        const float mainSpace = horizontal ? node.width - container.padding.left - container.padding.right : node.height - container.padding.top - container.padding.bottom;
+        const float crossSpace = horizontal ? node.height - container.padding.top - container.padding.bottom : node.width - container.padding.left - container.padding.right;
+
+        //grow and shrink work on the measured sizes, no item is measured again here
+        float used = container.gap * (count - 1);
+        float growTotal = 0.f;
+        float shrinkTotal = 0.f;
+        for (uint32_t child : node.children) {
+            const LayoutNode& item = this->nodes[child];
+            const float size = Along(item.measured, horizontal);
+            used += size + MarginBefore(item.item.margin, horizontal) + MarginAfter(item.item.margin, horizontal);
+            growTotal += item.item.grow;
+            shrinkTotal += item.item.shrink * size;
+        }
+        const float free = mainSpace - used;
+        const float growShare = free > 0.f && growTotal > 0.f ? free / growTotal : 0.f;
+        const float shrinkShare = free < 0.f && shrinkTotal > 0.f ? free / shrinkTotal : 0.f;
+
+        //second pass places the items, what growing and shrinking could not hand out goes to justify
+        float placed = container.gap * (count - 1);
+        for (uint32_t child : node.children) {
+            const LayoutNode& item = this->nodes[child];
+            const float size = Along(item.measured, horizontal);
+            const float target = size + item.item.grow * growShare + item.item.shrink * size * shrinkShare;
+            placed += Clamp(target, Along(item.item.minSize, horizontal), Along(item.item.maxSize, horizontal)) +
+                MarginBefore(item.item.margin, horizontal) + MarginAfter(item.item.margin, horizontal);
+        }
+        const float leftover = (std::max)(mainSpace - placed, 0.f);
+        float cursor = 0.f;
+        float spacing = container.gap;
+        if (container.justify == LayoutJustify::CENTER) cursor = leftover * 0.5f;
+        else if (container.justify == LayoutJustify::END) cursor = leftover;
+        else if (container.justify == LayoutJustify::SPACE_BETWEEN && count > 1) spacing += leftover / (count - 1);
+
+        const float mainStart = horizontal ? container.padding.left : container.padding.top;
+        const float crossStart = horizontal ? container.padding.top : container.padding.left;
+        for (uint32_t child : node.children) {
+            const LayoutNode& item = this->nodes[child];
+            const float size = Along(item.measured, horizontal);
+            const float mainSize = Clamp(
+                size + item.item.grow * growShare + item.item.shrink * size * shrinkShare,
+                Along(item.item.minSize, horizontal), Along(item.item.maxSize, horizontal)
+            );
+            const float cellMain = mainSize + MarginBefore(item.item.margin, horizontal) + MarginAfter(item.item.margin, horizontal);
+            //the main axis is sized exactly, STRETCH over a cell of that size gives it, alignment only applies across
+            if (horizontal) {
+                LayoutAlign mainAlign = item.item.size.x < 0.f ? LayoutAlign::STRETCH : LayoutAlign::START;
+                this->ArrangeChild(child, mainStart + cursor, crossStart, cellMain, crossSpace, mainAlign, container.align);
+            }
+            else {
+                LayoutAlign mainAlign = item.item.size.y < 0.f ? LayoutAlign::STRETCH : LayoutAlign::START;
+                this->ArrangeChild(child, crossStart, mainStart + cursor, crossSpace, cellMain, container.align, mainAlign);
+            }
+            cursor += cellMain + spacing;
+        }
+    }
+
+    void LayoutEngine::ArrangeGrid(LayoutNode& node) {
+        const LayoutContainer& container = node.container;
+        const size_t count = node.children.size();
+        const uint32_t columns = (std::max)(container.columns, 1u);
+        const float contentWidth = node.width - container.padding.left - container.padding.right;
+        const float cellWidth = (std::max)((contentWidth - container.gap * (columns - 1)) / columns, 0.f);
+
+        float y = container.padding.top;
+        for (size_t rowStart = 0; rowStart < count; rowStart += columns) {
+            const size_t rowEnd = (std::min)(rowStart + columns, count);
+            float rowHeight = container.rowHeight;
+            if (rowHeight <= 0.f) {
+                for (size_t i = rowStart; i < rowEnd; ++i) {
+                    const LayoutNode& item = this->nodes[node.children[i]];
+                    rowHeight = (std::max)(rowHeight, item.measured.y + item.item.margin.top + item.item.margin.bottom);
+                }
+            }
+            for (size_t i = rowStart; i < rowEnd; ++i) {
+                const float x = container.padding.left + (i - rowStart) * (cellWidth + container.gap);
+                this->ArrangeChild(node.children[i], x, y, cellWidth, rowHeight, container.align, container.align);
+            }
+            y += rowHeight + container.gap;
+        }
+    }
+
+    void LayoutEngine::ArrangeAbsolute(LayoutNode& node) {
+        const LayoutInsets& padding = node.container.padding;
+        const float contentWidth = node.width - padding.left - padding.right;
+        const float contentHeight = node.height - padding.top - padding.bottom;
+        for (uint32_t child : node.children) {
+            const LayoutItem& item = this->nodes[child].item;
+            //an edge that is not anchored leaves the item where its other edge or the center puts it
+            const bool left = item.anchors & ANCHOR_LEFT, right = item.anchors & ANCHOR_RIGHT;
+            const bool top = item.anchors & ANCHOR_TOP, bottom = item.anchors & ANCHOR_BOTTOM;
+            const LayoutAlign alignX = left && right ? LayoutAlign::STRETCH : (left ? LayoutAlign::START : (right ? LayoutAlign::END : LayoutAlign::CENTER));
+            const LayoutAlign alignY = top && bottom ? LayoutAlign::STRETCH : (top ? LayoutAlign::START : (bottom ? LayoutAlign::END : LayoutAlign::CENTER));
+            this->ArrangeChild(child, padding.left, padding.top, contentWidth, contentHeight, alignX, alignY);
+        }
+    }
+
+    void LayoutEngine::RunFrame() {
+        const auto started = std::chrono::steady_clock::now();
+        this->stats.lastMeasured = 0;
+        this->stats.lastArranged = 0;
+        this->stats.lastWritten = 0;
+        this->RefreshStructure();
+
+        for (uint32_t container : this->containers) {
+            if (this->nodes[container].parent != InvalidIndex) continue;
+            const vec2 size = this->Measure(container);
+            if (container == this->rootIndex) {
+                this->Arrange(container, 0.f, 0.f, this->viewport.x, this->viewport.y);
+            }
+            else {
+                //containers placed by hand keep their position
+                const vec2 position = this->nodes[container].owner->getRelativePosition();
+                this->Arrange(container, position.x, position.y, size.x, size.y);
+            }
+        }
+
+        ++this->stats.passes;
+        this->stats.lastLayoutMicroseconds = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count()
+        );
+    }
+
+    LayoutStats LayoutEngine::GetStats() const {
+        LayoutStats result = this->stats;
+        result.containers = this->containers.size();
+        return result;
+    }
+}
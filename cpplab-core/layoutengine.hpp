@@ -0,0 +1,165 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include "framescheduler.hpp"
+#include "engineelements.hpp"
+
+namespace cpplab {
+    enum class LayoutKind : uint8_t {
+        //children are placed by their anchors and margins
+        ABSOLUTE,
+        HORIZONTAL_STACK,
+        VERTICAL_STACK,
+        //fixed number of equal columns, rows as tall as their tallest item unless a row height is set
+        GRID
+    };
+    enum class LayoutAlign : uint8_t {
+        START, CENTER, END,
+        //fills the space across, items with a fixed size on that axis keep it
+        STRETCH
+    };
+    //where the space left over along a stack goes
+    enum class LayoutJustify : uint8_t {
+        START, CENTER, END, SPACE_BETWEEN
+    };
+    enum LayoutAnchor : uint8_t {
+        ANCHOR_LEFT = 1u << 0,
+        ANCHOR_TOP = 1u << 1,
+        ANCHOR_RIGHT = 1u << 2,
+        ANCHOR_BOTTOM = 1u << 3
+    };
+
+    struct LayoutInsets {
+        float left = 0.f, top = 0.f, right = 0.f, bottom = 0.f;
+
+        LayoutInsets() {}
+        LayoutInsets(float all) : left{ all }, top{ all }, right{ all }, bottom{ all } {}
+        LayoutInsets(float left_, float top_, float right_, float bottom_) : left{ left_ }, top{ top_ }, right{ right_ }, bottom{ bottom_ } {}
+    };
+
+    //how an element lays out its children
+    struct LayoutContainer {
+        LayoutKind kind = LayoutKind::ABSOLUTE;
+        LayoutInsets padding;
+        //between items of a stack, between rows and columns of a grid
+        float gap = 0.f;
+        //across a stack, and on both axes within a grid cell
+        LayoutAlign align = LayoutAlign::STRETCH;
+        LayoutJustify justify = LayoutJustify::START;
+        uint32_t columns = 1;
+        float rowHeight = 0.f;
+    };
+
+    //how an element sits in the container it is a child of
+    //the size wanted on an axis is the fixed size when one is given, else what a container's children need,
+    //else the size the element had when it joined the layout, call SetItem again after resizing such an element by hand
+    struct LayoutItem {
+        //negative on an axis means not fixed
+        vec2 size = vec2(-1.f, -1.f);
+        vec2 minSize = vec2(0.f, 0.f);
+        vec2 maxSize = vec2((std::numeric_limits<float>::max)(), (std::numeric_limits<float>::max)());
+        LayoutInsets margin;
+        //share of the space left over along a stack
+        float grow = 0.f;
+        //share of the space missing along a stack, weighted by the item's size
+        float shrink = 1.f;
+        //in absolute containers, the edges the margins measure from, both edges of an axis stretch and none centers
+        uint8_t anchors = ANCHOR_LEFT | ANCHOR_TOP;
+    };
+
+    struct LayoutStats {
+        size_t nodes = 0;
+        size_t containers = 0;
+        uint64_t passes = 0;
+        //nodes measured, arranged and written back by the last pass, unchanged subtrees are skipped
+        size_t lastMeasured = 0;
+        size_t lastArranged = 0;
+        size_t lastWritten = 0;
+        uint64_t lastLayoutMicroseconds = 0;
+    };
+
+    //measure and arrange pass over elements attached to containers, run once per frame
+    //measuring is bottom up and only for nodes whose item, container or children changed, sizes are cached otherwise
+    //arranging is top down and stops at every node whose rectangle and children are the same as last pass
+    //so a resize only revisits the subtrees whose space changed, and each element moved or resized costs one state swap
+    //containers whose parent is no container are laid out in their own place, the root given to SetRoot fills the viewport
+    //ui thread only, children may be added or removed from any thread, the next pass picks them up
+    class LayoutEngine {
+    private:
+        static constexpr uint32_t InvalidIndex = 0xffffffffu;
+
+        //indexed by element store slot
+        struct LayoutNode {
+            ElementHandle element;
+            ElementNode* owner = nullptr;
+            bool known = false;
+            bool hasContainer = false;
+            LayoutContainer container;
+            LayoutItem item;
+            //size the element had when it joined
+            vec2 intrinsic;
+            //the container laying this out
+            uint32_t parent = InvalidIndex;
+            std::vector<uint32_t> children;
+
+            vec2 measured;
+            bool measureDirty = true;
+            //children need new rectangles even if this node's own did not change
+            bool arrangeDirty = true;
+            bool placed = false;
+            float x = 0.f, y = 0.f, width = 0.f, height = 0.f;
+        };
+
+        FrameScheduler* frameScheduler;
+        std::vector<LayoutNode> nodes;
+        std::vector<uint32_t> containers;
+        uint32_t rootIndex = InvalidIndex;
+        vec2 viewport;
+        //element store edits seen by the last pass, child lists are compared again once it moves
+        uint64_t seenStructureEdits = 0;
+        bool structureDirty = true;
+        std::vector<ElementHandle> handleScratch;
+        std::vector<uint32_t> childScratch;
+
+        LayoutStats stats;
+
+        LayoutNode& Acquire(ElementNode* element);
+        LayoutNode* Find(ElementHandle handle);
+        void Forget(uint32_t index);
+        void Invalidate(uint32_t index);
+        void RefreshStructure();
+        vec2 Measure(uint32_t index);
+        void Arrange(uint32_t index, float x, float y, float width, float height);
+        void ArrangeChild(uint32_t child, float x, float y, float width, float height, LayoutAlign alignX, LayoutAlign alignY);
+        void ArrangeStack(LayoutNode& node, bool horizontal);
+        void ArrangeGrid(LayoutNode& node);
+        void ArrangeAbsolute(LayoutNode& node);
+
+    public:
+        LayoutEngine(FrameScheduler* frameScheduler);
+        LayoutEngine(const LayoutEngine&) = delete;
+        LayoutEngine& operator=(const LayoutEngine&) = delete;
+
+        //the element filling the viewport, usually the engine's root node
+        void SetRoot(ElementNode* root);
+        //in pixels, the units element positions and sizes are in, not dips
+        void SetViewport(vec2 size);
+        vec2 GetViewport() const {
+            return this->viewport;
+        }
+
+        //makes the element lay out its children
+        void SetContainer(ElementNode* element, const LayoutContainer& container);
+        //sets how the element sits in its container and takes its current size as its own size again
+        void SetItem(ElementNode* element, const LayoutItem& item);
+        //stops laying out the element's children and resets its item, positions already set stay
+        void Remove(ElementNode* element);
+
+        //ui thread, once per frame before animations run, so an animation started on a laid out element wins
+        void RunFrame();
+        LayoutStats GetStats() const;
+    };
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <atomic>
+#include <utility>
+
+namespace cpplab {
+    //unbounded multi producer single consumer queue, pushing never locks or waits
+    //a linked list with a stub node, producers swap the tail and link behind it, the consumer follows the links from the head
+    //a push that swapped the tail but did not link yet looks like the end of the queue, the consumer picks it up on a later pop
+    //T must be default constructible, the stub holds one
+    template <class T>
+    class MpscQueue {
+    private:
+        struct Node {
+            std::atomic<Node*> next = nullptr;
+            T value;
+        };
+
+        alignas(64) std::atomic<Node*> tail; //last pushed node, swapped by producers
+        alignas(64) Node* head; //stub whose next is the front, only touched by the consumer
+
+    public:
+        MpscQueue() {
+            Node* stub = new Node();
+            this->head = stub;
+            this->tail.store(stub, std::memory_order_relaxed);
+        }
+        MpscQueue(const MpscQueue&) = delete;
+        MpscQueue& operator=(const MpscQueue&) = delete;
+        //no producer may still be pushing
+        ~MpscQueue() {
+            Node* node = this->head;
+            while (node != nullptr) {
+                Node* next = node->next.load(std::memory_order_relaxed);
+                delete node;
+                node = next;
+            }
+        }
+
+        //any thread
+        void Push(T value) {
+            Node* node = new Node();
+            node->value = std::move(value);
+            Node* previous = this->tail.exchange(node, std::memory_order_acq_rel);
+            previous->next.store(node, std::memory_order_release);
+        }
+        //consumer only, returns false when empty
+        bool TryPop(T& out) {
+            Node* next = this->head->next.load(std::memory_order_acquire);
+            if (next == nullptr) return false;
+            //next becomes the stub, its value moves out and is reset so captured state does not live on in the stub
+            out = std::move(next->value);
+            next->value = T();
+            delete this->head;
+            this->head = next;
+            return true;
+        }
+    };
+}
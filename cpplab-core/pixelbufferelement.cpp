@@ -0,0 +1,145 @@
+#include <cstring>
+#include <stdexcept>
+#include "pixelbufferelement.hpp"
+
+namespace cpplab {
+    static PixelRegion UnionRegion(const PixelRegion& a, const PixelRegion& b) {
+        if (a.IsEmpty()) return b;
+        if (b.IsEmpty()) return a;
+        const uint32_t x0 = a.x < b.x ? a.x : b.x;
+        const uint32_t y0 = a.y < b.y ? a.y : b.y;
+        const uint32_t x1 = a.x + a.width > b.x + b.width ? a.x + a.width : b.x + b.width;
+        const uint32_t y1 = a.y + a.height > b.y + b.height ? a.y + a.height : b.y + b.height;
+        return PixelRegion{ x0, y0, x1 - x0, y1 - y0 };
+    }
+    static bool ContainsRegion(const PixelRegion& outer, const PixelRegion& inner) {
+        return inner.x >= outer.x && inner.y >= outer.y &&
+            inner.x + inner.width <= outer.x + outer.width &&
+            inner.y + inner.height <= outer.y + outer.height;
+    }
+    static uint64_t PackRegion(const PixelRegion& region) {
+        if (region.IsEmpty()) return 0;
+        return static_cast<uint64_t>(region.x) |
+            (static_cast<uint64_t>(region.y) << 16) |
+            (static_cast<uint64_t>(region.x + region.width) << 32) |
+            (static_cast<uint64_t>(region.y + region.height) << 48);
+    }
+    static PixelRegion UnpackRegion(uint64_t packed) {
+        if (packed == 0) return PixelRegion();
+        const uint32_t x0 = packed & 0xffff, y0 = (packed >> 16) & 0xffff;
+        const uint32_t x1 = (packed >> 32) & 0xffff, y1 = (packed >> 48) & 0xffff;
+        return PixelRegion{ x0, y0, x1 - x0, y1 - y0 };
+    }
+    static void CopyRows(PixelBuffer& target, const PixelRegion& region, const uint8_t* pixels, uint32_t stride) {
+        const size_t rowBytes = static_cast<size_t>(region.width) * 4;
+        for (uint32_t row = 0; row < region.height; ++row) {
+            std::memcpy(
+                &target.pixels[(static_cast<size_t>(region.y + row) * target.width + region.x) * 4],
+                pixels + static_cast<size_t>(row) * stride,
+                rowBytes
+            );
+        }
+    }
+
+    PixelBufferElement::PixelBufferElement(uint32_t width, uint32_t height) {
+        //regions are packed into 16 bit coordinates
+        if (width == 0 || height == 0 || width > 0xffff || height > 0xffff) {
+            throw std::runtime_error("[Cpplab Renderer] During Pixel Buffer Creation: Size must be between 1 and 65535 pixels!");
+        }
+        this->pixelWidth = width;
+        this->pixelHeight = height;
+        this->setInitialState(this->extendState<PixelBufferState>());
+        this->setNodeType(NodeType::PIXEL_BUFFER);
+        for (PixelBuffer& buffer : this->buffers) {
+            buffer.width = width;
+            buffer.height = height;
+            buffer.pixels.assign(static_cast<size_t>(width) * height * 4, 0);
+        }
+        this->readyState.store(this->latestIndex);
+    }
+
+    void PixelBufferElement::CatchUp(const PixelRegion& covered) {
+        //the write buffer was last written a couple of frames ago, copy what changed since from the newest frame
+        //skipped when the new frame overwrites all of it anyway
+        PixelRegion& stale = this->staleRegions[this->writeIndex];
+        if (!stale.IsEmpty() && !ContainsRegion(covered, stale)) {
+            const PixelBuffer& latest = this->buffers[this->latestIndex];
+            const uint8_t* source = &latest.pixels[(static_cast<size_t>(stale.y) * latest.width + stale.x) * 4];
+            CopyRows(this->buffers[this->writeIndex], stale, source, latest.width * 4);
+            this->bytesCaughtUp.fetch_add(static_cast<uint64_t>(stale.width) * stale.height * 4, std::memory_order_relaxed);
+        }
+        stale = PixelRegion();
+    }
+    void PixelBufferElement::Publish(const PixelRegion& changed) {
+        for (uint32_t i = 0; i < 3; ++i) {
+            if (i != this->writeIndex) this->staleRegions[i] = UnionRegion(this->staleRegions[i], changed);
+        }
+        this->latestIndex = this->writeIndex;
+        const uint32_t previous = this->readyState.exchange(this->writeIndex | FreshBit, std::memory_order_acq_rel);
+        this->writeIndex = previous & IndexMask;
+
+        //the region is added after the swap, so whoever takes it also finds the frame holding it
+        uint64_t expected = this->pendingUpload.load(std::memory_order_relaxed);
+        while (!this->pendingUpload.compare_exchange_weak(
+            expected, PackRegion(UnionRegion(UnpackRegion(expected), changed)),
+            std::memory_order_acq_rel, std::memory_order_relaxed
+        )) {}
+
+        this->framesPublished.fetch_add(1, std::memory_order_relaxed);
+        this->markModified(DIRTY_PIXELS);
+    }
+
+    void PixelBufferElement::updateRegion(const PixelRegion& region, const uint8_t* pixels, uint32_t stride) {
+        PixelRegionUpdate update;
+        update.region = region;
+        update.pixels = pixels;
+        update.stride = stride;
+        this->updateRegions(&update, 1);
+    }
+    void PixelBufferElement::updateRegions(const PixelRegionUpdate* updates, size_t count) {
+        PixelRegion changed;
+        for (size_t i = 0; i < count; ++i) {
+            const PixelRegion& region = updates[i].region;
+            if (region.x + region.width > this->pixelWidth || region.y + region.height > this->pixelHeight) {
+                throw std::runtime_error("[Cpplab Renderer] During Pixel Buffer Update: Region is outside the buffer!");
+            }
+            if (updates[i].stride < region.width * 4) {
+                throw std::runtime_error("[Cpplab Renderer] During Pixel Buffer Update: Stride is smaller than a row of the region!");
+            }
+            changed = UnionRegion(changed, region);
+        }
+        if (changed.IsEmpty()) return;
+
+        std::lock_guard<std::mutex> guard(this->producerLock);
+        this->CatchUp(changed);
+        uint64_t written = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (updates[i].region.IsEmpty()) continue;
+            CopyRows(this->buffers[this->writeIndex], updates[i].region, updates[i].pixels, updates[i].stride);
+            written += static_cast<uint64_t>(updates[i].region.width) * updates[i].region.height * 4;
+        }
+        this->bytesWritten.fetch_add(written, std::memory_order_relaxed);
+        this->Publish(changed);
+    }
+
+    PixelRegion PixelBufferElement::ConsumeFrame() {
+        //take the region before the frame, a region published in between is uploaded again next frame instead of lost
+        const PixelRegion region = UnpackRegion(this->pendingUpload.exchange(0, std::memory_order_acq_rel));
+        if (this->readyState.load(std::memory_order_acquire) & FreshBit) {
+            const uint32_t previous = this->readyState.exchange(this->readIndex, std::memory_order_acq_rel);
+            this->readIndex = previous & IndexMask;
+            this->framesConsumed.fetch_add(1, std::memory_order_relaxed);
+        }
+        return region;
+    }
+
+    PixelBufferStats PixelBufferElement::getStats() const {
+        PixelBufferStats stats;
+        stats.framesPublished = this->framesPublished.load(std::memory_order_relaxed);
+        stats.framesConsumed = this->framesConsumed.load(std::memory_order_relaxed);
+        stats.bytesWritten = this->bytesWritten.load(std::memory_order_relaxed);
+        stats.bytesCaughtUp = this->bytesCaughtUp.load(std::memory_order_relaxed);
+        stats.bytesUploaded = this->bytesUploaded.load(std::memory_order_relaxed);
+        return stats;
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include "renderdevice.hpp"
+
+namespace cpplab {
+    //one changed region of a frame, pixels points at the region's top left pixel
+    struct PixelRegionUpdate {
+        PixelRegion region;
+        const uint8_t* pixels = nullptr;
+        uint32_t stride = 0;
+    };
+
+    //cumulative byte counts, bytesCaughtUp is what the producer copied to bring a recycled buffer up to date
+    struct PixelBufferStats {
+        uint64_t framesPublished = 0;
+        uint64_t framesConsumed = 0;
+        uint64_t bytesWritten = 0;
+        uint64_t bytesCaughtUp = 0;
+        uint64_t bytesUploaded = 0;
+    };
+
+    struct PixelBufferState : public ElementState {
+        ImageFillMode fillMode = ImageFillMode::CONTAIN;
+
+        std::shared_ptr<ElementState> Clone() const override {
+            return std::make_shared<PixelBufferState>(*this);
+        }
+    };
+
+    //image element fed with premultiplied RGBA pixels from the caller instead of a file, for camera frames and live plots
+    //producers write changed regions into a triple buffer and publish them with one atomic swap, so they never wait on the renderer
+    //the renderer takes the newest frame and uploads only the rectangle changed since its last upload into the existing bitmap
+    class PixelBufferElement : public ElementNode {
+        friend class SceneRenderer;
+    private:
+        static constexpr uint32_t IndexMask = 3u;
+        static constexpr uint32_t FreshBit = 4u;
+
+        uint32_t pixelWidth;
+        uint32_t pixelHeight;
+
+        PixelBuffer buffers[3];
+        //index of the buffer waiting to be taken, FreshBit set while the renderer has not taken it yet
+        std::atomic<uint32_t> readyState;
+
+        //producer side, the lock only orders several producers against each other
+        std::mutex producerLock;
+        uint32_t writeIndex = 0;
+        uint32_t latestIndex = 1;
+        //area each buffer missed while the other buffers were written, copied over from the latest buffer before its next write
+        PixelRegion staleRegions[3];
+
+        //renderer side
+        uint32_t readIndex = 2;
+        //union of the regions published since the renderer last uploaded, packed x0, y0, x1, y1 in 16 bits each
+        std::atomic<uint64_t> pendingUpload = 0;
+
+        std::atomic<uint64_t> framesPublished = 0;
+        std::atomic<uint64_t> framesConsumed = 0;
+        std::atomic<uint64_t> bytesWritten = 0;
+        std::atomic<uint64_t> bytesCaughtUp = 0;
+        std::atomic<uint64_t> bytesUploaded = 0;
+
+        //expects producerLock to be held
+        void CatchUp(const PixelRegion& covered);
+        void Publish(const PixelRegion& changed);
+
+        //takes the newest frame and returns the region that has to be uploaded from ReadBuffer
+        PixelRegion ConsumeFrame();
+        const PixelBuffer& ReadBuffer() const {
+            return this->buffers[this->readIndex];
+        }
+        void CountUpload(uint64_t bytes) {
+            this->bytesUploaded.fetch_add(bytes, std::memory_order_relaxed);
+        }
+    public:
+        //throws std::runtime_error if a side is zero or larger than 65535 pixels
+        PixelBufferElement(uint32_t width, uint32_t height);
+
+        //copies one rectangle of pixels and publishes it as a new frame, safe to call from any thread
+        void updateRegion(const PixelRegion& region, const uint8_t* pixels, uint32_t stride);
+        //copies several rectangles and publishes them together as one frame
+        void updateRegions(const PixelRegionUpdate* updates, size_t count);
+
+        uint32_t getPixelWidth() const {
+            return this->pixelWidth;
+        }
+        uint32_t getPixelHeight() const {
+            return this->pixelHeight;
+        }
+
+        ImageFillMode getFillMode() {
+            return this->loadState<PixelBufferState>()->fillMode;
+        }
+        void setFillMode(ImageFillMode mode) {
+            this->updateState<PixelBufferState>(DIRTY_GEOMETRY, [mode](PixelBufferState& state) { state.fillMode = mode; });
+        }
+
+        PixelBufferStats getStats() const;
+    };
+}
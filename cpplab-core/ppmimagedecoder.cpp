@@ -0,0 +1,75 @@
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <filesystem>
+#include <stdexcept>
+#include "ppmimagedecoder.hpp"
+
+namespace cpplab {
+    namespace {
+        constexpr uint32_t MaxDimension = 1u << 15;
+
+        //skips whitespace and # comments between header fields
+        bool ReadHeaderValue(std::istream& in, uint32_t& value) {
+            int c = in.get();
+            while (c != EOF && (std::isspace(c) || c == '#')) {
+                if (c == '#') {
+                    while (c != EOF && c != '\n') c = in.get();
+                }
+                c = in.get();
+            }
+            if (c == EOF || !std::isdigit(c)) return false;
+            uint64_t result = 0;
+            while (c != EOF && std::isdigit(c)) {
+                result = result * 10 + (c - '0');
+                if (result > UINT32_MAX) return false;
+                c = in.get();
+            }
+            //exactly one whitespace character follows the last header value
+            value = static_cast<uint32_t>(result);
+            return c != EOF && std::isspace(c);
+        }
+    }
+
+    void PPMImageDecoder::Decode(const std::wstring& imageName, ImageType type, PixelBuffer& out) {
+        if (type != ImageType::FILE) {
+            throw std::runtime_error("[Cpplab Renderer] PPM decoder can only load files.");
+        }
+        std::ifstream in(std::filesystem::path(imageName), std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("[Cpplab Renderer] PPM decoder could not open " + std::filesystem::path(imageName).string());
+        }
+
+        char magic[2] = {};
+        uint32_t width = 0, height = 0, maxValue = 0;
+        in.read(magic, 2);
+        if (!in || magic[0] != 'P' || magic[1] != '6' ||
+            !ReadHeaderValue(in, width) || !ReadHeaderValue(in, height) || !ReadHeaderValue(in, maxValue) ||
+            width == 0 || height == 0 || width > MaxDimension || height > MaxDimension || maxValue == 0 || maxValue > 65535) {
+            throw std::runtime_error("[Cpplab Renderer] PPM decoder found an invalid header in " + std::filesystem::path(imageName).string());
+        }
+
+        const size_t bytesPerSample = maxValue < 256 ? 1 : 2;
+        std::vector<uint8_t> row(static_cast<size_t>(width) * 3 * bytesPerSample);
+        out.width = width;
+        out.height = height;
+        out.pixels.resize(static_cast<size_t>(width) * height * 4);
+        for (uint32_t y = 0; y < height; ++y) {
+            in.read(reinterpret_cast<char*>(row.data()), static_cast<std::streamsize>(row.size()));
+            if (!in) {
+                throw std::runtime_error("[Cpplab Renderer] PPM decoder hit the end of " + std::filesystem::path(imageName).string());
+            }
+            uint8_t* dst = &out.pixels[static_cast<size_t>(y) * width * 4];
+            for (uint32_t x = 0; x < width; ++x) {
+                for (int channel = 0; channel < 3; ++channel) {
+                    const size_t at = (static_cast<size_t>(x) * 3 + channel) * bytesPerSample;
+                    //samples are big endian when they take two bytes
+                    const uint32_t sample = bytesPerSample == 1 ? row[at] : (static_cast<uint32_t>(row[at]) << 8) | row[at + 1];
+                    dst[x * 4 + channel] = static_cast<uint8_t>((sample * 255 + maxValue / 2) / maxValue);
+                }
+                //ppm has no alpha, opaque pixels are already premultiplied
+                dst[x * 4 + 3] = 255;
+            }
+        }
+    }
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include "imagedecoder.hpp"
+
+namespace cpplab {
+    //decodes binary PPM (P6) files, the format SoftwareRenderDevice::SavePPM writes
+    //no platform dependencies, so the image cache and display list loading can run headless
+    class PPMImageDecoder : public ImageDecoder {
+    public:
+        void Decode(const std::wstring& imageName, ImageType type, PixelBuffer& out) override;
+    };
+}
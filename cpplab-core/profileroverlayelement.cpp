@@ -0,0 +1,65 @@
+#include <cstdio>
+#include "profileroverlayelement.hpp"
+
+namespace cpplab {
+    TextElementConfiguration ProfilerOverlayElement::DefaultConfiguration() {
+        TextElementConfiguration config;
+        config.SetDepth(1.0e6f).SetRelativePosition(vec2(8.f, 8.f)).SetDimension(vec2(300.f, 280.f)).SetHidden(false);
+        config.setTextColor(Color(1.f, 1.f, 1.f, 1.f))
+            .setBackgroundColor(Color(0.f, 0.f, 0.f, 0.7f))
+            .setTextMarginPx(6.f)
+            .setTextSize(9.f)
+            .setText(L"profiler waiting for frames");
+        return config;
+    }
+
+    ProfilerOverlayElement::ProfilerOverlayElement(FrameProfiler& profiler, const TextElementConfiguration& config, uint32_t refreshFrames) :
+    TextElement(config), profiler(profiler) {
+        this->refreshFrames = refreshFrames == 0 ? 1 : refreshFrames;
+    }
+
+    bool ProfilerOverlayElement::Refresh() {
+        //the report sorts the whole window, so only take it when the text is due
+        const uint64_t frames = this->profiler.FrameCount();
+        if (frames == 0) return false;
+        if (this->shown && frames - this->shownFrames < this->refreshFrames) return false;
+        this->shown = true;
+        this->shownFrames = frames;
+        this->setText(FormatReport(this->profiler.GetReport()));
+        return true;
+    }
+
+    static void AppendName(std::wstring& text, const char* name, size_t width) {
+        //names are ascii
+        size_t length = 0;
+        for (; name[length] != '\0'; ++length) {
+            text.push_back(static_cast<wchar_t>(name[length]));
+        }
+        for (; length < width; ++length) {
+            text.push_back(L' ');
+        }
+    }
+
+    std::wstring ProfilerOverlayElement::FormatReport(const FrameProfileReport& report) {
+        constexpr size_t NameWidth = 20;
+        wchar_t line[96];
+        std::wstring text;
+        std::swprintf(line, sizeof(line) / sizeof(line[0]), L"%llu frames, last %zu, ms\n", static_cast<unsigned long long>(report.frames), report.windowFrames);
+        text += line;
+        AppendName(text, "", NameWidth);
+        text += L"   p50    p95    p99\n";
+        for (size_t phase = 0; phase < ProfilePhaseCount; ++phase) {
+            const ProfilePercentiles& percentiles = report.phases[phase];
+            if (percentiles.max <= 0.f) continue;
+            AppendName(text, FrameProfiler::PhaseName(static_cast<ProfilePhase>(phase)), NameWidth);
+            std::swprintf(line, sizeof(line) / sizeof(line[0]), L"%6.2f %6.2f %6.2f\n", percentiles.p50 / 1000.f, percentiles.p95 / 1000.f, percentiles.p99 / 1000.f);
+            text += line;
+        }
+        for (size_t counter = 0; counter < ProfileCounterCount; ++counter) {
+            AppendName(text, FrameProfiler::CounterName(static_cast<ProfileCounter>(counter)), NameWidth);
+            std::swprintf(line, sizeof(line) / sizeof(line[0]), L"%llu\n", static_cast<unsigned long long>(report.lastCounters[counter]));
+            text += line;
+        }
+        return text;
+    }
+}
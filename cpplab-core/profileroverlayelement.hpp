@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "frameprofiler.hpp"
+#include "engineelements.hpp"
+
+namespace cpplab {
+    //a text element showing a frame profiler's percentiles and last frame's counters
+    //the text is written again every refreshFrames profiled frames, a frame with no profiled frames before it changes nothing, so an idle scene stays idle
+    //ui thread only, call Refresh once a frame before changes are collected, the engines do that for the overlay they show
+    class ProfilerOverlayElement : public TextElement {
+    private:
+        FrameProfiler& profiler;
+        uint32_t refreshFrames;
+        uint64_t shownFrames = 0;
+        bool shown = false;
+
+    public:
+        static constexpr uint32_t DefaultRefreshFrames = 30;
+        //top left, a dark translucent box drawn above the scene
+        static TextElementConfiguration DefaultConfiguration();
+
+        ProfilerOverlayElement(FrameProfiler& profiler, const TextElementConfiguration& config = DefaultConfiguration(), uint32_t refreshFrames = DefaultRefreshFrames);
+
+        //returns true if the text was written
+        bool Refresh();
+        //milliseconds, phases that took no time in the window are left out
+        static std::wstring FormatReport(const FrameProfileReport& report);
+    };
+}
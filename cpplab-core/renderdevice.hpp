@@ -0,0 +1,154 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+#include "engineelements.hpp"
+
+namespace cpplab {
+    //2d affine transform, same layout as a D2D1::Matrix3x2F
+    struct Transform2D {
+        float m11 = 1.f, m12 = 0.f;
+        float m21 = 0.f, m22 = 1.f;
+        float dx = 0.f, dy = 0.f;
+
+        static Transform2D Identity() {
+            return Transform2D();
+        }
+        static Transform2D Translation(float x, float y) {
+            Transform2D t;
+            t.dx = x;
+            t.dy = y;
+            return t;
+        }
+        static Transform2D Scale(float x, float y) {
+            Transform2D t;
+            t.m11 = x;
+            t.m22 = y;
+            return t;
+        }
+
+        //applies this transform first, then rhs
+        Transform2D operator*(const Transform2D& rhs) const {
+            Transform2D t;
+            t.m11 = this->m11 * rhs.m11 + this->m12 * rhs.m21;
+            t.m12 = this->m11 * rhs.m12 + this->m12 * rhs.m22;
+            t.m21 = this->m21 * rhs.m11 + this->m22 * rhs.m21;
+            t.m22 = this->m21 * rhs.m12 + this->m22 * rhs.m22;
+            t.dx = this->dx * rhs.m11 + this->dy * rhs.m21 + rhs.dx;
+            t.dy = this->dx * rhs.m12 + this->dy * rhs.m22 + rhs.dy;
+            return t;
+        }
+        vec2 Apply(vec2 p) const {
+            return vec2(p.x * this->m11 + p.y * this->m21 + this->dx, p.x * this->m12 + p.y * this->m22 + this->dy);
+        }
+        float Determinant() const {
+            return this->m11 * this->m22 - this->m12 * this->m21;
+        }
+        //returns identity for a singular transform
+        Transform2D Inverse() const {
+            const float det = this->Determinant();
+            if (det == 0.f) return Transform2D();
+            Transform2D t;
+            t.m11 = this->m22 / det;
+            t.m12 = -this->m12 / det;
+            t.m21 = -this->m21 / det;
+            t.m22 = this->m11 / det;
+            t.dx = -(this->dx * t.m11 + this->dy * t.m21);
+            t.dy = -(this->dx * t.m12 + this->dy * t.m22);
+            return t;
+        }
+        //axis aligned bounds of a transformed rect
+        RectF TransformBounds(const RectF& rect) const {
+            const vec2 corners[4] = {
+                this->Apply(vec2(rect.left, rect.top)), this->Apply(vec2(rect.right, rect.top)),
+                this->Apply(vec2(rect.left, rect.bottom)), this->Apply(vec2(rect.right, rect.bottom))
+            };
+            RectF bounds = RectF(corners[0].x, corners[0].y, corners[0].x, corners[0].y);
+            for (const vec2& c : corners) {
+                if (c.x < bounds.left) bounds.left = c.x;
+                if (c.y < bounds.top) bounds.top = c.y;
+                if (c.x > bounds.right) bounds.right = c.x;
+                if (c.y > bounds.bottom) bounds.bottom = c.y;
+            }
+            return bounds;
+        }
+    };
+
+    struct RoundedRectF {
+        RectF rect;
+        float radiusX = 0.f, radiusY = 0.f;
+        RoundedRectF() {};
+        RoundedRectF(const RectF& rect_, float radiusX_, float radiusY_) : rect{ rect_ }, radiusX{ radiusX_ }, radiusY{ radiusY_ } {};
+    };
+
+    //8 bit premultiplied RGBA, rows are tightly packed
+    struct PixelBuffer {
+        uint32_t width = 0, height = 0;
+        std::vector<uint8_t> pixels;
+    };
+
+    //rectangle of whole pixels inside a bitmap
+    struct PixelRegion {
+        uint32_t x = 0, y = 0, width = 0, height = 0;
+
+        bool IsEmpty() const {
+            return this->width == 0 || this->height == 0;
+        }
+    };
+
+    struct TextFormatDesc {
+        FontStyle fontStyle = FontStyle::Arial;
+        float size = 12.f;
+        HAlign hAlign = HAlign::LEFT;
+        VAlign vAlign = VAlign::TOP;
+    };
+
+    //resources are created by a device and only valid on that device, delete them to release
+    class RenderBitmap {
+    public:
+        virtual ~RenderBitmap() = default;
+        virtual vec2 GetSize() const = 0;
+    };
+    class RenderTextFormat {
+    public:
+        virtual ~RenderTextFormat() = default;
+    };
+
+    //everything the element draw path needs from a backend
+    //coordinates are in device independent units and go through the current transform
+    class RenderDevice {
+    public:
+        virtual ~RenderDevice() = default;
+
+        virtual void BeginFrame() = 0;
+        //returns false if the target was lost, resources created before have to be rebuilt
+        virtual bool EndFrame() = 0;
+        virtual vec2 GetSize() const = 0;
+
+        virtual void Clear(const Color& color) = 0;
+        virtual void SetTransform(const Transform2D& transform) = 0;
+        virtual Transform2D GetTransform() const = 0;
+
+        //clips are axis aligned in the current transform and nest
+        virtual void PushClip(const RectF& rect) = 0;
+        virtual void PopClip() = 0;
+
+        virtual void FillRoundedRect(const RoundedRectF& rect, const Color& color) = 0;
+        virtual void StrokeRoundedRect(const RoundedRectF& rect, const Color& color, float strokeWidth) = 0;
+
+        virtual RenderBitmap* CreateBitmap(const PixelBuffer& pixels) = 0;
+        //for pixels that are already shared, like the image cache's, devices that keep them around can skip the copy
+        virtual RenderBitmap* CreateSharedBitmap(const std::shared_ptr<const PixelBuffer>& pixels) {
+            return this->CreateBitmap(*pixels);
+        }
+        //overwrites part of a bitmap, pixels points at the region's top left pixel and rows are stride bytes apart
+        virtual void UpdateBitmap(RenderBitmap* bitmap, const PixelRegion& region, const uint8_t* pixels, uint32_t stride) = 0;
+        virtual void DrawBitmap(RenderBitmap* bitmap, const RectF& destination, float opacity) = 0;
+
+        virtual RenderTextFormat* CreateTextFormat(const TextFormatDesc& desc) = 0;
+        //lays the text out inside the box, wrapping at word boundaries
+        virtual void DrawString(const std::wstring& text, RenderTextFormat* format, const RectF& layoutBox, const Color& color) = 0;
+    };
+}
@@ -0,0 +1,445 @@
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include "scenefile.hpp"
+#include "pixelbufferelement.hpp"
+
+namespace cpplab {
+    namespace {
+        constexpr char Magic[8] = { 'C', 'P', 'L', 'S', 'C', 'E', 'N', 'E' };
+        constexpr uint32_t ByteOrderMark = 0x01020304u;
+        constexpr uint64_t SectionAlignment = 8;
+        //the format is these layouts, a change to any of them needs a new FormatVersion
+        static_assert(sizeof(SceneFileHeader) == 120 && sizeof(SceneNodeRecord) == 48 && sizeof(SceneString) == 8);
+        static_assert(sizeof(SceneTextRecord) == 76 && sizeof(SceneImageRecord) == 36 && sizeof(SceneBufferRecord) == 12);
+
+        std::runtime_error LoadError(const std::string& message) {
+            return std::runtime_error("[Cpplab Elements] During Scene Load: " + message);
+        }
+        template <class Enum>
+        Enum CheckedEnum(uint32_t value, Enum last, const char* what) {
+            if (value > static_cast<uint32_t>(last)) {
+                throw LoadError(std::string("The file holds an unknown ") + what + " " + std::to_string(value) + ".");
+            }
+            return static_cast<Enum>(value);
+        }
+
+        //wchar_t is utf-16 on windows and utf-32 elsewhere, the file always holds utf-16
+        void AppendUtf16(std::u16string& out, const std::wstring& text) {
+            for (const wchar_t c : text) {
+                const uint32_t codePoint = static_cast<uint32_t>(c);
+                if (sizeof(wchar_t) > 2 && codePoint > 0xffffu) {
+                    out.push_back(static_cast<char16_t>(0xd800u + ((codePoint - 0x10000u) >> 10)));
+                    out.push_back(static_cast<char16_t>(0xdc00u + ((codePoint - 0x10000u) & 0x3ffu)));
+                }
+                else out.push_back(static_cast<char16_t>(codePoint));
+            }
+        }
+        void AssignUtf16(std::wstring& out, const char16_t* text, size_t length) {
+            if constexpr (sizeof(wchar_t) == 2) {
+                out.assign(reinterpret_cast<const wchar_t*>(text), length);
+                return;
+            }
+            out.clear();
+            for (size_t i = 0; i < length; ++i) {
+                const uint32_t unit = text[i];
+                if (unit >= 0xd800u && unit < 0xdc00u && i + 1 < length && text[i + 1] >= 0xdc00u && text[i + 1] < 0xe000u) {
+                    out.push_back(static_cast<wchar_t>(0x10000u + ((unit - 0xd800u) << 10) + (text[i + 1] - 0xdc00u)));
+                    ++i;
+                }
+                else out.push_back(static_cast<wchar_t>(unit));
+            }
+        }
+
+        SceneColor ToSceneColor(const Color& color) {
+            return SceneColor{ color.r, color.g, color.b, color.a };
+        }
+        Color FromSceneColor(const SceneColor& color) {
+            return Color(color.r, color.g, color.b, color.a);
+        }
+
+        //appends a section at the next aligned offset and returns that offset
+        uint64_t AppendSection(std::vector<uint8_t>& file, const void* data, size_t bytes) {
+            file.resize((file.size() + SectionAlignment - 1) / SectionAlignment * SectionAlignment);
+            const uint64_t offset = file.size();
+            file.resize(file.size() + bytes);
+            if (bytes > 0) std::memcpy(file.data() + offset, data, bytes);
+            return offset;
+        }
+    }
+
+    SceneFile::SceneFile(const std::filesystem::path& path) {
+#ifdef _WIN32
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) throw LoadError("Could not open " + path.string() + ".");
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || static_cast<uint64_t>(fileSize.QuadPart) < sizeof(SceneFileHeader)) {
+            CloseHandle(file);
+            throw LoadError(path.string() + " is no scene file.");
+        }
+        //the view keeps the mapping and the file open, both handles can go right away
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (mapping == nullptr) throw LoadError("Could not map " + path.string() + ".");
+        const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        if (view == nullptr) throw LoadError("Could not map " + path.string() + ".");
+        this->data = static_cast<const uint8_t*>(view);
+        this->size = static_cast<size_t>(fileSize.QuadPart);
+#else
+        const int file = open(path.c_str(), O_RDONLY);
+        if (file < 0) throw LoadError("Could not open " + path.string() + ".");
+        struct stat status;
+        if (fstat(file, &status) != 0 || static_cast<uint64_t>(status.st_size) < sizeof(SceneFileHeader)) {
+            close(file);
+            throw LoadError(path.string() + " is no scene file.");
+        }
+        void* view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+        close(file);
+        if (view == MAP_FAILED) throw LoadError("Could not map " + path.string() + ".");
+        //nodes are read once front to back
+        madvise(view, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+        this->data = static_cast<const uint8_t*>(view);
+        this->size = static_cast<size_t>(status.st_size);
+#endif
+
+        this->header = reinterpret_cast<const SceneFileHeader*>(this->data);
+        const SceneFileHeader& header = *this->header;
+        const auto checkSection = [this](uint64_t offset, uint64_t count, uint64_t recordSize) {
+            return offset % SectionAlignment == 0 && offset <= this->size && count <= (this->size - offset) / recordSize;
+        };
+        std::string problem;
+        if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0) problem = " is no scene file.";
+        else if (header.byteOrder != ByteOrderMark) problem = " was written on a machine of the other byte order.";
+        else if (header.version != FormatVersion) problem = " is of format version " + std::to_string(header.version) + ", only version " + std::to_string(FormatVersion) + " is supported.";
+        else if (header.fileSize != this->size) problem = " is truncated.";
+        else if (!checkSection(header.nodesOffset, header.nodeCount, sizeof(SceneNodeRecord)) ||
+            !checkSection(header.idsOffset, header.idCount, sizeof(SceneString)) ||
+            !checkSection(header.textsOffset, header.textCount, sizeof(SceneTextRecord)) ||
+            !checkSection(header.imagesOffset, header.imageCount, sizeof(SceneImageRecord)) ||
+            !checkSection(header.buffersOffset, header.bufferCount, sizeof(SceneBufferRecord)) ||
+            !checkSection(header.namesOffset, header.namesSize, 1) ||
+            !checkSection(header.charsOffset, header.charsSize, sizeof(char16_t))) {
+            problem = " has a section outside the file.";
+        }
+        if (!problem.empty()) {
+            this->Unmap();
+            throw LoadError(path.string() + problem);
+        }
+    }
+    SceneFile::~SceneFile() {
+        this->Unmap();
+    }
+    void SceneFile::Unmap() {
+        if (this->data == nullptr) return;
+#ifdef _WIN32
+        UnmapViewOfFile(this->data);
+#else
+        munmap(const_cast<uint8_t*>(this->data), this->size);
+#endif
+        this->data = nullptr;
+        this->header = nullptr;
+    }
+
+    void SceneFile::CheckString(const SceneString& string, uint64_t sectionSize, const char* what) const {
+        if (static_cast<uint64_t>(string.offset) + string.length <= sectionSize) return;
+        throw LoadError(std::string("The file holds ") + what + " outside its section.");
+    }
+
+    void SceneFile::Instantiate(ElementTreeBuilder& builder, uint32_t parent) {
+        if (parent != ElementTreeBuilder::Target && parent >= builder.Size()) {
+            throw LoadError("Attempted to instantiate under entry " + std::to_string(parent) + ", but the builder only holds " + std::to_string(builder.Size()) + " entries.");
+        }
+        const SceneFileHeader& header = *this->header;
+        const SceneNodeRecord* nodes = this->Section<SceneNodeRecord>(header.nodesOffset);
+        const SceneString* idRecords = this->Section<SceneString>(header.idsOffset);
+        const SceneTextRecord* texts = this->Section<SceneTextRecord>(header.textsOffset);
+        const SceneImageRecord* images = this->Section<SceneImageRecord>(header.imagesOffset);
+        const SceneBufferRecord* buffers = this->Section<SceneBufferRecord>(header.buffersOffset);
+        const char* names = this->Section<char>(header.namesOffset);
+        const char16_t* chars = this->Section<char16_t>(header.charsOffset);
+
+        //each id is interned once, however many nodes use it
+        std::vector<ElementId> ids(header.idCount);
+        ElementIdTable& idTable = ElementIdTable::Instance();
+        for (uint32_t i = 0; i < header.idCount; ++i) {
+            this->CheckString(idRecords[i], header.namesSize, "an id");
+            ids[i] = idTable.Intern(std::string_view(names + idRecords[i].offset, idRecords[i].length));
+        }
+
+        const uint32_t first = static_cast<uint32_t>(builder.Size());
+        builder.Reserve(static_cast<size_t>(first) + header.nodeCount);
+        //one configuration per type, overwritten for every node so the strings in them keep their buffers
+        TextElementConfiguration textConfig;
+        ImageElementConfiguration imageConfig;
+        ElementNodeConfiguration baseConfig;
+        try {
+            for (uint32_t i = 0; i < header.nodeCount; ++i) {
+                const SceneNodeRecord& node = nodes[i];
+                if (node.parent != NoParent && node.parent >= i) {
+                    throw LoadError("Node " + std::to_string(i) + " names a parent that does not come before it.");
+                }
+                if (node.id >= header.idCount) {
+                    throw LoadError("Node " + std::to_string(i) + " names an id outside the id table.");
+                }
+                const NodeType type = CheckedEnum(node.type, NodeType::PIXEL_BUFFER, "node type");
+                const auto setGeometry = [&node](ElementNodeConfiguration& config) {
+                    config.depth = node.depth;
+                    config.relativePos = vec2(node.posX, node.posY);
+                    config.dimensions = vec2(node.width, node.height);
+                    config.hidden = (node.flags & SCENE_NODE_HIDDEN) != 0;
+                };
+                const auto checkRecord = [&node, i](uint32_t count) {
+                    if (node.record < count) return;
+                    throw LoadError("Node " + std::to_string(i) + " names a record outside its table.");
+                };
+
+                ElementNode* element = nullptr;
+                ImageFillMode bufferFill = ImageFillMode::CONTAIN;
+                switch (type) {
+                case NodeType::BASE_ELEMENT: {
+                    setGeometry(baseConfig);
+                    element = new ElementNode(baseConfig);
+                    break;
+                }
+                case NodeType::TEXT_AREA: {
+                    checkRecord(header.textCount);
+                    const SceneTextRecord& text = texts[node.record];
+                    this->CheckString(text.text, header.charsSize, "a text");
+                    setGeometry(textConfig);
+                    textConfig.textColor = FromSceneColor(text.textColor);
+                    textConfig.backgroundColor = FromSceneColor(text.backgroundColor);
+                    textConfig.borderColor = FromSceneColor(text.borderColor);
+                    textConfig.borderWidthPx = text.borderWidthPx;
+                    textConfig.roundedEdgePx = text.roundedEdgePx;
+                    textConfig.textMarginPx = text.textMarginPx;
+                    textConfig.textPtSize = text.textPointSize;
+                    textConfig.fontStyle = CheckedEnum(text.fontStyle, FontStyle::Calibri, "font style");
+                    textConfig.textHorizontalAlignment = CheckedEnum(text.hAlign, HAlign::JUSTIFY, "horizontal alignment");
+                    textConfig.textVerticalAlignment = CheckedEnum(text.vAlign, VAlign::BOTTOM, "vertical alignment");
+                    AssignUtf16(textConfig.startingText, chars + text.text.offset, text.text.length);
+                    element = new TextElement(textConfig);
+                    break;
+                }
+                case NodeType::IMAGE: {
+                    checkRecord(header.imageCount);
+                    const SceneImageRecord& image = images[node.record];
+                    this->CheckString(image.imageName, header.charsSize, "an image name");
+                    setGeometry(imageConfig);
+                    imageConfig.borderColor = FromSceneColor(image.borderColor);
+                    imageConfig.borderWidthPx = image.borderWidthPx;
+                    imageConfig.roundedEdgePx = image.roundedEdgePx;
+                    imageConfig.fillMode = CheckedEnum(image.fillMode, ImageFillMode::CONTAIN, "fill mode");
+                    imageConfig.borderMode = CheckedEnum(image.borderMode, BorderWrapMode::FIT_TO_BOUNDING_BOX, "border wrap mode");
+                    imageConfig.imgType = CheckedEnum(image.imageType, ImageType::RESOURCE, "image type");
+                    AssignUtf16(imageConfig.imageName, chars + image.imageName.offset, image.imageName.length);
+                    element = new ImageElement(imageConfig);
+                    break;
+                }
+                case NodeType::PIXEL_BUFFER: {
+                    checkRecord(header.bufferCount);
+                    const SceneBufferRecord& buffer = buffers[node.record];
+                    bufferFill = CheckedEnum(buffer.fillMode, ImageFillMode::CONTAIN, "fill mode");
+                    element = new PixelBufferElement(buffer.pixelWidth, buffer.pixelHeight);
+                    break;
+                }
+                }
+                builder.Add(node.parent == NoParent ? parent : first + node.parent, ids[node.id], element);
+
+                //pixel buffers take no configuration, they get their geometry the same way the rest get their opacity
+                if (type == NodeType::PIXEL_BUFFER) {
+                    element->updateState<PixelBufferState>(DIRTY_GEOMETRY | DIRTY_VISIBILITY | DIRTY_PAINT, [&node, bufferFill](PixelBufferState& state) {
+                        state.depth = node.depth;
+                        state.posX = node.posX;
+                        state.posY = node.posY;
+                        state.width = node.width;
+                        state.height = node.height;
+                        state.hidden = (node.flags & SCENE_NODE_HIDDEN) != 0;
+                        state.clipChildren = (node.flags & SCENE_NODE_CLIP_CHILDREN) != 0;
+                        state.opacity = node.opacity;
+                        state.fillMode = bufferFill;
+                    });
+                }
+                else if (node.opacity != 1.f || (node.flags & SCENE_NODE_CLIP_CHILDREN) != 0) {
+                    const float opacity = node.opacity;
+                    const bool clipChildren = (node.flags & SCENE_NODE_CLIP_CHILDREN) != 0;
+                    element->updateState<ElementState>(DIRTY_PAINT | DIRTY_VISIBILITY, [opacity, clipChildren](ElementState& state) {
+                        state.opacity = opacity;
+                        state.clipChildren = clipChildren;
+                    });
+                }
+            }
+        }
+        catch (...) {
+            //nothing is attached yet, the elements are only linked to each other through the builder
+            for (uint32_t entry = first; entry < builder.Size(); ++entry) {
+                delete builder.GetElement(entry);
+            }
+            builder.Truncate(first);
+            throw;
+        }
+    }
+
+    void SceneFile::InstantiateInto(ElementNode* target) {
+        ElementTreeBuilder builder;
+        this->Instantiate(builder, ElementTreeBuilder::Target);
+        try {
+            builder.AttachTo(target);
+        }
+        catch (...) {
+            for (uint32_t entry = 0; entry < builder.Size(); ++entry) {
+                delete builder.GetElement(entry);
+            }
+            throw;
+        }
+    }
+
+    void SceneFile::Save(ElementNode* root, const std::filesystem::path& path) {
+        if (root == nullptr) {
+            throw std::runtime_error("[Cpplab Elements] During Scene Save: A root element is required!");
+        }
+        ElementStore& store = ElementStore::Instance();
+        const uint32_t rootIndex = root->getHandle().index;
+
+        //the shape of the tree under one lock, the states are read after it
+        std::vector<uint32_t> order;
+        std::vector<uint32_t> parents;
+        store.VisitStagedSubtree(rootIndex, [rootIndex, &order, &parents](uint32_t index, uint32_t parent) {
+            if (index == rootIndex) return;
+            order.push_back(index);
+            parents.push_back(parent);
+        });
+
+        std::vector<SceneNodeRecord> nodes;
+        std::vector<SceneString> ids;
+        std::vector<SceneTextRecord> texts;
+        std::vector<SceneImageRecord> images;
+        std::vector<SceneBufferRecord> buffers;
+        std::string names;
+        std::u16string chars;
+        //store index to node record, id atom to id record
+        std::unordered_map<uint32_t, uint32_t> recordOf;
+        std::unordered_map<uint32_t, uint32_t> idOf;
+        nodes.reserve(order.size());
+        recordOf.reserve(order.size());
+        const auto addChars = [&chars](const std::wstring& text) {
+            const size_t offset = chars.size();
+            AppendUtf16(chars, text);
+            return SceneString{ static_cast<uint32_t>(offset), static_cast<uint32_t>(chars.size() - offset) };
+        };
+
+        for (size_t i = 0; i < order.size(); ++i) {
+            const uint32_t index = order[i];
+            const std::shared_ptr<const ElementState> state = store.StagedState(index).Load();
+            SceneNodeRecord node = {};
+            node.parent = parents[i] == rootIndex ? NoParent : recordOf.at(parents[i]);
+            const ElementId id{ store.IdAtom(index) };
+            auto [idRecord, added] = idOf.try_emplace(id.atom, static_cast<uint32_t>(ids.size()));
+            if (added) {
+                const std::string& name = ElementIdTable::Instance().Name(id);
+                ids.push_back(SceneString{ static_cast<uint32_t>(names.size()), static_cast<uint32_t>(name.size()) });
+                names += name;
+            }
+            node.id = idRecord->second;
+            node.type = static_cast<uint32_t>(store.Type(index));
+            node.depth = state->depth;
+            node.posX = state->posX;
+            node.posY = state->posY;
+            node.width = state->width;
+            node.height = state->height;
+            node.opacity = state->opacity;
+            node.flags = (state->hidden ? SCENE_NODE_HIDDEN : 0u) | (state->clipChildren ? SCENE_NODE_CLIP_CHILDREN : 0u);
+
+            switch (store.Type(index)) {
+            case NodeType::BASE_ELEMENT:
+                break;
+            case NodeType::TEXT_AREA: {
+                const TextElementState& text = static_cast<const TextElementState&>(*state);
+                SceneTextRecord record = {};
+                record.textColor = ToSceneColor(text.textColor);
+                record.backgroundColor = ToSceneColor(text.backgroundColor);
+                record.borderColor = ToSceneColor(text.borderColor);
+                record.borderWidthPx = text.borderWidthPx;
+                record.roundedEdgePx = text.roundedEdgePx;
+                record.textMarginPx = text.textMarginPx;
+                record.textPointSize = text.textPointSize;
+                record.fontStyle = static_cast<uint8_t>(text.fontStyle);
+                record.hAlign = static_cast<uint8_t>(text.textHAlign);
+                record.vAlign = static_cast<uint8_t>(text.textVAlign);
+                record.text = text.text ? addChars(*text.text) : SceneString{ 0, 0 };
+                node.record = static_cast<uint32_t>(texts.size());
+                texts.push_back(record);
+                break;
+            }
+            case NodeType::IMAGE: {
+                const ImageElementState& image = static_cast<const ImageElementState&>(*state);
+                SceneImageRecord record = {};
+                record.borderColor = ToSceneColor(image.borderColor);
+                record.borderWidthPx = image.borderWidthPx;
+                record.roundedEdgePx = image.roundedEdgePx;
+                record.fillMode = static_cast<uint8_t>(image.fillMode);
+                record.borderMode = static_cast<uint8_t>(image.borderMode);
+                record.imageType = static_cast<uint8_t>(image.imgType);
+                record.imageName = addChars(image.imageName);
+                node.record = static_cast<uint32_t>(images.size());
+                images.push_back(record);
+                break;
+            }
+            case NodeType::PIXEL_BUFFER: {
+                const PixelBufferElement* element = static_cast<const PixelBufferElement*>(store.Owner(index));
+                SceneBufferRecord record = {};
+                record.pixelWidth = element->getPixelWidth();
+                record.pixelHeight = element->getPixelHeight();
+                record.fillMode = static_cast<uint8_t>(static_cast<const PixelBufferState&>(*state).fillMode);
+                node.record = static_cast<uint32_t>(buffers.size());
+                buffers.push_back(record);
+                break;
+            }
+            }
+            recordOf.emplace(index, static_cast<uint32_t>(nodes.size()));
+            nodes.push_back(node);
+        }
+        if (names.size() > UINT32_MAX || chars.size() > UINT32_MAX) {
+            throw std::runtime_error("[Cpplab Elements] During Scene Save: The ids or texts of the tree are too large for the format!");
+        }
+
+        SceneFileHeader header = {};
+        std::memcpy(header.magic, Magic, sizeof(Magic));
+        header.version = FormatVersion;
+        header.byteOrder = ByteOrderMark;
+        header.nodeCount = static_cast<uint32_t>(nodes.size());
+        header.idCount = static_cast<uint32_t>(ids.size());
+        header.textCount = static_cast<uint32_t>(texts.size());
+        header.imageCount = static_cast<uint32_t>(images.size());
+        header.bufferCount = static_cast<uint32_t>(buffers.size());
+        std::vector<uint8_t> file(sizeof(SceneFileHeader));
+        header.nodesOffset = AppendSection(file, nodes.data(), nodes.size() * sizeof(SceneNodeRecord));
+        header.idsOffset = AppendSection(file, ids.data(), ids.size() * sizeof(SceneString));
+        header.textsOffset = AppendSection(file, texts.data(), texts.size() * sizeof(SceneTextRecord));
+        header.imagesOffset = AppendSection(file, images.data(), images.size() * sizeof(SceneImageRecord));
+        header.buffersOffset = AppendSection(file, buffers.data(), buffers.size() * sizeof(SceneBufferRecord));
+        header.namesOffset = AppendSection(file, names.data(), names.size());
+        header.namesSize = names.size();
+        header.charsOffset = AppendSection(file, chars.data(), chars.size() * sizeof(char16_t));
+        header.charsSize = chars.size();
+        header.fileSize = file.size();
+        std::memcpy(file.data(), &header, sizeof(header));
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+        if (!out) {
+            throw std::runtime_error("[Cpplab Elements] During Scene Save: Could not write " + path.string() + "!");
+        }
+    }
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include "engineelements.hpp"
+#include "elementtreebuilder.hpp"
+
+namespace cpplab {
+    //on disk layout of a scene file, little endian, every section starts 8 byte aligned
+    //records are read in place from the mapped file, so their layout is the format, change FormatVersion with them
+    struct SceneFileHeader {
+        char magic[8];
+        uint32_t version;
+        //0x01020304 as written, a file from a machine of the other byte order reads it reversed
+        uint32_t byteOrder;
+        uint32_t nodeCount;
+        uint32_t idCount;
+        uint32_t textCount;
+        uint32_t imageCount;
+        uint32_t bufferCount;
+        uint32_t reserved;
+        uint64_t nodesOffset;
+        uint64_t idsOffset;
+        uint64_t textsOffset;
+        uint64_t imagesOffset;
+        uint64_t buffersOffset;
+        //utf-8 id names
+        uint64_t namesOffset;
+        uint64_t namesSize;
+        //utf-16 text and image names, in code units
+        uint64_t charsOffset;
+        uint64_t charsSize;
+        uint64_t fileSize;
+    };
+
+    struct SceneColor {
+        float r, g, b, a;
+    };
+    //a range of the names or chars section
+    struct SceneString {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    enum SceneNodeFlags : uint32_t {
+        SCENE_NODE_HIDDEN = 1u << 0,
+        SCENE_NODE_CLIP_CHILDREN = 1u << 1
+    };
+    //nodes are stored parents first, parent is the index of an earlier node or SceneFile::NoParent for nodes of the top level
+    struct SceneNodeRecord {
+        uint32_t parent;
+        //index into the id table
+        uint32_t id;
+        //NodeType
+        uint32_t type;
+        //index into the table of the type, unused for base elements
+        uint32_t record;
+        float depth;
+        float posX, posY;
+        float width, height;
+        float opacity;
+        uint32_t flags;
+        uint32_t reserved;
+    };
+    struct SceneTextRecord {
+        SceneColor textColor, backgroundColor, borderColor;
+        float borderWidthPx, roundedEdgePx, textMarginPx, textPointSize;
+        uint8_t fontStyle, hAlign, vAlign, reserved;
+        SceneString text;
+    };
+    struct SceneImageRecord {
+        SceneColor borderColor;
+        float borderWidthPx, roundedEdgePx;
+        uint8_t fillMode, borderMode, imageType, reserved;
+        SceneString imageName;
+    };
+    //only the size and fill mode, pixel content is fed at run time
+    struct SceneBufferRecord {
+        uint32_t pixelWidth, pixelHeight;
+        uint8_t fillMode, reserved[3];
+    };
+
+    //a compact binary element tree, mapped read only and instantiated in one pass over fixed size records
+    //ids are stored once each and interned once per load, nodes refer to them by index
+    //elements are saved by their NodeType, subclasses come back as the element class of their type
+    //header and section bounds are checked when the file is opened, each record is checked as it is instantiated
+    class SceneFile {
+    public:
+        static constexpr uint32_t FormatVersion = 1;
+        static constexpr uint32_t NoParent = 0xffffffffu;
+
+    private:
+        //the mapped file, released by the destructor
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        const SceneFileHeader* header = nullptr;
+
+        template <class Record>
+        const Record* Section(uint64_t offset) const {
+            return reinterpret_cast<const Record*>(this->data + offset);
+        }
+        //throws if the range lies outside its section
+        void CheckString(const SceneString& string, uint64_t sectionSize, const char* what) const;
+        void Unmap();
+
+    public:
+        //maps the file and checks the header, throws std::runtime_error if it can not be opened or is no scene file of this version
+        SceneFile(const std::filesystem::path& path);
+        SceneFile(const SceneFile&) = delete;
+        SceneFile& operator=(const SceneFile&) = delete;
+        ~SceneFile();
+
+        size_t NodeCount() const {
+            return this->header->nodeCount;
+        }
+        //creates every node of the file and adds the nodes of the top level under parent, an entry of builder or ElementTreeBuilder::Target
+        //the elements belong to the tree once the builder attaches them, on a throw the elements created so far are deleted
+        void Instantiate(ElementTreeBuilder& builder, uint32_t parent);
+        //instantiates the file and attaches it under target in one step
+        void InstantiateInto(ElementNode* target);
+
+        //writes the subtree below root to path, root itself is not saved, it is where the file is loaded into
+        //save from the thread that edits the tree, pixel buffer content and click listeners are not saved
+        static void Save(ElementNode* root, const std::filesystem::path& path);
+    };
+}
@@ -0,0 +1,317 @@
+#include "scenerenderer.hpp"
+
+namespace cpplab {
+    SceneRenderer::SceneRenderer(ElementNode* rootNode, RenderDevice* device, ImageCache* imageCache, unsigned int dpi) {
+        this->rootElementNode = rootNode;
+        this->device = device;
+        this->imageCache = imageCache;
+        this->dpi = dpi;
+        this->changeJournal = ElementStore::Instance().RegisterBoundsJournal(rootNode->handle.index);
+    }
+    SceneRenderer::~SceneRenderer() {
+        ElementStore::Instance().UnregisterBoundsJournal(this->changeJournal);
+        for (NodeRenderData* data : this->renderDataBySlot) {
+            delete data;
+        }
+    }
+
+    bool SceneRenderer::CheckNodeModification() {
+        ProfileScope scope(this->profiler, ProfilePhase::DIRTY_CHECK);
+        if (this->rootElementNode->CheckSubtreeModification()) return true;
+        return !this->pendingImages.empty() && this->imageCache->CompletionVersion() != this->seenImageCompletions;
+    }
+    void SceneRenderer::CollectFinishedImages() {
+        if (this->pendingImages.empty()) return;
+        const uint64_t completions = this->imageCache->CompletionVersion();
+        if (completions == this->seenImageCompletions) return;
+        this->seenImageCompletions = completions;
+
+        //mark every waiting element, the ones still decoding go back on the list when they request again
+        ElementStore& store = ElementStore::Instance();
+        for (const ElementHandle& handle : this->pendingImages) {
+            if (handle.index >= this->renderDataBySlot.size()) continue;
+            NodeRenderData* data = this->renderDataBySlot[handle.index];
+            if (data == nullptr || data->handle != handle) continue;
+            store.MarkModified(handle.index, DIRTY_IMAGE_SOURCE);
+        }
+        this->pendingImages.clear();
+    }
+
+    void SceneRenderer::BuildNodeList() {
+        ProfileScope scope(this->profiler, ProfilePhase::BUILD_NODE_LIST);
+        ElementStore& store = ElementStore::Instance();
+        const uint32_t rootIndex = this->rootElementNode->handle.index;
+
+        //remove elements from the draw order if they left the tree or their slot got reused
+        for (const DrawOrderList::Entry& entry : this->depthSortedNodes.Entries()) {
+            NodeRenderData* data = this->renderDataBySlot[entry.id];
+            if (store.IsInTree(entry.id, rootIndex) && store.PublishedGeneration(entry.id) == data->handle.generation) continue;
+
+            this->depthSortedNodes.Remove(entry.id);
+            this->damage.ForgetElement(entry.id);
+            this->displayList.RemoveElement(entry.id);
+            delete data;
+            this->renderDataBySlot[entry.id] = nullptr;
+        }
+        this->depthSortedNodes.Commit();
+
+        //a linear scan of the published slots gives every node in this tree, add the ones not seen yet
+        //the store only allows one parent per node so double loads can no longer happen
+        store.CollectTreeIndices(rootIndex, this->treeIndexScratch);
+        if (this->renderDataBySlot.size() < store.Capacity()) {
+            this->renderDataBySlot.resize(store.Capacity(), nullptr);
+        }
+        for (uint32_t index : this->treeIndexScratch) {
+            if (this->renderDataBySlot[index] != nullptr) continue;
+
+            NodeRenderData* data = new NodeRenderData();
+            data->elementNode = store.PublishedOwner(index);
+            data->handle = ElementHandle{ index, store.PublishedGeneration(index) };
+            this->renderDataBySlot[index] = data;
+
+            //batched, the whole set is sorted and merged in once on commit
+            this->depthSortedNodes.Insert(index, store.Depth(index));
+        }
+        this->depthSortedNodes.Commit();
+    }
+    void SceneRenderer::RefreshNodeDepths() {
+        //setDepth only stages a new block, pick up published depths and resort just those entries
+        ElementStore& store = ElementStore::Instance();
+        const std::vector<DrawOrderList::Entry>& entries = this->depthSortedNodes.Entries();
+        for (size_t position = 0; position < entries.size(); ++position) {
+            this->depthSortedNodes.SetDepthAt(position, store.Depth(entries[position].id));
+        }
+        this->depthSortedNodes.Commit();
+    }
+
+    void SceneRenderer::CollectDamage() {
+        ProfileScope scope(this->profiler, ProfilePhase::COLLECT_DAMAGE);
+        //draw back to front?
+        //create depth sorted element array (find a way to presort)
+        //everything below reads the published side, changes made on other threads from here on wait for the next frame
+        this->CollectFinishedImages();
+        const bool published = this->rootElementNode->PublishSubtree();
+        //the store bumps its structure version whenever a publish moved slots in or out of a tree so rebuild only then
+        ElementStore& store = ElementStore::Instance();
+        const uint64_t structureVersion = store.StructureVersion();
+        const bool structureChanged = structureVersion != this->builtStructureVersion;
+        if (structureChanged) {
+            this->BuildNodeList();
+            this->builtStructureVersion = structureVersion;
+        }
+        if (!structureChanged && !published && !this->rescanPending) return;
+
+        //moved ancestors change world bounds without marking their children, the journal lists the whole moved subtree
+        //a new or removed node has no journal entry in this tree, so a structure change measures everything
+        const bool journaled = store.DrainBoundsJournal(this->changeJournal, this->changedScratch);
+        if (structureChanged || !journaled || this->rescanPending) {
+            this->rescanPending = false;
+            this->RefreshNodeDepths();
+            for (const DrawOrderList::Entry& entry : this->depthSortedNodes.Entries()) {
+                this->CheckElement(entry.id);
+            }
+            return;
+        }
+        for (uint32_t index : this->changedScratch) {
+            if (!this->depthSortedNodes.Contains(index)) continue;
+            //setDepth only stages a new block, resort just the elements whose depth was published
+            if (this->CheckElement(index) & DIRTY_DEPTH) this->depthSortedNodes.SetDepth(index, store.Depth(index));
+        }
+        this->depthSortedNodes.Commit();
+    }
+    uint32_t SceneRenderer::CheckElement(uint32_t index) {
+        ElementStore& store = ElementStore::Instance();
+        NodeRenderData* data = this->renderDataBySlot[index];
+        //color, geometry and visibility changes only need new commands, the dirty mask says which resources to rebuild
+        const uint32_t dirty = store.TakePublishedDirty(index);
+        data->staleResources |= dirty & ResourceDirtyFlags;
+        ++this->elementsCheckedSinceFrame;
+
+        //a hidden element tracks no bounds, so it damages where it was and is culled from then on
+        //its resources wait until it is shown again, showing it journals it like any other change
+        RectF bounds;
+        if (!store.WorldHidden(index)) {
+            //a new bitmap can change how far an image spills outside its box, so load it before measuring
+            if (data->staleResources != DIRTY_NONE) this->PrepareElementResources(data);
+            bounds = this->GetElementVisualBounds(data);
+        }
+        //the clip is pushed around the replay, so the commands stay the same when only the clip changed
+        data->clipped = GetPublishedClip(index, data->clip);
+        if (data->clipped) bounds = bounds.Intersection(data->clip);
+        if (bounds.IsEmpty()) bounds = RectF();
+
+        //commands hold world positions, so a moved element is recorded again too
+        //new pixels alone keep the commands and only damage the region they landed in
+        if (this->damage.TrackElement(index, data->handle.generation, bounds, (dirty & ~DIRTY_PIXELS) != DIRTY_NONE)) {
+            data->commandsStale = true;
+        }
+        return dirty;
+    }
+    void SceneRenderer::InvalidateAll() {
+        this->damage.InvalidateAll();
+    }
+
+    static ProfilePhase DrawPhase(NodeType type) {
+        switch (type) {
+        case NodeType::TEXT_AREA: return ProfilePhase::DRAW_TEXT;
+        case NodeType::IMAGE: return ProfilePhase::DRAW_IMAGE;
+        case NodeType::PIXEL_BUFFER: return ProfilePhase::DRAW_PIXEL_BUFFER;
+        default: return ProfilePhase::DRAW_BASE;
+        }
+    }
+
+    bool SceneRenderer::RenderFrame(const RectF& surfaceBounds, std::span<const RectF> extraDamage) {
+        const bool rendered = this->DrawFrame(surfaceBounds, extraDamage);
+        const FrameDamageStats& stats = this->lastFrameStats;
+        this->profiler.Count(ProfileCounter::ELEMENTS_DRAWN, stats.elementsDrawn);
+        this->profiler.Count(ProfileCounter::ELEMENTS_RECORDED, stats.elementsRecorded);
+        this->profiler.Count(ProfileCounter::ELEMENTS_SKIPPED, stats.elementsSkipped);
+        this->profiler.EndFrame();
+        return rendered;
+    }
+    bool SceneRenderer::DrawFrame(const RectF& surfaceBounds, std::span<const RectF> extraDamage) {
+        ProfileScope frameScope(this->profiler, ProfilePhase::FRAME);
+        //pick up changes that were not collected yet, then clip to everything that needs repainting
+        this->CollectDamage();
+        for (const RectF& rect : extraDamage) {
+            this->damage.AddRect(rect.Intersection(surfaceBounds));
+        }
+        //the tracker keeps its rects disjoint, so painting them one after another blends nothing twice
+        this->clipScratch.clear();
+        if (this->damage.IsFullDamage()) {
+            this->clipScratch.push_back(surfaceBounds);
+        }
+        else {
+            for (const RectF& rect : this->damage.Rects()) {
+                const RectF clipped = rect.Intersection(surfaceBounds);
+                if (!clipped.IsEmpty()) this->clipScratch.push_back(clipped);
+            }
+        }
+
+        FrameDamageStats stats;
+        for (const RectF& clip : this->clipScratch) {
+            stats.damagedArea += clip.Area();
+        }
+        stats.fullRedraw = this->damage.IsFullDamage() || stats.damagedArea >= surfaceBounds.Area();
+        stats.damageRects = this->clipScratch.size();
+        stats.elementsChecked = this->elementsCheckedSinceFrame;
+        this->elementsCheckedSinceFrame = 0;
+
+        //node list should be ordered from least to greatest now
+        //too lazy to do some reverse stuff so ill make larger depth on top.
+        //cull once against every rect, each rect then only walks the elements touching it
+        this->drawScratch.clear();
+        for (const DrawOrderList::Entry& entry : this->depthSortedNodes.Entries()) {
+            const RectF bounds = this->damage.GetTrackedBounds(entry.id);
+            if (bounds.IsEmpty()) continue; //nothing visible to draw
+            uint32_t rectMask = 0;
+            for (size_t i = 0; i < this->clipScratch.size(); ++i) {
+                if (bounds.Intersects(this->clipScratch[i])) rectMask |= 1u << i;
+            }
+            if (rectMask == 0) {
+                ++stats.elementsSkipped;
+                continue;
+            }
+            this->drawScratch.push_back(DrawItem{ entry.id, rectMask });
+        }
+        stats.elementsDrawn = this->drawScratch.size();
+
+        ElementStore& store = ElementStore::Instance();
+        const bool profiling = this->profiler.IsEnabled();
+        this->device->BeginFrame();
+        for (size_t i = 0; i < this->clipScratch.size(); ++i) {
+            //draw background color
+            this->device->SetTransform(Transform2D::Identity());
+            this->device->PushClip(this->scaleDPI(this->clipScratch[i]));
+            this->device->Clear(this->backgroundColor);
+            for (const DrawItem& item : this->drawScratch) {
+                if ((item.rectMask & (1u << i)) == 0) continue;
+                NodeRenderData* data = this->renderDataBySlot[item.id];
+                //the type is only looked up while profiling
+                ProfileScope drawScope(this->profiler, profiling ? DrawPhase(store.Type(item.id)) : ProfilePhase::DRAW_BASE);
+                if (data->commandsStale) {
+                    this->RecordElement(data);
+                    ++stats.elementsRecorded;
+                }
+                if (data->clipped) {
+                    this->device->SetTransform(Transform2D::Identity());
+                    this->device->PushClip(this->scaleDPI(data->clip));
+                }
+                this->displayList.ReplayElement(*this->device, item.id);
+                if (data->clipped) this->device->PopClip();
+            }
+            this->device->SetTransform(Transform2D::Identity());
+            this->device->PopClip();
+        }
+
+        this->damage.ResetRegion();
+        this->lastFrameStats = stats;
+
+        bool ended;
+        {
+            ProfileScope endScope(this->profiler, ProfilePhase::END_FRAME);
+            ended = this->device->EndFrame();
+        }
+        if (!ended) {
+            this->ReleaseDeviceResources();
+            this->damage.InvalidateAll();
+            return false;
+        }
+        return true;
+    }
+    FrameDamageStats SceneRenderer::GetLastFrameStats() {
+        return this->lastFrameStats;
+    }
+
+    void SceneRenderer::ReleaseDeviceResources() {
+        for (NodeRenderData* data : this->renderDataBySlot) {
+            if (!data) continue;
+            data->staleResources = DIRTY_ALL;
+            data->commandsStale = true;
+        }
+        this->rescanPending = true;
+        this->displayList.ReleaseDeviceResources();
+        this->damage.InvalidateAll();
+    }
+
+    bool SceneRenderer::SaveDisplayList(const std::string& path) {
+        this->CollectDamage();
+        std::vector<uint32_t> order;
+        order.reserve(this->depthSortedNodes.Size());
+        ElementStore& store = ElementStore::Instance();
+        for (const DrawOrderList::Entry& entry : this->depthSortedNodes.Entries()) {
+            if (store.WorldHidden(entry.id)) continue;
+            NodeRenderData* data = this->renderDataBySlot[entry.id];
+            if (data->commandsStale) this->RecordElement(data);
+            order.push_back(entry.id);
+        }
+        return this->displayList.Save(path, order, this->backgroundColor);
+    }
+
+    void SceneRenderer::SetBackgroundColor(Color c) {
+        this->backgroundColor = c;
+        this->damage.InvalidateAll();
+    }
+    Color SceneRenderer::GetBackgroundColor() {
+        return this->backgroundColor;
+    }
+    void SceneRenderer::SetImagePlaceholderColor(Color c) {
+        this->imagePlaceholderColor = c;
+        for (NodeRenderData* data : this->renderDataBySlot) {
+            if (data && data->imagePending) data->commandsStale = true;
+        }
+        this->damage.InvalidateAll();
+    }
+
+    float SceneRenderer::scaleDPI(float val) {
+        return (val * 96.f)/this->dpi;
+    }
+    RectF SceneRenderer::scaleDPI(const RectF& rect) {
+        return RectF(
+            (rect.left * 96.f) / this->dpi,
+            (rect.top * 96.f) / this->dpi,
+            (rect.right * 96.f) / this->dpi,
+            (rect.bottom * 96.f) / this->dpi
+        );
+    }
+}
@@ -0,0 +1,152 @@
+#pragma once
+#include "frameprofiler.hpp"
+#include <span>
+#include "engineelements.hpp"
+#include "draworder.hpp"
+#include "damage.hpp"
+#include "renderdevice.hpp"
+#include "imagecache.hpp"
+#include "displaylist.hpp"
+#include "pixelbufferelement.hpp"
+
+namespace cpplab {
+    struct NodeRenderData {
+        ElementNode* elementNode;
+        ElementHandle handle;
+        //DirtyFlags of the text format, text content or bitmap that still need building
+        uint32_t staleResources = DIRTY_ALL;
+        //set when the element was modified or moved since its display list commands were recorded
+        bool commandsStale = true;
+        //set when a clipping ancestor cuts the element, the commands are replayed inside clip
+        bool clipped = false;
+        RectF clip;
+        //image still decoding, a placeholder is drawn until it is ready unless an older size of it is shown
+        bool imagePending = false;
+        //source and decode size of the bitmap last requested for an image element
+        ImageKey imageKey;
+    };
+
+    //dirty flags that need more than the element's commands recorded again
+    //a resized image may have crossed into another decode size
+    constexpr uint32_t ResourceDirtyFlags = DIRTY_TEXT_CONTENT | DIRTY_TEXT_FORMAT | DIRTY_IMAGE_SOURCE | DIRTY_GEOMETRY | DIRTY_PIXELS;
+
+    //cumulative counters of the work done for changed elements
+    struct ResourceRebuildStats {
+        uint64_t textFormatUpdates = 0;
+        uint64_t textContentUpdates = 0;
+        uint64_t bitmapUploads = 0;
+        //partial uploads of pixel buffer elements, counted apart from full bitmap uploads
+        uint64_t pixelRegionUploads = 0;
+        uint64_t pixelBytesUploaded = 0;
+        uint64_t elementsRecorded = 0;
+    };
+
+    //draws an element tree through a render device
+    //keeps the draw order, damage and a display list between frames, knows nothing about windows so it also runs headless
+    //elements are recorded into the display list when they change and replayed from it otherwise
+    class SceneRenderer {
+    private:
+        ElementNode* rootElementNode;
+        RenderDevice* device;
+        ImageCache* imageCache;
+        unsigned int dpi;
+
+        //draw order holds element store indices, render data is looked up by the same index
+        DrawOrderList depthSortedNodes;
+        std::vector<NodeRenderData*> renderDataBySlot;
+        std::vector<uint32_t> treeIndexScratch;
+        uint64_t builtStructureVersion = 0;
+        //the store journals the slots each publish changed, so only those are measured again
+        uint32_t changeJournal;
+        std::vector<uint32_t> changedScratch;
+        //set when every element has to be measured again, after the device dropped its resources
+        bool rescanPending = false;
+        size_t elementsCheckedSinceFrame = 0;
+        //elements waiting on the image cache, asked again whenever a decode finished
+        std::vector<ElementHandle> pendingImages;
+        uint64_t seenImageCompletions = 0;
+
+        DisplayList displayList;
+
+        DamageTracker damage;
+        //the damage rects of this frame cut to the surface, and the elements touching them with a bit per rect
+        std::vector<RectF> clipScratch;
+        struct DrawItem {
+            uint32_t id;
+            uint32_t rectMask;
+        };
+        std::vector<DrawItem> drawScratch;
+        FrameDamageStats lastFrameStats;
+        ResourceRebuildStats rebuildStats;
+        FrameProfiler profiler;
+
+        Color backgroundColor;
+        Color imagePlaceholderColor = Color(0.85f);
+
+        void BuildNodeList();
+        void CollectFinishedImages();
+        void RefreshNodeDepths();
+        //turns the published changes of one element into damage, returns the dirty flags it took
+        uint32_t CheckElement(uint32_t index);
+        RectF GetElementVisualBounds(NodeRenderData* element);
+
+        //builds the text formats, text and bitmaps named by staleResources, done before bounds are measured since the bitmap size matters
+        void PrepareElementResources(NodeRenderData* element);
+        //uploads the pixels changed since the last frame and damages just the part of the element showing them
+        void UploadPixelBuffer(NodeRenderData* element);
+        void RecordElement(NodeRenderData* element);
+        //RenderFrame without closing the profiler's frame
+        bool DrawFrame(const RectF& surfaceBounds, std::span<const RectF> extraDamage);
+
+        float scaleDPI(float val);
+        RectF scaleDPI(const RectF& rect);
+    public:
+        //the image cache may be null, image elements then only draw their border
+        SceneRenderer(ElementNode* rootNode, RenderDevice* device, ImageCache* imageCache, unsigned int dpi);
+        ~SceneRenderer();
+
+        //true when an element changed or an image this scene waits on finished decoding
+        bool CheckNodeModification();
+        //picks up structure and element changes and turns them into damage
+        void CollectDamage();
+        const DamageTracker& GetDamage() const {
+            return this->damage;
+        }
+        void InvalidateAll();
+
+        //repaints each damage rect on its own, clipped to it, with only the elements touching it
+        //extraDamage adds areas the platform wants painted, surfaceBounds is the whole target in pixels
+        //returns false if the device lost its target, the next frame is a full redraw
+        bool RenderFrame(const RectF& surfaceBounds, std::span<const RectF> extraDamage = {});
+        FrameDamageStats GetLastFrameStats();
+        ResourceRebuildStats GetRebuildStats() const {
+            return this->rebuildStats;
+        }
+        void ResetRebuildStats() {
+            this->rebuildStats = ResourceRebuildStats();
+        }
+
+        //off until enabled, every RenderFrame closes one frame of it
+        FrameProfiler& GetProfiler() {
+            return this->profiler;
+        }
+
+        //bitmaps and text formats belong to the device, drop them when it recreates its target
+        void ReleaseDeviceResources();
+
+        //records every stale element and writes the display list in draw order, see DisplayList::Load for replaying it
+        //hidden elements are left out, clips are not saved so a clipped element replays whole
+        bool SaveDisplayList(const std::string& path);
+        const DisplayList& GetDisplayList() const {
+            return this->displayList;
+        }
+        TextFormatCacheStats GetTextFormatStats() const {
+            return this->displayList.GetTextFormatCache().GetStats();
+        }
+
+        void SetBackgroundColor(Color c);
+        Color GetBackgroundColor();
+        //fills image boxes whose image is still decoding
+        void SetImagePlaceholderColor(Color c);
+    };
+}
@@ -0,0 +1,195 @@
+#include <string>
+#include <stdexcept>
+#include "scrolllistelement.hpp"
+
+namespace cpplab {
+    ScrollListElement::ScrollListElement(IListDataSource* source, float rowHeight, size_t overscan) {
+        if (source == nullptr) {
+            throw std::runtime_error("[Cpplab Elements] During Scroll List Creation: A data source is required!");
+        }
+        if (!(rowHeight > 0.f)) {
+            throw std::runtime_error("[Cpplab Elements] During Scroll List Creation: Row height must be positive!");
+        }
+        this->source = source;
+        this->rowHeight = rowHeight;
+        this->overscan = overscan;
+        this->setClipChildren(true);
+
+        //the only child, scrolling moves it and nothing else
+        this->content = new ElementNode();
+        this->content->show();
+        this->AddChildElement("content", this->content);
+
+        this->rowCount = this->source->GetRowCount();
+        this->Update();
+    }
+    ScrollListElement::~ScrollListElement() {
+        for (PooledRow& row : this->pool) {
+            delete row.element;
+        }
+        delete this->content;
+    }
+
+    void ScrollListElement::GrowPool(size_t size) {
+        if (size <= this->pool.size()) return;
+        //slots are picked modulo the pool size, which just changed, so every row is bound again
+        for (PooledRow& row : this->pool) {
+            row.rowIndex = InvalidRow;
+        }
+        const size_t first = this->pool.size();
+        this->pool.resize(size);
+        for (size_t slot = first; slot < size; ++slot) {
+            ElementNode* element = this->source->CreateRow();
+            if (element == nullptr) {
+                this->pool.resize(slot);
+                throw std::runtime_error("[Cpplab Elements] During Scroll List Update: The data source returned no row element!");
+            }
+            this->pool[slot].element = element;
+            this->content->AddChildElement("row" + std::to_string(slot), element);
+        }
+    }
+
+    void ScrollListElement::Realize() {
+        const uint64_t boundBefore = this->stats.rowsBound;
+        const double rowHeight = this->rowHeight;
+        const double viewHeight = (std::max)(this->viewportHeight, 0.f);
+        const float width = (std::max)(this->viewportWidth, 0.f);
+        this->scrollOffset = (std::min)((std::max)(this->scrollOffset, 0.0), this->getMaxScrollOffset());
+
+        //rows at least partly inside the list, then the window of rows kept bound around them
+        const size_t first = this->getFirstVisibleRow();
+        const size_t visibleEnd = (std::min)(this->rowCount, static_cast<size_t>(std::ceil((this->scrollOffset + viewHeight) / rowHeight)));
+        const size_t windowStart = first > this->overscan ? first - this->overscan : 0;
+        const size_t windowEnd = (std::max)(windowStart, (std::min)(this->rowCount, visibleEnd + this->overscan));
+        //sized for the widest window this height allows, a row cut at both edges included, so scrolling never grows it
+        const size_t widestWindow = static_cast<size_t>(std::ceil(viewHeight / rowHeight)) + 1 + 2 * this->overscan;
+        this->GrowPool((std::min)(this->rowCount, widestWindow));
+
+        //rows are placed relative to the anchor row, moved once the scroll position gets far from it
+        if (std::abs(static_cast<double>(first) - static_cast<double>(this->anchorRow)) * rowHeight > RebaseDistance) {
+            this->anchorRow = first;
+            ++this->stats.rebases;
+        }
+        const float contentY = static_cast<float>(static_cast<double>(this->anchorRow) * rowHeight - this->scrollOffset);
+        if (contentY != this->contentY) {
+            this->contentY = contentY;
+            this->content->setRelativePosition(vec2(0.f, contentY));
+        }
+
+        const size_t poolSize = this->pool.size();
+        size_t visible = 0;
+        for (size_t slot = 0; slot < poolSize; ++slot) {
+            PooledRow& row = this->pool[slot];
+            //the one row of the window this slot serves, if the window reaches it
+            const size_t rowIndex = poolSize == 0 ? InvalidRow : windowStart + (slot + poolSize - windowStart % poolSize) % poolSize;
+            const bool inWindow = rowIndex < windowEnd;
+            if (inWindow && row.rowIndex != rowIndex) {
+                this->source->BindRow(row.element, rowIndex);
+                row.rowIndex = rowIndex;
+                ++this->stats.rowsBound;
+            }
+
+            //a row keeps the row it was bound to while hidden, scrolling back to it needs no bind
+            //rows of the window sit at their place even in the overscan, leaving it only flips their visibility
+            const bool shown = inWindow && rowIndex >= first && rowIndex < visibleEnd;
+            const float y = inWindow ? static_cast<float>((static_cast<double>(rowIndex) - static_cast<double>(this->anchorRow)) * rowHeight) : row.y;
+            if (shown) ++visible;
+            if (y == row.y && width == row.width && shown == row.shown) continue;
+
+            const uint32_t dirtyFlags = shown != row.shown ? DIRTY_GEOMETRY | DIRTY_VISIBILITY : DIRTY_GEOMETRY;
+            row.y = y;
+            row.width = width;
+            row.shown = shown;
+            //one state swap for position, size and visibility together
+            const float height = this->rowHeight;
+            row.element->updateState<ElementState>(dirtyFlags, [y, width, height, shown](ElementState& state) {
+                state.posX = 0.f;
+                state.posY = y;
+                state.width = width;
+                state.height = height;
+                state.hidden = !shown;
+            });
+        }
+
+        this->stats.rowCount = this->rowCount;
+        this->stats.pooledRows = poolSize;
+        this->stats.visibleRows = visible;
+        this->stats.lastRowsBound = static_cast<size_t>(this->stats.rowsBound - boundBefore);
+    }
+
+    void ScrollListElement::setScrollOffset(double offset) {
+        if (offset == this->scrollOffset) return;
+        this->scrollOffset = offset;
+        this->Realize();
+    }
+    void ScrollListElement::scrollBy(double delta) {
+        this->setScrollOffset(this->scrollOffset + delta);
+    }
+    void ScrollListElement::scrollToRow(size_t rowIndex) {
+        this->setScrollOffset(static_cast<double>(rowIndex) * this->rowHeight);
+    }
+    double ScrollListElement::getMaxScrollOffset() {
+        const double contentHeight = static_cast<double>(this->rowCount) * this->rowHeight;
+        return (std::max)(contentHeight - (std::max)(this->viewportHeight, 0.f), 0.0);
+    }
+    size_t ScrollListElement::getFirstVisibleRow() {
+        if (this->rowCount == 0) return 0;
+        const size_t row = static_cast<size_t>(this->scrollOffset / this->rowHeight);
+        return (std::min)(row, this->rowCount - 1);
+    }
+
+    void ScrollListElement::dataChanged() {
+        this->rowCount = this->source->GetRowCount();
+        for (PooledRow& row : this->pool) {
+            row.rowIndex = InvalidRow;
+        }
+        this->Realize();
+    }
+    void ScrollListElement::rowChanged(size_t rowIndex) {
+        ElementNode* row = this->getRowElement(rowIndex);
+        if (row == nullptr) return;
+        this->source->BindRow(row, rowIndex);
+        ++this->stats.rowsBound;
+    }
+    ElementNode* ScrollListElement::getRowElement(size_t rowIndex) {
+        if (this->pool.empty() || rowIndex >= this->rowCount) return nullptr;
+        PooledRow& row = this->pool[rowIndex % this->pool.size()];
+        return row.rowIndex == rowIndex ? row.element : nullptr;
+    }
+
+    void ScrollListElement::Update() {
+        const std::shared_ptr<const ElementState> state = this->loadState<ElementState>();
+        if (state->width == this->viewportWidth && state->height == this->viewportHeight) return;
+        this->viewportWidth = state->width;
+        this->viewportHeight = state->height;
+        this->Realize();
+    }
+
+    void ScrollListSet::Add(ScrollListElement* list) {
+        for (const Entry& entry : this->lists) {
+            if (entry.list == list) return;
+        }
+        this->lists.push_back(Entry{ list->getHandle(), list, list });
+    }
+    void ScrollListSet::Remove(ScrollListElement* list) {
+        for (size_t i = 0; i < this->lists.size(); ++i) {
+            if (this->lists[i].list != list) continue;
+            this->lists[i] = this->lists.back();
+            this->lists.pop_back();
+            return;
+        }
+    }
+    void ScrollListSet::RunFrame() {
+        ElementStore& store = ElementStore::Instance();
+        for (size_t i = 0; i < this->lists.size();) {
+            //a list deleted since it was added no longer resolves
+            if (store.Resolve(this->lists[i].handle) != this->lists[i].node) {
+                this->lists[i] = this->lists.back();
+                this->lists.pop_back();
+                continue;
+            }
+            this->lists[i].list->Update();
+            ++i;
+        }
+    }
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include "engineelements.hpp"
+
+namespace cpplab {
+    //rows for a ScrollListElement, only the rows in view and a few around them are ever asked for
+    class IListDataSource {
+    public:
+        virtual ~IListDataSource() = default;
+
+        virtual size_t GetRowCount() = 0;
+        //builds one pooled row, called once per pool slot, the list owns and deletes it
+        virtual ElementNode* CreateRow() = 0;
+        //fills a pooled row with the data of a row, called whenever the row element is reused for another row
+        //the list sets the row's position, size and visibility itself
+        virtual void BindRow(ElementNode* row, size_t rowIndex) = 0;
+    };
+
+    struct ScrollListStats {
+        size_t rowCount = 0;
+        size_t pooledRows = 0;
+        size_t visibleRows = 0;
+        uint64_t rowsBound = 0;
+        //rows bound by the last scroll, resize or data change
+        size_t lastRowsBound = 0;
+        //times the rows were placed relative to a new anchor row, see anchorRow
+        uint64_t rebases = 0;
+    };
+
+    //scroll container for any number of rows of one height, materializes only the rows in view plus overscan
+    //a small pool of row elements is recycled, a row scrolled out is bound to the row scrolling in
+    //rows sit in a content node and scrolling moves only that node, rows are bound again only when their row changes
+    //rows outside the list are hidden, and the list clips its children so a row cut by its edge draws only the part inside
+    //ui thread only, do not make the list a layout container, it places its own rows
+    class ScrollListElement : public ElementNode {
+    private:
+        static constexpr size_t InvalidRow = static_cast<size_t>(-1);
+        //how far the scroll position may move from the anchor row before rows are placed relative to a new one
+        static constexpr double RebaseDistance = 65536.0;
+
+        struct PooledRow {
+            ElementNode* element = nullptr;
+            size_t rowIndex = InvalidRow;
+            //what was last written into the row, to skip writes that change nothing
+            float y = 0.f;
+            float width = -1.f;
+            bool shown = false;
+        };
+
+        IListDataSource* source;
+        float rowHeight;
+        size_t overscan;
+        ElementNode* content;
+        //pool slot of a row is its index modulo the pool size, so rows in the window never share a slot
+        std::vector<PooledRow> pool;
+
+        size_t rowCount = 0;
+        double scrollOffset = 0.0;
+        //row at the content node's origin, rows are placed relative to it so their floats stay exact a million rows down
+        size_t anchorRow = 0;
+        float contentY = 0.f;
+        float viewportWidth = -1.f;
+        float viewportHeight = -1.f;
+
+        ScrollListStats stats;
+
+        void GrowPool(size_t size);
+        //brings the pool in line with the scroll position, size and data, touching only rows that changed
+        void Realize();
+
+    public:
+        //throws std::runtime_error without a data source or with a row height that is not positive
+        ScrollListElement(IListDataSource* source, float rowHeight, size_t overscan = 4);
+        //deletes the pooled rows
+        ~ScrollListElement();
+
+        float getRowHeight() const {
+            return this->rowHeight;
+        }
+        size_t getRowCount() const {
+            return this->rowCount;
+        }
+        double getScrollOffset() const {
+            return this->scrollOffset;
+        }
+        //clamped to the rows there are
+        void setScrollOffset(double offset);
+        void scrollBy(double delta);
+        //scrolls so the row is at the top, or as far as the list goes
+        void scrollToRow(size_t rowIndex);
+        double getMaxScrollOffset();
+        size_t getFirstVisibleRow();
+
+        //the row count or the data of every row changed, asks the source for the count and binds the pooled rows again
+        void dataChanged();
+        //binds the row again if it is materialized
+        void rowChanged(size_t rowIndex);
+        //the pooled element showing the row, null when the row is not materialized
+        ElementNode* getRowElement(size_t rowIndex);
+
+        //once per frame from the engine, picks up a size the list was given since, by the layout or by hand
+        void Update();
+
+        ScrollListStats getStats() const {
+            return this->stats;
+        }
+    };
+
+    //the scroll lists an engine updates every frame after layout
+    //lists are held by handle, a deleted list is dropped on the next frame
+    class ScrollListSet {
+    private:
+        struct Entry {
+            ElementHandle handle;
+            //compared with what the handle resolves to, never dereferenced before it matched
+            ElementNode* node;
+            ScrollListElement* list;
+        };
+        std::vector<Entry> lists;
+
+    public:
+        void Add(ScrollListElement* list);
+        void Remove(ScrollListElement* list);
+        //ui thread, once per frame after layout
+        void RunFrame();
+        size_t Size() const {
+            return this->lists.size();
+        }
+    };
+}
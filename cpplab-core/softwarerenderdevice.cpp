@@ -0,0 +1,498 @@
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include "softwarerenderdevice.hpp"
+
+namespace cpplab {
+    namespace {
+        //5x7 glyphs for printable ascii, one byte per row, bit 4 is the leftmost column
+        constexpr int GlyphColumns = 5;
+        constexpr int GlyphRows = 7;
+        const uint8_t Font5x7[95][GlyphRows] = {
+            { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // space
+            { 0x04, 0x04, 0x04, 0x04, 0x00, 0x00, 0x04 }, // !
+            { 0x0A, 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00 }, // "
+            { 0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A }, // #
+            { 0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04 }, // $
+            { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 }, // %
+            { 0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D }, // &
+            { 0x0C, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00 }, // '
+            { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 }, // (
+            { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 }, // )
+            { 0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00 }, // *
+            { 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 }, // +
+            { 0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08 }, // ,
+            { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 }, // -
+            { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C }, // .
+            { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 }, // /
+            { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E }, // 0
+            { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E }, // 1
+            { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F }, // 2
+            { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E }, // 3
+            { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 }, // 4
+            { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E }, // 5
+            { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E }, // 6
+            { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 }, // 7
+            { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E }, // 8
+            { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C }, // 9
+            { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 }, // :
+            { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08 }, // ;
+            { 0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02 }, // <
+            { 0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00 }, // =
+            { 0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08 }, // >
+            { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 }, // ?
+            { 0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E }, // @
+            { 0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11 }, // A
+            { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E }, // B
+            { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E }, // C
+            { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C }, // D
+            { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F }, // E
+            { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 }, // F
+            { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F }, // G
+            { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 }, // H
+            { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E }, // I
+            { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C }, // J
+            { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 }, // K
+            { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F }, // L
+            { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 }, // M
+            { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 }, // N
+            { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E }, // O
+            { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 }, // P
+            { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D }, // Q
+            { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 }, // R
+            { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E }, // S
+            { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 }, // T
+            { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E }, // U
+            { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 }, // V
+            { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A }, // W
+            { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 }, // X
+            { 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04 }, // Y
+            { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F }, // Z
+            { 0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E }, // [
+            { 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00 }, // backslash
+            { 0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E }, // ]
+            { 0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00 }, // ^
+            { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F }, // _
+            { 0x08, 0x04, 0x02, 0x00, 0x00, 0x00, 0x00 }, // `
+            { 0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F }, // a
+            { 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1E }, // b
+            { 0x00, 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E }, // c
+            { 0x01, 0x01, 0x0D, 0x13, 0x11, 0x11, 0x0F }, // d
+            { 0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E }, // e
+            { 0x06, 0x09, 0x08, 0x1C, 0x08, 0x08, 0x08 }, // f
+            { 0x00, 0x0F, 0x11, 0x11, 0x0F, 0x01, 0x0E }, // g
+            { 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11 }, // h
+            { 0x04, 0x00, 0x0C, 0x04, 0x04, 0x04, 0x0E }, // i
+            { 0x02, 0x00, 0x06, 0x02, 0x02, 0x12, 0x0C }, // j
+            { 0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12 }, // k
+            { 0x0C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E }, // l
+            { 0x00, 0x00, 0x1A, 0x15, 0x15, 0x11, 0x11 }, // m
+            { 0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11 }, // n
+            { 0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E }, // o
+            { 0x00, 0x00, 0x1E, 0x11, 0x1E, 0x10, 0x10 }, // p
+            { 0x00, 0x00, 0x0D, 0x13, 0x0F, 0x01, 0x01 }, // q
+            { 0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10 }, // r
+            { 0x00, 0x00, 0x0E, 0x10, 0x0E, 0x01, 0x1E }, // s
+            { 0x08, 0x08, 0x1C, 0x08, 0x08, 0x09, 0x06 }, // t
+            { 0x00, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0D }, // u
+            { 0x00, 0x00, 0x11, 0x11, 0x11, 0x0A, 0x04 }, // v
+            { 0x00, 0x00, 0x11, 0x11, 0x15, 0x15, 0x0A }, // w
+            { 0x00, 0x00, 0x11, 0x0A, 0x04, 0x0A, 0x11 }, // x
+            { 0x00, 0x00, 0x11, 0x11, 0x0F, 0x01, 0x0E }, // y
+            { 0x00, 0x00, 0x1F, 0x02, 0x04, 0x08, 0x1F }, // z
+            { 0x02, 0x04, 0x04, 0x08, 0x04, 0x04, 0x02 }, // {
+            { 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 }, // |
+            { 0x08, 0x04, 0x04, 0x02, 0x04, 0x04, 0x08 }, // }
+            { 0x00, 0x00, 0x00, 0x0D, 0x12, 0x00, 0x00 }, // ~
+        };
+        //anything outside printable ascii draws as a hollow box
+        const uint8_t MissingGlyph[GlyphRows] = { 0x1F, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1F };
+
+        //font metrics in glyph units, one unit is an eighth of the font size
+        constexpr float UnitsPerEm = 8.f;
+        constexpr float GlyphAdvance = 6.f;
+        constexpr float LineHeight = 10.f;
+        constexpr float GlyphTopOffset = 1.5f;
+
+        float Clamp01(float v) {
+            return v < 0.f ? 0.f : (v > 1.f ? 1.f : v);
+        }
+        float Smaller(float a, float b) {
+            return a < b ? a : b;
+        }
+        float Larger(float a, float b) {
+            return a > b ? a : b;
+        }
+        uint8_t ToByte(float v) {
+            return static_cast<uint8_t>(Clamp01(v) * 255.f + 0.5f);
+        }
+        void Premultiply(const Color& color, float out[4]) {
+            const float a = Clamp01(color.a);
+            out[0] = Clamp01(color.r) * a;
+            out[1] = Clamp01(color.g) * a;
+            out[2] = Clamp01(color.b) * a;
+            out[3] = a;
+        }
+
+        //signed distance to a rounded rect, negative inside
+        float RoundedRectDistance(const RoundedRectF& rect, float px, float py) {
+            const float halfW = (rect.rect.right - rect.rect.left) / 2;
+            const float halfH = (rect.rect.bottom - rect.rect.top) / 2;
+            //elliptical corners are approximated with the smaller radius
+            float radius = Smaller(rect.radiusX, rect.radiusY);
+            radius = Larger(0.f, Smaller(radius, Smaller(halfW, halfH)));
+
+            const float qx = std::fabs(px - (rect.rect.left + halfW)) - (halfW - radius);
+            const float qy = std::fabs(py - (rect.rect.top + halfH)) - (halfH - radius);
+            const float ox = Larger(qx, 0.f), oy = Larger(qy, 0.f);
+            return std::sqrt(ox * ox + oy * oy) + Smaller(Larger(qx, qy), 0.f) - radius;
+        }
+
+        //greedy word wrap, words longer than a line are broken between characters
+        void WrapText(const std::wstring& text, size_t maxChars, std::vector<std::wstring>& lines) {
+            if (maxChars == 0) maxChars = 1;
+            size_t paragraphStart = 0;
+            while (paragraphStart <= text.size()) {
+                size_t paragraphEnd = text.find(L'\n', paragraphStart);
+                if (paragraphEnd == std::wstring::npos) paragraphEnd = text.size();
+
+                std::wstring line;
+                size_t pos = paragraphStart;
+                while (pos < paragraphEnd) {
+                    if (text[pos] == L' ') {
+                        ++pos;
+                        continue;
+                    }
+                    size_t wordEnd = pos;
+                    while (wordEnd < paragraphEnd && text[wordEnd] != L' ') ++wordEnd;
+                    std::wstring word = text.substr(pos, wordEnd - pos);
+                    pos = wordEnd;
+
+                    const size_t needed = line.empty() ? word.size() : line.size() + 1 + word.size();
+                    if (needed <= maxChars) {
+                        if (!line.empty()) line += L' ';
+                        line += word;
+                        continue;
+                    }
+                    if (!line.empty()) {
+                        lines.push_back(line);
+                        line.clear();
+                    }
+                    while (word.size() > maxChars) {
+                        lines.push_back(word.substr(0, maxChars));
+                        word.erase(0, maxChars);
+                    }
+                    line = word;
+                }
+                lines.push_back(line);
+                paragraphStart = paragraphEnd + 1;
+            }
+        }
+    }
+
+    vec2 SoftwareBitmap::GetSize() const {
+        return vec2(static_cast<float>(this->pixels.width), static_cast<float>(this->pixels.height));
+    }
+
+    SoftwareRenderDevice::SoftwareRenderDevice(uint32_t width, uint32_t height) {
+        this->width = 0;
+        this->height = 0;
+        this->Resize(width, height);
+    }
+    void SoftwareRenderDevice::Resize(uint32_t width, uint32_t height) {
+        this->width = width;
+        this->height = height;
+        this->framebuffer.assign(static_cast<size_t>(width) * height * 4, 0);
+        this->clipStack.clear();
+    }
+    void SoftwareRenderDevice::SetDpi(unsigned int dpi) {
+        this->pixelsPerUnit = static_cast<float>(dpi) / 96.f;
+    }
+    uint32_t SoftwareRenderDevice::GetPixel(uint32_t x, uint32_t y) const {
+        if (x >= this->width || y >= this->height) return 0;
+        const uint8_t* px = &this->framebuffer[(static_cast<size_t>(y) * this->width + x) * 4];
+        return (static_cast<uint32_t>(px[0]) << 24) | (static_cast<uint32_t>(px[1]) << 16) |
+               (static_cast<uint32_t>(px[2]) << 8) | static_cast<uint32_t>(px[3]);
+    }
+    bool SoftwareRenderDevice::SavePPM(const std::string& path) const {
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) return false;
+        std::fprintf(file, "P6\n%u %u\n255\n", this->width, this->height);
+        std::vector<uint8_t> row(static_cast<size_t>(this->width) * 3);
+        bool ok = true;
+        for (uint32_t y = 0; y < this->height && ok; ++y) {
+            for (uint32_t x = 0; x < this->width; ++x) {
+                const uint8_t* px = &this->framebuffer[(static_cast<size_t>(y) * this->width + x) * 4];
+                row[x * 3 + 0] = px[0];
+                row[x * 3 + 1] = px[1];
+                row[x * 3 + 2] = px[2];
+            }
+            ok = std::fwrite(row.data(), 1, row.size(), file) == row.size();
+        }
+        return std::fclose(file) == 0 && ok;
+    }
+
+    SoftwareRenderDevice::PixelRect SoftwareRenderDevice::CurrentClip() const {
+        if (this->clipStack.empty()) return PixelRect{ 0, 0, static_cast<int>(this->width), static_cast<int>(this->height) };
+        return this->clipStack.back();
+    }
+    SoftwareRenderDevice::PixelRect SoftwareRenderDevice::ClipBounds(const RectF& deviceBounds) const {
+        const PixelRect clip = this->CurrentClip();
+        PixelRect bounds = {
+            static_cast<int>(std::floor(Larger(deviceBounds.left, static_cast<float>(clip.left)))),
+            static_cast<int>(std::floor(Larger(deviceBounds.top, static_cast<float>(clip.top)))),
+            static_cast<int>(std::ceil(Smaller(deviceBounds.right, static_cast<float>(clip.right)))),
+            static_cast<int>(std::ceil(Smaller(deviceBounds.bottom, static_cast<float>(clip.bottom))))
+        };
+        if (bounds.right < bounds.left) bounds.right = bounds.left;
+        if (bounds.bottom < bounds.top) bounds.bottom = bounds.top;
+        return bounds;
+    }
+    void SoftwareRenderDevice::BlendPixel(int x, int y, const float premultiplied[4], float coverage) {
+        if (coverage <= 0.f) return;
+        uint8_t* px = &this->framebuffer[(static_cast<size_t>(y) * this->width + x) * 4];
+        //source over with premultiplied alpha
+        const float inverse = 1.f - premultiplied[3] * coverage;
+        for (int c = 0; c < 4; ++c) {
+            px[c] = ToByte(premultiplied[c] * coverage + (px[c] / 255.f) * inverse);
+        }
+    }
+
+    void SoftwareRenderDevice::BeginFrame() {
+        this->SetTransform(Transform2D::Identity());
+        this->clipStack.clear();
+    }
+    bool SoftwareRenderDevice::EndFrame() {
+        //nothing to present and the target can not be lost
+        this->clipStack.clear();
+        return true;
+    }
+    vec2 SoftwareRenderDevice::GetSize() const {
+        return vec2(static_cast<float>(this->width) / this->pixelsPerUnit, static_cast<float>(this->height) / this->pixelsPerUnit);
+    }
+
+    void SoftwareRenderDevice::Clear(const Color& color) {
+        //clear replaces pixels inside the current clip, like the d2d clear
+        float premultiplied[4];
+        Premultiply(color, premultiplied);
+        const uint8_t value[4] = { ToByte(premultiplied[0]), ToByte(premultiplied[1]), ToByte(premultiplied[2]), ToByte(premultiplied[3]) };
+        const PixelRect clip = this->CurrentClip();
+        for (int y = clip.top; y < clip.bottom; ++y) {
+            for (int x = clip.left; x < clip.right; ++x) {
+                uint8_t* px = &this->framebuffer[(static_cast<size_t>(y) * this->width + x) * 4];
+                px[0] = value[0];
+                px[1] = value[1];
+                px[2] = value[2];
+                px[3] = value[3];
+            }
+        }
+    }
+    void SoftwareRenderDevice::SetTransform(const Transform2D& transform) {
+        this->userTransform = transform;
+        this->transform = transform * Transform2D::Scale(this->pixelsPerUnit, this->pixelsPerUnit);
+    }
+    Transform2D SoftwareRenderDevice::GetTransform() const {
+        return this->userTransform;
+    }
+
+    void SoftwareRenderDevice::PushClip(const RectF& rect) {
+        //aliased, a pixel is inside when its center is
+        const RectF bounds = this->transform.TransformBounds(rect);
+        const PixelRect current = this->CurrentClip();
+        PixelRect clip = {
+            static_cast<int>(std::ceil(bounds.left - 0.5f)), static_cast<int>(std::ceil(bounds.top - 0.5f)),
+            static_cast<int>(std::ceil(bounds.right - 0.5f)), static_cast<int>(std::ceil(bounds.bottom - 0.5f))
+        };
+        if (clip.left < current.left) clip.left = current.left;
+        if (clip.top < current.top) clip.top = current.top;
+        if (clip.right > current.right) clip.right = current.right;
+        if (clip.bottom > current.bottom) clip.bottom = current.bottom;
+        if (clip.right < clip.left) clip.right = clip.left;
+        if (clip.bottom < clip.top) clip.bottom = clip.top;
+        this->clipStack.push_back(clip);
+    }
+    void SoftwareRenderDevice::PopClip() {
+        if (!this->clipStack.empty()) this->clipStack.pop_back();
+    }
+
+    void SoftwareRenderDevice::RasterRoundedRect(const RoundedRectF& rect, const Color& color, float strokeWidth, bool stroke) {
+        if (color.a <= 0.f) return;
+        float premultiplied[4];
+        Premultiply(color, premultiplied);
+
+        //distances are measured in local units, scale turns them into pixels for the antialiasing ramp
+        const float scale = std::sqrt(std::fabs(this->transform.Determinant()));
+        if (scale == 0.f) return;
+        const float halfStroke = stroke ? strokeWidth / 2 : 0.f;
+        const Transform2D inverse = this->transform.Inverse();
+        const PixelRect bounds = this->ClipBounds(this->transform.TransformBounds(rect.rect.Inflate(halfStroke + 1.f / scale)));
+
+        for (int y = bounds.top; y < bounds.bottom; ++y) {
+            for (int x = bounds.left; x < bounds.right; ++x) {
+                const vec2 local = inverse.Apply(vec2(x + 0.5f, y + 0.5f));
+                const float distance = RoundedRectDistance(rect, local.x, local.y) * scale;
+                float coverage;
+                if (stroke) {
+                    //thin strokes fade out instead of disappearing
+                    coverage = Clamp01(halfStroke * scale + 0.5f - std::fabs(distance));
+                    coverage = Smaller(coverage, strokeWidth * scale);
+                }
+                else {
+                    coverage = Clamp01(0.5f - distance);
+                }
+                this->BlendPixel(x, y, premultiplied, coverage);
+            }
+        }
+    }
+    void SoftwareRenderDevice::FillRoundedRect(const RoundedRectF& rect, const Color& color) {
+        this->RasterRoundedRect(rect, color, 0.f, false);
+    }
+    void SoftwareRenderDevice::StrokeRoundedRect(const RoundedRectF& rect, const Color& color, float strokeWidth) {
+        if (strokeWidth <= 0.f) return;
+        this->RasterRoundedRect(rect, color, strokeWidth, true);
+    }
+
+    RenderBitmap* SoftwareRenderDevice::CreateBitmap(const PixelBuffer& pixels) {
+        SoftwareBitmap* bitmap = new SoftwareBitmap();
+        bitmap->pixels = pixels;
+        return bitmap;
+    }
+    void SoftwareRenderDevice::UpdateBitmap(RenderBitmap* bitmap, const PixelRegion& region, const uint8_t* pixels, uint32_t stride) {
+        PixelBuffer& target = static_cast<SoftwareBitmap*>(bitmap)->pixels;
+        for (uint32_t row = 0; row < region.height; ++row) {
+            std::memcpy(
+                &target.pixels[(static_cast<size_t>(region.y + row) * target.width + region.x) * 4],
+                pixels + static_cast<size_t>(row) * stride,
+                static_cast<size_t>(region.width) * 4
+            );
+        }
+    }
+    void SoftwareRenderDevice::DrawBitmap(RenderBitmap* bitmap, const RectF& destination, float opacity) {
+        const PixelBuffer& source = static_cast<SoftwareBitmap*>(bitmap)->pixels;
+        if (source.width == 0 || source.height == 0 || destination.IsEmpty() || opacity <= 0.f) return;
+
+        const Transform2D inverse = this->transform.Inverse();
+        const PixelRect bounds = this->ClipBounds(this->transform.TransformBounds(destination));
+        const float toSourceX = source.width / (destination.right - destination.left);
+        const float toSourceY = source.height / (destination.bottom - destination.top);
+        const int maxX = static_cast<int>(source.width) - 1;
+        const int maxY = static_cast<int>(source.height) - 1;
+
+        for (int y = bounds.top; y < bounds.bottom; ++y) {
+            for (int x = bounds.left; x < bounds.right; ++x) {
+                const vec2 local = inverse.Apply(vec2(x + 0.5f, y + 0.5f));
+                if (local.x < destination.left || local.x >= destination.right ||
+                    local.y < destination.top || local.y >= destination.bottom) continue;
+
+                //bilinear sample with clamped edges
+                const float sx = (local.x - destination.left) * toSourceX - 0.5f;
+                const float sy = (local.y - destination.top) * toSourceY - 0.5f;
+                const float fx = std::floor(sx), fy = std::floor(sy);
+                const float tx = sx - fx, ty = sy - fy;
+                int x0 = static_cast<int>(fx), y0 = static_cast<int>(fy);
+                int x1 = x0 + 1, y1 = y0 + 1;
+                x0 = x0 < 0 ? 0 : (x0 > maxX ? maxX : x0);
+                x1 = x1 < 0 ? 0 : (x1 > maxX ? maxX : x1);
+                y0 = y0 < 0 ? 0 : (y0 > maxY ? maxY : y0);
+                y1 = y1 < 0 ? 0 : (y1 > maxY ? maxY : y1);
+
+                const uint8_t* p00 = &source.pixels[(static_cast<size_t>(y0) * source.width + x0) * 4];
+                const uint8_t* p10 = &source.pixels[(static_cast<size_t>(y0) * source.width + x1) * 4];
+                const uint8_t* p01 = &source.pixels[(static_cast<size_t>(y1) * source.width + x0) * 4];
+                const uint8_t* p11 = &source.pixels[(static_cast<size_t>(y1) * source.width + x1) * 4];
+                float sample[4];
+                for (int c = 0; c < 4; ++c) {
+                    const float top = p00[c] + (p10[c] - p00[c]) * tx;
+                    const float bottom = p01[c] + (p11[c] - p01[c]) * tx;
+                    sample[c] = (top + (bottom - top) * ty) / 255.f;
+                }
+                this->BlendPixel(x, y, sample, opacity);
+            }
+        }
+    }
+
+    RenderTextFormat* SoftwareRenderDevice::CreateTextFormat(const TextFormatDesc& desc) {
+        SoftwareTextFormat* format = new SoftwareTextFormat();
+        format->desc = desc;
+        return format;
+    }
+    void SoftwareRenderDevice::RasterGlyph(wchar_t character, float x, float y, float unit, const Color& color) {
+        const uint8_t* rows = (character >= 32 && character < 127) ? Font5x7[character - 32] : MissingGlyph;
+
+        //sum the exact area each lit cell covers so neighbouring cells do not leave seams
+        const PixelRect bounds = this->ClipBounds(this->transform.TransformBounds(
+            RectF(x, y, x + GlyphColumns * unit, y + GlyphRows * unit)
+        ));
+        const int boundsWidth = bounds.right - bounds.left;
+        const int boundsHeight = bounds.bottom - bounds.top;
+        if (boundsWidth <= 0 || boundsHeight <= 0) return;
+        this->coverageScratch.assign(static_cast<size_t>(boundsWidth) * boundsHeight, 0.f);
+
+        for (int row = 0; row < GlyphRows; ++row) {
+            for (int column = 0; column < GlyphColumns; ++column) {
+                if (!(rows[row] & (0x10 >> column))) continue;
+                const RectF cell = this->transform.TransformBounds(RectF(
+                    x + column * unit, y + row * unit,
+                    x + (column + 1) * unit, y + (row + 1) * unit
+                ));
+                const int left = static_cast<int>(std::floor(Larger(cell.left, static_cast<float>(bounds.left))));
+                const int top = static_cast<int>(std::floor(Larger(cell.top, static_cast<float>(bounds.top))));
+                const int right = static_cast<int>(std::ceil(Smaller(cell.right, static_cast<float>(bounds.right))));
+                const int bottom = static_cast<int>(std::ceil(Smaller(cell.bottom, static_cast<float>(bounds.bottom))));
+                for (int py = top; py < bottom; ++py) {
+                    const float coverY = Smaller(py + 1.f, cell.bottom) - Larger(static_cast<float>(py), cell.top);
+                    if (coverY <= 0.f) continue;
+                    for (int px = left; px < right; ++px) {
+                        const float coverX = Smaller(px + 1.f, cell.right) - Larger(static_cast<float>(px), cell.left);
+                        if (coverX <= 0.f) continue;
+                        this->coverageScratch[static_cast<size_t>(py - bounds.top) * boundsWidth + (px - bounds.left)] += coverX * coverY;
+                    }
+                }
+            }
+        }
+
+        float premultiplied[4];
+        Premultiply(color, premultiplied);
+        for (int py = 0; py < boundsHeight; ++py) {
+            for (int px = 0; px < boundsWidth; ++px) {
+                const float coverage = this->coverageScratch[static_cast<size_t>(py) * boundsWidth + px];
+                this->BlendPixel(bounds.left + px, bounds.top + py, premultiplied, Clamp01(coverage));
+            }
+        }
+    }
+    void SoftwareRenderDevice::DrawString(const std::wstring& text, RenderTextFormat* format, const RectF& layoutBox, const Color& color) {
+        if (color.a <= 0.f || text.empty()) return;
+        const TextFormatDesc& desc = static_cast<SoftwareTextFormat*>(format)->desc;
+        const float unit = desc.size / UnitsPerEm;
+        if (unit <= 0.f) return;
+        const float advance = GlyphAdvance * unit;
+        const float lineHeight = LineHeight * unit;
+        const float boxWidth = layoutBox.right - layoutBox.left;
+        const float boxHeight = layoutBox.bottom - layoutBox.top;
+
+        //the last glyph on a line has no spacing after it
+        const float fitting = (boxWidth + (GlyphAdvance - GlyphColumns) * unit) / advance;
+        std::vector<std::wstring> lines;
+        WrapText(text, fitting > 0.f ? static_cast<size_t>(fitting) : 0, lines);
+
+        //text is not clipped to the layout box, same as directwrite
+        const float textHeight = lines.size() * lineHeight;
+        float y = layoutBox.top;
+        if (desc.vAlign == VAlign::CENTER) y += (boxHeight - textHeight) / 2;
+        else if (desc.vAlign == VAlign::BOTTOM) y += boxHeight - textHeight;
+
+        for (const std::wstring& line : lines) {
+            const float lineWidth = line.empty() ? 0.f : line.size() * advance - (GlyphAdvance - GlyphColumns) * unit;
+            float x = layoutBox.left;
+            //justified text is drawn left aligned
+            if (desc.hAlign == HAlign::CENTER) x += (boxWidth - lineWidth) / 2;
+            else if (desc.hAlign == HAlign::RIGHT) x += boxWidth - lineWidth;
+
+            for (wchar_t character : line) {
+                if (character != L' ') this->RasterGlyph(character, x, y + GlyphTopOffset * unit, unit, color);
+                x += advance;
+            }
+            y += lineHeight;
+        }
+    }
+}
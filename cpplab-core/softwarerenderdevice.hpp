@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "renderdevice.hpp"
+
+namespace cpplab {
+    class SoftwareBitmap : public RenderBitmap {
+    public:
+        PixelBuffer pixels;
+        vec2 GetSize() const override;
+    };
+    class SoftwareTextFormat : public RenderTextFormat {
+    public:
+        TextFormatDesc desc;
+    };
+
+    //cpu rasteriser drawing into an in memory framebuffer, no platform dependencies so it runs headless
+    //the framebuffer is 8 bit premultiplied RGBA, one unit is dpi / 96 pixels like a d2d target of that dpi, one pixel at the default 96
+    //text uses a built in 5x7 bitmap font so output does not depend on installed fonts
+    class SoftwareRenderDevice : public RenderDevice {
+    private:
+        struct PixelRect {
+            int left, top, right, bottom;
+        };
+
+        uint32_t width, height;
+        std::vector<uint8_t> framebuffer;
+        std::vector<float> coverageScratch;
+
+        //the caller's transform, and the one drawing uses with the dpi scale applied after it
+        Transform2D userTransform;
+        Transform2D transform;
+        float pixelsPerUnit = 1.f;
+        std::vector<PixelRect> clipStack;
+
+        PixelRect CurrentClip() const;
+        PixelRect ClipBounds(const RectF& deviceBounds) const;
+        void BlendPixel(int x, int y, const float premultiplied[4], float coverage);
+        void RasterRoundedRect(const RoundedRectF& rect, const Color& color, float strokeWidth, bool stroke);
+        void RasterGlyph(wchar_t character, float x, float y, float unit, const Color& color);
+    public:
+        SoftwareRenderDevice(uint32_t width, uint32_t height);
+
+        //clears the framebuffer to transparent black
+        void Resize(uint32_t width, uint32_t height);
+        //takes effect at the next BeginFrame
+        void SetDpi(unsigned int dpi);
+        uint32_t GetWidth() const {
+            return this->width;
+        }
+        uint32_t GetHeight() const {
+            return this->height;
+        }
+        const std::vector<uint8_t>& GetPixels() const {
+            return this->framebuffer;
+        }
+        //packed as 0xRRGGBBAA
+        uint32_t GetPixel(uint32_t x, uint32_t y) const;
+        //binary ppm, alpha is dropped which is the same as compositing over black
+        bool SavePPM(const std::string& path) const;
+
+        void BeginFrame() override;
+        bool EndFrame() override;
+        vec2 GetSize() const override;
+
+        void Clear(const Color& color) override;
+        void SetTransform(const Transform2D& transform) override;
+        Transform2D GetTransform() const override;
+
+        void PushClip(const RectF& rect) override;
+        void PopClip() override;
+
+        void FillRoundedRect(const RoundedRectF& rect, const Color& color) override;
+        void StrokeRoundedRect(const RoundedRectF& rect, const Color& color, float strokeWidth) override;
+
+        RenderBitmap* CreateBitmap(const PixelBuffer& pixels) override;
+        void UpdateBitmap(RenderBitmap* bitmap, const PixelRegion& region, const uint8_t* pixels, uint32_t stride) override;
+        void DrawBitmap(RenderBitmap* bitmap, const RectF& destination, float opacity) override;
+
+        RenderTextFormat* CreateTextFormat(const TextFormatDesc& desc) override;
+        void DrawString(const std::wstring& text, RenderTextFormat* format, const RectF& layoutBox, const Color& color) override;
+    };
+}
@@ -0,0 +1,106 @@
+#include "spatialindex.hpp"
+#include <cmath>
+
+namespace cpplab {
+    SpatialGridIndex::SpatialGridIndex(float cellSize) {
+        this->cellSize = cellSize > 0.f ? cellSize : DefaultCellSize;
+    }
+
+    int SpatialGridIndex::CellCoord(float v) const {
+        return static_cast<int>(std::floor(v / this->cellSize));
+    }
+    uint64_t SpatialGridIndex::CellKey(int x, int y) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+    }
+
+    void SpatialGridIndex::Unlink(uint32_t id, Entry& entry) {
+        auto eraseFrom = [id](std::vector<uint32_t>& list) {
+            for (size_t i = 0; i < list.size(); ++i) {
+                if (list[i] == id) {
+                    list[i] = list.back();
+                    list.pop_back();
+                    return;
+                }
+            }
+        };
+
+        if (entry.large) {
+            eraseFrom(this->largeEntries);
+        }
+        else {
+            for (int cy = entry.cellY0; cy <= entry.cellY1; ++cy) {
+                for (int cx = entry.cellX0; cx <= entry.cellX1; ++cx) {
+                    auto cell = this->cells.find(CellKey(cx, cy));
+                    if (cell == this->cells.end()) continue;
+                    eraseFrom(cell->second);
+                    if (cell->second.empty()) this->cells.erase(cell);
+                }
+            }
+        }
+        entry.present = false;
+        --this->entryCount;
+    }
+
+    void SpatialGridIndex::Update(uint32_t id, float left, float top, float right, float bottom) {
+        if (id >= this->entries.size()) this->entries.resize(static_cast<size_t>(id) + 1);
+        Entry& entry = this->entries[id];
+
+        const int cellX0 = this->CellCoord(left);
+        const int cellY0 = this->CellCoord(top);
+        const int cellX1 = this->CellCoord(right);
+        const int cellY1 = this->CellCoord(bottom);
+
+        //same cells, only the exact bounds need to change
+        if (entry.present && !entry.large &&
+            entry.cellX0 == cellX0 && entry.cellY0 == cellY0 &&
+            entry.cellX1 == cellX1 && entry.cellY1 == cellY1) {
+            entry.left = left; entry.top = top; entry.right = right; entry.bottom = bottom;
+            return;
+        }
+        if (entry.present) this->Unlink(id, entry);
+
+        entry.present = true;
+        entry.left = left; entry.top = top; entry.right = right; entry.bottom = bottom;
+        entry.cellX0 = cellX0; entry.cellY0 = cellY0;
+        entry.cellX1 = cellX1; entry.cellY1 = cellY1;
+        ++this->entryCount;
+
+        const int64_t cellSpan = static_cast<int64_t>(cellX1 - cellX0 + 1) * static_cast<int64_t>(cellY1 - cellY0 + 1);
+        entry.large = cellSpan > MaxCellsPerEntry;
+        if (entry.large) {
+            this->largeEntries.push_back(id);
+            return;
+        }
+        for (int cy = cellY0; cy <= cellY1; ++cy) {
+            for (int cx = cellX0; cx <= cellX1; ++cx) {
+                this->cells[CellKey(cx, cy)].push_back(id);
+            }
+        }
+    }
+    void SpatialGridIndex::Remove(uint32_t id) {
+        if (id >= this->entries.size() || !this->entries[id].present) return;
+        this->Unlink(id, this->entries[id]);
+    }
+    void SpatialGridIndex::Clear() {
+        this->entries.clear();
+        this->cells.clear();
+        this->largeEntries.clear();
+        this->entryCount = 0;
+    }
+
+    void SpatialGridIndex::Query(float x, float y, std::vector<uint32_t>& out) const {
+        auto contains = [x, y](const Entry& e) {
+            return x >= e.left && x <= e.right && y >= e.top && y <= e.bottom;
+        };
+
+        auto cell = this->cells.find(CellKey(this->CellCoord(x), this->CellCoord(y)));
+        if (cell != this->cells.end()) {
+            for (uint32_t id : cell->second) {
+                if (contains(this->entries[id])) out.push_back(id);
+            }
+        }
+        for (uint32_t id : this->largeEntries) {
+            if (contains(this->entries[id])) out.push_back(id);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <unordered_map>
+
+namespace cpplab {
+    //uniform grid over axis aligned bounds, used as the broad phase for mouse hit testing
+    //entries are identified by their element store index
+    //elements spanning too many cells go into a shared large entry list instead of every cell
+    class SpatialGridIndex {
+    public:
+        static constexpr float DefaultCellSize = 64.f;
+        static constexpr int MaxCellsPerEntry = 64;
+
+    private:
+        struct Entry {
+            bool present = false;
+            bool large = false;
+            int cellX0 = 0, cellY0 = 0, cellX1 = 0, cellY1 = 0;
+            float left = 0.f, top = 0.f, right = 0.f, bottom = 0.f;
+        };
+
+        float cellSize;
+        std::vector<Entry> entries;
+        std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+        std::vector<uint32_t> largeEntries;
+        size_t entryCount = 0;
+
+        int CellCoord(float v) const;
+        static uint64_t CellKey(int x, int y);
+        void Unlink(uint32_t id, Entry& entry);
+
+    public:
+        SpatialGridIndex(float cellSize = DefaultCellSize);
+
+        //inserts or moves an entry
+        void Update(uint32_t id, float left, float top, float right, float bottom);
+        void Remove(uint32_t id);
+        void Clear();
+
+        //appends every entry whose bounds contain the point, borders included
+        void Query(float x, float y, std::vector<uint32_t>& out) const;
+
+        size_t Size() const {
+            return this->entryCount;
+        }
+        size_t LargeEntryCount() const {
+            return this->largeEntries.size();
+        }
+    };
+}
\ No newline at end of file
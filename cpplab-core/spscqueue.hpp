@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <atomic>
+#include <vector>
+
+namespace cpplab {
+    //bounded single producer single consumer queue, pushing and popping never lock or wait
+    //head and tail only grow, a slot is the count modulo the capacity so any capacity works
+    template <class T>
+    class SpscQueue {
+    private:
+        std::vector<T> slots;
+        alignas(64) std::atomic<size_t> head = 0; //next slot to pop, written by the consumer
+        alignas(64) std::atomic<size_t> tail = 0; //next slot to push, written by the producer
+
+    public:
+        explicit SpscQueue(size_t capacity) : slots(capacity > 0 ? capacity : 1) {}
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        //producer only, returns false when full
+        bool TryPush(T value) {
+            const size_t currentTail = this->tail.load(std::memory_order_relaxed);
+            if (currentTail - this->head.load(std::memory_order_acquire) == this->slots.size()) return false;
+            this->slots[currentTail % this->slots.size()] = std::move(value);
+            this->tail.store(currentTail + 1, std::memory_order_release);
+            return true;
+        }
+        //consumer only, returns false when empty
+        bool TryPop(T& out) {
+            const size_t currentHead = this->head.load(std::memory_order_relaxed);
+            if (currentHead == this->tail.load(std::memory_order_acquire)) return false;
+            out = std::move(this->slots[currentHead % this->slots.size()]);
+            this->head.store(currentHead + 1, std::memory_order_release);
+            return true;
+        }
+
+        //a snapshot, exact only on the producer or consumer thread while the other side is idle
+        size_t Size() const {
+            return this->tail.load(std::memory_order_acquire) - this->head.load(std::memory_order_acquire);
+        }
+        bool IsFull() const {
+            return this->Size() == this->slots.size();
+        }
+        size_t Capacity() const {
+            return this->slots.size();
+        }
+    };
+}
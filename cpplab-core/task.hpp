@@ -0,0 +1,145 @@
+#pragma once
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace cpplab {
+    class UiScheduler;
+    template <class T> class Task;
+
+    //what every task promise carries, a task only needs the list links once UiScheduler::Spawn owns it
+    struct TaskPromiseBase {
+        //the coroutine awaiting this task, resumed when it finishes
+        std::coroutine_handle<> continuation;
+        std::exception_ptr exception;
+        UiScheduler* scheduler = nullptr;
+        TaskPromiseBase* previousSpawned = nullptr;
+        TaskPromiseBase* nextSpawned = nullptr;
+
+        //tasks start when awaited or spawned, not when called
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+        void unhandled_exception() noexcept {
+            this->exception = std::current_exception();
+        }
+    };
+
+    //hands a finished spawned task back to its scheduler, which destroys it
+    void FinishSpawnedTask(TaskPromiseBase& promise);
+
+    struct TaskFinalAwaiter {
+        bool await_ready() const noexcept {
+            return false;
+        }
+        template <class Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            TaskPromiseBase& promise = handle.promise();
+            //jump straight back into the awaiting coroutine, no stack grows however long the await chain is
+            if (promise.continuation) return promise.continuation;
+            if (promise.scheduler) FinishSpawnedTask(promise);
+            return std::noop_coroutine();
+        }
+        void await_resume() const noexcept {}
+    };
+
+    template <class T>
+    class TaskPromise : public TaskPromiseBase {
+    public:
+        std::optional<T> value;
+
+        Task<T> get_return_object() noexcept;
+        TaskFinalAwaiter final_suspend() noexcept {
+            return {};
+        }
+        template <class U>
+        void return_value(U&& result) {
+            this->value.emplace(std::forward<U>(result));
+        }
+    };
+    template <>
+    class TaskPromise<void> : public TaskPromiseBase {
+    public:
+        Task<void> get_return_object() noexcept;
+        TaskFinalAwaiter final_suspend() noexcept {
+            return {};
+        }
+        void return_void() noexcept {}
+    };
+
+    //a lazily started coroutine returning T, co_await it from another task or hand a Task<void> to UiScheduler::Spawn
+    //owns its coroutine frame, destroying an unfinished task destroys the frame without resuming it
+    //exceptions thrown inside come out of the co_await, a spawned task's come out of the loop that resumed it
+    template <class T = void>
+    class [[nodiscard]] Task {
+        friend class TaskPromise<T>;
+        friend class UiScheduler;
+    public:
+        using promise_type = TaskPromise<T>;
+
+    private:
+        std::coroutine_handle<promise_type> handle;
+
+        explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+        std::coroutine_handle<promise_type> Release() {
+            return std::exchange(this->handle, nullptr);
+        }
+
+    public:
+        Task() = default;
+        Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+        Task& operator=(Task&& other) noexcept {
+            if (this != &other) {
+                if (this->handle) this->handle.destroy();
+                this->handle = std::exchange(other.handle, nullptr);
+            }
+            return *this;
+        }
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+        ~Task() {
+            if (this->handle) this->handle.destroy();
+        }
+
+        bool IsValid() const {
+            return static_cast<bool>(this->handle);
+        }
+        bool IsDone() const {
+            return this->handle && this->handle.done();
+        }
+
+        auto operator co_await() && noexcept {
+            struct Awaiter {
+                std::coroutine_handle<promise_type> handle;
+
+                bool await_ready() const noexcept {
+                    return !this->handle || this->handle.done();
+                }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                    this->handle.promise().continuation = awaiting;
+                    return this->handle;
+                }
+                T await_resume() {
+                    if (!this->handle) throw std::runtime_error("[Cpplab Task] Awaited an empty task");
+                    promise_type& promise = this->handle.promise();
+                    if (promise.exception) std::rethrow_exception(promise.exception);
+                    if constexpr (!std::is_void_v<T>) {
+                        return std::move(*promise.value);
+                    }
+                }
+            };
+            return Awaiter{ this->handle };
+        }
+    };
+
+    template <class T>
+    Task<T> TaskPromise<T>::get_return_object() noexcept {
+        return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+    }
+    inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+        return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+    }
+}
@@ -0,0 +1,67 @@
+#include <cstring>
+#include <functional>
+#include "textformatcache.hpp"
+
+namespace cpplab {
+    size_t TextFormatKeyHash::operator()(const TextFormatKey& key) const {
+        uint32_t sizeBits;
+        std::memcpy(&sizeBits, &key.pointSize, sizeof(sizeBits));
+        uint64_t packed = sizeBits;
+        packed = packed * 31 + key.dpi;
+        packed = packed * 31 + static_cast<uint64_t>(key.fontStyle);
+        packed = packed * 31 + static_cast<uint64_t>(key.hAlign);
+        packed = packed * 31 + static_cast<uint64_t>(key.vAlign);
+        return std::hash<uint64_t>()(packed);
+    }
+
+    TextFormatCache::~TextFormatCache() {
+        this->Clear();
+    }
+
+    RenderTextFormat* TextFormatCache::Acquire(const TextFormatKey& key, RenderDevice& device) {
+        ++this->stats.lookups;
+        auto found = this->entries.find(key);
+        if (found != this->entries.end()) {
+            ++this->stats.hits;
+            ++found->second.references;
+            ++this->liveReferences;
+            return found->second.format;
+        }
+
+        ++this->stats.misses;
+        Entry entry;
+        entry.format = device.CreateTextFormat(key.ToDesc());
+        entry.references = 1;
+        this->entries.emplace(key, entry);
+        ++this->liveReferences;
+        return entry.format;
+    }
+    void TextFormatCache::Release(const TextFormatKey& key) {
+        auto found = this->entries.find(key);
+        if (found == this->entries.end()) return;
+
+        --this->liveReferences;
+        if (--found->second.references == 0) {
+            delete found->second.format;
+            this->entries.erase(found);
+            ++this->stats.released;
+        }
+    }
+    void TextFormatCache::Clear() {
+        for (auto& [key, entry] : this->entries) {
+            delete entry.format;
+        }
+        this->entries.clear();
+        this->liveReferences = 0;
+    }
+
+    TextFormatCacheStats TextFormatCache::GetStats() const {
+        TextFormatCacheStats current = this->stats;
+        current.liveEntries = this->entries.size();
+        current.liveReferences = this->liveReferences;
+        return current;
+    }
+    void TextFormatCache::ResetStats() {
+        this->stats = TextFormatCacheStats();
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+#include "renderdevice.hpp"
+
+namespace cpplab {
+    //everything a text format depends on, the color and text itself are not part of it
+    struct TextFormatKey {
+        FontStyle fontStyle = FontStyle::Arial;
+        float pointSize = 12.f;
+        unsigned int dpi = 96;
+        HAlign hAlign = HAlign::LEFT;
+        VAlign vAlign = VAlign::TOP;
+
+        TextFormatDesc ToDesc() const {
+            TextFormatDesc desc;
+            desc.fontStyle = this->fontStyle;
+            desc.size = (this->pointSize * 96.f) / this->dpi;
+            desc.hAlign = this->hAlign;
+            desc.vAlign = this->vAlign;
+            return desc;
+        }
+        bool operator==(const TextFormatKey& rhs) const {
+            return this->fontStyle == rhs.fontStyle && this->pointSize == rhs.pointSize && this->dpi == rhs.dpi &&
+                   this->hAlign == rhs.hAlign && this->vAlign == rhs.vAlign;
+        }
+        bool operator!=(const TextFormatKey& rhs) const {
+            return !(this->operator==(rhs));
+        }
+    };
+    struct TextFormatKeyHash {
+        size_t operator()(const TextFormatKey& key) const;
+    };
+
+    struct TextFormatCacheStats {
+        uint64_t lookups = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        //formats deleted because their last user released them
+        uint64_t released = 0;
+        size_t liveEntries = 0;
+        size_t liveReferences = 0;
+
+        double HitRate() const {
+            return this->lookups == 0 ? 0.0 : static_cast<double>(this->hits) / this->lookups;
+        }
+    };
+
+    //reference counted text formats shared by every element with the same key
+    //formats are created through whichever device asks first and deleted when the last user releases them
+    class TextFormatCache {
+    private:
+        struct Entry {
+            RenderTextFormat* format = nullptr;
+            uint32_t references = 0;
+        };
+
+        std::unordered_map<TextFormatKey, Entry, TextFormatKeyHash> entries;
+        TextFormatCacheStats stats;
+        size_t liveReferences = 0;
+
+    public:
+        TextFormatCache() = default;
+        TextFormatCache(const TextFormatCache&) = delete;
+        TextFormatCache& operator=(const TextFormatCache&) = delete;
+        ~TextFormatCache();
+
+        //adds a reference, every Acquire needs a matching Release
+        RenderTextFormat* Acquire(const TextFormatKey& key, RenderDevice& device);
+        void Release(const TextFormatKey& key);
+        //deletes every format regardless of references, used when the device is lost
+        void Clear();
+
+        TextFormatCacheStats GetStats() const;
+        void ResetStats();
+        size_t Size() const {
+            return this->entries.size();
+        }
+    };
+}
@@ -0,0 +1,146 @@
+#include "uischeduler.hpp"
+#include <algorithm>
+
+namespace cpplab {
+    void FinishSpawnedTask(TaskPromiseBase& promise) {
+        promise.scheduler->Finish(promise);
+    }
+
+    bool UiScheduler::ImageAwaiter::await_ready() {
+        if (this->scheduler->imageCache == nullptr) {
+            this->result.state = ImageRequestState::FAILED;
+            return true;
+        }
+        this->result.state = this->scheduler->imageCache->Request(this->key, this->result.pixels);
+        return this->result.state != ImageRequestState::PENDING;
+    }
+    void UiScheduler::UiThreadAwaiter::await_suspend(std::coroutine_handle<> handle) {
+        UiScheduler* scheduler = this->scheduler;
+        scheduler->uiTasks->Post([scheduler, handle]() {
+            scheduler->Resume(handle);
+            scheduler->RethrowPending();
+        });
+    }
+
+    UiScheduler::UiScheduler(UiTaskQueue* uiTasks, FrameScheduler* frameScheduler, ImageCache* imageCache) {
+        this->uiTasks = uiTasks;
+        this->frameScheduler = frameScheduler;
+        this->imageCache = imageCache;
+    }
+    UiScheduler::~UiScheduler() {
+        //the waiter lists only point into frames owned by the spawned tasks
+        this->frameWaiters.clear();
+        this->timers.clear();
+        this->imageWaiters.clear();
+        while (this->spawnedTasks != nullptr) {
+            TaskPromiseBase* promise = this->spawnedTasks;
+            this->spawnedTasks = promise->nextSpawned;
+            //destroying the root destroys the tasks it is awaiting with it
+            std::coroutine_handle<TaskPromise<void>>::from_promise(static_cast<TaskPromise<void>&>(*promise)).destroy();
+        }
+    }
+
+    void UiScheduler::SetImageCache(ImageCache* imageCache) {
+        this->imageCache = imageCache;
+    }
+
+    void UiScheduler::Spawn(Task<void> task) {
+        if (!task.IsValid()) return;
+        std::coroutine_handle<TaskPromise<void>> handle = task.Release();
+        TaskPromise<void>& promise = handle.promise();
+        promise.scheduler = this;
+        promise.nextSpawned = this->spawnedTasks;
+        if (this->spawnedTasks) this->spawnedTasks->previousSpawned = &promise;
+        this->spawnedTasks = &promise;
+        ++this->liveTasks;
+        ++this->tasksSpawned;
+
+        this->Resume(handle);
+        this->RethrowPending();
+    }
+    void UiScheduler::Finish(TaskPromiseBase& promise) {
+        if (promise.previousSpawned) promise.previousSpawned->nextSpawned = promise.nextSpawned;
+        else this->spawnedTasks = promise.nextSpawned;
+        if (promise.nextSpawned) promise.nextSpawned->previousSpawned = promise.previousSpawned;
+        --this->liveTasks;
+        ++this->tasksFinished;
+
+        if (promise.exception && !this->pendingException) this->pendingException = promise.exception;
+        std::coroutine_handle<TaskPromise<void>>::from_promise(static_cast<TaskPromise<void>&>(promise)).destroy();
+    }
+
+    void UiScheduler::AddTimer(Clock::time_point deadline, std::coroutine_handle<> handle) {
+        this->timers.push_back(Timer{ deadline, handle });
+        std::push_heap(this->timers.begin(), this->timers.end(), &UiScheduler::LaterDeadline);
+        this->frameScheduler->RequestFrameAt(deadline);
+    }
+    bool UiScheduler::LaterDeadline(const Timer& lhs, const Timer& rhs) {
+        return lhs.deadline > rhs.deadline;
+    }
+    void UiScheduler::Resume(std::coroutine_handle<> handle) {
+        ++this->resumes;
+        ++this->resumeDepth;
+        handle.resume();
+        --this->resumeDepth;
+    }
+    void UiScheduler::RethrowPending() {
+        //a task spawning another from inside a resume must not get an unrelated task's exception
+        if (!this->pendingException || this->resumeDepth > 0) return;
+        std::exception_ptr exception = std::exchange(this->pendingException, nullptr);
+        std::rethrow_exception(exception);
+    }
+
+    void UiScheduler::RunFrame() {
+        const Clock::time_point now = this->frameScheduler->Now();
+
+        //collect everything first, tasks waiting again from inside this batch go into the next one
+        this->resumeScratch.swap(this->frameWaiters);
+        while (!this->timers.empty() && this->timers.front().deadline <= now) {
+            std::pop_heap(this->timers.begin(), this->timers.end(), &UiScheduler::LaterDeadline);
+            this->resumeScratch.push_back(this->timers.back().handle);
+            this->timers.pop_back();
+        }
+        if (this->imageCache && !this->imageWaiters.empty()) {
+            //read before asking again, a decode finishing in between bumps it past what was seen
+            const uint64_t completions = this->imageCache->CompletionVersion();
+            if (completions != this->seenImageCompletions) {
+                this->seenImageCompletions = completions;
+                for (size_t i = 0; i < this->imageWaiters.size();) {
+                    ImageAwaiter& awaiter = *this->imageWaiters[i].awaiter;
+                    awaiter.result.state = this->imageCache->Request(awaiter.key, awaiter.result.pixels);
+                    if (awaiter.result.state == ImageRequestState::PENDING) {
+                        ++i;
+                        continue;
+                    }
+                    this->resumeScratch.push_back(this->imageWaiters[i].handle);
+                    this->imageWaiters[i] = this->imageWaiters.back();
+                    this->imageWaiters.pop_back();
+                }
+            }
+        }
+
+        for (std::coroutine_handle<> handle : this->resumeScratch) {
+            this->Resume(handle);
+        }
+        this->resumeScratch.clear();
+        //the frame took the timed request that brought it, the timers left need theirs again
+        if (!this->timers.empty()) this->frameScheduler->RequestFrameAt(this->timers.front().deadline);
+        this->RethrowPending();
+    }
+
+    bool UiScheduler::NeedsFrame() const {
+        return this->imageCache && !this->imageWaiters.empty() && this->imageCache->CompletionVersion() != this->seenImageCompletions;
+    }
+
+    UiSchedulerStats UiScheduler::GetStats() const {
+        UiSchedulerStats stats;
+        stats.liveTasks = this->liveTasks;
+        stats.tasksSpawned = this->tasksSpawned;
+        stats.tasksFinished = this->tasksFinished;
+        stats.resumes = this->resumes;
+        stats.frameWaiters = this->frameWaiters.size();
+        stats.timerWaiters = this->timers.size();
+        stats.imageWaiters = this->imageWaiters.size();
+        return stats;
+    }
+}
@@ -0,0 +1,168 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <vector>
+#include "task.hpp"
+#include "uitaskqueue.hpp"
+#include "framescheduler.hpp"
+#include "imagecache.hpp"
+
+namespace cpplab {
+    struct ImageLoadResult {
+        ImageRequestState state = ImageRequestState::PENDING;
+        std::shared_ptr<const PixelBuffer> pixels;
+    };
+
+    struct UiSchedulerStats {
+        //spawned tasks that have not finished yet
+        size_t liveTasks = 0;
+        uint64_t tasksSpawned = 0;
+        uint64_t tasksFinished = 0;
+        uint64_t resumes = 0;
+        size_t frameWaiters = 0;
+        size_t timerWaiters = 0;
+        size_t imageWaiters = 0;
+    };
+
+    //runs coroutines on the ui thread, resumed by the engine's loop rather than by threads of their own
+    //a suspended task costs its coroutine frame and one entry in the list it waits on
+    //time comes from the frame scheduler, awaiting a frame or timer asks it for one
+    //everything except ResumeOnUiThread is ui thread only
+    class UiScheduler {
+    public:
+        using Clock = FrameClock::Clock;
+
+        struct NextFrameAwaiter {
+            UiScheduler* scheduler;
+
+            bool await_ready() const noexcept {
+                return false;
+            }
+            void await_suspend(std::coroutine_handle<> handle) {
+                this->scheduler->frameWaiters.push_back(handle);
+                this->scheduler->frameScheduler->RequestFrame();
+            }
+            //the frame scheduler's current frame, copy it to keep it past the next frame
+            const FrameInfo& await_resume() const noexcept {
+                return this->scheduler->frameScheduler->GetCurrentFrame();
+            }
+        };
+        struct DelayAwaiter {
+            UiScheduler* scheduler;
+            Clock::duration duration;
+
+            bool await_ready() const noexcept {
+                return this->duration <= Clock::duration::zero();
+            }
+            void await_suspend(std::coroutine_handle<> handle) {
+                this->scheduler->AddTimer(this->scheduler->frameScheduler->Now() + this->duration, handle);
+            }
+            void await_resume() const noexcept {}
+        };
+        struct ImageAwaiter {
+            UiScheduler* scheduler;
+            ImageKey key;
+            ImageLoadResult result;
+
+            bool await_ready();
+            void await_suspend(std::coroutine_handle<> handle) {
+                this->scheduler->imageWaiters.push_back(ImageWaiter{ this, handle });
+            }
+            ImageLoadResult await_resume() {
+                return std::move(this->result);
+            }
+        };
+        struct UiThreadAwaiter {
+            UiScheduler* scheduler;
+
+            bool await_ready() const noexcept {
+                return false;
+            }
+            void await_suspend(std::coroutine_handle<> handle);
+            void await_resume() const noexcept {}
+        };
+
+    private:
+        struct Timer {
+            Clock::time_point deadline;
+            std::coroutine_handle<> handle;
+        };
+        //the awaiter lives in the suspended coroutine's frame, the result is written straight into it
+        struct ImageWaiter {
+            ImageAwaiter* awaiter;
+            std::coroutine_handle<> handle;
+        };
+
+        UiTaskQueue* uiTasks;
+        FrameScheduler* frameScheduler;
+        ImageCache* imageCache;
+
+        std::vector<std::coroutine_handle<>> frameWaiters;
+        //min heap on the deadline
+        std::vector<Timer> timers;
+        std::vector<ImageWaiter> imageWaiters;
+        uint64_t seenImageCompletions = 0;
+        std::vector<std::coroutine_handle<>> resumeScratch;
+
+        //spawned tasks still running, so they can be destroyed with the scheduler
+        TaskPromiseBase* spawnedTasks = nullptr;
+        //the first exception a spawned task ended with, thrown once the resuming batch is done
+        std::exception_ptr pendingException;
+        //tasks being resumed right now, nested through Spawn
+        int resumeDepth = 0;
+
+        size_t liveTasks = 0;
+        uint64_t tasksSpawned = 0;
+        uint64_t tasksFinished = 0;
+        uint64_t resumes = 0;
+
+        friend void FinishSpawnedTask(TaskPromiseBase& promise);
+        void Finish(TaskPromiseBase& promise);
+        static bool LaterDeadline(const Timer& lhs, const Timer& rhs);
+        void AddTimer(Clock::time_point deadline, std::coroutine_handle<> handle);
+        void Resume(std::coroutine_handle<> handle);
+        void RethrowPending();
+
+    public:
+        //uiTasks carries resumes from other threads, the image cache may be null and set later
+        UiScheduler(UiTaskQueue* uiTasks, FrameScheduler* frameScheduler, ImageCache* imageCache);
+        UiScheduler(const UiScheduler&) = delete;
+        UiScheduler& operator=(const UiScheduler&) = delete;
+        //destroys unfinished tasks without resuming them, resumes still queued on the task queue must be dropped first
+        ~UiScheduler();
+
+        void SetImageCache(ImageCache* imageCache);
+
+        //starts the task right away, it runs until its first suspension before Spawn returns
+        void Spawn(Task<void> task);
+
+        //resumes with the next frame and returns its info
+        NextFrameAwaiter NextFrame() {
+            return NextFrameAwaiter{ this };
+        }
+        //resumes with the first frame after the duration passed
+        DelayAwaiter Delay(Clock::duration duration) {
+            return DelayAwaiter{ this, duration };
+        }
+        //requests the image from the cache and resumes once it is ready or failed, without a cache it fails right away
+        ImageAwaiter ImageLoaded(const ImageKey& key) {
+            return ImageAwaiter{ this, key, ImageLoadResult() };
+        }
+        //any thread, continues on the ui thread at its next task drain
+        UiThreadAwaiter ResumeOnUiThread() {
+            return UiThreadAwaiter{ this };
+        }
+
+        //ui thread, once per frame after the task queue was drained
+        //resumes the frame waiters, due timers and waiters whose image finished
+        //rethrows the first exception a spawned task ended with
+        void RunFrame();
+        //true when an image a task waits on may have finished, the loop asks for a frame then
+        bool NeedsFrame() const;
+        UiSchedulerStats GetStats() const;
+    };
+}
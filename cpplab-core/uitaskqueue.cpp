@@ -0,0 +1,85 @@
+#include "uitaskqueue.hpp"
+
+namespace cpplab {
+    namespace {
+        uint64_t MicrosecondsBetween(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+            if (end <= start) return 0;
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+        }
+    }
+
+    void UiTaskQueue::SetWakeCallback(std::function<void()> callback) {
+        this->wakeCallback = std::move(callback);
+    }
+
+    void UiTaskQueue::Post(std::function<void()> task) {
+        this->Enqueue(std::move(task), true);
+    }
+    void UiTaskQueue::PostForFrame(std::function<void()> task) {
+        this->Enqueue(std::move(task), false);
+    }
+
+    void UiTaskQueue::Enqueue(std::function<void()> task, bool wake) {
+        //counted before it is linked so a drain never pops more than the depth says
+        this->depth.fetch_add(1, std::memory_order_acq_rel);
+        this->tasksPosted.fetch_add(1, std::memory_order_relaxed);
+        this->queue.Push(Task{ std::move(task), std::chrono::steady_clock::now() });
+
+        //only the first post after a drain wakes the loop, the rest of the burst goes with it
+        if (!wake || this->wakePending.exchange(true, std::memory_order_acq_rel)) return;
+        this->wakes.fetch_add(1, std::memory_order_relaxed);
+        if (this->wakeCallback) this->wakeCallback();
+    }
+
+    size_t UiTaskQueue::Drain() {
+        //cleared first, a post from here on wakes the loop again and runs in the next drain
+        this->wakePending.store(false, std::memory_order_release);
+        const size_t pending = this->depth.load(std::memory_order_acquire);
+        if (pending == 0) return 0;
+
+        const auto start = std::chrono::steady_clock::now();
+        if (pending > this->maxDepth.load(std::memory_order_relaxed)) {
+            this->maxDepth.store(pending, std::memory_order_relaxed);
+        }
+
+        size_t run = 0;
+        Task task;
+        //stops at the depth seen above so tasks posting more tasks cannot keep the frame from finishing
+        //a push still linking looks like the end, it runs next time
+        while (run < pending && this->queue.TryPop(task)) {
+            this->depth.fetch_sub(1, std::memory_order_acq_rel);
+            if (run == 0) {
+                const uint64_t latency = MicrosecondsBetween(task.posted, start);
+                this->lastDrainLatencyMicroseconds.store(latency, std::memory_order_relaxed);
+                if (latency > this->maxDrainLatencyMicroseconds.load(std::memory_order_relaxed)) {
+                    this->maxDrainLatencyMicroseconds.store(latency, std::memory_order_relaxed);
+                }
+            }
+            ++run;
+            this->tasksRun.fetch_add(1, std::memory_order_relaxed);
+            if (task.run) task.run();
+            task.run = nullptr;
+        }
+
+        const uint64_t elapsed = MicrosecondsBetween(start, std::chrono::steady_clock::now());
+        this->lastDrainMicroseconds.store(elapsed, std::memory_order_relaxed);
+        this->drainMicroseconds.fetch_add(elapsed, std::memory_order_relaxed);
+        this->drains.fetch_add(1, std::memory_order_relaxed);
+        return run;
+    }
+
+    UiTaskQueueStats UiTaskQueue::GetStats() const {
+        UiTaskQueueStats stats;
+        stats.tasksPosted = this->tasksPosted.load(std::memory_order_relaxed);
+        stats.tasksRun = this->tasksRun.load(std::memory_order_relaxed);
+        stats.drains = this->drains.load(std::memory_order_relaxed);
+        stats.wakes = this->wakes.load(std::memory_order_relaxed);
+        stats.depth = this->depth.load(std::memory_order_relaxed);
+        stats.maxDepth = this->maxDepth.load(std::memory_order_relaxed);
+        stats.lastDrainLatencyMicroseconds = this->lastDrainLatencyMicroseconds.load(std::memory_order_relaxed);
+        stats.maxDrainLatencyMicroseconds = this->maxDrainLatencyMicroseconds.load(std::memory_order_relaxed);
+        stats.lastDrainMicroseconds = this->lastDrainMicroseconds.load(std::memory_order_relaxed);
+        stats.drainMicroseconds = this->drainMicroseconds.load(std::memory_order_relaxed);
+        return stats;
+    }
+}
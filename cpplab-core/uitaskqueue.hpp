@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include "mpscqueue.hpp"
+
+namespace cpplab {
+    struct UiTaskQueueStats {
+        uint64_t tasksPosted = 0;
+        uint64_t tasksRun = 0;
+        uint64_t drains = 0;
+        //wakes sent to the ui loop, a burst of posts between two drains sends one
+        uint64_t wakes = 0;
+        size_t depth = 0;
+        //deepest the queue was when a drain started
+        size_t maxDepth = 0;
+        //how long the oldest task of a drain waited to run
+        uint64_t lastDrainLatencyMicroseconds = 0;
+        uint64_t maxDrainLatencyMicroseconds = 0;
+        //time spent running tasks
+        uint64_t lastDrainMicroseconds = 0;
+        uint64_t drainMicroseconds = 0;
+    };
+
+    //work other threads hand to the ui thread, run in the order it was posted
+    //the ui loop drains it once per frame before changes are collected, so a burst of updates costs one repaint
+    //tasks still queued when the queue is destroyed are dropped without running
+    class UiTaskQueue {
+    private:
+        struct Task {
+            std::function<void()> run;
+            std::chrono::steady_clock::time_point posted;
+        };
+
+        MpscQueue<Task> queue;
+        std::atomic<size_t> depth = 0;
+        //set by the first post that wakes the ui loop after a drain
+        std::atomic<bool> wakePending = false;
+        std::function<void()> wakeCallback;
+
+        std::atomic<uint64_t> tasksPosted = 0;
+        std::atomic<uint64_t> tasksRun = 0;
+        std::atomic<uint64_t> drains = 0;
+        std::atomic<uint64_t> wakes = 0;
+        std::atomic<size_t> maxDepth = 0;
+        std::atomic<uint64_t> lastDrainLatencyMicroseconds = 0;
+        std::atomic<uint64_t> maxDrainLatencyMicroseconds = 0;
+        std::atomic<uint64_t> lastDrainMicroseconds = 0;
+        std::atomic<uint64_t> drainMicroseconds = 0;
+
+        void Enqueue(std::function<void()> task, bool wake);
+
+    public:
+        UiTaskQueue() = default;
+        UiTaskQueue(const UiTaskQueue&) = delete;
+        UiTaskQueue& operator=(const UiTaskQueue&) = delete;
+
+        //runs on the posting thread, set it before any thread posts
+        void SetWakeCallback(std::function<void()> callback);
+
+        //any thread, runs at the next drain and wakes the ui loop if it is waiting
+        void Post(std::function<void()> task);
+        //any thread, runs at the next drain without waking the ui loop, it goes with whatever frame comes next
+        void PostForFrame(std::function<void()> task);
+
+        //ui thread, runs the tasks posted before it started, tasks they post wait for the next drain
+        //returns the number of tasks run
+        size_t Drain();
+        size_t Depth() const {
+            return this->depth.load(std::memory_order_acquire);
+        }
+        UiTaskQueueStats GetStats() const;
+    };
+}
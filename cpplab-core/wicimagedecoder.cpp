@@ -0,0 +1,273 @@
+#include "wicimagedecoder.hpp"
+#include "windowrenderer.hpp"
+
+namespace cpplab {
+
+    std::string wstr_to_utf8(const std::wstring& wstr)
+    {
+        int wstr_len = (int)wcslen(wstr.c_str());
+        int num_chars = WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), wstr_len, NULL, 0, NULL, NULL);
+        CHAR* strTo = (CHAR*)malloc((num_chars + 1) * sizeof(CHAR));
+        if (strTo)
+        {
+            WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), wstr_len, strTo, num_chars, NULL, NULL);
+            strTo[num_chars] = '\0';
+        }
+
+        std::string ret(strTo);
+        free(strTo);
+        return ret;
+    }
+
+    namespace {
+        //image cache workers call Decode from their own threads, each needs com initialized once
+        //a thread that already joined another apartment keeps it
+        struct ComThreadScope {
+            HRESULT hr;
+            ComThreadScope() {
+                this->hr = CoInitializeEx(NULL, COINIT_MULTITHREADED);
+            }
+            ~ComThreadScope() {
+                if (SUCCEEDED(this->hr)) CoUninitialize();
+            }
+        };
+    }
+
+    WICImageDecoder::WICImageDecoder() {
+        this->wicImgFactory = NULL;
+
+        //wicimg factory
+        CoInitialize(NULL);
+        HRESULT hr = CoCreateInstance(
+            CLSID_WICImagingFactory,
+            NULL,
+            CLSCTX_INPROC_SERVER,
+            IID_PPV_ARGS(&(this->wicImgFactory))
+        );
+        if (FAILED(hr)) {
+            throw std::runtime_error("[Cpplab Renderer] During WIC Initialization: Failure creating WIC Imaging Factory!");
+        }
+    }
+    WICImageDecoder::~WICImageDecoder() {
+        SafeRelease(&this->wicImgFactory);
+    }
+
+    void WICImageDecoder::DecodeFrame(IWICBitmapDecoder* decoder, const std::wstring& imageName, const char* source, const ImageDecodeSize& size,
+        PixelBuffer& out, ImageDecodeInfo& info) {
+        IWICBitmapFrameDecode* decFrame = nullptr;
+        HRESULT hr = decoder->GetFrame(0, &decFrame);
+        if (FAILED(hr)) {
+            std::stringstream ss;
+            ss << "[Cpplab Renderer] During WIC Image Decoder Frame Retrieval: Failed to retrieve image frame for " << source << " " <<
+                wstr_to_utf8(imageName);
+            SafeRelease(&decFrame);
+            throw std::runtime_error(ss.str());
+        }
+
+        //scale while decoding, the scaler pulls rows from the frame so the full resolution image is never held at once
+        UINT sourceWidth = 0, sourceHeight = 0;
+        hr = decFrame->GetSize(&sourceWidth, &sourceHeight);
+        if (FAILED(hr)) {
+            std::stringstream ss;
+            ss << "[Cpplab Renderer] During WIC Image Decoder Frame Retrieval: Failed to read the image size for " << source << " " <<
+                wstr_to_utf8(imageName);
+            SafeRelease(&decFrame);
+            throw std::runtime_error(ss.str());
+        }
+        info.sourceWidth = sourceWidth;
+        info.sourceHeight = sourceHeight;
+
+        uint32_t decodeWidth, decodeHeight;
+        GetScaledDecodeSize(sourceWidth, sourceHeight, size, decodeWidth, decodeHeight);
+        IWICBitmapSource* frameSource = decFrame;
+        IWICBitmapScaler* scaler = nullptr;
+        if (decodeWidth != sourceWidth || decodeHeight != sourceHeight) {
+            hr = wicImgFactory->CreateBitmapScaler(&scaler);
+            if (SUCCEEDED(hr)) {
+                hr = scaler->Initialize(decFrame, decodeWidth, decodeHeight, WICBitmapInterpolationModeFant);
+            }
+            if (FAILED(hr)) {
+                std::stringstream ss;
+                ss << "[Cpplab Renderer] During WIC Bitmap Scaler creation: Failed to scale " << source << " " <<
+                    wstr_to_utf8(imageName);
+                SafeRelease(&decFrame);
+                SafeRelease(&scaler);
+                throw std::runtime_error(ss.str());
+            }
+            frameSource = scaler;
+        }
+
+        IWICFormatConverter* converter = nullptr;
+        hr = wicImgFactory->CreateFormatConverter(&converter);
+        if (FAILED(hr)) {
+            SafeRelease(&decFrame);
+            SafeRelease(&scaler);
+            SafeRelease(&converter);
+            throw std::runtime_error("[Cpplab Renderer] During WIC Format Converter creation: Failed to create WICFormatConverter!");
+        }
+
+        //premultiplied rgba so every render device can take the pixels as they are
+        hr = converter->Initialize(
+            frameSource,
+            GUID_WICPixelFormat32bppPRGBA,
+            WICBitmapDitherTypeNone,
+            NULL,
+            0.f,
+            WICBitmapPaletteTypeMedianCut
+        );
+        if (FAILED(hr)) {
+            std::stringstream ss;
+            ss << "[Cpplab Renderer] During WIC Format Converter creation: Failed to initialize WICFormatConverter for " << source << " " <<
+                wstr_to_utf8(imageName);
+            SafeRelease(&decFrame);
+            SafeRelease(&scaler);
+            SafeRelease(&converter);
+            throw std::runtime_error(ss.str());
+        }
+
+        UINT width = 0, height = 0;
+        hr = converter->GetSize(&width, &height);
+        if (SUCCEEDED(hr)) {
+            out.width = width;
+            out.height = height;
+            out.pixels.resize(static_cast<size_t>(width) * height * 4);
+            hr = converter->CopyPixels(
+                NULL,
+                width * 4,
+                static_cast<UINT>(out.pixels.size()),
+                out.pixels.data()
+            );
+        }
+        if (FAILED(hr)) {
+            std::stringstream ss;
+            ss << "[Cpplab Renderer] During WIC Pixel Copy: Failed to copy decoded pixels for " << source << " " <<
+                wstr_to_utf8(imageName);
+            SafeRelease(&decFrame);
+            SafeRelease(&scaler);
+            SafeRelease(&converter);
+            throw std::runtime_error(ss.str());
+        }
+        SafeRelease(&decFrame);
+        SafeRelease(&scaler);
+        SafeRelease(&converter);
+    }
+
+    void WICImageDecoder::Decode(const std::wstring& imageName, ImageType type, PixelBuffer& out) {
+        ImageDecodeInfo info;
+        this->DecodeToSize(imageName, type, ImageDecodeSize(), out, info);
+    }
+    void WICImageDecoder::DecodeToSize(const std::wstring& imageName, ImageType type, const ImageDecodeSize& size, PixelBuffer& out, ImageDecodeInfo& info) {
+        thread_local ComThreadScope comScope;
+        if (type == ImageType::FILE) {
+            IWICBitmapDecoder* decoder = nullptr;
+            HRESULT hr = this->wicImgFactory->CreateDecoderFromFilename(
+                imageName.c_str(),
+                NULL,
+                GENERIC_READ,
+                WICDecodeMetadataCacheOnLoad,
+                &decoder
+            );
+            if (FAILED(hr)) {
+                std::stringstream ss;
+                ss << "[Cpplab Renderer] During WIC Image Decoder Creation: Failed to create image decoder for file " <<
+                    wstr_to_utf8(imageName);
+                SafeRelease(&decoder);
+                throw std::runtime_error(ss.str());
+            }
+
+            try {
+                this->DecodeFrame(decoder, imageName, "file", size, out, info);
+            }
+            catch (...) {
+                SafeRelease(&decoder);
+                throw;
+            }
+            SafeRelease(&decoder);
+        }
+        else if (type == ImageType::RESOURCE) {
+            // Locate the resource.
+            HRSRC imageResHandle = FindResourceW(NULL,
+                imageName.c_str(),
+                RT_BITMAP
+            );
+            if (!imageResHandle) {
+                std::stringstream ss;
+                ss << "[Cpplab Renderer] When finding resource named " <<
+                    wstr_to_utf8(imageName) << ": Could not create resource handle.";
+                throw std::runtime_error(ss.str());
+            }
+
+            HGLOBAL imageResDataHandle = LoadResource(NULL, imageResHandle);
+            if (!imageResDataHandle) {
+                std::stringstream ss;
+                ss << "[Cpplab Renderer] When loading resource named " <<
+                    wstr_to_utf8(imageName) << ": Could not create resource handle.";
+                throw std::runtime_error(ss.str());
+            }
+
+            void* imgfile = LockResource(imageResDataHandle);
+            if (!imgfile) {
+                std::stringstream ss;
+                ss << "[Cpplab Renderer] When locking resource named " <<
+                    wstr_to_utf8(imageName) << ": Could not lock resource.";
+                throw std::runtime_error(ss.str());
+            }
+
+            DWORD imgFileSize = SizeofResource(NULL, imageResHandle);
+            if (!imgFileSize) {
+                std::stringstream ss;
+                ss << "[Cpplab Renderer] When retrieving resource size named " <<
+                    wstr_to_utf8(imageName) << ": Could not get resource size.";
+                throw std::runtime_error(ss.str());
+            }
+
+            IWICStream* wicstream = nullptr;
+            HRESULT hr = this->wicImgFactory->CreateStream(&wicstream);
+            if (FAILED(hr)) {
+                std::stringstream ss;
+                ss << "[Cpplab Renderer] When creating WICStream for resource named " <<
+                    wstr_to_utf8(imageName) << ": Could not create stream.";
+                throw std::runtime_error(ss.str());
+            }
+
+            hr = wicstream->InitializeFromMemory(
+                reinterpret_cast<BYTE*>(imgfile),
+                imgFileSize
+            );
+            if (FAILED(hr)) {
+                std::stringstream ss;
+                ss << "[Cpplab Renderer] When initializing WICStream for resource named " <<
+                    wstr_to_utf8(imageName) << ": Could not initialize resource stream.";
+                SafeRelease(&wicstream);
+                throw std::runtime_error(ss.str());
+            }
+
+            IWICBitmapDecoder* decoder = nullptr;
+            hr = this->wicImgFactory->CreateDecoderFromStream(
+                wicstream,
+                NULL,
+                WICDecodeMetadataCacheOnLoad,
+                &decoder
+            );
+            if (FAILED(hr)) {
+                std::stringstream ss;
+                ss << "[Cpplab Renderer] During WIC Image Decoder Creation: Failed to create image decoder for resource " <<
+                    wstr_to_utf8(imageName);
+                SafeRelease(&decoder);
+                SafeRelease(&wicstream);
+                throw std::runtime_error(ss.str());
+            }
+
+            try {
+                this->DecodeFrame(decoder, imageName, "resource", size, out, info);
+            }
+            catch (...) {
+                SafeRelease(&decoder);
+                SafeRelease(&wicstream);
+                throw;
+            }
+            SafeRelease(&decoder);
+            SafeRelease(&wicstream);
+        }
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "imagedecoder.hpp"
+#include <Windows.h>
+#include <wincodec.h>
+#include <wincodecsdk.h>
+
+namespace cpplab {
+    std::string wstr_to_utf8(const std::wstring& wstr);
+
+    //decodes files and RT_BITMAP resources with the windows imaging component
+    class WICImageDecoder : public ImageDecoder {
+    private:
+        IWICImagingFactory* wicImgFactory;
+
+        void DecodeFrame(IWICBitmapDecoder* decoder, const std::wstring& imageName, const char* source, const ImageDecodeSize& size,
+            PixelBuffer& out, ImageDecodeInfo& info);
+    public:
+        WICImageDecoder();
+        ~WICImageDecoder();
+
+        void Decode(const std::wstring& imageName, ImageType type, PixelBuffer& out) override;
+        void DecodeToSize(const std::wstring& imageName, ImageType type, const ImageDecodeSize& size, PixelBuffer& out, ImageDecodeInfo& info) override;
+    };
+}
@@ -1,5 +1,4 @@
 #include "windowengine.hpp"
-#include <functional>
 #include <algorithm>
 
 namespace cpplab {
@@ -8,8 +7,11 @@ namespace cpplab {
         this->rootWindowNode = new ElementNode();
         this->windowApp = app;
         this->windowRenderer = new WindowD2DRenderer(windowHWND, this->rootWindowNode, this->windowDPI);
+        this->hitTestJournal = ElementStore::Instance().RegisterBoundsJournal(this->rootWindowNode->handle.index);
     }
     void WindowData::OnDestroy() {
+        ElementStore::Instance().UnregisterBoundsJournal(this->hitTestJournal);
+        delete this->profilerOverlay;
         delete this->rootWindowNode;
         delete this->windowRenderer;
     }
@@ -41,23 +43,60 @@ namespace cpplab {
     }
 
 
+    void WindowData::UpdateHitTestIndex() {
+        ElementStore& store = ElementStore::Instance();
+        const uint32_t rootIndex = this->rootWindowNode->handle.index;
+
+        //the renderer publishes once per frame and fills the bounds journal then
+        //hit testing follows the published tree, the one on screen, and takes no locks
+        if (!store.DrainBoundsJournal(this->hitTestJournal, this->boundsScratch)) {
+            //first use or the journal overflowed, rebuild from a scan of the tree
+            this->hitTestIndex.Clear();
+            store.CollectTreeIndices(rootIndex, this->boundsScratch);
+        }
+
+        //hidden elements take no mouse events, clipped ones only inside their clip, the journal lists every change to either
+        for (uint32_t index : this->boundsScratch) {
+            if (!store.IsInTree(index, rootIndex) || store.WorldHidden(index)) {
+                this->hitTestIndex.Remove(index);
+                continue;
+            }
+            const float left = store.WorldX(index);
+            const float top = store.WorldY(index);
+            RectF bounds(left, top, left + store.Width(index), top + store.Height(index));
+            RectF clip;
+            if (GetPublishedClip(index, clip)) bounds = bounds.Intersection(clip);
+            if (bounds.IsEmpty()) {
+                this->hitTestIndex.Remove(index);
+                continue;
+            }
+            this->hitTestIndex.Update(index, bounds.left, bounds.top, bounds.right, bounds.bottom);
+        }
+    }
+
     void WindowData::ProcessElementMouseEvents(uint8_t prevMouseState, vec2 prevMousePosition) {
 
         //get elements that are under the cursor
         std::set<ElementNode*, SetDepthComparator> currentSet;
         
-        //recursive lambda
-        std::function<void(ElementNode*)> checkNodesClick = [&checkNodesClick, &currentSet, this](ElementNode* currentNode) {
-            if (currentNode->MouseOverCheck(this->mousePosition)) {
-                if (!currentSet.contains(currentNode)) {
+        //ask the spatial index for candidates instead of checking every node
+        {
+            FrameProfiler& profiler = this->windowRenderer->GetProfiler();
+            ProfileScope hitTestScope(profiler, ProfilePhase::HIT_TEST);
+            this->UpdateHitTestIndex();
+            ElementStore& store = ElementStore::Instance();
+            const uint32_t rootIndex = this->rootWindowNode->handle.index;
+            this->hitTestScratch.clear();
+            this->hitTestIndex.Query(this->mousePosition.x, this->mousePosition.y, this->hitTestScratch);
+            profiler.Count(ProfileCounter::HIT_TEST_CANDIDATES, this->hitTestScratch.size());
+            for (uint32_t index : this->hitTestScratch) {
+                if (!store.IsInTree(index, rootIndex)) continue;
+                ElementNode* currentNode = store.PublishedOwner(index);
+                if (currentNode->MouseOverCheck(this->mousePosition)) {
                     currentSet.insert(currentNode);
                 }
             }
-            for (auto& childNodes : currentNode->childNodes) {
-                checkNodesClick(childNodes.second);
-            }
-        };
-        checkNodesClick(this->rootWindowNode);
+        }
 
         //if (currentSet.size() == 0) return;
 
@@ -1,6 +1,11 @@
 #include "windowengine.hpp"
 #include <Windows.h>
 namespace cpplab {
+    namespace {
+        //used when the display does not report its refresh rate
+        constexpr std::chrono::microseconds DefaultRefreshInterval(16667);
+    }
+
     std::map<HWND, WindowData*> WindowEngine::windowDataMap = std::map<HWND, WindowData*>();
     std::mutex WindowEngine::wDMLock = std::mutex();
 
@@ -31,7 +36,14 @@ namespace cpplab {
                 currentWindowData.windowRenderer->RebuildD2DResources();
                 currentWindowData.windowSize.x = static_cast<float>(width);
                 currentWindowData.windowSize.y = static_cast<float>(height);
+                //element coordinates are client pixels, the renderer scales them to dips when drawing
+                if (currentWindowData.layoutEngine != nullptr) {
+                    currentWindowData.layoutEngine->SetViewport(currentWindowData.windowSize);
+                }
                 currentWindowData.windowApp->OnWindowResize(currentWindowData.windowSize);
+                //the window loop does not run while windows drags the border, so the layout follows the size right here
+                if (currentWindowData.layoutEngine != nullptr) currentWindowData.layoutEngine->RunFrame();
+                if (currentWindowData.scrollLists != nullptr) currentWindowData.scrollLists->RunFrame();
                 return 0;
             }
             break;
@@ -71,7 +83,7 @@ namespace cpplab {
         int nCmdShow,
         const wchar_t* windowName,
         WindowEngineConfiguration conf
-    ) {
+    ) : frameScheduler(&frameClock, DefaultRefreshInterval), layout(&frameScheduler), animations(&frameScheduler), scheduler(&uiTasks, &frameScheduler, nullptr) {
         const wchar_t classname[] = L"Crypt2pWindowClass";
 
         WNDCLASSEXW wc = { };
@@ -149,6 +161,11 @@ namespace cpplab {
         }
 
         this->nCmdShow = nCmdShow;
+        //the loop sleeps in MsgWaitForMultipleObjectsEx, an empty message wakes it and gets it to the drain
+        HWND wakeHandle = this->windowHandle;
+        this->uiTasks.SetWakeCallback([wakeHandle]() {
+            PostMessage(wakeHandle, WM_NULL, 0, 0);
+        });
 
         WindowEngine::wDMLock.lock();
         WindowEngine::windowDataMap.insert({ {this->windowHandle, new WindowData() } });
@@ -182,22 +199,68 @@ namespace cpplab {
         WindowEngine::windowDataMap[this->windowHandle]->OnInitialize(
             this->windowHandle, app
         );
+        this->scheduler.SetImageCache(WindowEngine::windowDataMap[this->windowHandle]->windowRenderer->GetImageCache());
+        WindowEngine::windowDataMap[this->windowHandle]->layoutEngine = &this->layout;
+        WindowEngine::windowDataMap[this->windowHandle]->scrollLists = &this->scrollLists;
+        this->layout.SetRoot(WindowEngine::windowDataMap[this->windowHandle]->rootWindowNode);
         this->wDMLock.unlock();
 
+        //pace frames to the display, the interval stays the default if it reports 0 or 1 (hardware default)
+        HDC windowDC = GetDC(this->windowHandle);
+        const int refreshRate = GetDeviceCaps(windowDC, VREFRESH);
+        ReleaseDC(this->windowHandle, windowDC);
+        if (refreshRate > 1) {
+            this->frameScheduler.SetRefreshInterval(std::chrono::duration_cast<FrameClock::Clock::duration>(std::chrono::seconds(1)) / refreshRate);
+        }
+
         app->OnWindowEntry(this);
         ShowWindow(this->windowHandle, this->nCmdShow);
 
         MSG msg = { };
 
-        while (GetMessage(&msg, NULL, 0, 0) > 0)
-        {
-            TranslateMessage(&msg);
-            DispatchMessage(&msg);
+        for (;;) {
+            //sleep until input arrives or the next frame is due, with no frame wanted this blocks like GetMessage
+            const FrameClock::Clock::time_point frameTime = this->frameScheduler.NextFrameTime();
+            DWORD timeout = INFINITE;
+            if (frameTime != (FrameClock::Clock::time_point::max)()) {
+                const auto delay = std::chrono::ceil<std::chrono::milliseconds>(frameTime - this->frameScheduler.Now());
+                timeout = static_cast<DWORD>((std::max)(delay.count(), std::chrono::milliseconds::rep(0)));
+            }
+            if (timeout != 0) {
+                MsgWaitForMultipleObjectsEx(0, NULL, timeout, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+            }
 
-            //force redraw on node modify
-            if (WindowEngine::windowDataMap[this->windowHandle]->windowRenderer->CheckNodeModification()) {
-                InvalidateRect(this->windowHandle, NULL, NULL);
+            while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
+                if (msg.message == WM_QUIT) return;
+                TranslateMessage(&msg);
+                DispatchMessage(&msg);
             }
+
+            this->RunFrameIfDue();
+        }
+    }
+    void WindowEngine::RunFrameIfDue() {
+        WindowData& windowData = *WindowEngine::windowDataMap[this->windowHandle];
+        WindowD2DRenderer* renderer = windowData.windowRenderer;
+        //any number of messages, posts and changes since the last frame end up in one
+        if (this->uiTasks.Depth() > 0 || this->scheduler.NeedsFrame() || renderer->CheckNodeModification()) {
+            this->frameScheduler.RequestFrame();
+        }
+        if (!this->frameScheduler.IsFrameDue()) return;
+
+        this->frameScheduler.BeginFrame();
+        //posted tasks run together so a burst of updates from other threads costs one repaint
+        this->uiTasks.Drain();
+        this->scheduler.RunFrame();
+        this->layout.RunFrame();
+        //after layout so lists materialize rows for the size they were just given
+        this->scrollLists.RunFrame();
+        //after the code that starts animations ran, so they move in the frame they were started in
+        this->animations.RunFrame();
+        if (windowData.profilerOverlay) windowData.profilerOverlay->Refresh();
+        //redraw only the damaged parts on node modify, the paint comes as soon as the queue is empty
+        if (renderer->CheckNodeModification()) {
+            renderer->InvalidateDamage();
         }
     }
 
@@ -206,6 +269,56 @@ namespace cpplab {
         std::lock_guard<std::mutex> guard(WindowEngine::wDMLock);
         return WindowEngine::windowDataMap[this->windowHandle]->rootWindowNode;
     }
+    void WindowEngine::Post(std::function<void()> task) {
+        this->uiTasks.Post(std::move(task));
+    }
+    void WindowEngine::PostForFrame(std::function<void()> task) {
+        this->uiTasks.PostForFrame(std::move(task));
+    }
+    UiTaskQueueStats WindowEngine::GetUiTaskStats() const {
+        return this->uiTasks.GetStats();
+    }
+    UiScheduler& WindowEngine::GetScheduler() {
+        return this->scheduler;
+    }
+    FrameScheduler& WindowEngine::GetFrameScheduler() {
+        return this->frameScheduler;
+    }
+    LayoutEngine& WindowEngine::GetLayout() {
+        return this->layout;
+    }
+    ScrollListSet& WindowEngine::GetScrollLists() {
+        return this->scrollLists;
+    }
+    AnimationEngine& WindowEngine::GetAnimations() {
+        return this->animations;
+    }
+    FrameProfiler& WindowEngine::GetProfiler() {
+        std::lock_guard<std::mutex> guard(WindowEngine::wDMLock);
+        WindowD2DRenderer* renderer = WindowEngine::windowDataMap[this->windowHandle]->windowRenderer;
+        if (renderer == nullptr) {
+            throw std::runtime_error("[Cpplab WindowEngine] During GetProfiler: the window loop has not been started, the renderer does not exist yet.");
+        }
+        return renderer->GetProfiler();
+    }
+    void WindowEngine::ShowProfilerOverlay(bool show) {
+        std::lock_guard<std::mutex> guard(WindowEngine::wDMLock);
+        WindowData& wdata = *WindowEngine::windowDataMap[this->windowHandle];
+        if (wdata.windowRenderer == nullptr) {
+            throw std::runtime_error("[Cpplab WindowEngine] During ShowProfilerOverlay: the window loop has not been started, the renderer does not exist yet.");
+        }
+        if (show == (wdata.profilerOverlay != nullptr)) return;
+        if (!show) {
+            //the destructor unlinks it from the root
+            delete wdata.profilerOverlay;
+            wdata.profilerOverlay = nullptr;
+            return;
+        }
+        FrameProfiler& profiler = wdata.windowRenderer->GetProfiler();
+        profiler.SetEnabled(true);
+        wdata.profilerOverlay = new ProfilerOverlayElement(profiler);
+        wdata.rootWindowNode->AddChildElement("cpplab profiler overlay", wdata.profilerOverlay);
+    }
     void WindowEngine::SetBackgroundColor(Color c) {
         std::lock_guard<std::mutex> guard(WindowEngine::wDMLock);
         if(WindowEngine::windowDataMap[this->windowHandle]->windowRenderer != nullptr)
@@ -7,7 +7,15 @@
 #include <map>
 #include <mutex>
 #include <vector>
+#include "uitaskqueue.hpp"
+#include "framescheduler.hpp"
+#include "uischeduler.hpp"
+#include "animationengine.hpp"
+#include "layoutengine.hpp"
+#include "scrolllistelement.hpp"
+#include "profileroverlayelement.hpp"
 #include "windowrenderer.hpp"
+#include "spatialindex.hpp"
 
 namespace cpplab {
     static const char* VERSION = "v0.1.0";
@@ -18,13 +26,13 @@ namespace cpplab {
     // make some sort of reusable config struct for elements: DONE
     // image rendering DONE
     // set window icon and title at runtime
-    // debug window
+    // debug window: DONE
     // 
     // low priority:
     // improve render efficiency
     // window hiearchy/inheritance
     // add more primitive render types
-    // animation engine
+    // animation engine: DONE
     // multithreadable: task based? or std::async and promises + futures
     // development toolkit: seperate app that helps with design
     // script language?
@@ -93,6 +101,11 @@ namespace cpplab {
         ElementNode* rootWindowNode = nullptr;
         WindowD2DRenderer* windowRenderer = nullptr;
         ICpplabApp* windowApp = nullptr;
+        //set by the window loop, WM_SIZE hands it the new client size
+        LayoutEngine* layoutEngine = nullptr;
+        ScrollListSet* scrollLists = nullptr;
+        //owned by the window while shown, a child of the root node
+        ProfilerOverlayElement* profilerOverlay = nullptr;
         unsigned int windowDPI = 0;
 
         //setup window instance data
@@ -115,16 +128,26 @@ namespace cpplab {
         struct SetDepthComparator {
             bool operator() (const ElementNode* rhs, const ElementNode* lhs) const {
                 if (rhs != nullptr && lhs != nullptr) {
-                    if (rhs->depth == lhs->depth) {
+                    const float rhsDepth = ElementStore::Instance().Depth(rhs->handle.index);
+                    const float lhsDepth = ElementStore::Instance().Depth(lhs->handle.index);
+                    if (rhsDepth == lhsDepth) {
                         return reinterpret_cast<long>(rhs) > reinterpret_cast<long>(lhs);
                     }
-                    return rhs->depth > lhs->depth;
+                    return rhsDepth > lhsDepth;
                 }
                 return false;
             }
         };
         std::set<ElementNode*, SetDepthComparator> hoveredElements;
 
+        //broad phase for hit testing, kept in sync through the element store bounds journal
+        //MouseOverCheck still does the exact test so custom checks must stay inside the element bounds
+        SpatialGridIndex hitTestIndex;
+        uint32_t hitTestJournal = 0;
+        std::vector<uint32_t> boundsScratch;
+        std::vector<uint32_t> hitTestScratch;
+        void UpdateHitTestIndex();
+
         LRESULT OnMouseMoveEvent(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
         LRESULT OnKBEvent(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
 
@@ -165,6 +188,18 @@ namespace cpplab {
     private:
         HWND windowHandle;
         int nCmdShow;
+        SteadyFrameClock frameClock;
+        FrameScheduler frameScheduler;
+        LayoutEngine layout;
+        ScrollListSet scrollLists;
+        AnimationEngine animations;
+        //before the task queue so resumes still queued are dropped before the tasks they would resume
+        UiScheduler scheduler;
+        //drained at the start of every frame, before changes are collected
+        UiTaskQueue uiTasks;
+
+        //asks for a frame if work is waiting and runs it once the frame scheduler says it is due
+        void RunFrameIfDue();
 
         static std::mutex wDMLock;
         static std::map<HWND, WindowData*> windowDataMap;
@@ -183,6 +218,26 @@ namespace cpplab {
 
         ElementNode* GetRootNode();
 
+        //any thread, runs on the window thread and wakes its loop, see UiTaskQueue
+        void Post(std::function<void()> task);
+        //any thread, runs with the next frame without waking the loop
+        void PostForFrame(std::function<void()> task);
+        UiTaskQueueStats GetUiTaskStats() const;
+        //coroutines resumed by the window loop, spawn and await on the window thread
+        UiScheduler& GetScheduler();
+        //frame pacing, window thread only, the current frame's deadline and the continuous mode live here
+        FrameScheduler& GetFrameScheduler();
+        //containers and items on elements, the root node fills the client area, window thread only
+        LayoutEngine& GetLayout();
+        //scroll lists added here follow the size the layout gives them, window thread only
+        ScrollListSet& GetScrollLists();
+        //tweens and springs on element properties, window thread only
+        AnimationEngine& GetAnimations();
+        //phase timings of every frame painted, off until enabled or the overlay is shown, window thread only once the loop started
+        FrameProfiler& GetProfiler();
+        //showing enables the profiler, hiding deletes the overlay and leaves the profiler on
+        void ShowProfilerOverlay(bool show);
+
         void SetBackgroundColor(Color c);
         void SetWindowClampSize(vec2 maxSize, vec2 minSize, bool clampEnabled = true);
         vec2 GetWindowSize();
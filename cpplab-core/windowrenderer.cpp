@@ -1,273 +1,149 @@
 #include "windowrenderer.hpp"
 #include "engineelements.hpp"
-#include <functional>
-#include <dwrite.h>
-
-#include <d2d1_1.h>
+#include <cmath>
 
 namespace cpplab {
-    WindowD2DRenderer::WindowD2DRenderer(HWND windowHWND, ElementNode* rootNode, unsigned int dpi) {
-        this->d2dFactory = NULL;
-        this->renderTarget = NULL;
-        this->solidColorBrush = NULL;
+    namespace {
+        constexpr size_t ImageCacheBudgetBytes = 64u << 20;
+        constexpr unsigned int ImageDecodeWorkers = 2;
+        //frames the message loop may record ahead of the render thread
+        constexpr size_t MaxQueuedFrames = 2;
+    }
 
+    WindowD2DRenderer::WindowD2DRenderer(HWND windowHWND, ElementNode* rootNode, unsigned int dpi) :
+        device(windowHWND), imageCache(&imageDecoder, ImageCacheBudgetBytes, ImageDecodeWorkers),
+        pipeline(&device, MaxQueuedFrames, [this]() { this->device.RecreateTarget(); }),
+        scene(rootNode, &pipeline, &imageCache, dpi) {
         this->windowHandle = windowHWND;
+        //the window loop sleeps in MsgWaitForMultipleObjectsEx until a message arrives, post an empty one so it checks for finished images
+        this->imageCache.SetCompletionCallback([windowHWND]() {
+            PostMessage(windowHWND, WM_NULL, 0, 0);
+        });
+        //same for a presented frame, a deferred paint or a lost target is picked up then
+        this->pipeline.SetPresentCallback([windowHWND]() {
+            PostMessage(windowHWND, WM_NULL, 0, 0);
+        });
         this->rootElementNode = rootNode;
-        this->rootElementNode->selfId = "Window Root Node";
-
-        this->persistentDepthSortedNodes.data = new NodeRenderData();
-        this->persistentDepthSortedNodes.data->elementNode = rootNode;
-        this->existingSortedNodes.insert(rootNode);
-
-        this->dpi = dpi;
-
-        this->BuildD2DResources();
+        this->rootElementNode->setRootId("Window Root Node");
     }
     WindowD2DRenderer::~WindowD2DRenderer() {
-        this->FreeD2DResources();
     }
 
-    void WindowD2DRenderer::BuildD2DResources() {
-        //d2d factory
-        HRESULT hr = D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, &this->d2dFactory);
-        if (FAILED(hr)) {
-            throw std::runtime_error("[Cpplab Renderer] During D2D Initialization: Failure creating D2D Factory!");
-        }
-
-        //dwrite factory
-        hr = DWriteCreateFactory(DWRITE_FACTORY_TYPE_SHARED,
-            __uuidof(IDWriteFactory),
-            reinterpret_cast<IUnknown**>(&dwriteFactory));
-        if (FAILED(hr)) {
-            throw std::runtime_error("[Cpplab Renderer] During D2D Initialization: Failure creating DWrite Factory!");
-        }
+    bool WindowD2DRenderer::CheckNodeModification() {
+        if (this->pipeline.IsTargetLost()) return true;
+        if (!this->deferredPaint.IsEmpty() && this->pipeline.CanSubmitFrame()) return true;
+        return this->scene.CheckNodeModification();
+    }
 
-        //wicimg factory
-        CoInitialize(NULL);
-        hr = CoCreateInstance(
-            CLSID_WICImagingFactory,
-            NULL,
-            CLSCTX_INPROC_SERVER,
-            IID_PPV_ARGS(&(this->wicImgFactory))
-        );
-        if (FAILED(hr)) {
-            throw std::runtime_error("[Cpplab Renderer] During WIC Initialization: Failure creating WICImagingFactory instance!");
+    void WindowD2DRenderer::InvalidateDamage() {
+        //the render thread dropped every bitmap and text format with its target, build them again
+        if (this->pipeline.TakeTargetLost()) {
+            this->scene.ReleaseDeviceResources();
         }
-
-        //d2d render target
-        RECT rc;
-        GetClientRect(windowHandle, &rc);
-
-        D2D1_SIZE_U size = D2D1::SizeU(
-            static_cast<UINT32>(rc.right), static_cast<UINT32>(rc.bottom)
-        );
-
-        hr = this->d2dFactory->CreateHwndRenderTarget(
-            D2D1::RenderTargetProperties(),
-            D2D1::HwndRenderTargetProperties(windowHandle, size),
-            &this->renderTarget
-        );
-        if (FAILED(hr)) {
-            throw std::runtime_error("[Cpplab Renderer] During D2D Initialization: Failure creating Render Target!");
+        if (!this->deferredPaint.IsEmpty()) {
+            RECT deferredRect = {
+                static_cast<LONG>(std::floor(this->deferredPaint.left)), static_cast<LONG>(std::floor(this->deferredPaint.top)),
+                static_cast<LONG>(std::ceil(this->deferredPaint.right)), static_cast<LONG>(std::ceil(this->deferredPaint.bottom))
+            };
+            InvalidateRect(this->windowHandle, &deferredRect, NULL);
         }
-
-        //d2d brush
-        //any color will do, we just change later when needed
-        const D2D1_COLOR_F color = D2D1::ColorF(0.0f, 0.0f, 0.0f);
-        hr = this->renderTarget->CreateSolidColorBrush(color, &this->solidColorBrush);
-        if (FAILED(hr)) {
-            this->FreeD2DResources();
-            throw std::runtime_error("[Cpplab Renderer] During D2D Initialization: Failure creating color brush!");
+        this->scene.CollectDamage();
+        const DamageTracker& damage = this->scene.GetDamage();
+        if (damage.IsFullDamage()) {
+            InvalidateRect(this->windowHandle, NULL, NULL);
+            return;
         }
-
-        hr = this->renderTarget->CreateLayer(&this->clipLayer);
-        if(FAILED(hr)) {
-            this->FreeD2DResources();
-            throw std::runtime_error("[Cpplab Renderer] During D2D Initialization: Failure creating clip layer!");
+        for (const RectF& rect : damage.Rects()) {
+            RECT damagedRect = {
+                static_cast<LONG>(std::floor(rect.left)), static_cast<LONG>(std::floor(rect.top)),
+                static_cast<LONG>(std::ceil(rect.right)), static_cast<LONG>(std::ceil(rect.bottom))
+            };
+            InvalidateRect(this->windowHandle, &damagedRect, NULL);
         }
     }
-    void WindowD2DRenderer::FreeD2DResources() {
-        SafeRelease(&this->renderTarget);
-        SafeRelease(&this->solidColorBrush);
-        SafeRelease(&this->clipLayer);
+    FrameDamageStats WindowD2DRenderer::GetLastFrameStats() {
+        return this->scene.GetLastFrameStats();
     }
-    bool WindowD2DRenderer::CheckNodeModification() {
-        return this->rootElementNode->RecursiveCheckModification();
+    FrameProfiler& WindowD2DRenderer::GetProfiler() {
+        return this->scene.GetProfiler();
+    }
+    FramePipelineStats WindowD2DRenderer::GetPipelineStats() {
+        return this->pipeline.GetStats();
+    }
+    ImageCacheStats WindowD2DRenderer::GetImageCacheStats() {
+        return this->imageCache.GetStats();
+    }
+    ImageCache* WindowD2DRenderer::GetImageCache() {
+        return &this->imageCache;
+    }
+    void WindowD2DRenderer::GetImageMemoryReport(std::vector<ImageMemoryReportEntry>& out) {
+        this->imageCache.GetMemoryReport(out);
     }
 
-    void WindowD2DRenderer::BuildNodeList() {
-        //check if node no longer loaded
-        std::map<ElementNode*, bool> nodeLoaded;
-        for (ElementNode* p_n : this->existingSortedNodes) {
-            nodeLoaded.insert({ {p_n, false } });
-        }
-
-        //traverse root node
-        //use recursive function (this is a stack destroyer lol)
-        std::function<void(ElementNode*)> updateNode = [this, &updateNode, &nodeLoaded](ElementNode* currentNode) {
-            //update node loaded
-            if (nodeLoaded.contains(currentNode)) {
-                if (nodeLoaded[currentNode] == true) {
-                    //how tf, node apparently loaded twice?
-                    std::stringstream errmsg;
-                    errmsg << "[Cpplab Renderer] During drawlist generation: " <<
-                        "Node double loaded! Element of id \"" << currentNode->getSelfId() <<
-                        "\" was seen twice. It is likely that the element was added to two or more seperate parent elements. Are you sure this is intended behavior?";
-                    throw std::runtime_error(errmsg.str());
-                }
-                nodeLoaded[currentNode] = true;
-            }
-
-            //check if node already in linked list
-            if (existingSortedNodes.contains(currentNode)) {
-                //skip to checking child nodes
-                std::vector<std::string> childIds = currentNode->GetAllChildElements();
-                for (const std::string& id : childIds) {
-                    updateNode(currentNode->GetChildElement(id));
-                }
-                return;
-            }
-            //otherwise add this node
-            //traverse the sorted nodes until the currently indexed node has a higher depth
-            //insert new linkedlist node between the previously indexed node and currently indexed node
-            
-            //new node
-            LinkedListNode<NodeRenderData*>* newNode = new LinkedListNode<NodeRenderData*>();
-            if (currentNode->getNodeType() == NodeType::TEXT_AREA) {
-                newNode->data = new TextElementNodeRenderData();
-            }
-            else if (currentNode->getNodeType() == NodeType::IMAGE) {
-                newNode->data = new ImageElementNodeRenderData();
-            }
-            else {
-                newNode->data = new NodeRenderData();
-            }
-            newNode->data->elementNode = currentNode;
-
-            /* Locate the node before the point of insertion */
-            LinkedListNode<NodeRenderData*>* currentlyIndexed = &persistentDepthSortedNodes;
-            while (currentlyIndexed->nextNode != nullptr
-                && currentlyIndexed->nextNode->data->elementNode->getDepth()
-                < newNode->data->elementNode->getDepth()) {
-                currentlyIndexed = currentlyIndexed->nextNode;
-            }
-            newNode->nextNode = currentlyIndexed->nextNode;
-            currentlyIndexed->nextNode = newNode;
-
-            existingSortedNodes.insert(currentNode);
-            
-            //check child nodes
-            std::vector<std::string> childIds = currentNode->GetAllChildElements();
-            for (const std::string& id : childIds) {
-                updateNode(currentNode->GetChildElement(id));
-            }
-            return;
-        };
-        updateNode(rootElementNode);
-
-        //remove elements from sorted list if no longer exists in element tree
-        for (auto nodeExistsPair : nodeLoaded) {
-            if (nodeExistsPair.second) continue;
-
-            //find node in the list
-            //ignoring the first node is ok cause it never gets deleted i hope
-            LinkedListNode<NodeRenderData*>* lastIndexedNode = nullptr;
-            LinkedListNode<NodeRenderData*>* currentlyIndexedNode = &this->persistentDepthSortedNodes;
-            while (currentlyIndexedNode->data->elementNode != nodeExistsPair.first) {
-                if (currentlyIndexedNode->nextNode == nullptr) {
-                    currentlyIndexedNode = nullptr;
-                    break;
+    void WindowD2DRenderer::Draw() {
+        //the update region covers our own invalidations and anything the system uncovered
+        //its rects are taken one by one, rcPaint is only their bounding box and would repaint everything between them
+        this->paintRects.clear();
+        HRGN updateRegion = CreateRectRgn(0, 0, 0, 0);
+        if (GetUpdateRgn(this->windowHandle, updateRegion, FALSE) > NULLREGION) {
+            const DWORD regionBytes = GetRegionData(updateRegion, 0, NULL);
+            this->regionScratch.resize(regionBytes);
+            RGNDATA* region = reinterpret_cast<RGNDATA*>(this->regionScratch.data());
+            if (regionBytes != 0 && GetRegionData(updateRegion, regionBytes, region) != 0) {
+                const RECT* rects = reinterpret_cast<const RECT*>(region->Buffer);
+                for (DWORD i = 0; i < region->rdh.nCount; ++i) {
+                    this->paintRects.push_back(RectF(
+                        static_cast<float>(rects[i].left), static_cast<float>(rects[i].top),
+                        static_cast<float>(rects[i].right), static_cast<float>(rects[i].bottom)
+                    ));
                 }
-                lastIndexedNode = currentlyIndexedNode;
-                currentlyIndexedNode = currentlyIndexedNode->nextNode;
-            }
-            if (currentlyIndexedNode == nullptr) {
-                //wasnt found?? skip regardless
-                continue;
             }
-
-            //found in node
-            //current node should point to the node after
-            lastIndexedNode->nextNode = currentlyIndexedNode->nextNode;
-            delete currentlyIndexedNode->data;
-            delete currentlyIndexedNode;
         }
-    }
+        DeleteObject(updateRegion);
 
-    void WindowD2DRenderer::Draw() {
-        //draw background color
         PAINTSTRUCT ps;
         BeginPaint(this->windowHandle, &ps);
-        this->renderTarget->BeginDraw();
-        this->renderTarget->SetTransform(D2D1::Matrix3x2F::Identity());
-        this->renderTarget->Clear(D2D1::ColorF(
-            this->backgroundColor.r,
-            this->backgroundColor.g,
-            this->backgroundColor.b,
-            this->backgroundColor.a
-        ));
-        
-        //draw back to front?
-        //create depth sorted element array (find a way to presort)
-        //check tree for node count change (small optimization since i think counting nodes is slightly cheaper)
-        if((this->rootElementNode->RecursiveCountAllChildNodes() + 1) != this->existingSortedNodes.size())
-            this->BuildNodeList();
-
-        //node list should be ordered from least to greatest now
-        //too lazy to do some reverse stuff so ill make larger depth on top.
-        LinkedListNode<NodeRenderData*>* currentNode = &this->persistentDepthSortedNodes;
-        while (true) {
-            this->PerformElementDraw(currentNode->data);
-            currentNode->data->elementNode->ResetModification();
-            if (currentNode->nextNode == nullptr) break;
-            currentNode = currentNode->nextNode;
+        RECT rc;
+        GetClientRect(this->windowHandle, &rc);
+        if (!this->deferredPaint.IsEmpty()) this->paintRects.push_back(this->deferredPaint);
+
+        //the render thread presents on its own, each replay goes back to the frame that recorded it
+        FrameProfiler& profiler = this->scene.GetProfiler();
+        FrameReplayTime replay;
+        while (this->pipeline.TakeReplayTime(replay)) {
+            profiler.AddLateTime(replay.frameTag, ProfilePhase::PRESENT, std::chrono::microseconds(replay.microseconds));
         }
 
-        HRESULT hr = this->renderTarget->EndDraw();
-        if (FAILED(hr) || hr == D2DERR_RECREATE_TARGET) {
-            this->FreeD2DResources();
-            this->BuildD2DResources();
+        //with the render thread still behind, keep the damage and paint once a frame was presented
+        if (this->pipeline.CanSubmitFrame()) {
+            this->pipeline.SetFrameTag(profiler.FrameCount());
+            this->pipeline.SetSize(vec2(static_cast<float>(rc.right), static_cast<float>(rc.bottom)));
+            this->scene.RenderFrame(
+                RectF(0.f, 0.f, static_cast<float>(rc.right), static_cast<float>(rc.bottom)),
+                this->paintRects
+            );
+            this->deferredPaint = RectF();
+        }
+        else {
+            //held back as one box, the render thread being behind is rare
+            RectF held;
+            for (const RectF& rect : this->paintRects) {
+                held = held.Union(rect);
+            }
+            this->deferredPaint = held;
+            this->pipeline.DeferFrame();
         }
+
         EndPaint(this->windowHandle, &ps);
     }
 
     void WindowD2DRenderer::SetBackgroundColor(Color c) {
-        this->backgroundColor = c;
+        this->scene.SetBackgroundColor(c);
         InvalidateRect(this->windowHandle, NULL, NULL);
     }
     void WindowD2DRenderer::RebuildD2DResources() {
-        this->FreeD2DResources();
-
-        //d2d render target
-        RECT rc;
-        GetClientRect(windowHandle, &rc);
-
-        D2D1_SIZE_U size = D2D1::SizeU(
-            static_cast<UINT32>(rc.right), static_cast<UINT32>(rc.bottom)
-        );
-
-        HRESULT hr = this->d2dFactory->CreateHwndRenderTarget(
-            D2D1::RenderTargetProperties(),
-            D2D1::HwndRenderTargetProperties(windowHandle, size),
-            &this->renderTarget
-        );
-        if (FAILED(hr)) {
-            throw std::runtime_error("[Cpplab Renderer] During D2D Resource Rebuild: Failure creating D2D Render Target!");
-        }
-
-        //d2d brush
-        //any color will do, we just change later when needed
-        const D2D1_COLOR_F color = D2D1::ColorF(0.0f, 0.0f, 0.0f);
-        hr = this->renderTarget->CreateSolidColorBrush(color, &this->solidColorBrush);
-        if (FAILED(hr)) {
-            this->FreeD2DResources();
-            throw std::runtime_error("[Cpplab Renderer] During D2D Resource Rebuild: Failure creating D2D Color Brush!");
-        }
-
-        hr = this->renderTarget->CreateLayer(&this->clipLayer);
-        if (FAILED(hr)) {
-            this->FreeD2DResources();
-            throw std::runtime_error("[Cpplab Renderer] During D2D Resource Rebuild: Failure creating clip layer!");
-        }
+        //bitmaps die with the old target, the render thread recreates it before its next frame
+        this->scene.ReleaseDeviceResources();
+        this->pipeline.RecreateTarget();
     }
-}
\ No newline at end of file
+}
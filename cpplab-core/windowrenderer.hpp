@@ -1,5 +1,9 @@
 #pragma once
 #include "engineelements.hpp"
+#include "scenerenderer.hpp"
+#include "d2drenderdevice.hpp"
+#include "framepipeline.hpp"
+#include "wicimagedecoder.hpp"
 #include <d2d1.h>
 #include <dwrite.h>
 #include <wincodec.h>
@@ -19,64 +23,40 @@ namespace cpplab {
         }
     }
 
-    template<typename T>
-    struct LinkedListNode {
-        T data;
-        LinkedListNode<T>* nextNode = nullptr;
-    };
-
-    struct NodeRenderData {
-        ElementNode* elementNode;
-    };
-    struct TextElementNodeRenderData : public NodeRenderData {
-        //store shape and text renderer to reuse
-        D2D1_ROUNDED_RECT boxShape;
-        D2D1_RECT_F textboxShape;
-        IDWriteTextFormat* textFormat;
-    };
-    struct ImageElementNodeRenderData : public NodeRenderData {
-        D2D1_ROUNDED_RECT boxShape;
-        ID2D1Bitmap* image;
-        ID2D1PathGeometry* clipMask;
-    };
-
+    //window side of the renderer, records frames of a scene renderer from WM_PAINT
+    //the direct2d device only runs on the pipeline's render thread, so presenting never holds up the message loop
     class WindowD2DRenderer {
     private:
         HWND windowHandle;
         ElementNode* rootElementNode;
-        LinkedListNode<NodeRenderData*> persistentDepthSortedNodes;
-        std::set<ElementNode*> existingSortedNodes;
-
-        ID2D1Factory* d2dFactory;
-        ID2D1HwndRenderTarget* renderTarget;
-        ID2D1SolidColorBrush* solidColorBrush;
-        ID2D1Layer* clipLayer;
-
-        IDWriteFactory* dwriteFactory;
-
-        IWICImagingFactory* wicImgFactory;
-
-        Color backgroundColor;
-
-        unsigned int dpi;
-
-        void BuildNodeList();
-
-        void BuildD2DResources();
-        void FreeD2DResources();
 
-        void PerformElementDraw(NodeRenderData* element);
+        D2DRenderDevice device;
+        WICImageDecoder imageDecoder;
+        ImageCache imageCache;
+        FramePipeline pipeline;
+        SceneRenderer scene;
+        //painted area held back while the render thread was behind
+        RectF deferredPaint;
+        //rects of the window's update region for the paint in progress
+        std::vector<RectF> paintRects;
+        std::vector<uint8_t> regionScratch;
 
-        float scaleDPI(float val);
-        D2D1_RECT_F scaleDPI(D2D1_RECT_F rect);
-        D2D1_POINT_2F scaleDPI(D2D1_POINT_2F point);
     public:
         WindowD2DRenderer(HWND windowHandle, ElementNode* rootNode, unsigned int dpi);
         ~WindowD2DRenderer();
 
         void Draw();
         bool CheckNodeModification();
+        //collects damage from modified elements and invalidates only those parts of the window
+        void InvalidateDamage();
+        FrameDamageStats GetLastFrameStats();
+        FramePipelineStats GetPipelineStats();
+        ImageCacheStats GetImageCacheStats();
+        ImageCache* GetImageCache();
+        //phases of the scene renderer plus the render thread's present, ui thread only
+        FrameProfiler& GetProfiler();
+        void GetImageMemoryReport(std::vector<ImageMemoryReportEntry>& out);
         void SetBackgroundColor(Color c);
         void RebuildD2DResources();
     };
-}
\ No newline at end of file
+}
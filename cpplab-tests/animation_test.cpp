@@ -0,0 +1,166 @@
+//animation engine, tweens land on their easing curves at the frame time and springs settle on their target
+//benchmark: one frame of 10k elements tweening position and opacity, pass an element count as the first argument
+#include <cmath>
+#include <vector>
+#include "animationengine.hpp"
+#include "check.hpp"
+
+using namespace cpplab;
+using namespace std::chrono_literals;
+
+namespace {
+    //no refresh grid, every frame is evaluated at exactly the time the clock was advanced to
+    struct Frames {
+        ManualFrameClock clock;
+        FrameScheduler scheduler;
+        AnimationEngine animations;
+
+        Frames() : scheduler(&clock, FrameClock::Clock::duration::zero()), animations(&scheduler) {
+            this->clock.Set(FrameClock::Clock::time_point(100s));
+        }
+        void Run(FrameClock::Clock::duration advance) {
+            this->clock.Advance(advance);
+            this->scheduler.BeginFrame();
+            this->animations.RunFrame();
+        }
+    };
+
+    bool Near(float value, float expected) {
+        return std::fabs(value - expected) < 0.01f;
+    }
+}
+
+static void TestEasings() {
+    Frames frames;
+    ElementNode root;
+    const Easing easings[EasingCount] = { Easing::LINEAR, Easing::EASE_IN, Easing::EASE_OUT, Easing::EASE_IN_OUT };
+    std::vector<ElementNode*> nodes;
+    std::vector<AnimationHandle> handles;
+    for (Easing easing : easings) {
+        ElementNode* node = new ElementNode();
+        root.AddChildElement(std::to_string(nodes.size()), node);
+        nodes.push_back(node);
+        handles.push_back(frames.animations.Tween(node, AnimProperty::POSITION, vec2(100.f, 200.f), 100ms, easing));
+    }
+    CPPLAB_CHECK(frames.animations.GetStats().activeChannels == 2 * EasingCount && frames.scheduler.IsFrameDue());
+
+    //a quarter of the way, t, t cubed, one minus (1 - t) cubed, and 4 t cubed in the first half
+    frames.Run(25ms);
+    const float quarter[EasingCount] = { 0.25f, 0.015625f, 0.578125f, 0.0625f };
+    for (size_t i = 0; i < EasingCount; ++i) {
+        const vec2 position = nodes[i]->getRelativePosition();
+        CPPLAB_CHECK(Near(position.x, 100.f * quarter[i]) && Near(position.y, 200.f * quarter[i]));
+    }
+    //three quarters, the in and out curve mirrors its first half
+    frames.Run(50ms);
+    const float threeQuarters[EasingCount] = { 0.75f, 0.421875f, 0.984375f, 0.9375f };
+    for (size_t i = 0; i < EasingCount; ++i) {
+        CPPLAB_CHECK(Near(nodes[i]->getRelativePosition().x, 100.f * threeQuarters[i]));
+    }
+    CPPLAB_CHECK(frames.animations.GetStats().lastElementsWritten == EasingCount);
+
+    //past the end every tween sits exactly on its target and finishes
+    frames.Run(30ms);
+    for (size_t i = 0; i < EasingCount; ++i) {
+        CPPLAB_CHECK(nodes[i]->getRelativePosition() == vec2(100.f, 200.f) && !frames.animations.IsActive(handles[i]));
+    }
+    const AnimationStats stats = frames.animations.GetStats();
+    CPPLAB_CHECK(stats.activeAnimations == 0 && stats.animationsFinished == EasingCount && !frames.animations.HasAnimations());
+    for (ElementNode* node : nodes) delete node;
+}
+
+static void TestReplaceAndCancel() {
+    Frames frames;
+    ElementNode root;
+    TextElement* node = new TextElement();
+    root.AddChildElement("node", node);
+
+    //a second tween on the property takes over from where the first one got to
+    const AnimationHandle first = frames.animations.Tween(node, AnimProperty::OPACITY, 0.f, 100ms, Easing::LINEAR);
+    frames.Run(50ms);
+    CPPLAB_CHECK(Near(node->getOpacity(), 0.5f));
+    const AnimationHandle second = frames.animations.Tween(node, AnimProperty::OPACITY, 1.f, 100ms, Easing::LINEAR);
+    CPPLAB_CHECK(!frames.animations.IsActive(first) && frames.animations.IsActive(second));
+    frames.Run(50ms);
+    CPPLAB_CHECK(Near(node->getOpacity(), 0.75f));
+
+    //cancel leaves the value where it is, other properties keep running
+    node->setBackgroundColor(Color(0.f, 0.f, 0.f, 1.f));
+    frames.animations.Tween(node, AnimProperty::BACKGROUND_COLOR, Color(1.f, 0.f, 0.f, 1.f), 100ms, Easing::LINEAR);
+    frames.animations.Cancel(second);
+    frames.Run(50ms);
+    CPPLAB_CHECK(Near(node->getOpacity(), 0.75f) && frames.animations.GetStats().activeAnimations == 1);
+    CPPLAB_CHECK(Near(node->getBackgroundColor().r, 0.5f));
+    frames.animations.CancelElement(node);
+    frames.Run(50ms);
+    CPPLAB_CHECK(!frames.animations.HasAnimations() && Near(node->getBackgroundColor().r, 0.5f));
+
+    //deleting an animated element ends its animations
+    const AnimationHandle orphan = frames.animations.Tween(node, AnimProperty::DEPTH, 10.f, 100ms);
+    delete node;
+    frames.Run(16ms);
+    CPPLAB_CHECK(!frames.animations.IsActive(orphan) && !frames.animations.HasAnimations());
+}
+
+static void TestSpring() {
+    Frames frames;
+    ElementNode root;
+    ElementNode* node = new ElementNode();
+    root.AddChildElement("node", node);
+
+    //the default spring is within two pixels after half a second, never overshoots, and rests on the target a little later
+    const AnimationHandle spring = frames.animations.Spring(node, AnimProperty::DIMENSIONS, vec2(100.f, 50.f));
+    float peak = 0.f;
+    int frameCount = 0;
+    while (frames.animations.IsActive(spring) && frameCount < 120) {
+        frames.Run(16ms);
+        peak = (std::max)(peak, node->getDimensions().x);
+        ++frameCount;
+        if (frameCount == 32) CPPLAB_CHECK(node->getDimensions().x > 98.f);
+    }
+    CPPLAB_CHECK(!frames.animations.IsActive(spring) && frameCount > 32 && frameCount < 90);
+    CPPLAB_CHECK(node->getDimensions() == vec2(100.f, 50.f) && peak <= 100.f);
+
+    //a stiff spring in a long frame stays stable, the step is split
+    SpringConfig stiff;
+    stiff.stiffness = 2000.f;
+    stiff.damping = 60.f;
+    frames.animations.Spring(node, AnimProperty::DEPTH, 1.f, stiff);
+    frames.Run(100ms);
+    CPPLAB_CHECK(std::isfinite(node->getDepth()) && node->getDepth() < 2.f);
+    delete node;
+}
+
+static void BenchmarkFrame(size_t elementCount) {
+    Frames frames;
+    ElementNode root;
+    std::vector<TextElement*> nodes;
+    for (size_t i = 0; i < elementCount; ++i) {
+        TextElement* node = new TextElement();
+        root.AddChildElement(std::to_string(i), node);
+        nodes.push_back(node);
+        const Easing easing = static_cast<Easing>(i % EasingCount);
+        frames.animations.Tween(node, AnimProperty::POSITION, vec2(static_cast<float>(i % 500), 300.f), 10s, easing);
+        frames.animations.Tween(node, AnimProperty::OPACITY, 0.f, 10s, easing);
+    }
+
+    uint64_t total = 0;
+    constexpr int FrameCount = 60;
+    for (int frame = 0; frame < FrameCount; ++frame) {
+        frames.Run(16ms);
+        total += frames.animations.GetStats().lastEvaluateMicroseconds;
+    }
+    const AnimationStats stats = frames.animations.GetStats();
+    CPPLAB_CHECK(stats.lastElementsWritten == elementCount && stats.activeChannels == elementCount * 3);
+    std::printf("%zu elements, %zu channels: %.1f us a frame, worst %llu us\n", elementCount, stats.activeChannels,
+        static_cast<double>(total) / FrameCount, static_cast<unsigned long long>(stats.maxEvaluateMicroseconds));
+    for (TextElement* node : nodes) delete node;
+}
+
+int main(int argc, char** argv) {
+    TestEasings();
+    TestReplaceAndCancel();
+    TestSpring();
+    BenchmarkFrame(cpplab::testing::SizeArgument(argc, argv, 10000));
+    return 0;
+}
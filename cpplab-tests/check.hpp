@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <stdexcept>
+
+//stays on in release builds, the benchmarks are only meaningful with optimization
+#define CPPLAB_CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            std::exit(1); \
+        } \
+    } while (0)
+
+#define CPPLAB_CHECK_THROWS(statement) \
+    do { \
+        bool thrown = false; \
+        try { statement; } catch (const std::runtime_error&) { thrown = true; } \
+        if (!thrown) { \
+            std::fprintf(stderr, "%s:%d: expected a throw: %s\n", __FILE__, __LINE__, #statement); \
+            std::exit(1); \
+        } \
+    } while (0)
+
+namespace cpplab::testing {
+    //the first argument of a benchmark, or fallback under ctest
+    inline size_t SizeArgument(int argc, char** argv, size_t fallback) {
+        return argc > 1 ? static_cast<size_t>(std::strtoull(argv[1], nullptr, 10)) : fallback;
+    }
+    inline double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
@@ -0,0 +1,199 @@
+//coroutine tasks on the headless loop, awaiting frames, timers, images and the ui thread without a thread per await
+//benchmark: memory and resume cost of 10k suspended tasks, pass a task count as the first argument
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+#include "headlessengine.hpp"
+#include "check.hpp"
+
+using namespace cpplab;
+using namespace std::chrono_literals;
+
+//every allocation of the process is counted so the benchmark can report what a suspended task holds on to
+static std::atomic<size_t> liveBytes = 0;
+void* operator new(size_t size) {
+    void* block = std::malloc(size + alignof(std::max_align_t));
+    if (block == nullptr) throw std::bad_alloc();
+    *static_cast<size_t*>(block) = size;
+    liveBytes.fetch_add(size, std::memory_order_relaxed);
+    return static_cast<char*>(block) + alignof(std::max_align_t);
+}
+void operator delete(void* pointer) noexcept {
+    if (pointer == nullptr) return;
+    char* block = static_cast<char*>(pointer) - alignof(std::max_align_t);
+    liveBytes.fetch_sub(*reinterpret_cast<size_t*>(block), std::memory_order_relaxed);
+    std::free(block);
+}
+void operator delete(void* pointer, size_t) noexcept {
+    operator delete(pointer);
+}
+
+static Task<int> Add(UiScheduler& scheduler, int a, int b) {
+    co_await scheduler.NextFrame();
+    co_return a + b;
+}
+static Task<void> Chain(UiScheduler& scheduler, int& out) {
+    const int first = co_await Add(scheduler, 1, 2);
+    out = co_await Add(scheduler, first, 10);
+}
+static Task<void> Throws(UiScheduler& scheduler) {
+    co_await scheduler.NextFrame();
+    throw std::runtime_error("thrown from a task");
+}
+static Task<void> Catches(UiScheduler& scheduler, bool& caught) {
+    try {
+        co_await Throws(scheduler);
+    }
+    catch (const std::runtime_error&) {
+        caught = true;
+    }
+}
+//leaves the ui thread on a thread of its own, like a blocking read would, then comes back
+static Task<void> Hop(UiScheduler& scheduler, std::thread::id uiThread, std::thread& worker, std::atomic<int>& stage) {
+    struct ToWorker {
+        std::thread& worker;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { this->worker = std::thread([handle] { handle.resume(); }); }
+        void await_resume() const noexcept {}
+    };
+    co_await ToWorker{ worker };
+    CPPLAB_CHECK(std::this_thread::get_id() != uiThread);
+    stage = 1;
+    co_await scheduler.ResumeOnUiThread();
+    CPPLAB_CHECK(std::this_thread::get_id() == uiThread);
+    stage = 2;
+}
+static Task<void> Wait(UiScheduler& scheduler, FrameClock::Clock::duration duration, bool& done) {
+    co_await scheduler.Delay(duration);
+    done = true;
+}
+static Task<void> Load(UiScheduler& scheduler, const std::wstring& source, ImageLoadResult& result) {
+    ImageKey key;
+    key.source = source;
+    result = co_await scheduler.ImageLoaded(key);
+}
+static Task<void> Forever(UiScheduler& scheduler, int& frames) {
+    for (;;) {
+        co_await scheduler.NextFrame();
+        ++frames;
+    }
+}
+
+static void TestAwaitables() {
+    ManualFrameClock clock;
+    HeadlessEngine engine(64, 64, 96, &clock);
+    UiScheduler& scheduler = engine.GetScheduler();
+
+    //each await of a nested task takes one frame
+    int sum = 0;
+    scheduler.Spawn(Chain(scheduler, sum));
+    engine.RunFrame();
+    CPPLAB_CHECK(sum == 0);
+    engine.RunFrame();
+    CPPLAB_CHECK(sum == 13 && scheduler.GetStats().liveTasks == 0);
+
+    //exceptions come out of the co_await, or out of the frame for a spawned task
+    bool caught = false;
+    scheduler.Spawn(Catches(scheduler, caught));
+    engine.RunFrame();
+    CPPLAB_CHECK(caught);
+    scheduler.Spawn(Throws(scheduler));
+    CPPLAB_CHECK_THROWS(engine.RunFrame());
+
+    std::atomic<int> stage = 0;
+    std::thread worker;
+    scheduler.Spawn(Hop(scheduler, std::this_thread::get_id(), worker, stage));
+    while (engine.GetTaskStats().depth == 0) std::this_thread::yield();
+    CPPLAB_CHECK(stage == 1);
+    engine.RunFrame();
+    CPPLAB_CHECK(stage == 2);
+    //the worker may still be inside the post that woke the engine
+    worker.join();
+
+    //timers follow the frame clock
+    bool done = false;
+    scheduler.Spawn(Wait(scheduler, 40ms, done));
+    clock.Advance(39ms);
+    engine.RunFrame();
+    CPPLAB_CHECK(!done && scheduler.GetStats().timerWaiters == 1);
+    clock.Advance(1ms);
+    engine.RunFrame();
+    CPPLAB_CHECK(done);
+
+    //an image written by the software device, decoded on the cache's workers
+    SoftwareRenderDevice device(8, 8);
+    device.BeginFrame();
+    device.Clear(Color(1.f, 0.f, 0.f, 1.f));
+    device.EndFrame();
+    CPPLAB_CHECK(device.SavePPM("coroutine_test.ppm"));
+    ImageLoadResult loaded;
+    ImageLoadResult missing;
+    scheduler.Spawn(Load(scheduler, L"coroutine_test.ppm", loaded));
+    scheduler.Spawn(Load(scheduler, L"coroutine_test_missing.ppm", missing));
+    const auto start = std::chrono::steady_clock::now();
+    while ((loaded.state == ImageRequestState::PENDING || missing.state == ImageRequestState::PENDING) && cpplab::testing::MillisecondsSince(start) < 5000.0) {
+        engine.RunFrame();
+        std::this_thread::sleep_for(1ms);
+    }
+    CPPLAB_CHECK(loaded.state == ImageRequestState::READY && loaded.pixels && loaded.pixels->width == 8);
+    CPPLAB_CHECK(missing.state == ImageRequestState::FAILED);
+
+    //a task still suspended is destroyed with the engine
+    int frames = 0;
+    scheduler.Spawn(Forever(scheduler, frames));
+    engine.RunFrame();
+    CPPLAB_CHECK(frames == 1 && scheduler.GetStats().liveTasks == 1);
+}
+
+static Task<void> Ticker(HeadlessEngine& engine, int& ticks) {
+    for (int i = 0; i < 5; ++i) {
+        co_await engine.GetScheduler().Delay(5ms);
+        ++ticks;
+    }
+    engine.Stop();
+}
+
+static void TestRunLoop() {
+    //the loop sleeps until the next timer is due, nothing else wakes it
+    HeadlessEngine engine(64, 64);
+    int ticks = 0;
+    engine.GetScheduler().Spawn(Ticker(engine, ticks));
+    engine.RunLoop();
+    CPPLAB_CHECK(ticks == 5);
+}
+
+static void BenchmarkSuspended(size_t taskCount) {
+    HeadlessEngine engine(64, 64);
+    UiScheduler& scheduler = engine.GetScheduler();
+    std::vector<int> frames(taskCount);
+
+    const size_t before = liveBytes.load();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < taskCount; ++i) {
+        scheduler.Spawn(Forever(scheduler, frames[i]));
+    }
+    const double spawnMilliseconds = cpplab::testing::MillisecondsSince(start);
+    const size_t bytes = liveBytes.load() - before;
+    CPPLAB_CHECK(scheduler.GetStats().liveTasks == taskCount && scheduler.GetStats().frameWaiters == taskCount);
+
+    constexpr int Frames = 100;
+    start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < Frames; ++frame) {
+        scheduler.RunFrame();
+    }
+    const double resumeMilliseconds = cpplab::testing::MillisecondsSince(start);
+    CPPLAB_CHECK(frames.front() == Frames && frames.back() == Frames);
+
+    std::printf("%zu suspended tasks: %zu bytes a task, spawn %.1f ns a task, resume %.1f ns a task a frame\n",
+        taskCount, bytes / taskCount, spawnMilliseconds * 1.0e6 / static_cast<double>(taskCount),
+        resumeMilliseconds * 1.0e6 / static_cast<double>(taskCount) / Frames);
+}
+
+int main(int argc, char** argv) {
+    TestAwaitables();
+    TestRunLoop();
+    BenchmarkSuspended(cpplab::testing::SizeArgument(argc, argv, 10000));
+    return 0;
+}
@@ -0,0 +1,181 @@
+//damage is painted rect by rect, two changes in opposite corners repaint the corners and nothing between them
+#include "headlessengine.hpp"
+#include "check.hpp"
+
+using namespace cpplab;
+
+static TextElement* AddPatch(ElementNode* parent, const std::string& id, RectF rect, Color color) {
+    TextElementConfiguration config;
+    config.setText(L"").setBackgroundColor(color);
+    config.SetRelativePosition(vec2(rect.left, rect.top)).SetDimension(vec2(rect.right - rect.left, rect.bottom - rect.top)).SetHidden(false);
+    TextElement* patch = new TextElement(config);
+    parent->AddChildElement(id, patch);
+    return patch;
+}
+
+static void TestTracker() {
+    DamageTracker tracker;
+    tracker.ResetRegion();
+    tracker.AddRect(RectF(0.f, 0.f, 10.f, 10.f));
+    tracker.AddRect(RectF(5.f, 5.f, 15.f, 15.f));
+    CPPLAB_CHECK(tracker.Rects().size() == 1);
+    tracker.AddRect(RectF(100.f, 100.f, 110.f, 110.f));
+    CPPLAB_CHECK(tracker.Rects().size() == 2);
+    CPPLAB_CHECK(tracker.Area() == 325.f);
+    CPPLAB_CHECK(tracker.Intersects(RectF(105.f, 105.f, 106.f, 106.f)));
+    CPPLAB_CHECK(!tracker.Intersects(RectF(50.f, 50.f, 60.f, 60.f)));
+    for (int i = 0; i < 20; ++i) {
+        tracker.AddRect(RectF(i * 20.f, 300.f, i * 20.f + 5.f, 305.f));
+    }
+    CPPLAB_CHECK(tracker.Rects().size() <= DamageTracker::MaxRects);
+}
+
+static void TestOppositeCorners() {
+    HeadlessEngine engine(400, 300);
+    ElementNode* root = engine.GetRootNode();
+    engine.GetScene().SetBackgroundColor(Color(0.f, 0.f, 0.f, 1.f));
+    TextElement* topLeft = AddPatch(root, "topLeft", RectF(0.f, 0.f, 20.f, 20.f), Color(1.f, 0.f, 0.f, 1.f));
+    TextElement* bottomRight = AddPatch(root, "bottomRight", RectF(380.f, 280.f, 400.f, 300.f), Color(1.f, 0.f, 0.f, 1.f));
+    TextElement* middle = AddPatch(root, "middle", RectF(100.f, 100.f, 300.f, 200.f), Color(0.f, 0.f, 1.f, 1.f));
+    CPPLAB_CHECK(engine.RunFrame());
+    CPPLAB_CHECK(engine.GetScene().GetLastFrameStats().fullRedraw);
+    const SoftwareRenderDevice& device = engine.GetDevice();
+    const uint32_t red = device.GetPixel(10, 10);
+    const uint32_t blue = device.GetPixel(200, 150);
+
+    topLeft->setBackgroundColor(Color(0.f, 1.f, 0.f, 1.f));
+    bottomRight->setBackgroundColor(Color(0.f, 1.f, 0.f, 1.f));
+    CPPLAB_CHECK(engine.RunFrame());
+    const FrameDamageStats stats = engine.GetScene().GetLastFrameStats();
+    std::printf("corners: %zu rects, %.0f px damaged, %zu drawn, %zu skipped\n", stats.damageRects, stats.damagedArea, stats.elementsDrawn, stats.elementsSkipped);
+    CPPLAB_CHECK(!stats.fullRedraw);
+    CPPLAB_CHECK(stats.damageRects == 2);
+    //the two corners and a pixel of antialiasing around them, far from the 400x300 box around both
+    CPPLAB_CHECK(stats.damagedArea >= 800.f && stats.damagedArea <= 2.f * 24.f * 24.f);
+    CPPLAB_CHECK(stats.elementsDrawn == 2 && stats.elementsSkipped == 1);
+    CPPLAB_CHECK(device.GetPixel(10, 10) != red && device.GetPixel(390, 290) == device.GetPixel(10, 10));
+    CPPLAB_CHECK(device.GetPixel(200, 150) == blue);
+
+    //an element spanning both rects is drawn into each, clipped to it
+    middle->setRelativePosition(vec2(0.f, 0.f));
+    middle->setDimensions(vec2(400.f, 300.f));
+    topLeft->setDepth(1.f);
+    bottomRight->setDepth(1.f);
+    engine.RunFrame();
+    CPPLAB_CHECK(device.GetPixel(390, 290) == device.GetPixel(10, 10));
+    CPPLAB_CHECK(device.GetPixel(200, 150) == blue && device.GetPixel(50, 50) == blue);
+
+    delete topLeft;
+    delete bottomRight;
+    delete middle;
+}
+
+static void TestChangedElementsOnly() {
+    HeadlessEngine engine(400, 300);
+    ElementNode* root = engine.GetRootNode();
+    engine.GetScene().SetBackgroundColor(Color(0.f, 0.f, 0.f, 1.f));
+    std::vector<TextElement*> grid;
+    for (int i = 0; i < 1000; ++i) {
+        grid.push_back(AddPatch(root, "cell" + std::to_string(i), RectF(static_cast<float>(i % 40) * 10.f, static_cast<float>(i / 40) * 10.f, static_cast<float>(i % 40) * 10.f + 8.f, static_cast<float>(i / 40) * 10.f + 8.f), Color(0.f, 0.f, 1.f, 1.f)));
+    }
+    TextElement* panel = AddPatch(root, "panel", RectF(0.f, 260.f, 100.f, 300.f), Color(1.f, 1.f, 1.f, 1.f));
+    std::vector<TextElement*> items;
+    for (int i = 0; i < 10; ++i) {
+        items.push_back(AddPatch(panel, "item" + std::to_string(i), RectF(static_cast<float>(i) * 10.f, 0.f, static_cast<float>(i) * 10.f + 5.f, 5.f), Color(1.f, 0.f, 0.f, 1.f)));
+    }
+    engine.RunFrame();
+    //the new tree is measured whole, the root included
+    CPPLAB_CHECK(engine.GetScene().GetLastFrameStats().elementsChecked == 1012);
+
+    //one changed color measures that element alone, not the whole tree
+    grid[500]->setBackgroundColor(Color(0.f, 1.f, 0.f, 1.f));
+    engine.RunFrame();
+    FrameDamageStats stats = engine.GetScene().GetLastFrameStats();
+    std::printf("one change: %zu checked, %zu recorded\n", stats.elementsChecked, stats.elementsRecorded);
+    CPPLAB_CHECK(stats.elementsChecked == 1 && stats.elementsRecorded == 1);
+
+    //a moved parent takes its children along without marking them, they are measured through the journal
+    const SoftwareRenderDevice& device = engine.GetDevice();
+    const uint32_t red = device.GetPixel(2, 262);
+    panel->setRelativePosition(vec2(300.f, 260.f));
+    engine.RunFrame();
+    stats = engine.GetScene().GetLastFrameStats();
+    CPPLAB_CHECK(stats.elementsChecked == 11);
+    CPPLAB_CHECK(device.GetPixel(302, 262) == red && device.GetPixel(2, 262) != red);
+
+    //a depth change alone resorts the element and repaints it on top
+    grid[0]->setDimensions(vec2(30.f, 30.f));
+    grid[0]->setBackgroundColor(Color(0.f, 1.f, 0.f, 1.f));
+    grid[0]->setDepth(-1.f);
+    engine.RunFrame();
+    CPPLAB_CHECK(device.GetPixel(15, 5) != device.GetPixel(5, 5));
+    grid[0]->setDepth(1.f);
+    engine.RunFrame();
+    CPPLAB_CHECK(engine.GetScene().GetLastFrameStats().elementsChecked == 1);
+    CPPLAB_CHECK(device.GetPixel(15, 5) == device.GetPixel(5, 5));
+
+    for (TextElement* item : items) delete item;
+    delete panel;
+    for (TextElement* cell : grid) delete cell;
+}
+
+static void TestHiddenSubtree() {
+    HeadlessEngine engine(200, 200);
+    ElementNode* root = engine.GetRootNode();
+    engine.GetScene().SetBackgroundColor(Color(0.f, 0.f, 0.f, 1.f));
+    TextElement* panel = AddPatch(root, "panel", RectF(10.f, 10.f, 110.f, 110.f), Color(0.f, 0.f, 1.f, 1.f));
+    TextElement* child = AddPatch(panel, "child", RectF(50.f, 50.f, 150.f, 70.f), Color(1.f, 0.f, 0.f, 1.f));
+    child->setDepth(1.f);
+    engine.RunFrame();
+    const SoftwareRenderDevice& device = engine.GetDevice();
+    const uint32_t background = device.GetPixel(5, 5);
+    const uint32_t red = device.GetPixel(100, 70);
+    CPPLAB_CHECK(red != background && device.GetPixel(150, 70) == red);
+
+    //hiding the parent takes the shown child with it and damages where both were
+    panel->hide();
+    engine.RunFrame();
+    CPPLAB_CHECK(engine.GetScene().GetLastFrameStats().elementsDrawn == 0);
+    CPPLAB_CHECK(device.GetPixel(50, 50) == background && device.GetPixel(150, 70) == background);
+    panel->show();
+    engine.RunFrame();
+    CPPLAB_CHECK(device.GetPixel(150, 70) == red);
+
+    //a clipping parent cuts the child at its box
+    panel->setClipChildren(true);
+    engine.RunFrame();
+    CPPLAB_CHECK(device.GetPixel(100, 70) == red && device.GetPixel(150, 70) == background);
+    panel->setDimensions(vec2(150.f, 100.f));
+    engine.RunFrame();
+    CPPLAB_CHECK(device.GetPixel(150, 70) == red);
+
+    delete child;
+    delete panel;
+}
+
+static void TestDefaultShown() {
+    HeadlessEngine engine(100, 100);
+    engine.GetScene().SetBackgroundColor(Color(0.f, 0.f, 0.f, 1.f));
+    //elements made with the default configuration are shown, a plain container keeps its children drawn
+    ElementNode* container = new ElementNode();
+    engine.GetRootNode()->AddChildElement("container", container);
+    TextElementConfiguration config;
+    config.setText(L"").setBackgroundColor(Color(1.f, 0.f, 0.f, 1.f));
+    config.SetRelativePosition(vec2(10.f, 10.f)).SetDimension(vec2(20.f, 20.f));
+    TextElement* child = new TextElement(config);
+    container->AddChildElement("child", child);
+    CPPLAB_CHECK(!container->isHidden() && !child->isHidden());
+    CPPLAB_CHECK(engine.RunFrame() && engine.GetScene().GetLastFrameStats().elementsDrawn == 1);
+    CPPLAB_CHECK(engine.GetDevice().GetPixel(20, 20) != engine.GetDevice().GetPixel(50, 50));
+    delete child;
+    delete container;
+}
+
+int main() {
+    TestTracker();
+    TestOppositeCorners();
+    TestChangedElementsOnly();
+    TestHiddenSubtree();
+    TestDefaultShown();
+    return 0;
+}
@@ -0,0 +1,138 @@
+//display list files, a saved frame loads into a fresh device and replays to the same pixels the engine drew
+//benchmark: loading and replaying a saved frame of 10k elements into the software device, pass an element count as the first argument
+#include <filesystem>
+#include <thread>
+#include <vector>
+#include "headlessengine.hpp"
+#include "ppmimagedecoder.hpp"
+#include "check.hpp"
+
+using namespace cpplab;
+using namespace std::chrono_literals;
+
+namespace {
+    //loads the file into a device of the engine's size and draws it once, like a viewer would
+    struct Replayed {
+        SoftwareRenderDevice device;
+        DisplayList list;
+        std::vector<uint32_t> order;
+        Color clearColor;
+
+        Replayed(uint32_t width, uint32_t height) : device(width, height) {}
+        bool Load(const std::string& path, ImageDecoder* decoder) {
+            return this->list.Load(path, this->device, decoder, this->order, this->clearColor);
+        }
+        void Draw() {
+            this->device.BeginFrame();
+            this->device.Clear(this->clearColor);
+            this->list.Replay(this->device, this->order);
+            this->device.EndFrame();
+        }
+    };
+}
+
+static void TestRoundTrip() {
+    SoftwareRenderDevice source(16, 16);
+    source.BeginFrame();
+    source.Clear(Color(0.f, 0.6f, 0.2f, 1.f));
+    source.EndFrame();
+    CPPLAB_CHECK(source.SavePPM("displaylist_test.ppm"));
+
+    HeadlessEngine engine(160, 120);
+    engine.GetScene().SetBackgroundColor(Color(0.1f, 0.1f, 0.1f, 1.f));
+    ElementNode* root = engine.GetRootNode();
+    TextElementConfiguration labelConfig;
+    labelConfig.setText(L"display list").setBackgroundColor(Color(0.9f, 0.9f, 0.9f, 1.f)).setTextColor(Color(0.f, 0.f, 0.f, 1.f));
+    labelConfig.setBorderColor(Color(1.f, 0.f, 0.f, 1.f)).setBorderWidth(2.f).setRoundedEdgeRadius(4.f);
+    labelConfig.SetRelativePosition(vec2(10.f, 10.f)).SetDimension(vec2(120.f, 30.f));
+    TextElement* label = new TextElement(labelConfig);
+    root->AddChildElement("label", label);
+    TextElementConfiguration patchConfig;
+    patchConfig.setText(L"").setBackgroundColor(Color(0.f, 0.f, 1.f, 1.f));
+    patchConfig.SetRelativePosition(vec2(100.f, 30.f)).SetDimension(vec2(40.f, 60.f)).SetDepth(1.f);
+    TextElement* patch = new TextElement(patchConfig);
+    patch->setOpacity(0.5f);
+    root->AddChildElement("patch", patch);
+    ImageElementConfiguration imageConfig;
+    imageConfig.setImageFile(L"displaylist_test.ppm", ImageType::FILE);
+    imageConfig.SetRelativePosition(vec2(20.f, 60.f)).SetDimension(vec2(16.f, 16.f));
+    ImageElement* image = new ImageElement(imageConfig);
+    root->AddChildElement("image", image);
+    TextElementConfiguration hiddenConfig;
+    hiddenConfig.setText(L"").setBackgroundColor(Color(1.f, 1.f, 0.f, 1.f));
+    hiddenConfig.SetDimension(vec2(160.f, 120.f)).SetDepth(5.f).SetHidden(true);
+    TextElement* hidden = new TextElement(hiddenConfig);
+    root->AddChildElement("hidden", hidden);
+
+    //the image decodes on the cache's workers
+    const auto start = std::chrono::steady_clock::now();
+    while (engine.GetScene().GetRebuildStats().bitmapUploads == 0 && cpplab::testing::MillisecondsSince(start) < 5000.0) {
+        engine.RunFrame();
+        std::this_thread::sleep_for(1ms);
+    }
+    engine.RunFrame();
+    CPPLAB_CHECK(engine.GetScene().GetRebuildStats().bitmapUploads == 1);
+    CPPLAB_CHECK(engine.GetScene().SaveDisplayList("displaylist_test.dl"));
+
+    Replayed replayed(160, 120);
+    PPMImageDecoder decoder;
+    CPPLAB_CHECK(replayed.Load("displaylist_test.dl", &decoder));
+    //the root and the three shown elements, hidden ones are left out of the file
+    CPPLAB_CHECK(replayed.order.size() == 4 && replayed.list.CommandCount() > 0);
+    replayed.Draw();
+    CPPLAB_CHECK(replayed.device.GetPixels() == engine.GetDevice().GetPixels());
+    CPPLAB_CHECK(replayed.device.GetPixel(28, 68) == engine.GetDevice().GetPixel(28, 68));
+
+    //without a decoder the image is left out and the rest still replays
+    Replayed noImages(160, 120);
+    CPPLAB_CHECK(noImages.Load("displaylist_test.dl", nullptr));
+    noImages.Draw();
+    CPPLAB_CHECK(noImages.device.GetPixel(28, 68) != engine.GetDevice().GetPixel(28, 68));
+    CPPLAB_CHECK(noImages.device.GetPixel(60, 20) == engine.GetDevice().GetPixel(60, 20));
+    //a missing file loads nothing
+    CPPLAB_CHECK(!noImages.Load("displaylist_test_missing.dl", nullptr));
+
+    delete hidden;
+    delete image;
+    delete patch;
+    delete label;
+}
+
+static void BenchmarkReplay(size_t elementCount) {
+    HeadlessEngine engine(1000, 1000);
+    std::vector<TextElement*> patches;
+    for (size_t i = 0; i < elementCount; ++i) {
+        TextElementConfiguration config;
+        config.setText(L"").setBackgroundColor(Color(static_cast<float>(i % 7) / 7.f, 0.3f, 0.6f, 1.f)).setBorderWidth(1.f);
+        config.SetRelativePosition(vec2(static_cast<float>(i % 100) * 10.f, static_cast<float>(i / 100 % 100) * 10.f)).SetDimension(vec2(9.f, 9.f));
+        patches.push_back(new TextElement(config));
+        engine.GetRootNode()->AddChildElement(std::to_string(i), patches.back());
+    }
+    engine.RunFrame();
+
+    auto start = std::chrono::steady_clock::now();
+    CPPLAB_CHECK(engine.GetScene().SaveDisplayList("displaylist_bench.dl"));
+    const double saveMilliseconds = cpplab::testing::MillisecondsSince(start);
+    Replayed replayed(1000, 1000);
+    start = std::chrono::steady_clock::now();
+    CPPLAB_CHECK(replayed.Load("displaylist_bench.dl", nullptr));
+    const double loadMilliseconds = cpplab::testing::MillisecondsSince(start);
+
+    constexpr int Frames = 10;
+    start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < Frames; ++frame) replayed.Draw();
+    const double replayMilliseconds = cpplab::testing::MillisecondsSince(start) / Frames;
+    CPPLAB_CHECK(replayed.device.GetPixels() == engine.GetDevice().GetPixels());
+
+    std::printf("%zu elements, %zu commands, %ju KB: save %.2f ms, load %.2f ms, replay %.2f ms a frame (%.1f M commands a second)\n",
+        elementCount, replayed.list.CommandCount(), static_cast<uintmax_t>(std::filesystem::file_size("displaylist_bench.dl") / 1024),
+        saveMilliseconds, loadMilliseconds, replayMilliseconds,
+        static_cast<double>(replayed.list.CommandCount()) / replayMilliseconds / 1000.0);
+    for (TextElement* patch : patches) delete patch;
+}
+
+int main(int argc, char** argv) {
+    TestRoundTrip();
+    BenchmarkReplay(cpplab::testing::SizeArgument(argc, argv, 2000));
+    return 0;
+}
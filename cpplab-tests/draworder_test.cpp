@@ -0,0 +1,127 @@
+//draw order under random inserts, removes and depth churn, compared with a full sort after every commit
+//benchmark: building the order for 50k nodes, pass a node count as the first argument
+#include <algorithm>
+#include <map>
+#include <random>
+#include <tuple>
+#include <vector>
+#include "draworder.hpp"
+#include "check.hpp"
+
+using namespace cpplab;
+
+namespace {
+    //depth and insertion sequence of every id in the list
+    using Reference = std::map<uint32_t, std::pair<float, uint64_t>>;
+
+    void CheckOrder(const DrawOrderList& list, const Reference& reference) {
+        std::vector<std::tuple<float, uint64_t, uint32_t>> expected;
+        for (const auto& [id, key] : reference) {
+            expected.push_back({ key.first, key.second, id });
+        }
+        std::sort(expected.begin(), expected.end());
+        CPPLAB_CHECK(list.Size() == expected.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            CPPLAB_CHECK(list.Entries()[i].id == std::get<2>(expected[i]));
+            CPPLAB_CHECK(list.Entries()[i].depth == std::get<0>(expected[i]));
+        }
+    }
+}
+
+static void TestChurn() {
+    DrawOrderList list;
+    Reference reference;
+    uint64_t sequence = 0;
+    std::mt19937 rng(3);
+    for (int round = 0; round < 2000; ++round) {
+        //few distinct depths, so equal depths and the insertion order tie break come up all the time
+        const int changes = static_cast<int>(rng() % 20);
+        for (int change = 0; change < changes; ++change) {
+            const uint32_t id = rng() % 500;
+            switch (rng() % 4) {
+            case 0:
+                if (reference.count(id) == 0) {
+                    const float depth = static_cast<float>(rng() % 10);
+                    list.Insert(id, depth);
+                    reference[id] = { depth, sequence++ };
+                }
+                break;
+            case 1:
+                list.Remove(id);
+                reference.erase(id);
+                break;
+            case 2:
+                //by id, also for entries inserted in this batch and not sorted in yet
+                if (reference.count(id) != 0) {
+                    const float depth = static_cast<float>(rng() % 10);
+                    list.SetDepth(id, depth);
+                    reference[id].first = depth;
+                }
+                break;
+            default:
+                //inserting an id removed in the same batch gives it a new place
+                if (reference.count(id) != 0) {
+                    list.Remove(id);
+                    const float depth = static_cast<float>(rng() % 10);
+                    list.Insert(id, depth);
+                    reference[id] = { depth, sequence++ };
+                }
+                break;
+            }
+        }
+        list.Commit();
+        CheckOrder(list, reference);
+
+        //depth churn by position, as the full refresh does
+        const std::vector<DrawOrderList::Entry>& entries = list.Entries();
+        for (size_t position = 0; position < entries.size(); ++position) {
+            if (rng() % 10 != 0) continue;
+            const float depth = static_cast<float>(rng() % 10);
+            reference[entries[position].id].first = depth;
+            list.SetDepthAt(position, depth);
+        }
+        list.Commit();
+        CheckOrder(list, reference);
+        CPPLAB_CHECK(!list.HasQueuedChanges());
+    }
+
+    list.Clear();
+    CPPLAB_CHECK(list.Size() == 0 && !list.Contains(0));
+}
+
+static void BenchmarkBuild(size_t nodeCount) {
+    std::mt19937 rng(5);
+    std::vector<float> depths(nodeCount);
+    for (float& depth : depths) depth = static_cast<float>(rng() % 100);
+
+    //one batch for the whole tree, like the first BuildNodeList
+    DrawOrderList list;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t id = 0; id < nodeCount; ++id) {
+        list.Insert(id, depths[id]);
+    }
+    list.Commit();
+    const double buildMilliseconds = cpplab::testing::MillisecondsSince(start);
+    CPPLAB_CHECK(list.Size() == nodeCount);
+
+    //a hundred depth changes and a hundred new nodes in a later frame
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < 100; ++i) {
+        list.SetDepth(static_cast<uint32_t>(rng() % nodeCount), static_cast<float>(rng() % 100));
+        list.Insert(static_cast<uint32_t>(nodeCount) + i, static_cast<float>(rng() % 100));
+    }
+    list.Commit();
+    const double updateMilliseconds = cpplab::testing::MillisecondsSince(start);
+    CPPLAB_CHECK(list.Size() == nodeCount + 100);
+    for (size_t i = 1; i < list.Size(); ++i) {
+        CPPLAB_CHECK(list.Entries()[i - 1].depth <= list.Entries()[i].depth);
+    }
+
+    std::printf("%zu nodes: build %.2f ms, 200 changes %.3f ms\n", nodeCount, buildMilliseconds, updateMilliseconds);
+}
+
+int main(int argc, char** argv) {
+    TestChurn();
+    BenchmarkBuild(cpplab::testing::SizeArgument(argc, argv, 50000));
+    return 0;
+}
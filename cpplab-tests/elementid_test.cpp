@@ -0,0 +1,211 @@
+//interned ids, child tables against a reference map and path lookups through edits
+//benchmark: id lookups, path resolves and child enumeration on 100k nodes with allocations counted, pass a node count as the first argument
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "elementtreebuilder.hpp"
+#include "elementpathindex.hpp"
+#include "check.hpp"
+
+using namespace cpplab;
+
+//every allocation of the process is counted, the lookups under test must not make any
+static std::atomic<size_t> allocations = 0;
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void* block = std::malloc(size != 0 ? size : 1);
+    if (block == nullptr) throw std::bad_alloc();
+    return block;
+}
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+void operator delete(void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+static void TestInterning() {
+    ElementIdTable& table = ElementIdTable::Instance();
+    const ElementId id = table.Intern("interned id");
+    CPPLAB_CHECK(id.IsValid() && table.Intern("interned id") == id && table.Find("interned id") == id);
+    CPPLAB_CHECK(table.Name(id) == "interned id" && table.Name(ElementId()).empty());
+    //finding never adds
+    const size_t size = table.Size();
+    CPPLAB_CHECK(!table.Find("an id nobody added").IsValid() && table.Size() == size);
+}
+
+static void TestChildTable() {
+    //fake element pointers, the table never dereferences them
+    ChildTable table;
+    std::unordered_map<uint32_t, ElementNode*> reference;
+    std::mt19937 rng(23);
+    for (int step = 0; step < 100000; ++step) {
+        //grows past the linear limit into the hashed layout and shrinks back
+        const uint32_t atom = 1 + rng() % 300;
+        ElementNode* element = reinterpret_cast<ElementNode*>(static_cast<uintptr_t>(atom) * 16);
+        if (rng() % 3 != 0) {
+            CPPLAB_CHECK(table.Insert(ElementId{ atom }, element) == (reference.count(atom) == 0));
+            reference.emplace(atom, element);
+        }
+        else {
+            const auto found = reference.find(atom);
+            CPPLAB_CHECK(table.Erase(ElementId{ atom }) == (found != reference.end() ? found->second : nullptr));
+            reference.erase(atom);
+        }
+        if (step % 97 != 0) continue;
+        CPPLAB_CHECK(table.Size() == reference.size());
+        for (const auto& [key, value] : reference) {
+            CPPLAB_CHECK(table.Find(ElementId{ key }) == value);
+        }
+        for (const ChildEntry& entry : table.Entries()) {
+            CPPLAB_CHECK(reference[entry.id.atom] == entry.element);
+        }
+    }
+}
+
+static void TestPaths() {
+    ElementNode root;
+    ElementNode* sidebar = new ElementNode();
+    root.AddChildElement("sidebar", sidebar);
+    ElementNode* list = new ElementNode();
+    sidebar->AddChildElement("list", list);
+    std::vector<ElementNode*> rows;
+    for (int i = 0; i < 50; ++i) {
+        rows.push_back(new ElementNode());
+        list->AddChildElement("row" + std::to_string(i), rows.back());
+    }
+
+    ElementPathIndex index(&root);
+    CPPLAB_CHECK(index.Resolve("") == &root && index.Resolve("sidebar") == sidebar && index.Resolve("sidebar/list") == list);
+    CPPLAB_CHECK(index.Resolve("sidebar/list/row42") == rows[42] && rows[42]->getSelfId() == "row42");
+    CPPLAB_CHECK(index.Resolve("sidebar/list/row50") == nullptr && index.Resolve("list/row4") == nullptr);
+    CPPLAB_CHECK(index.Resolve("sidebar/list/") == nullptr && index.Resolve("/sidebar") == nullptr);
+
+    //a removed node keeps its id until added again under a new one
+    list->DeleteChildElement("row7");
+    CPPLAB_CHECK(index.Resolve("sidebar/list/row7") == nullptr && rows[7]->getSelfId() == "row7");
+    sidebar->AddChildElement("moved", rows[7]);
+    CPPLAB_CHECK(index.Resolve("sidebar/moved") == rows[7] && rows[7]->getSelfId() == "moved");
+    delete rows[3];
+    rows[3] = nullptr;
+    CPPLAB_CHECK(index.Resolve("sidebar/list/row3") == nullptr && list->GetChildren().size() == 48);
+
+    //unknown, removed and duplicate ids throw
+    CPPLAB_CHECK_THROWS(list->GetChildElement("never interned"));
+    CPPLAB_CHECK_THROWS(list->DeleteChildElement("row3"));
+    ElementNode* duplicate = new ElementNode();
+    CPPLAB_CHECK_THROWS(list->AddChildElement("row4", duplicate));
+    delete duplicate;
+    size_t visited = 0;
+    list->ForEachChildElement([&visited](ElementId id, ElementNode* child) {
+        CPPLAB_CHECK(child->getSelfElementId() == id);
+        ++visited;
+    });
+    CPPLAB_CHECK(visited == 48);
+
+    //the builder interns while adding, the index sees its elements after the attach
+    ElementTreeBuilder builder;
+    const uint32_t panel = builder.Create<ElementNode>(ElementTreeBuilder::Target, "panel");
+    const uint32_t button = builder.Create<ElementNode>(panel, "button");
+    ElementNode* panelNode = builder.GetElement(panel);
+    ElementNode* buttonNode = builder.GetElement(button);
+    builder.AttachTo(sidebar);
+    CPPLAB_CHECK(index.Resolve("sidebar/panel/button") == buttonNode);
+    CPPLAB_CHECK(index.GetStats().rebuilds >= 3);
+
+    delete buttonNode;
+    delete panelNode;
+    for (ElementNode* row : rows) delete row;
+    delete list;
+    delete sidebar;
+}
+
+static void BenchmarkLookups(size_t nodeCount) {
+    //groups of a thousand rows, built once with the builder
+    const size_t groups = (std::max)(nodeCount / 1000, size_t(1));
+    ElementNode root;
+    ElementNode* big = new ElementNode();
+    root.AddChildElement("big", big);
+    std::vector<std::string> groupNames;
+    std::vector<std::string> rowNames;
+    for (size_t g = 0; g < groups; ++g) groupNames.push_back("g" + std::to_string(g));
+    for (size_t r = 0; r < 999; ++r) rowNames.push_back("r" + std::to_string(r));
+    ElementTreeBuilder builder;
+    builder.Reserve(groups * 1000);
+    for (size_t g = 0; g < groups; ++g) {
+        const uint32_t group = builder.Create<ElementNode>(ElementTreeBuilder::Target, groupNames[g]);
+        for (size_t r = 0; r < rowNames.size(); ++r) builder.Create<ElementNode>(group, rowNames[r]);
+    }
+    std::vector<ElementNode*> made;
+    for (uint32_t entry = 0; entry < builder.Size(); ++entry) made.push_back(builder.GetElement(entry));
+    builder.AttachTo(big);
+
+    std::vector<ElementId> rowIds;
+    for (const std::string& name : rowNames) rowIds.push_back(ElementIdTable::Instance().Find(name));
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < 100000; ++i) {
+        paths.push_back("big/" + groupNames[i % groups] + "/" + rowNames[(i * 7) % rowNames.size()]);
+    }
+    ElementNode* group = big->GetChildElement(groupNames[groups / 2]);
+    ElementPathIndex index(&root);
+    index.Resolve("");
+    constexpr size_t Lookups = 1000000;
+
+    size_t hits = 0;
+    size_t before = allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < Lookups; ++i) hits += group->GetChildElement(rowIds[i % rowIds.size()]) != nullptr;
+    const double idMilliseconds = cpplab::testing::MillisecondsSince(start);
+    CPPLAB_CHECK(allocations.load() == before);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < Lookups; ++i) hits += group->GetChildElement(rowNames[i % rowNames.size()]) != nullptr;
+    const double nameMilliseconds = cpplab::testing::MillisecondsSince(start);
+    CPPLAB_CHECK(allocations.load() == before);
+
+    start = std::chrono::steady_clock::now();
+    for (const std::string& path : paths) hits += index.Resolve(path) != nullptr;
+    const double pathMilliseconds = cpplab::testing::MillisecondsSince(start);
+    CPPLAB_CHECK(allocations.load() == before);
+    CPPLAB_CHECK(hits == 2 * Lookups + paths.size());
+
+    //the whole tree through the stored children, then the copying enumeration it replaces
+    size_t enumerated = 0;
+    start = std::chrono::steady_clock::now();
+    for (const ChildEntry& child : big->GetChildren()) {
+        enumerated += 1 + child.element->GetChildren().size();
+    }
+    const double spanMilliseconds = cpplab::testing::MillisecondsSince(start);
+    CPPLAB_CHECK(allocations.load() == before && enumerated == made.size());
+
+    size_t copied = 0;
+    start = std::chrono::steady_clock::now();
+    for (const std::string& id : big->GetAllChildElements()) {
+        copied += 1 + big->GetChildElement(id)->GetAllChildElements().size();
+    }
+    const double copyMilliseconds = cpplab::testing::MillisecondsSince(start);
+    const size_t copyAllocations = allocations.load() - before;
+    CPPLAB_CHECK(copied == made.size());
+
+    std::printf("%zu nodes: 1M id lookups %.1f ms, 1M name lookups %.1f ms, 100k path resolves %.1f ms (%llu extra probes), none allocating\n",
+        made.size(), idMilliseconds, nameMilliseconds, pathMilliseconds, static_cast<unsigned long long>(index.GetStats().extraProbes));
+    std::printf("%zu nodes: enumerating the stored children %.2f ms, GetAllChildElements %.2f ms with %zu allocations\n",
+        made.size(), spanMilliseconds, copyMilliseconds, copyAllocations);
+
+    for (size_t i = made.size(); i-- > 0;) {
+        delete made[i];
+    }
+    delete big;
+}
+
+int main(int argc, char** argv) {
+    TestInterning();
+    TestChildTable();
+    TestPaths();
+    BenchmarkLookups(cpplab::testing::SizeArgument(argc, argv, 20000));
+    return 0;
+}
@@ -0,0 +1,125 @@
+//element store tree operations and handles, the facade keeps the old ElementNode behavior
+//benchmark: building, counting and publishing a wide tree, pass a node count as the first argument
+#include <string>
+#include <vector>
+#include "engineelements.hpp"
+#include "check.hpp"
+
+using namespace cpplab;
+
+static void TestTree() {
+    ElementNode root;
+    TextElement* a = new TextElement();
+    ImageElement* b = new ImageElement();
+    ElementNode* c = new ElementNode();
+    root.AddChildElement("a", a);
+    a->AddChildElement("b", b);
+    root.AddChildElement("c", c);
+    a->setRelativePosition(vec2(10.f, 10.f));
+    b->setRelativePosition(vec2(1.f, 2.f));
+    CPPLAB_CHECK(b->getTruePosition() == vec2(11.f, 12.f));
+    CPPLAB_CHECK(root.RecursiveCountAllChildNodes() == 3 && a->RecursiveCountAllChildNodes() == 1);
+    CPPLAB_CHECK(b->getNodeType() == NodeType::IMAGE);
+    //tree scans take the root, an inner index is no tree of its own
+    ElementStore& store = ElementStore::Instance();
+    std::vector<ElementNode*> members;
+    store.CollectTree(root.getHandle().index, members);
+    CPPLAB_CHECK(store.CountTree(root.getHandle().index) == 4 && members.size() == 4 && members[0] == &root && members[2] == b);
+    store.CollectTree(a->getHandle().index, members);
+    CPPLAB_CHECK(store.CountTree(a->getHandle().index) == 0 && members.empty() && store.CountSubtree(a->getHandle().index) == 2);
+
+    //one parent per node and no cycles
+    CPPLAB_CHECK_THROWS(c->AddChildElement("x", b));
+    CPPLAB_CHECK_THROWS(b->AddChildElement("x", a));
+    //ids are unique among siblings
+    ElementNode* duplicate = new ElementNode();
+    CPPLAB_CHECK_THROWS(root.AddChildElement("c", duplicate));
+    delete duplicate;
+
+    //deleting a node unlinks it, its children stay with the caller and become roots
+    delete a;
+    CPPLAB_CHECK(root.RecursiveCountAllChildNodes() == 1 && b->RecursiveCountAllChildNodes() == 0);
+    const std::vector<std::string> ids = root.GetAllChildElements();
+    CPPLAB_CHECK(ids.size() == 1 && ids[0] == "c");
+    delete b;
+    delete c;
+}
+
+static void TestHandles() {
+    ElementStore& store = ElementStore::Instance();
+    ElementNode* node = new ElementNode();
+    const ElementHandle handle = node->getHandle();
+    CPPLAB_CHECK(store.Resolve(handle) == node);
+    delete node;
+    CPPLAB_CHECK(store.Resolve(handle) == nullptr);
+
+    //a reused slot gets a new generation, the old handle stays dead
+    ElementNode* reused = new ElementNode();
+    if (reused->getHandle().index == handle.index) {
+        CPPLAB_CHECK(reused->getHandle().generation != handle.generation);
+    }
+    CPPLAB_CHECK(store.Resolve(handle) == nullptr && store.Resolve(reused->getHandle()) == reused);
+    delete reused;
+}
+
+static void BenchmarkWideTree(size_t nodeCount) {
+    ElementStore& store = ElementStore::Instance();
+    ElementNode root;
+    std::vector<ElementNode*> nodes;
+    nodes.reserve(nodeCount);
+
+    //a hundred panels with the rest spread below them, like a large dashboard
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < nodeCount; ++i) {
+        ElementNode* node = new ElementNode();
+        ElementNode* parent = i < 100 ? &root : nodes[i % 100];
+        parent->AddChildElement(std::to_string(i), node);
+        nodes.push_back(node);
+    }
+    const double buildMilliseconds = cpplab::testing::MillisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    const size_t counted = root.RecursiveCountAllChildNodes();
+    const double countMilliseconds = cpplab::testing::MillisecondsSince(start);
+    CPPLAB_CHECK(counted == nodeCount);
+
+    const uint32_t rootIndex = root.getHandle().index;
+    start = std::chrono::steady_clock::now();
+    CPPLAB_CHECK(store.IsSubtreeDirty(rootIndex));
+    CPPLAB_CHECK(store.Publish(rootIndex));
+    const double publishMilliseconds = cpplab::testing::MillisecondsSince(start);
+    CPPLAB_CHECK(!store.IsSubtreeDirty(rootIndex));
+
+    start = std::chrono::steady_clock::now();
+    std::vector<uint32_t> indices;
+    store.CollectTreeIndices(rootIndex, indices);
+    const double scanMilliseconds = cpplab::testing::MillisecondsSince(start);
+    CPPLAB_CHECK(indices.size() == nodeCount + 1);
+
+    //a small tree next to the big one costs what its own nodes cost, a thousand rounds in milliseconds is microseconds a round
+    ElementNode small;
+    ElementNode* leaf = new ElementNode();
+    small.AddChildElement("leaf", leaf);
+    std::vector<ElementNode*> members;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 1000; ++i) {
+        store.CollectTree(small.getHandle().index, members);
+        CPPLAB_CHECK(store.CountTree(small.getHandle().index) == 2 && members.size() == 2);
+    }
+    const double smallMicroseconds = cpplab::testing::MillisecondsSince(start);
+    delete leaf;
+
+    std::printf("%zu nodes: build %.2f ms, count %.2f ms, first publish %.2f ms, published scan %.2f ms, small tree count and collect %.3f us\n",
+        nodeCount, buildMilliseconds, countMilliseconds, publishMilliseconds, scanMilliseconds, smallMicroseconds);
+    //children first, the panels go last
+    for (size_t i = nodeCount; i-- > 0;) {
+        delete nodes[i];
+    }
+}
+
+int main(int argc, char** argv) {
+    TestTree();
+    TestHandles();
+    BenchmarkWideTree(cpplab::testing::SizeArgument(argc, argv, 10000));
+    return 0;
+}
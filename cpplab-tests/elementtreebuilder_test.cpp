@@ -0,0 +1,207 @@
+//tree builder, a batch attaches in one step and a failed check leaves the tree and the batch as they were
+//benchmark: building a 100k node tree with AddChildElement and with the builder, pass a node count as the first argument
+#include <functional>
+#include <string>
+#include <vector>
+#include "headlessengine.hpp"
+#include "elementtreebuilder.hpp"
+#include "check.hpp"
+
+using namespace cpplab;
+
+namespace {
+    class NullListener : public IMouseEventListener {
+    public:
+        void OnMouseDown(vec2, Button, size_t) override {}
+        void OnMouseUp(vec2, Button) override {}
+        void OnMouseHover(vec2, size_t) override {}
+        void OnMouseLeaveHover(vec2) override {}
+    };
+}
+
+static void DeleteEntries(ElementTreeBuilder& builder) {
+    for (uint32_t entry = static_cast<uint32_t>(builder.Size()); entry-- > 0;) {
+        delete builder.GetElement(entry);
+    }
+    builder.Clear();
+}
+
+static void TestAttach() {
+    HeadlessEngine engine(200, 200);
+    ElementStore& store = ElementStore::Instance();
+    ElementNode* root = engine.GetRootNode();
+    engine.RunFrame();
+    NullListener listener;
+
+    ElementTreeBuilder builder;
+    const uint32_t panel = builder.Create<ElementNode>(ElementTreeBuilder::Target, "panel", ElementNodeConfiguration().SetRelativePosition(vec2(10.f, 10.f)).SetHidden(false));
+    TextElementConfiguration config;
+    config.setText(L"hi").SetRelativePosition(vec2(5.f, 5.f)).SetDimension(vec2(50.f, 20.f)).SetHidden(false);
+    const uint32_t first = builder.Create<TextElement>(panel, "first", config);
+    const uint32_t second = builder.Create<TextElement>(panel, "second", config);
+    builder.Create<ElementNode>(second, "inner");
+    builder.AddClickListener(first, "click", &listener);
+    ElementNode* panelNode = builder.GetElement(panel);
+    //nothing is linked before AttachTo
+    CPPLAB_CHECK(panelNode->RecursiveCountAllChildNodes() == 0);
+    const uint64_t editsBefore = store.StructureEdits();
+    builder.AttachTo(root);
+    CPPLAB_CHECK(builder.Size() == 0 && store.StructureEdits() != editsBefore);
+    CPPLAB_CHECK(root->GetChildElement("panel") == panelNode && panelNode->RecursiveCountAllChildNodes() == 3);
+    ElementNode* firstNode = panelNode->GetChildElement("first");
+    ElementNode* secondNode = panelNode->GetChildElement("second");
+    ElementNode* inner = secondNode->GetChildElement("inner");
+    CPPLAB_CHECK(firstNode->getSelfId() == "first" && inner->getTruePosition() == vec2(15.f, 15.f));
+    //children keep the order they were added in
+    CPPLAB_CHECK(store.FirstChild(panelNode->getHandle().index) == firstNode->getHandle().index);
+    CPPLAB_CHECK(engine.RunFrame() && store.WorldX(firstNode->getHandle().index) == 15.f);
+
+    //a failed check throws before anything is linked and keeps the batch
+    ElementTreeBuilder failing;
+    failing.Create<ElementNode>(ElementTreeBuilder::Target, "panel");
+    CPPLAB_CHECK_THROWS(failing.AttachTo(root));
+    CPPLAB_CHECK(failing.Size() == 1 && root->RecursiveCountAllChildNodes() == 4);
+    DeleteEntries(failing);
+    //duplicate ids among new siblings
+    const uint32_t holder = failing.Create<ElementNode>(ElementTreeBuilder::Target, "holder");
+    failing.Create<ElementNode>(holder, "x");
+    failing.Create<ElementNode>(holder, "x");
+    CPPLAB_CHECK_THROWS(failing.AttachTo(root));
+    CPPLAB_CHECK(root->RecursiveCountAllChildNodes() == 4);
+    DeleteEntries(failing);
+    //the same element twice, or one that already has a parent
+    ElementNode* loose = new ElementNode();
+    failing.Add(ElementTreeBuilder::Target, "a", loose);
+    failing.Add(ElementTreeBuilder::Target, "b", loose);
+    CPPLAB_CHECK_THROWS(failing.AttachTo(root));
+    failing.Clear();
+    failing.Add(ElementTreeBuilder::Target, "a", firstNode);
+    CPPLAB_CHECK_THROWS(failing.AttachTo(root));
+    failing.Clear();
+    //a subtree attached below itself
+    ElementNode* top = new ElementNode();
+    ElementNode* below = new ElementNode();
+    top->AddChildElement("below", below);
+    failing.Add(ElementTreeBuilder::Target, "top", top);
+    CPPLAB_CHECK_THROWS(failing.AttachTo(below));
+    failing.Clear();
+    //listener ids collide like element ids, entries must come from this batch
+    const uint32_t listened = failing.Add(ElementTreeBuilder::Target, "loose", loose);
+    failing.AddClickListener(listened, "click", &listener);
+    failing.AddClickListener(listened, "click", &listener);
+    CPPLAB_CHECK_THROWS(failing.AttachTo(root));
+    CPPLAB_CHECK_THROWS(failing.Add(7, "bad", loose));
+    failing.Clear();
+
+    //an element built the old way keeps its children, they join the target's tree with it
+    failing.Add(ElementTreeBuilder::Target, "top", top);
+    failing.AttachTo(root);
+    CPPLAB_CHECK(store.Root(below->getHandle().index) == store.Root(root->getHandle().index) && root->RecursiveCountAllChildNodes() == 6);
+    engine.RunFrame();
+    CPPLAB_CHECK(store.IsInTree(below->getHandle().index, root->getHandle().index));
+
+    delete inner;
+    delete firstNode;
+    delete secondNode;
+    delete panelNode;
+    delete below;
+    delete top;
+    delete loose;
+}
+
+static void BenchmarkBuild(size_t nodeCount) {
+    HeadlessEngine engine(200, 200);
+    ElementNode* root = engine.GetRootNode();
+
+    //build runs the code under test, the first frame publishes what it made
+    const auto measure = [&](const char* name, const std::function<void(ElementNode*, std::vector<ElementNode*>&)>& build) {
+        ElementNode* panel = new ElementNode();
+        root->AddChildElement("bench", panel);
+        engine.RunFrame();
+        std::vector<ElementNode*> made;
+        made.reserve(nodeCount + 1000);
+        auto start = std::chrono::steady_clock::now();
+        build(panel, made);
+        const double buildMilliseconds = cpplab::testing::MillisecondsSince(start);
+        start = std::chrono::steady_clock::now();
+        engine.RunFrame();
+        const double frameMilliseconds = cpplab::testing::MillisecondsSince(start);
+        CPPLAB_CHECK(panel->RecursiveCountAllChildNodes() == made.size());
+        std::printf("%-26s build %8.2f ms, first frame %8.2f ms (%zu nodes)\n", name, buildMilliseconds, frameMilliseconds, made.size());
+        for (size_t i = made.size(); i-- > 0;) {
+            delete made[i];
+        }
+        delete panel;
+        engine.RunFrame();
+    };
+    const size_t groups = 100;
+    const size_t perGroup = nodeCount / groups - 1;
+
+    measure("add, flat", [&](ElementNode* panel, std::vector<ElementNode*>& made) {
+        for (size_t i = 0; i < nodeCount; ++i) {
+            made.push_back(new ElementNode());
+            panel->AddChildElement(std::to_string(i), made.back());
+        }
+    });
+    measure("add, 100 groups", [&](ElementNode* panel, std::vector<ElementNode*>& made) {
+        for (size_t g = 0; g < groups; ++g) {
+            ElementNode* group = new ElementNode();
+            made.push_back(group);
+            panel->AddChildElement(std::to_string(g), group);
+            for (size_t i = 0; i < perGroup; ++i) {
+                made.push_back(new ElementNode());
+                group->AddChildElement(std::to_string(i), made.back());
+            }
+        }
+    });
+    measure("builder, flat", [&](ElementNode* panel, std::vector<ElementNode*>& made) {
+        ElementTreeBuilder builder;
+        builder.Reserve(nodeCount);
+        for (size_t i = 0; i < nodeCount; ++i) {
+            made.push_back(new ElementNode());
+            builder.Add(ElementTreeBuilder::Target, std::to_string(i), made.back());
+        }
+        builder.AttachTo(panel);
+    });
+    measure("builder, 100 groups", [&](ElementNode* panel, std::vector<ElementNode*>& made) {
+        ElementTreeBuilder builder;
+        builder.Reserve(nodeCount);
+        for (size_t g = 0; g < groups; ++g) {
+            made.push_back(new ElementNode());
+            const uint32_t group = builder.Add(ElementTreeBuilder::Target, std::to_string(g), made.back());
+            for (size_t i = 0; i < perGroup; ++i) {
+                made.push_back(new ElementNode());
+                builder.Add(group, std::to_string(i), made.back());
+            }
+        }
+        builder.AttachTo(panel);
+    });
+
+    //the attach step alone, elements and ids made up front
+    std::vector<ElementNode*> elements;
+    std::vector<std::string> ids;
+    for (size_t i = 0; i < nodeCount; ++i) {
+        elements.push_back(new ElementNode());
+        ids.push_back(std::to_string(i));
+    }
+    ElementNode* panel = new ElementNode();
+    root->AddChildElement("attach", panel);
+    ElementTreeBuilder builder;
+    builder.Reserve(nodeCount);
+    for (size_t i = 0; i < nodeCount; ++i) {
+        builder.Add(ElementTreeBuilder::Target, ids[i], elements[i]);
+    }
+    const auto start = std::chrono::steady_clock::now();
+    builder.AttachTo(panel);
+    const double attachMilliseconds = cpplab::testing::MillisecondsSince(start);
+    CPPLAB_CHECK(panel->RecursiveCountAllChildNodes() == nodeCount);
+    std::printf("%-26s %.2f ms for %zu nodes\n", "AttachTo alone", attachMilliseconds, nodeCount);
+    for (ElementNode* element : elements) delete element;
+    delete panel;
+}
+
+int main(int argc, char** argv) {
+    TestAttach();
+    BenchmarkBuild(cpplab::testing::SizeArgument(argc, argv, 20000));
+    return 0;
+}
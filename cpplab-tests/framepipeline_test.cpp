@@ -0,0 +1,203 @@
+//render thread pipeline, snapshots reach the device in order, a full queue holds the ui back and shutdown replays what was queued
+//benchmark: frames a second through the pipeline into a device that draws nothing, pass a frame count as the first argument
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "framepipeline.hpp"
+#include "check.hpp"
+
+using namespace cpplab;
+using namespace std::chrono_literals;
+
+namespace {
+    std::atomic<int> liveBitmaps = 0;
+
+    class StubBitmap : public RenderBitmap {
+    public:
+        vec2 size;
+        StubBitmap(vec2 size) : size(size) {
+            ++liveBitmaps;
+        }
+        ~StubBitmap() {
+            --liveBitmaps;
+        }
+        vec2 GetSize() const override {
+            return this->size;
+        }
+    };
+
+    //counts what it is asked to draw, EndFrame waits while the gate is closed and can report a lost target once
+    class CountingDevice : public RenderDevice {
+    public:
+        std::atomic<int> framesBegun = 0;
+        std::atomic<int> framesPresented = 0;
+        std::atomic<int> fills = 0;
+        std::atomic<int> bitmapsCreated = 0;
+        std::atomic<bool> gateOpen = true;
+        std::atomic<bool> loseNextFrame = false;
+        //the clear colour's red channel of every presented frame, render thread only until the pipeline is idle
+        std::vector<float> presentedReds;
+        float currentRed = 0.f;
+
+        void BeginFrame() override {
+            ++this->framesBegun;
+            this->framesBegun.notify_all();
+        }
+        bool EndFrame() override {
+            this->gateOpen.wait(false);
+            this->presentedReds.push_back(this->currentRed);
+            ++this->framesPresented;
+            return !this->loseNextFrame.exchange(false);
+        }
+        vec2 GetSize() const override {
+            return vec2(64.f, 64.f);
+        }
+        void Clear(const Color& color) override {
+            this->currentRed = color.r;
+        }
+        void SetTransform(const Transform2D&) override {}
+        Transform2D GetTransform() const override {
+            return Transform2D::Identity();
+        }
+        void PushClip(const RectF&) override {}
+        void PopClip() override {}
+        void FillRoundedRect(const RoundedRectF&, const Color&) override {
+            ++this->fills;
+        }
+        void StrokeRoundedRect(const RoundedRectF&, const Color&, float) override {}
+        RenderBitmap* CreateBitmap(const PixelBuffer& pixels) override {
+            ++this->bitmapsCreated;
+            return new StubBitmap(vec2(static_cast<float>(pixels.width), static_cast<float>(pixels.height)));
+        }
+        void UpdateBitmap(RenderBitmap*, const PixelRegion&, const uint8_t*, uint32_t) override {}
+        void DrawBitmap(RenderBitmap*, const RectF&, float) override {}
+        RenderTextFormat* CreateTextFormat(const TextFormatDesc&) override {
+            return new RenderTextFormat();
+        }
+        void DrawString(const std::wstring&, RenderTextFormat*, const RectF&, const Color&) override {}
+    };
+
+    void SubmitFrame(FramePipeline& pipeline, float red, int fills = 1) {
+        pipeline.BeginFrame();
+        pipeline.Clear(Color(red, 0.f, 0.f, 1.f));
+        for (int i = 0; i < fills; ++i) {
+            pipeline.FillRoundedRect(RoundedRectF(RectF(0.f, 0.f, 10.f, 10.f), 0.f, 0.f), Color(1.f));
+        }
+        pipeline.EndFrame();
+    }
+}
+
+static void TestOrderAndResources() {
+    CountingDevice device;
+    std::atomic<int> presentCallbacks = 0;
+    FramePipeline pipeline(&device, 2, {});
+    pipeline.SetPresentCallback([&presentCallbacks]() { ++presentCallbacks; });
+
+    for (int frame = 0; frame < 10; ++frame) {
+        SubmitFrame(pipeline, static_cast<float>(frame));
+    }
+    pipeline.WaitIdle();
+    CPPLAB_CHECK(device.framesPresented == 10 && device.fills == 10 && presentCallbacks == 10);
+    for (int frame = 0; frame < 10; ++frame) {
+        CPPLAB_CHECK(device.presentedReds[frame] == static_cast<float>(frame));
+    }
+    const FramePipelineStats stats = pipeline.GetStats();
+    CPPLAB_CHECK(stats.framesSubmitted == 10 && stats.framesPresented == 10 && stats.queuedFrames == 0 && stats.maxQueuedFrames == 2);
+
+    //a bitmap made and released on the ui side lives on the render thread in between, a flush sends the release without a frame
+    PixelBuffer pixels;
+    pixels.width = 4;
+    pixels.height = 2;
+    pixels.pixels.assign(4 * 2 * 4, 255);
+    RenderBitmap* bitmap = pipeline.CreateBitmap(pixels);
+    CPPLAB_CHECK(bitmap->GetSize() == vec2(4.f, 2.f));
+    SubmitFrame(pipeline, 0.f);
+    pipeline.WaitIdle();
+    CPPLAB_CHECK(device.bitmapsCreated == 1 && liveBitmaps == 1);
+    delete bitmap;
+    pipeline.Flush();
+    pipeline.WaitIdle();
+    CPPLAB_CHECK(liveBitmaps == 0 && device.framesPresented == 11);
+}
+
+static void TestBackpressure() {
+    CountingDevice device;
+    FramePipeline pipeline(&device, 2, {});
+    device.gateOpen = false;
+
+    //the render thread holds the first frame, two more fill the queue
+    SubmitFrame(pipeline, 1.f);
+    device.framesBegun.wait(0);
+    SubmitFrame(pipeline, 2.f);
+    SubmitFrame(pipeline, 3.f);
+    CPPLAB_CHECK(!pipeline.CanSubmitFrame() && pipeline.GetStats().queuedFrames == 2);
+    //a caller that checks defers, one that does not waits for a slot
+    pipeline.DeferFrame();
+    std::atomic<bool> submitted = false;
+    std::thread ui([&pipeline, &submitted]() {
+        SubmitFrame(pipeline, 4.f);
+        submitted = true;
+    });
+    std::this_thread::sleep_for(20ms);
+    CPPLAB_CHECK(!submitted && device.framesPresented == 0);
+    device.gateOpen = true;
+    device.gateOpen.notify_all();
+    ui.join();
+    pipeline.WaitIdle();
+    const FramePipelineStats stats = pipeline.GetStats();
+    CPPLAB_CHECK(stats.framesDeferred == 1 && stats.submitWaits >= 1 && stats.framesPresented == 4);
+    CPPLAB_CHECK((device.presentedReds == std::vector<float>{ 1.f, 2.f, 3.f, 4.f }));
+
+    //a lost target is reported once, the recreate callback runs before the next snapshot
+    device.loseNextFrame = true;
+    SubmitFrame(pipeline, 5.f);
+    pipeline.WaitIdle();
+    CPPLAB_CHECK(pipeline.TakeTargetLost() && !pipeline.TakeTargetLost() && pipeline.GetStats().targetLosses == 1);
+}
+
+static void TestShutdown() {
+    std::atomic<int> recreated = 0;
+    CountingDevice device;
+    std::thread opener;
+    {
+        FramePipeline pipeline(&device, 3, [&recreated]() { ++recreated; });
+        pipeline.RecreateTarget();
+        device.gateOpen = false;
+        SubmitFrame(pipeline, 1.f);
+        device.framesBegun.wait(0);
+        SubmitFrame(pipeline, 2.f);
+        SubmitFrame(pipeline, 3.f);
+        //the destructor joins once the render thread got through the queue, opened from the side while it waits
+        opener = std::thread([&device]() {
+            std::this_thread::sleep_for(10ms);
+            device.gateOpen = true;
+            device.gateOpen.notify_all();
+        });
+    }
+    opener.join();
+    CPPLAB_CHECK(device.framesPresented == 3 && recreated == 1);
+}
+
+static void BenchmarkThroughput(size_t frameCount) {
+    CountingDevice device;
+    FramePipeline pipeline(&device, 2, {});
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t frame = 0; frame < frameCount; ++frame) {
+        SubmitFrame(pipeline, 0.f, 100);
+    }
+    pipeline.WaitIdle();
+    const double milliseconds = cpplab::testing::MillisecondsSince(start);
+    CPPLAB_CHECK(device.framesPresented == static_cast<int>(frameCount));
+    const FramePipelineStats stats = pipeline.GetStats();
+    std::printf("%zu frames of 100 fills: %.0f frames a second, %llu waits for a free slot, longest replay %llu us\n",
+        frameCount, static_cast<double>(frameCount) * 1000.0 / milliseconds,
+        static_cast<unsigned long long>(stats.submitWaits), static_cast<unsigned long long>(stats.maxReplayMicroseconds));
+}
+
+int main(int argc, char** argv) {
+    TestOrderAndResources();
+    TestBackpressure();
+    TestShutdown();
+    BenchmarkThroughput(cpplab::testing::SizeArgument(argc, argv, 2000));
+    return 0;
+}
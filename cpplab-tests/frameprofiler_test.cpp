@@ -0,0 +1,80 @@
+//frame profiler, a present measured on the render thread lands in the frame that recorded it, not the one running when it arrives
+#include <vector>
+#include "framepipeline.hpp"
+#include "frameprofiler.hpp"
+#include "softwarerenderdevice.hpp"
+#include "check.hpp"
+
+using namespace cpplab;
+using namespace std::chrono_literals;
+
+static constexpr size_t Present = static_cast<size_t>(ProfilePhase::PRESENT);
+static constexpr size_t EndFrame = static_cast<size_t>(ProfilePhase::END_FRAME);
+
+static void TestLateTime() {
+    FrameProfiler profiler(4);
+    profiler.SetEnabled(true);
+    //pending presents are left out, a report of only pending frames has none
+    profiler.AddTime(ProfilePhase::END_FRAME, 10us);
+    profiler.EndFrame();
+    profiler.EndFrame();
+    FrameProfileReport report = profiler.GetReport();
+    CPPLAB_CHECK(report.windowFrames == 2 && report.phases[Present].max == 0.f && report.phases[EndFrame].max == 10.f);
+
+    //frame 0 gets two snapshots, frame 1 one, a frame not ended yet gets nothing
+    profiler.AddLateTime(0, ProfilePhase::PRESENT, 100us);
+    profiler.AddLateTime(0, ProfilePhase::PRESENT, 50us);
+    profiler.AddLateTime(1, ProfilePhase::PRESENT, 300us);
+    profiler.AddLateTime(2, ProfilePhase::PRESENT, 999us);
+    report = profiler.GetReport();
+    CPPLAB_CHECK(report.phases[Present].p50 == 300.f && report.phases[Present].max == 300.f && report.lastFrame[Present] == 300.f);
+    profiler.AddLateTime(1, ProfilePhase::PRESENT, -250us);
+    CPPLAB_CHECK(profiler.GetReport().phases[Present].max == 150.f);
+
+    //once the window moved past a frame its present is dropped
+    for (int i = 0; i < 4; ++i) profiler.EndFrame();
+    profiler.AddLateTime(1, ProfilePhase::PRESENT, 5000us);
+    profiler.AddLateTime(5, ProfilePhase::PRESENT, 20us);
+    report = profiler.GetReport();
+    CPPLAB_CHECK(report.frames == 6 && report.phases[Present].max == 20.f && report.phases[Present].p50 == 20.f);
+
+    //nothing is added while disabled
+    profiler.SetEnabled(false);
+    profiler.AddLateTime(4, ProfilePhase::PRESENT, 7000us);
+    profiler.SetEnabled(true);
+    CPPLAB_CHECK(profiler.GetReport().phases[Present].max == 20.f);
+}
+
+static void TestPipelineTags() {
+    SoftwareRenderDevice device(32, 32);
+    FramePipeline pipeline(&device, 2, {});
+    FrameProfiler profiler;
+    profiler.SetEnabled(true);
+
+    //tagged like the window renderer does, the replay times come back with the frame that recorded them
+    std::vector<uint64_t> tags;
+    for (int frame = 0; frame < 5; ++frame) {
+        FrameReplayTime replay;
+        while (pipeline.TakeReplayTime(replay)) {
+            tags.push_back(replay.frameTag);
+            profiler.AddLateTime(replay.frameTag, ProfilePhase::PRESENT, std::chrono::microseconds(replay.microseconds));
+        }
+        pipeline.SetFrameTag(profiler.FrameCount());
+        pipeline.BeginFrame();
+        pipeline.Clear(Color(static_cast<float>(frame) / 4.f));
+        pipeline.EndFrame();
+        profiler.EndFrame();
+        pipeline.WaitIdle();
+    }
+    FrameReplayTime replay;
+    while (pipeline.TakeReplayTime(replay)) tags.push_back(replay.frameTag);
+    CPPLAB_CHECK((tags == std::vector<uint64_t>{ 0, 1, 2, 3, 4 }));
+    //the last present was taken after its frame, the four before it landed in the window
+    CPPLAB_CHECK(profiler.GetReport().windowFrames == 5 && pipeline.GetStats().framesPresented == 5);
+}
+
+int main() {
+    TestLateTime();
+    TestPipelineTags();
+    return 0;
+}
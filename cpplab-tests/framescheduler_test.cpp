@@ -0,0 +1,111 @@
+//frame scheduler, requests coalesce into one frame an interval, nothing is due without one and continuous frames stay on the grid
+#include "framescheduler.hpp"
+#include "check.hpp"
+
+using namespace cpplab;
+using namespace std::chrono_literals;
+
+using TimePoint = FrameClock::Clock::time_point;
+
+static void TestIdle() {
+    ManualFrameClock clock;
+    FrameScheduler scheduler(&clock, 16ms);
+    CPPLAB_CHECK(scheduler.NextFrameTime() == (TimePoint::max)() && !scheduler.IsFrameDue());
+    clock.Advance(1s);
+    CPPLAB_CHECK(!scheduler.IsFrameDue());
+
+    //once a frame ran and took its request the loop can sleep again
+    scheduler.RequestFrame();
+    CPPLAB_CHECK(scheduler.IsFrameDue());
+    scheduler.BeginFrame();
+    clock.Advance(1s);
+    CPPLAB_CHECK(scheduler.NextFrameTime() == (TimePoint::max)() && !scheduler.IsFrameDue());
+}
+
+static void TestIntervalAndCoalescing() {
+    ManualFrameClock clock;
+    FrameScheduler scheduler(&clock, 16ms);
+    clock.Advance(100ms);
+    const TimePoint start = clock.Now();
+
+    //the first frame runs right away
+    scheduler.RequestFrame();
+    CPPLAB_CHECK(scheduler.NextFrameTime() <= start && scheduler.IsFrameDue());
+    FrameInfo frame = scheduler.BeginFrame();
+    CPPLAB_CHECK(frame.number == 1 && frame.frameTime == start && frame.deadline == start + 16ms && frame.interval == 16ms);
+
+    //requests inside the interval wait for its end and all go into the one frame
+    clock.Advance(2ms);
+    scheduler.RequestFrame();
+    scheduler.RequestFrame();
+    scheduler.RequestFrame();
+    CPPLAB_CHECK(scheduler.NextFrameTime() == start + 16ms && !scheduler.IsFrameDue());
+    clock.Advance(13ms);
+    CPPLAB_CHECK(!scheduler.IsFrameDue());
+    clock.Advance(1ms);
+    CPPLAB_CHECK(scheduler.IsFrameDue());
+    //a late wake inside the next interval still lands on the grid
+    clock.Advance(5ms);
+    frame = scheduler.BeginFrame();
+    CPPLAB_CHECK(frame.number == 2 && frame.frameTime == start + 16ms && frame.deadline == start + 32ms);
+    CPPLAB_CHECK(!scheduler.IsFrameDue() && scheduler.NextFrameTime() == (TimePoint::max)());
+    FrameSchedulerStats stats = scheduler.GetStats();
+    CPPLAB_CHECK(stats.framesRun == 2 && stats.requests == 4 && stats.coalescedRequests == 2 && stats.missedIntervals == 0);
+
+    //after an idle gap an on demand frame starts a new grid and counts nothing as missed
+    clock.Advance(1s);
+    scheduler.RequestFrame();
+    CPPLAB_CHECK(scheduler.IsFrameDue());
+    frame = scheduler.BeginFrame();
+    CPPLAB_CHECK(frame.frameTime == clock.Now() && scheduler.GetStats().missedIntervals == 0);
+
+    //a timed request is due when its time comes, not before the interval is over
+    const TimePoint timerStart = clock.Now();
+    scheduler.RequestFrameAt(timerStart + 5ms);
+    CPPLAB_CHECK(scheduler.NextFrameTime() == timerStart + 16ms);
+    clock.Advance(16ms);
+    scheduler.BeginFrame();
+    CPPLAB_CHECK(scheduler.NextFrameTime() == (TimePoint::max)());
+    scheduler.RequestFrameAt(timerStart + 40ms);
+    CPPLAB_CHECK(scheduler.NextFrameTime() == timerStart + 40ms);
+    clock.Advance(24ms);
+    CPPLAB_CHECK(scheduler.IsFrameDue());
+    scheduler.BeginFrame();
+    CPPLAB_CHECK(scheduler.NextFrameTime() == (TimePoint::max)());
+}
+
+static void TestContinuous() {
+    ManualFrameClock clock;
+    FrameScheduler scheduler(&clock, 10ms);
+    scheduler.SetMode(FrameMode::CONTINUOUS);
+    CPPLAB_CHECK(scheduler.GetMode() == FrameMode::CONTINUOUS);
+
+    //frames are due every interval without a request
+    CPPLAB_CHECK(scheduler.IsFrameDue());
+    const TimePoint start = scheduler.BeginFrame().frameTime;
+    for (int i = 1; i <= 5; ++i) {
+        CPPLAB_CHECK(scheduler.NextFrameTime() == start + i * 10ms && !scheduler.IsFrameDue());
+        clock.Advance(10ms);
+        CPPLAB_CHECK(scheduler.IsFrameDue());
+        CPPLAB_CHECK(scheduler.BeginFrame().frameTime == start + i * 10ms);
+    }
+    CPPLAB_CHECK(scheduler.GetStats().framesRun == 6 && scheduler.GetStats().requests == 0);
+
+    //a slow frame skips the slots it overran and counts them
+    clock.Advance(35ms);
+    const FrameInfo frame = scheduler.BeginFrame();
+    CPPLAB_CHECK(frame.frameTime == start + 80ms && frame.deadline == start + 90ms);
+    CPPLAB_CHECK(scheduler.GetStats().missedIntervals == 2);
+
+    //back on demand nothing is due until asked
+    scheduler.SetMode(FrameMode::ON_DEMAND);
+    clock.Advance(100ms);
+    CPPLAB_CHECK(!scheduler.IsFrameDue() && scheduler.NextFrameTime() == (TimePoint::max)());
+}
+
+int main() {
+    TestIdle();
+    TestIntervalAndCoalescing();
+    TestContinuous();
+    return 0;
+}
@@ -0,0 +1,17 @@
+//the element headers come first on purpose, standard headers included after them must still compile
+#include "engineelements.hpp"
+#include "scenerenderer.hpp"
+#include "headlessengine.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <semaphore>
+#include <thread>
+#include "check.hpp"
+
+int main() {
+    CPPLAB_CHECK(std::max(1, 2) == 2);
+    CPPLAB_CHECK(std::min({ 3, 1, 2 }) == 1);
+    CPPLAB_CHECK((std::chrono::milliseconds::max)() > std::chrono::milliseconds(0));
+    return 0;
+}
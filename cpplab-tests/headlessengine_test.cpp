@@ -0,0 +1,95 @@
+//ui task queue and the headless loop, posts from worker threads end up in one drain and one frame
+#include <thread>
+#include <vector>
+#include <atomic>
+#include "headlessengine.hpp"
+#include "check.hpp"
+
+using namespace cpplab;
+using namespace std::chrono_literals;
+
+static void TestOrderAndDrainBoundary() {
+    UiTaskQueue queue;
+    std::vector<int> order;
+    for (int i = 0; i < 5; ++i) {
+        queue.Post([&order, i]() { order.push_back(i); });
+    }
+    //a task posted while draining waits for the next drain
+    queue.Post([&queue, &order]() { queue.Post([&order]() { order.push_back(100); }); });
+    CPPLAB_CHECK(queue.Drain() == 6);
+    CPPLAB_CHECK((order == std::vector<int>{ 0, 1, 2, 3, 4 }));
+    CPPLAB_CHECK(queue.Depth() == 1);
+    CPPLAB_CHECK(queue.Drain() == 1);
+    CPPLAB_CHECK(order.back() == 100);
+}
+
+static void TestWakes() {
+    UiTaskQueue queue;
+    std::atomic<int> wakes = 0;
+    queue.SetWakeCallback([&wakes]() { ++wakes; });
+    queue.PostForFrame([]() {});
+    CPPLAB_CHECK(wakes == 0);
+    queue.Post([]() {});
+    queue.Post([]() {});
+    CPPLAB_CHECK(wakes == 1);
+    queue.Drain();
+    queue.Post([]() {});
+    CPPLAB_CHECK(wakes == 2);
+}
+
+static void TestBurstIsOneFrame(size_t posts) {
+    ManualFrameClock clock;
+    clock.Set(FrameClock::Clock::time_point(100s));
+    HeadlessEngine engine(64, 64, 96, &clock);
+    TextElementConfiguration config;
+    config.setText(L"0").SetDimension(vec2(40.f, 20.f)).SetHidden(false);
+    TextElement* label = new TextElement(config);
+    engine.GetRootNode()->AddChildElement("label", label);
+    engine.RunFrame();
+
+    const UiTaskQueueStats before = engine.GetTaskStats();
+    const uint64_t renderedBefore = engine.GetFrameStats().framesRendered;
+    const auto start = std::chrono::steady_clock::now();
+    std::thread worker([&engine, label, posts]() {
+        for (size_t i = 0; i < posts; ++i) {
+            engine.Post([label, i]() { label->setText(std::to_wstring(i)); });
+        }
+    });
+    worker.join();
+    const double postMs = testing::MillisecondsSince(start);
+    clock.Advance(17ms);
+    CPPLAB_CHECK(engine.Tick());
+
+    const UiTaskQueueStats after = engine.GetTaskStats();
+    CPPLAB_CHECK(after.tasksRun - before.tasksRun == posts);
+    CPPLAB_CHECK(after.wakes - before.wakes == 1);
+    CPPLAB_CHECK(after.drains - before.drains == 1);
+    CPPLAB_CHECK(engine.GetFrameStats().framesRendered - renderedBefore == 1);
+    CPPLAB_CHECK(label->getText() == std::to_wstring(posts - 1));
+    std::printf("%zu posts from a worker: %.2f ms to post, drain %llu us, one wake, one drain, one frame\n",
+        posts, postMs, static_cast<unsigned long long>(after.lastDrainMicroseconds));
+    //children belong to whoever made them
+    delete label;
+}
+
+static void TestRunLoopStops() {
+    HeadlessEngine engine(32, 32);
+    std::atomic<int> ran = 0;
+    std::thread worker([&engine, &ran]() {
+        for (int i = 0; i < 100; ++i) {
+            engine.Post([&ran]() { ++ran; });
+        }
+        engine.Post([&engine]() { engine.Stop(); });
+    });
+    engine.RunLoop();
+    worker.join();
+    CPPLAB_CHECK(ran == 100);
+}
+
+int main(int argc, char** argv) {
+    TestOrderAndDrainBoundary();
+    TestWakes();
+    TestBurstIsOneFrame(testing::SizeArgument(argc, argv, 10000));
+    TestRunLoopStops();
+    return 0;
+}
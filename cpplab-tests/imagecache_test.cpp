@@ -0,0 +1,168 @@
+//image cache over the ppm decoder, decoded pixels are shared on a repeated request and the least recently used go past the byte budget
+//benchmark: a cache hit against decoding the same file again, pass a request count as the first argument
+#include <fstream>
+#include <string>
+#include "imagecache.hpp"
+#include "ppmimagedecoder.hpp"
+#include "softwarerenderdevice.hpp"
+#include "check.hpp"
+
+using namespace cpplab;
+
+namespace {
+    //a size x size image of one colour, written the way the software device saves frames
+    std::vector<uint8_t> WriteImage(const std::string& path, uint32_t size, const Color& color) {
+        SoftwareRenderDevice device(size, size);
+        device.BeginFrame();
+        device.Clear(color);
+        device.EndFrame();
+        CPPLAB_CHECK(device.SavePPM(path));
+        return device.GetPixels();
+    }
+    ImageKey FileKey(const std::string& path, uint32_t width = 0, uint32_t height = 0) {
+        ImageKey key;
+        key.source = std::wstring(path.begin(), path.end());
+        key.type = ImageType::FILE;
+        key.size.width = width;
+        key.size.height = height;
+        return key;
+    }
+}
+
+static void TestDecoder() {
+    PPMImageDecoder decoder;
+    const std::vector<uint8_t> saved = WriteImage("imagecache_test_a.ppm", 8, Color(0.f, 0.6f, 0.2f, 1.f));
+    PixelBuffer decoded;
+    decoder.Decode(L"imagecache_test_a.ppm", ImageType::FILE, decoded);
+    CPPLAB_CHECK(decoded.width == 8 && decoded.height == 8 && decoded.pixels == saved);
+
+    //comments in the header and two byte samples
+    {
+        std::ofstream out("imagecache_test_wide.ppm", std::ios::binary);
+        out << "P6\n# two bytes a sample\n2 1\n65535\n";
+        const unsigned char samples[] = { 0xff, 0xff, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff };
+        out.write(reinterpret_cast<const char*>(samples), sizeof(samples));
+    }
+    decoder.Decode(L"imagecache_test_wide.ppm", ImageType::FILE, decoded);
+    CPPLAB_CHECK(decoded.width == 2 && decoded.height == 1);
+    CPPLAB_CHECK((decoded.pixels == std::vector<uint8_t>{ 255, 0, 128, 255, 0, 255, 255, 255 }));
+
+    //missing, truncated and non file images throw
+    CPPLAB_CHECK_THROWS(decoder.Decode(L"imagecache_test_missing.ppm", ImageType::FILE, decoded));
+    {
+        std::ofstream out("imagecache_test_short.ppm", std::ios::binary);
+        out << "P6 4 4 255\n" << "abc";
+    }
+    CPPLAB_CHECK_THROWS(decoder.Decode(L"imagecache_test_short.ppm", ImageType::FILE, decoded));
+    CPPLAB_CHECK_THROWS(decoder.Decode(L"imagecache_test_a.ppm", ImageType::RESOURCE, decoded));
+
+    //decoding to a box downscales and reports the source size
+    ImageDecodeSize size;
+    size.width = 4;
+    size.height = 4;
+    ImageDecodeInfo info;
+    decoder.DecodeToSize(L"imagecache_test_a.ppm", ImageType::FILE, size, decoded, info);
+    CPPLAB_CHECK(decoded.width == 4 && decoded.height == 4 && info.sourceWidth == 8 && info.sourceHeight == 8);
+}
+
+static void TestHits() {
+    WriteImage("imagecache_test_a.ppm", 8, Color(0.f, 0.6f, 0.2f, 1.f));
+    PPMImageDecoder decoder;
+    ImageCache cache(&decoder, 1 << 20, 2);
+    std::shared_ptr<const PixelBuffer> pixels;
+
+    //a miss decodes on a worker, the repeated request shares the decoded pixels
+    const uint64_t version = cache.CompletionVersion();
+    CPPLAB_CHECK(cache.Request(FileKey("imagecache_test_a.ppm"), pixels) == ImageRequestState::PENDING && !pixels);
+    cache.WaitIdle();
+    CPPLAB_CHECK(cache.CompletionVersion() > version);
+    CPPLAB_CHECK(cache.Request(FileKey("imagecache_test_a.ppm"), pixels) == ImageRequestState::READY && pixels->width == 8);
+    std::shared_ptr<const PixelBuffer> again;
+    CPPLAB_CHECK(cache.Request(FileKey("imagecache_test_a.ppm"), again) == ImageRequestState::READY && again == pixels);
+    ImageCacheStats stats = cache.GetStats();
+    CPPLAB_CHECK(stats.requests == 3 && stats.misses == 1 && stats.decodes == 1 && stats.hits == 2 && stats.bytesUsed == 8 * 8 * 4);
+
+    //another size of the same file is its own entry
+    CPPLAB_CHECK(cache.Request(FileKey("imagecache_test_a.ppm", 4, 4), pixels) == ImageRequestState::PENDING);
+    cache.WaitIdle();
+    CPPLAB_CHECK(cache.Request(FileKey("imagecache_test_a.ppm", 4, 4), pixels) == ImageRequestState::READY && pixels->width == 4);
+    CPPLAB_CHECK(cache.GetStats().entries == 2 && cache.GetStats().bytesUsed == (8 * 8 + 4 * 4) * 4);
+
+    //a failure stays failed until invalidated
+    CPPLAB_CHECK(cache.Request(FileKey("imagecache_test_missing.ppm"), pixels) == ImageRequestState::PENDING);
+    cache.WaitIdle();
+    CPPLAB_CHECK(cache.Request(FileKey("imagecache_test_missing.ppm"), pixels) == ImageRequestState::FAILED && !pixels);
+    CPPLAB_CHECK(cache.GetStats().failures == 1 && cache.GetStats().decodes == 3);
+    cache.Invalidate(FileKey("imagecache_test_missing.ppm"));
+    CPPLAB_CHECK(cache.Request(FileKey("imagecache_test_missing.ppm"), pixels) == ImageRequestState::PENDING);
+    cache.WaitIdle();
+
+    cache.Clear();
+    stats = cache.GetStats();
+    CPPLAB_CHECK(stats.entries == 0 && stats.bytesUsed == 0);
+}
+
+static void TestBudget() {
+    WriteImage("imagecache_test_a.ppm", 8, Color(1.f, 0.f, 0.f, 1.f));
+    WriteImage("imagecache_test_b.ppm", 8, Color(0.f, 1.f, 0.f, 1.f));
+    WriteImage("imagecache_test_c.ppm", 8, Color(0.f, 0.f, 1.f, 1.f));
+    PPMImageDecoder decoder;
+    //room for two 8x8 images, no workers so every miss decodes inside Request
+    constexpr size_t ImageBytes = 8 * 8 * 4;
+    ImageCache cache(&decoder, 2 * ImageBytes, 0);
+    std::shared_ptr<const PixelBuffer> a, b, c, pixels;
+    CPPLAB_CHECK(cache.Request(FileKey("imagecache_test_a.ppm"), a) == ImageRequestState::READY);
+    CPPLAB_CHECK(cache.Request(FileKey("imagecache_test_b.ppm"), b) == ImageRequestState::READY);
+    //a is used again, so b is the least recently used when c comes in
+    CPPLAB_CHECK(cache.Request(FileKey("imagecache_test_a.ppm"), pixels) == ImageRequestState::READY);
+    CPPLAB_CHECK(cache.Request(FileKey("imagecache_test_c.ppm"), c) == ImageRequestState::READY);
+    ImageCacheStats stats = cache.GetStats();
+    CPPLAB_CHECK(stats.evictions == 1 && stats.entries == 2 && stats.bytesUsed == 2 * ImageBytes);
+
+    //the evicted image decodes again, its old pixels stay valid for whoever still holds them
+    CPPLAB_CHECK(b->width == 8 && b->pixels.size() == ImageBytes);
+    CPPLAB_CHECK(cache.Request(FileKey("imagecache_test_b.ppm"), pixels) == ImageRequestState::READY && pixels != b);
+    CPPLAB_CHECK(cache.GetStats().misses == 4 && cache.GetStats().evictions == 2);
+    CPPLAB_CHECK(cache.Request(FileKey("imagecache_test_c.ppm"), pixels) == ImageRequestState::READY && pixels == c);
+
+    //an image larger than the whole budget is still kept while it is the newest
+    cache.SetMemoryBudget(ImageBytes / 2);
+    stats = cache.GetStats();
+    CPPLAB_CHECK(stats.entries == 0 && stats.bytesUsed == 0 && stats.memoryBudget == ImageBytes / 2);
+    CPPLAB_CHECK(cache.Request(FileKey("imagecache_test_a.ppm"), pixels) == ImageRequestState::READY);
+    CPPLAB_CHECK(cache.GetStats().entries == 1 && cache.GetStats().bytesUsed == ImageBytes);
+}
+
+static void BenchmarkHits(size_t requestCount) {
+    WriteImage("imagecache_bench.ppm", 256, Color(0.3f, 0.4f, 0.5f, 1.f));
+    PPMImageDecoder decoder;
+    ImageCache cache(&decoder, 64 << 20, 0);
+    std::shared_ptr<const PixelBuffer> pixels;
+    const ImageKey key = FileKey("imagecache_bench.ppm");
+    cache.Request(key, pixels);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < requestCount; ++i) {
+        cache.Request(key, pixels);
+    }
+    const double hitMilliseconds = cpplab::testing::MillisecondsSince(start);
+    CPPLAB_CHECK(cache.GetStats().hits == requestCount);
+
+    const size_t decodeCount = requestCount / 100 + 1;
+    PixelBuffer decoded;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < decodeCount; ++i) {
+        decoder.Decode(key.source, key.type, decoded);
+    }
+    const double decodeMilliseconds = cpplab::testing::MillisecondsSince(start);
+    std::printf("256x256 ppm: cache hit %.2f us, decode %.2f us\n",
+        hitMilliseconds * 1000.0 / static_cast<double>(requestCount), decodeMilliseconds * 1000.0 / static_cast<double>(decodeCount));
+}
+
+int main(int argc, char** argv) {
+    TestDecoder();
+    TestHits();
+    TestBudget();
+    BenchmarkHits(cpplab::testing::SizeArgument(argc, argv, 10000));
+    return 0;
+}
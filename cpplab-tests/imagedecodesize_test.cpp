@@ -0,0 +1,110 @@
+//decode sizes, images decode at the shown size rounded up a square root of two step and the memory report adds up to what the cache holds
+#include <thread>
+#include <vector>
+#include "headlessengine.hpp"
+#include "check.hpp"
+
+using namespace cpplab;
+using namespace std::chrono_literals;
+
+static void TestQuantizeSteps() {
+    CPPLAB_CHECK(QuantizeDecodeExtent(0.f) == 1 && QuantizeDecodeExtent(0.5f) == 1 && QuantizeDecodeExtent(1.f) == 1);
+    CPPLAB_CHECK(QuantizeDecodeExtent(1.01f) == 2 && QuantizeDecodeExtent(2.f) == 2 && QuantizeDecodeExtent(2.01f) == 3);
+    //powers of two land on themselves, the half steps in between round up to the next whole pixel
+    CPPLAB_CHECK(QuantizeDecodeExtent(16.f) == 16 && QuantizeDecodeExtent(16.01f) == 23 && QuantizeDecodeExtent(22.62f) == 23);
+    CPPLAB_CHECK(QuantizeDecodeExtent(22.64f) == 32 && QuantizeDecodeExtent(32.f) == 32);
+    CPPLAB_CHECK(QuantizeDecodeExtent(40.f) == 46 && QuantizeDecodeExtent(42.f) == 46 && QuantizeDecodeExtent(80.f) == 91);
+    CPPLAB_CHECK(QuantizeDecodeExtent(4096.f) == 4096);
+
+    //never smaller than asked, at most one step larger, and a sweep only passes through two sizes an octave
+    uint32_t previous = 1;
+    size_t distinct = 1;
+    for (float extent = 1.f; extent <= 4096.f; extent += 0.25f) {
+        const uint32_t quantized = QuantizeDecodeExtent(extent);
+        CPPLAB_CHECK(static_cast<float>(quantized) >= extent && static_cast<float>(quantized) <= extent * 1.4143f + 1.f);
+        CPPLAB_CHECK(quantized >= previous);
+        if (quantized != previous) ++distinct;
+        previous = quantized;
+    }
+    //1, 2, 3, 4, 6, 8, 12, 16, 23 and on to 4096, the first half step rounds up onto 2
+    CPPLAB_CHECK(distinct == 24);
+}
+
+//frames until the images decoded on the cache's workers were uploaded
+static void RunUntilUploaded(HeadlessEngine& engine, uint64_t uploads) {
+    const auto start = std::chrono::steady_clock::now();
+    while (engine.GetScene().GetRebuildStats().bitmapUploads < uploads && cpplab::testing::MillisecondsSince(start) < 5000.0) {
+        engine.RunFrame();
+        std::this_thread::sleep_for(1ms);
+    }
+    CPPLAB_CHECK(engine.GetScene().GetRebuildStats().bitmapUploads == uploads);
+}
+
+//the report's entries add up to the bytes the cache counts
+static size_t ReportedBytes(HeadlessEngine& engine, std::vector<ImageMemoryReportEntry>& report) {
+    engine.GetImageMemoryReport(report);
+    size_t bytes = 0;
+    for (const ImageMemoryReportEntry& entry : report) bytes += entry.bytes;
+    CPPLAB_CHECK(bytes == engine.GetImageCacheStats().bytesUsed);
+    return bytes;
+}
+
+static void TestMemoryReport() {
+    SoftwareRenderDevice wide(64, 32);
+    wide.BeginFrame();
+    wide.Clear(Color(1.f, 0.5f, 0.f, 1.f));
+    wide.EndFrame();
+    CPPLAB_CHECK(wide.SavePPM("imagedecodesize_test_wide.ppm"));
+    SoftwareRenderDevice small(16, 16);
+    small.BeginFrame();
+    small.Clear(Color(0.f, 0.5f, 1.f, 1.f));
+    small.EndFrame();
+    CPPLAB_CHECK(small.SavePPM("imagedecodesize_test_small.ppm"));
+
+    HeadlessEngine engine(300, 200);
+    //a 64x32 image contained in 20x20 decodes into the 23x23 step, fitted to 23x12
+    ImageElementConfiguration thumbConfig;
+    thumbConfig.setImageFile(L"imagedecodesize_test_wide.ppm", ImageType::FILE).setFillMode(ImageFillMode::CONTAIN);
+    thumbConfig.SetRelativePosition(vec2(10.f, 10.f)).SetDimension(vec2(20.f, 20.f));
+    ImageElement* thumb = new ImageElement(thumbConfig);
+    engine.GetRootNode()->AddChildElement("thumb", thumb);
+    //a box larger than the source keeps the native size
+    ImageElementConfiguration largeConfig;
+    largeConfig.setImageFile(L"imagedecodesize_test_small.ppm", ImageType::FILE);
+    largeConfig.SetRelativePosition(vec2(100.f, 10.f)).SetDimension(vec2(100.f, 100.f));
+    ImageElement* large = new ImageElement(largeConfig);
+    engine.GetRootNode()->AddChildElement("large", large);
+    RunUntilUploaded(engine, 2);
+
+    std::vector<ImageMemoryReportEntry> report;
+    CPPLAB_CHECK(ReportedBytes(engine, report) == (23 * 12 + 16 * 16) * 4 && report.size() == 2);
+    for (const ImageMemoryReportEntry& entry : report) {
+        CPPLAB_CHECK(entry.state == ImageRequestState::READY && entry.bytes == static_cast<size_t>(entry.width) * entry.height * 4);
+        if (entry.key.source == L"imagedecodesize_test_wide.ppm") {
+            CPPLAB_CHECK(entry.key.size.width == 23 && entry.key.size.height == 23 && entry.width == 23 && entry.height == 12);
+            CPPLAB_CHECK(entry.sourceWidth == 64 && entry.sourceHeight == 32 && entry.nativeBytes == 64 * 32 * 4);
+        }
+        else {
+            CPPLAB_CHECK(entry.key.size.width == 128 && entry.width == 16 && entry.height == 16 && entry.nativeBytes == entry.bytes);
+        }
+    }
+
+    //a resize inside the step keeps the entry, crossing it adds the new size next to the old one
+    thumb->setDimensions(vec2(22.f, 22.f));
+    engine.RunFrame();
+    CPPLAB_CHECK(ReportedBytes(engine, report) == (23 * 12 + 16 * 16) * 4 && report.size() == 2);
+    thumb->setDimensions(vec2(30.f, 30.f));
+    RunUntilUploaded(engine, 3);
+    CPPLAB_CHECK(ReportedBytes(engine, report) == (23 * 12 + 32 * 16 + 16 * 16) * 4 && report.size() == 3);
+    //the most recently used comes first
+    CPPLAB_CHECK(report.front().key.size.width == 32 && report.front().width == 32);
+
+    delete large;
+    delete thumb;
+}
+
+int main() {
+    TestQuantizeSteps();
+    TestMemoryReport();
+    return 0;
+}
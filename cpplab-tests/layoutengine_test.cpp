@@ -0,0 +1,158 @@
+//stacks, grids and anchors, incremental passes, and the root filling the device at a dpi other than 96
+#include "headlessengine.hpp"
+#include "check.hpp"
+
+using namespace cpplab;
+
+static bool Near(float a, float b) {
+    return a > b - 0.01f && a < b + 0.01f;
+}
+static ElementNode* AddBox(ElementNode* parent, const std::string& id, vec2 size) {
+    ElementNode* box = new ElementNode(ElementNodeConfiguration().SetDimension(size).SetHidden(false));
+    parent->AddChildElement(id, box);
+    return box;
+}
+
+//at 144 dpi a 300x200 device is 200x133 dips, the root still has to cover all 300x200 pixels
+static void TestRootFillsDeviceAtHighDpi() {
+    HeadlessEngine engine(300, 200, 144);
+    LayoutEngine& layout = engine.GetLayout();
+    ElementNode* root = engine.GetRootNode();
+    CPPLAB_CHECK(Near(layout.GetViewport().x, 300.f) && Near(layout.GetViewport().y, 200.f));
+
+    LayoutContainer column;
+    column.kind = LayoutKind::VERTICAL_STACK;
+    column.align = LayoutAlign::STRETCH;
+    layout.SetContainer(root, column);
+
+    TextElementConfiguration config;
+    config.setText(L"").setBackgroundColor(Color(1.f, 0.f, 0.f, 1.f)).SetHidden(false);
+    TextElement* fill = new TextElement(config);
+    root->AddChildElement("fill", fill);
+    LayoutItem grows;
+    grows.grow = 1.f;
+    layout.SetItem(fill, grows);
+
+    engine.RunFrame();
+    CPPLAB_CHECK(Near(root->getDimensions().x, 300.f) && Near(root->getDimensions().y, 200.f));
+    CPPLAB_CHECK(Near(fill->getDimensions().x, 300.f) && Near(fill->getDimensions().y, 200.f));
+    //the bottom right pixel is painted by the element, not left at the background
+    const SoftwareRenderDevice& device = engine.GetDevice();
+    CPPLAB_CHECK(device.GetPixel(299, 199) == device.GetPixel(150, 100));
+    CPPLAB_CHECK(device.GetPixel(0, 0) == device.GetPixel(150, 100));
+    delete fill;
+}
+
+static void TestStacks() {
+    HeadlessEngine engine(400, 300);
+    LayoutEngine& layout = engine.GetLayout();
+    ElementNode* root = engine.GetRootNode();
+
+    LayoutContainer column;
+    column.kind = LayoutKind::VERTICAL_STACK;
+    column.padding = LayoutInsets(10.f);
+    column.gap = 5.f;
+    column.align = LayoutAlign::STRETCH;
+    layout.SetContainer(root, column);
+
+    ElementNode* header = AddBox(root, "header", vec2(50.f, 40.f));
+    ElementNode* body = AddBox(root, "body", vec2(50.f, 10.f));
+    ElementNode* footer = AddBox(root, "footer", vec2(80.f, 30.f));
+    LayoutItem fixed;
+    fixed.size = vec2(-1.f, 40.f);
+    layout.SetItem(header, fixed);
+    LayoutItem grows;
+    grows.grow = 1.f;
+    layout.SetItem(body, grows);
+    LayoutItem centered;
+    centered.size = vec2(80.f, 30.f);
+    layout.SetItem(footer, centered);
+
+    //a row inside the body, two items sharing the width 1:3
+    LayoutContainer row;
+    row.kind = LayoutKind::HORIZONTAL_STACK;
+    row.align = LayoutAlign::STRETCH;
+    layout.SetContainer(body, row);
+    ElementNode* left = AddBox(body, "left", vec2(0.f, 0.f));
+    ElementNode* right = AddBox(body, "right", vec2(0.f, 0.f));
+    LayoutItem share;
+    share.grow = 1.f;
+    layout.SetItem(left, share);
+    share.grow = 3.f;
+    layout.SetItem(right, share);
+
+    engine.RunFrame();
+    CPPLAB_CHECK(Near(header->getRelativePosition().x, 10.f) && Near(header->getRelativePosition().y, 10.f));
+    CPPLAB_CHECK(Near(header->getDimensions().x, 380.f) && Near(header->getDimensions().y, 40.f));
+    //300 - 20 padding - 40 - 30 - 2 gaps of 5
+    CPPLAB_CHECK(Near(body->getRelativePosition().y, 55.f) && Near(body->getDimensions().y, 200.f));
+    //a fixed width is kept under stretch
+    CPPLAB_CHECK(Near(footer->getDimensions().x, 80.f) && Near(footer->getRelativePosition().y, 260.f));
+    CPPLAB_CHECK(Near(left->getDimensions().x, 95.f) && Near(right->getDimensions().x, 285.f));
+    CPPLAB_CHECK(Near(right->getRelativePosition().x, 95.f) && Near(right->getDimensions().y, 200.f));
+
+    //nothing changed, nothing is measured or written
+    engine.RunFrame();
+    layout.RunFrame();
+    CPPLAB_CHECK(layout.GetStats().lastMeasured == 0 && layout.GetStats().lastWritten == 0);
+
+    //a new header height moves the body and resizes it, the row's items only get new heights
+    fixed.size = vec2(-1.f, 60.f);
+    layout.SetItem(header, fixed);
+    layout.RunFrame();
+    CPPLAB_CHECK(Near(body->getRelativePosition().y, 75.f) && Near(body->getDimensions().y, 180.f));
+    CPPLAB_CHECK(Near(left->getDimensions().y, 180.f));
+    CPPLAB_CHECK(layout.GetStats().lastWritten <= 4);
+
+    delete left;
+    delete right;
+    delete header;
+    delete body;
+    delete footer;
+}
+
+static void TestGridAndAnchors() {
+    HeadlessEngine engine(400, 300);
+    LayoutEngine& layout = engine.GetLayout();
+    ElementNode* root = engine.GetRootNode();
+
+    layout.SetContainer(root, LayoutContainer());
+    ElementNode* grid = AddBox(root, "grid", vec2(200.f, 100.f));
+    LayoutItem gridItem;
+    gridItem.size = vec2(200.f, 100.f);
+    layout.SetItem(grid, gridItem);
+    LayoutContainer cells;
+    cells.kind = LayoutKind::GRID;
+    cells.columns = 2;
+    cells.gap = 10.f;
+    cells.rowHeight = 20.f;
+    layout.SetContainer(grid, cells);
+    std::vector<ElementNode*> items;
+    for (int i = 0; i < 5; ++i) {
+        items.push_back(AddBox(grid, "cell" + std::to_string(i), vec2(1.f, 1.f)));
+    }
+
+    //this box keeps 20 pixels from the right and bottom edges
+    ElementNode* corner = AddBox(root, "corner", vec2(30.f, 30.f));
+    LayoutItem anchored;
+    anchored.size = vec2(30.f, 30.f);
+    anchored.margin = LayoutInsets(0.f, 0.f, 20.f, 20.f);
+    anchored.anchors = ANCHOR_RIGHT | ANCHOR_BOTTOM;
+    layout.SetItem(corner, anchored);
+
+    engine.RunFrame();
+    CPPLAB_CHECK(Near(items[1]->getRelativePosition().x, 105.f) && Near(items[1]->getDimensions().x, 95.f));
+    CPPLAB_CHECK(Near(items[4]->getRelativePosition().y, 60.f) && Near(items[4]->getRelativePosition().x, 0.f));
+    CPPLAB_CHECK(Near(corner->getRelativePosition().x, 350.f) && Near(corner->getRelativePosition().y, 250.f));
+
+    for (ElementNode* item : items) delete item;
+    delete grid;
+    delete corner;
+}
+
+int main() {
+    TestRootFillsDeviceAtHighDpi();
+    TestStacks();
+    TestGridAndAnchors();
+    return 0;
+}
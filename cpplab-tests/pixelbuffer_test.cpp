@@ -0,0 +1,149 @@
+//pixel buffer element, partial updates reach the screen and only the changed rectangle is uploaded
+//benchmark: a producer thread pushing 1080p frames at 60 Hz, full frames and row bands, pass a frame count as the first argument
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "headlessengine.hpp"
+#include "check.hpp"
+
+using namespace cpplab;
+
+//one opaque color for every pixel of a width by height block, rows packed
+static std::vector<uint8_t> Solid(uint32_t width, uint32_t height, uint8_t r, uint8_t g, uint8_t b) {
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+    for (size_t i = 0; i < pixels.size(); i += 4) {
+        pixels[i] = r;
+        pixels[i + 1] = g;
+        pixels[i + 2] = b;
+        pixels[i + 3] = 255;
+    }
+    return pixels;
+}
+
+static void TestPartialUpdates() {
+    HeadlessEngine engine(64, 64);
+    engine.GetScene().SetBackgroundColor(Color(0.f, 0.f, 0.f, 1.f));
+    //drawn one to one at 8, 8 so buffer pixel x, y lands on device pixel 8 + x, 8 + y
+    PixelBufferElement* buffer = new PixelBufferElement(16, 16);
+    buffer->setDimensions(vec2(16.f, 16.f));
+    buffer->setRelativePosition(vec2(8.f, 8.f));
+    buffer->show();
+    engine.GetRootNode()->AddChildElement("buffer", buffer);
+    CPPLAB_CHECK(engine.RunFrame());
+    const SoftwareRenderDevice& device = engine.GetDevice();
+    const uint32_t background = device.GetPixel(12, 12);
+    const PixelBufferStats first = buffer->getStats();
+
+    //one region, the rest of the buffer stays transparent
+    const std::vector<uint8_t> white = Solid(8, 8, 255, 255, 255);
+    buffer->updateRegion(PixelRegion{ 4, 4, 8, 8 }, white.data(), 8 * 4);
+    CPPLAB_CHECK(engine.RunFrame());
+    const uint32_t whitePixel = device.GetPixel(8 + 6, 8 + 6);
+    CPPLAB_CHECK(whitePixel != background && device.GetPixel(8 + 2, 8 + 2) == background);
+    PixelBufferStats stats = buffer->getStats();
+    CPPLAB_CHECK(stats.framesPublished - first.framesPublished == 1 && stats.framesConsumed - first.framesConsumed == 1);
+    CPPLAB_CHECK(stats.bytesUploaded - first.bytesUploaded == 8 * 8 * 4);
+
+    //three frames before the renderer looks, it takes the newest and uploads the union of their regions once
+    //the source rows are wider than the region, the stride skips the rest
+    const std::vector<uint8_t> red = Solid(16, 2, 255, 0, 0);
+    const std::vector<uint8_t> blue = Solid(2, 2, 0, 0, 255);
+    const PixelBufferStats before = buffer->getStats();
+    buffer->updateRegion(PixelRegion{ 0, 0, 4, 2 }, red.data(), 16 * 4);
+    buffer->updateRegion(PixelRegion{ 12, 14, 4, 2 }, red.data(), 16 * 4);
+    buffer->updateRegion(PixelRegion{ 6, 6, 2, 2 }, blue.data(), 2 * 4);
+    CPPLAB_CHECK(engine.RunFrame());
+    stats = buffer->getStats();
+    CPPLAB_CHECK(stats.framesPublished - before.framesPublished == 3 && stats.framesConsumed - before.framesConsumed == 1);
+    CPPLAB_CHECK(stats.bytesUploaded - before.bytesUploaded == 16 * 16 * 4);
+    //the recycled buffers were brought up to date, nothing from the earlier frames is missing
+    const uint32_t redPixel = device.GetPixel(8 + 1, 8 + 1);
+    CPPLAB_CHECK(redPixel != background && redPixel != whitePixel && device.GetPixel(8 + 14, 8 + 15) == redPixel);
+    CPPLAB_CHECK(device.GetPixel(8 + 6, 8 + 6) != whitePixel && device.GetPixel(8 + 6, 8 + 6) != redPixel);
+    CPPLAB_CHECK(device.GetPixel(8 + 10, 8 + 10) == whitePixel && device.GetPixel(8 + 14, 8 + 2) == background);
+
+    //several rectangles as one frame
+    const PixelRegionUpdate updates[2] = {
+        { PixelRegion{ 0, 8, 2, 2 }, blue.data(), 2 * 4 },
+        { PixelRegion{ 14, 8, 2, 2 }, blue.data(), 2 * 4 },
+    };
+    buffer->updateRegions(updates, 2);
+    CPPLAB_CHECK(buffer->getStats().framesPublished - stats.framesPublished == 1);
+    CPPLAB_CHECK(engine.RunFrame());
+    CPPLAB_CHECK(device.GetPixel(8 + 0, 8 + 9) == device.GetPixel(8 + 15, 8 + 9) && device.GetPixel(8 + 0, 8 + 9) == device.GetPixel(8 + 6, 8 + 6));
+
+    //nothing published, nothing uploaded
+    const uint64_t uploaded = buffer->getStats().bytesUploaded;
+    engine.RunFrame();
+    CPPLAB_CHECK(buffer->getStats().bytesUploaded == uploaded);
+
+    CPPLAB_CHECK_THROWS(buffer->updateRegion(PixelRegion{ 10, 10, 8, 8 }, white.data(), 8 * 4));
+    CPPLAB_CHECK_THROWS(buffer->updateRegion(PixelRegion{ 0, 0, 8, 8 }, white.data(), 4 * 4));
+    CPPLAB_CHECK_THROWS(PixelBufferElement(0, 16));
+    CPPLAB_CHECK_THROWS(PixelBufferElement(16, 70000));
+    delete buffer;
+}
+
+static void BenchmarkStream(const char* name, uint32_t bandHeight, size_t frames) {
+    constexpr uint32_t Width = 1920;
+    constexpr uint32_t Height = 1080;
+    HeadlessEngine engine(Width, Height);
+    PixelBufferElement* buffer = new PixelBufferElement(Width, Height);
+    buffer->setDimensions(vec2(static_cast<float>(Width), static_cast<float>(Height)));
+    buffer->show();
+    engine.GetRootNode()->AddChildElement("buffer", buffer);
+    engine.RunFrame();
+    const PixelBufferStats base = buffer->getStats();
+
+    //the producer owns its frame, a band moves down the image each frame
+    std::vector<uint8_t> source(static_cast<size_t>(Width) * Height * 4, 255);
+    std::atomic<bool> done = false;
+    double seconds = 0.0;
+    std::thread producer([&] {
+        const auto start = std::chrono::steady_clock::now();
+        auto next = std::chrono::steady_clock::now();
+        for (size_t frame = 0; frame < frames; ++frame) {
+            const uint32_t y = bandHeight >= Height ? 0 : static_cast<uint32_t>(frame * bandHeight % Height);
+            const uint32_t height = (std::min)(bandHeight, Height - y);
+            for (uint32_t row = y; row < y + height; ++row) {
+                source[static_cast<size_t>(row) * Width * 4] = static_cast<uint8_t>(frame);
+            }
+            buffer->updateRegion(PixelRegion{ 0, y, Width, height }, &source[static_cast<size_t>(y) * Width * 4], Width * 4);
+            next += std::chrono::microseconds(16667);
+            std::this_thread::sleep_until(next);
+        }
+        seconds = cpplab::testing::MillisecondsSince(start) / 1000.0;
+        done = true;
+    });
+    //the ui thread renders whenever a frame arrived, a software frame at 1080p takes longer than the producer's interval
+    while (!done) {
+        if (!engine.RunFrame()) std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    producer.join();
+    engine.RunFrame();
+
+    const PixelBufferStats stats = buffer->getStats();
+    const double published = static_cast<double>(stats.framesPublished - base.framesPublished);
+    const double consumed = static_cast<double>(stats.framesConsumed - base.framesConsumed);
+    CPPLAB_CHECK(published == static_cast<double>(frames) && consumed >= 1.0);
+    //a band never costs a full frame of copies
+    if (bandHeight < Height) {
+        CPPLAB_CHECK(stats.bytesUploaded - base.bytesUploaded < published * Width * Height * 4);
+    }
+    std::printf("%-13s published %.1f fps, rendered %.1f fps, per published frame: written %.0f KB, caught up %.0f KB, uploaded %.0f KB (full frame %.0f KB)\n",
+        name, published / seconds, consumed / seconds,
+        (stats.bytesWritten - base.bytesWritten) / published / 1024.0,
+        (stats.bytesCaughtUp - base.bytesCaughtUp) / published / 1024.0,
+        (stats.bytesUploaded - base.bytesUploaded) / published / 1024.0,
+        Width * Height * 4 / 1024.0);
+    delete buffer;
+}
+
+int main(int argc, char** argv) {
+    TestPartialUpdates();
+    const size_t frames = cpplab::testing::SizeArgument(argc, argv, 30);
+    BenchmarkStream("full frames", 1080, frames);
+    BenchmarkStream("64 row bands", 64, frames);
+    BenchmarkStream("8 row bands", 8, frames);
+    return 0;
+}
@@ -0,0 +1,109 @@
+//resource rebuilds, a colour change redraws from the resources it has and only text, font and size changes build new ones
+//benchmark: a frame recolouring every text element against one changing all their text, pass an element count as the first argument
+#include <thread>
+#include <vector>
+#include "headlessengine.hpp"
+#include "check.hpp"
+
+using namespace cpplab;
+using namespace std::chrono_literals;
+
+//frames until the image decoded on the cache's workers was uploaded
+static void RunUntilUploaded(HeadlessEngine& engine, uint64_t uploads) {
+    const auto start = std::chrono::steady_clock::now();
+    while (engine.GetScene().GetRebuildStats().bitmapUploads < uploads && cpplab::testing::MillisecondsSince(start) < 5000.0) {
+        engine.RunFrame();
+        std::this_thread::sleep_for(1ms);
+    }
+    CPPLAB_CHECK(engine.GetScene().GetRebuildStats().bitmapUploads == uploads);
+}
+
+static void TestColourOnly() {
+    SoftwareRenderDevice source(16, 16);
+    source.BeginFrame();
+    source.Clear(Color(0.f, 1.f, 0.f, 1.f));
+    source.EndFrame();
+    CPPLAB_CHECK(source.SavePPM("rebuildstats_test.ppm"));
+
+    HeadlessEngine engine(200, 100);
+    TextElementConfiguration textConfig;
+    textConfig.setText(L"label").SetRelativePosition(vec2(10.f, 10.f)).SetDimension(vec2(80.f, 20.f));
+    TextElement* text = new TextElement(textConfig);
+    engine.GetRootNode()->AddChildElement("text", text);
+    ImageElementConfiguration imageConfig;
+    imageConfig.setImageFile(L"rebuildstats_test.ppm", ImageType::FILE).setBorderWidth(1.f);
+    imageConfig.SetRelativePosition(vec2(100.f, 10.f)).SetDimension(vec2(40.f, 40.f));
+    ImageElement* image = new ImageElement(imageConfig);
+    engine.GetRootNode()->AddChildElement("image", image);
+    RunUntilUploaded(engine, 1);
+    const ResourceRebuildStats built = engine.GetScene().GetRebuildStats();
+    CPPLAB_CHECK(built.textFormatUpdates == 1 && built.textContentUpdates == 1);
+
+    //colours go straight into the recorded commands
+    text->setTextColor(Color(1.f, 0.f, 0.f, 1.f));
+    text->setBackgroundColor(Color(0.f, 0.f, 1.f, 1.f));
+    text->setBorderColor(Color(1.f, 1.f, 0.f, 1.f));
+    image->setBorderColor(Color(1.f, 0.f, 1.f, 1.f));
+    CPPLAB_CHECK(engine.RunFrame());
+    ResourceRebuildStats stats = engine.GetScene().GetRebuildStats();
+    CPPLAB_CHECK(stats.textFormatUpdates == built.textFormatUpdates && stats.textContentUpdates == built.textContentUpdates);
+    CPPLAB_CHECK(stats.bitmapUploads == built.bitmapUploads && stats.elementsRecorded == built.elementsRecorded + 2);
+
+    //new text builds a layout, a new point size a format, only the one each needs
+    text->setText(L"changed");
+    engine.RunFrame();
+    stats = engine.GetScene().GetRebuildStats();
+    CPPLAB_CHECK(stats.textContentUpdates == built.textContentUpdates + 1 && stats.textFormatUpdates == built.textFormatUpdates);
+    text->setTextPointSize(20.f);
+    engine.RunFrame();
+    stats = engine.GetScene().GetRebuildStats();
+    CPPLAB_CHECK(stats.textFormatUpdates == built.textFormatUpdates + 1 && stats.textContentUpdates == built.textContentUpdates + 1);
+
+    //a size within the same decode step keeps the bitmap, twice the size decodes again
+    image->setDimensions(vec2(42.f, 42.f));
+    engine.RunFrame();
+    CPPLAB_CHECK(engine.GetScene().GetRebuildStats().bitmapUploads == built.bitmapUploads);
+    image->setDimensions(vec2(80.f, 80.f));
+    RunUntilUploaded(engine, built.bitmapUploads + 1);
+
+    delete image;
+    delete text;
+}
+
+static void BenchmarkRecolour(size_t elementCount) {
+    HeadlessEngine engine(1000, 1000);
+    std::vector<TextElement*> labels;
+    for (size_t i = 0; i < elementCount; ++i) {
+        TextElementConfiguration config;
+        config.setText(L"label " + std::to_wstring(i));
+        config.SetRelativePosition(vec2(static_cast<float>(i % 50) * 20.f, static_cast<float>(i / 50 % 50) * 20.f)).SetDimension(vec2(18.f, 18.f));
+        labels.push_back(new TextElement(config));
+        engine.GetRootNode()->AddChildElement(std::to_string(i), labels.back());
+    }
+    engine.RunFrame();
+
+    const ResourceRebuildStats before = engine.GetScene().GetRebuildStats();
+    for (TextElement* label : labels) label->setTextColor(Color(1.f, 0.f, 0.f, 1.f));
+    auto start = std::chrono::steady_clock::now();
+    engine.RunFrame();
+    const double recolourMilliseconds = cpplab::testing::MillisecondsSince(start);
+    const ResourceRebuildStats recoloured = engine.GetScene().GetRebuildStats();
+    CPPLAB_CHECK(recoloured.textContentUpdates == before.textContentUpdates && recoloured.textFormatUpdates == before.textFormatUpdates);
+
+    for (TextElement* label : labels) label->setText(L"changed");
+    start = std::chrono::steady_clock::now();
+    engine.RunFrame();
+    const double retextMilliseconds = cpplab::testing::MillisecondsSince(start);
+    CPPLAB_CHECK(engine.GetScene().GetRebuildStats().textContentUpdates == before.textContentUpdates + elementCount);
+
+    //the software device rasterizes every label in both frames, the rebuilds are what a real text stack pays extra for
+    std::printf("%zu text elements: recolour frame %.2f ms with no rebuilds, new text frame %.2f ms with %zu layouts\n",
+        elementCount, recolourMilliseconds, retextMilliseconds, elementCount);
+    for (TextElement* label : labels) delete label;
+}
+
+int main(int argc, char** argv) {
+    TestColourOnly();
+    BenchmarkRecolour(cpplab::testing::SizeArgument(argc, argv, 2000));
+    return 0;
+}
@@ -0,0 +1,283 @@
+//scene files, a saved tree loads back equal and renders the same, damaged files are refused without leaking what was built
+//benchmark: building 50k nodes in code against loading them from a mapped file, pass a node count as the first argument
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+#include "headlessengine.hpp"
+#include "scenefile.hpp"
+#include "check.hpp"
+
+using namespace cpplab;
+
+namespace {
+    const char* const ScenePath = "scenefile_test.scene";
+    const char* const DamagedPath = "scenefile_test_damaged.scene";
+
+    std::vector<char> ReadFile(const char* path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    void WriteFile(const char* path, const std::vector<char>& bytes) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+    template <class Value>
+    void Poke(std::vector<char>& bytes, size_t offset, Value value) {
+        std::memcpy(bytes.data() + offset, &value, sizeof(Value));
+    }
+    bool SameColor(Color a, Color b) {
+        return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+    }
+    SceneFileHeader HeaderOf(const std::vector<char>& bytes) {
+        SceneFileHeader header;
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        return header;
+    }
+}
+
+//a panel with text, an image, a pixel buffer and a clipped group, every kind of field the format stores
+static void BuildScene(ElementNode* root) {
+    ElementNode* panel = new ElementNode(ElementNodeConfiguration().SetRelativePosition(vec2(10.f, 10.f)).SetDimension(vec2(180.f, 120.f)).SetHidden(false));
+    root->AddChildElement("panel", panel);
+    TextElementConfiguration title;
+    title.setText(L"title é中").setBackgroundColor(Color(0.2f, 0.4f, 0.6f, 1.f)).setTextColor(Color(1.f, 1.f, 0.f, 1.f));
+    title.setBorderColor(Color(1.f, 0.f, 0.f, 1.f)).setBorderWidth(2.f).setRoundedEdgeRadius(3.f).setTextSize(14.f);
+    title.setTextHorizontalAlignment(HAlign::CENTER).setTextVerticalAlignment(VAlign::BOTTOM);
+    title.SetRelativePosition(vec2(5.f, 5.f)).SetDimension(vec2(100.f, 30.f)).SetDepth(2.f).SetHidden(false);
+    panel->AddChildElement("title", new TextElement(title));
+    ImageElementConfiguration image;
+    image.setImageFile(L"missing.ppm", ImageType::FILE).setFillMode(ImageFillMode::CONTAIN).setBorderWidth(1.f);
+    image.SetRelativePosition(vec2(120.f, 5.f)).SetDimension(vec2(40.f, 40.f)).SetHidden(false);
+    panel->AddChildElement("image", new ImageElement(image));
+    PixelBufferElement* buffer = new PixelBufferElement(8, 4);
+    buffer->setRelativePosition(vec2(5.f, 50.f));
+    buffer->setDimensions(vec2(16.f, 8.f));
+    buffer->setFillMode(ImageFillMode::COVER);
+    panel->AddChildElement("buffer", buffer);
+    ElementNode* group = new ElementNode(ElementNodeConfiguration().SetRelativePosition(vec2(40.f, 60.f)).SetDimension(vec2(50.f, 20.f)).SetHidden(false));
+    group->setClipChildren(true);
+    group->setOpacity(0.5f);
+    panel->AddChildElement("group", group);
+    TextElementConfiguration wide;
+    wide.setText(L"").setBackgroundColor(Color(0.f, 1.f, 0.f, 1.f));
+    wide.SetRelativePosition(vec2(-10.f, 5.f)).SetDimension(vec2(200.f, 10.f)).SetHidden(false);
+    group->AddChildElement("wide", new TextElement(wide));
+    TextElementConfiguration hidden;
+    hidden.setText(L"not shown").SetHidden(true);
+    group->AddChildElement("hidden", new TextElement(hidden));
+}
+
+//children first, the tree's own structure decides the order
+static void DeleteSubtree(ElementNode* node) {
+    std::vector<ElementNode*> children;
+    for (const ChildEntry& child : node->GetChildren()) children.push_back(child.element);
+    for (ElementNode* child : children) {
+        DeleteSubtree(child);
+        delete child;
+    }
+}
+
+static void CheckEqual(ElementNode* saved, ElementNode* loaded) {
+    CPPLAB_CHECK(saved->getNodeType() == loaded->getNodeType() && saved->getSelfId() == loaded->getSelfId());
+    CPPLAB_CHECK(saved->getRelativePosition() == loaded->getRelativePosition() && saved->getDimensions() == loaded->getDimensions());
+    CPPLAB_CHECK(saved->getDepth() == loaded->getDepth() && saved->getOpacity() == loaded->getOpacity());
+    CPPLAB_CHECK(saved->isHidden() == loaded->isHidden() && saved->getClipChildren() == loaded->getClipChildren());
+    switch (saved->getNodeType()) {
+    case NodeType::TEXT_AREA: {
+        TextElement* a = static_cast<TextElement*>(saved);
+        TextElement* b = static_cast<TextElement*>(loaded);
+        CPPLAB_CHECK(a->getText() == b->getText() && a->getTextPointSize() == b->getTextPointSize());
+        CPPLAB_CHECK(SameColor(a->getTextColor(), b->getTextColor()) && SameColor(a->getBackgroundColor(), b->getBackgroundColor()) && SameColor(a->getBorderColor(), b->getBorderColor()));
+        CPPLAB_CHECK(a->getBorderWidth() == b->getBorderWidth() && a->getRoundedEdge() == b->getRoundedEdge() && a->getTextMargin() == b->getTextMargin());
+        CPPLAB_CHECK(a->getFontStyle() == b->getFontStyle() && a->getTextHAlign() == b->getTextHAlign() && a->getTextVAlign() == b->getTextVAlign());
+        break;
+    }
+    case NodeType::IMAGE: {
+        ImageElement* a = static_cast<ImageElement*>(saved);
+        ImageElement* b = static_cast<ImageElement*>(loaded);
+        CPPLAB_CHECK(a->getImageFileName() == b->getImageFileName() && a->getFillMode() == b->getFillMode() && a->getBorderWidthPx() == b->getBorderWidthPx());
+        break;
+    }
+    case NodeType::PIXEL_BUFFER: {
+        PixelBufferElement* a = static_cast<PixelBufferElement*>(saved);
+        PixelBufferElement* b = static_cast<PixelBufferElement*>(loaded);
+        CPPLAB_CHECK(a->getPixelWidth() == b->getPixelWidth() && a->getPixelHeight() == b->getPixelHeight() && a->getFillMode() == b->getFillMode());
+        break;
+    }
+    default:
+        break;
+    }
+    CPPLAB_CHECK(saved->GetChildren().size() == loaded->GetChildren().size());
+    for (const ChildEntry& child : saved->GetChildren()) {
+        CheckEqual(child.element, loaded->GetChildElement(child.id));
+    }
+}
+
+static void TestRoundTrip() {
+    HeadlessEngine original(200, 140);
+    HeadlessEngine copy(200, 140);
+    BuildScene(original.GetRootNode());
+    SceneFile::Save(original.GetRootNode(), ScenePath);
+    {
+        SceneFile file(ScenePath);
+        CPPLAB_CHECK(file.NodeCount() == 7);
+        file.InstantiateInto(copy.GetRootNode());
+    }
+    //the root is where the file loads into, it is not part of it
+    CPPLAB_CHECK(copy.GetRootNode()->getSelfId() == "Headless Root Node" && copy.GetRootNode()->RecursiveCountAllChildNodes() == 7);
+    CheckEqual(original.GetRootNode()->GetChildElement("panel"), copy.GetRootNode()->GetChildElement("panel"));
+
+    //the missing image fails on the cache's workers, the two engines may see that in different frames
+    const auto start = std::chrono::steady_clock::now();
+    do {
+        original.RunFrame();
+        copy.RunFrame();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    } while (original.GetDevice().GetPixels() != copy.GetDevice().GetPixels() && cpplab::testing::MillisecondsSince(start) < 5000.0);
+    CPPLAB_CHECK(original.GetDevice().GetPixels() == copy.GetDevice().GetPixels());
+
+    //a file saved from the loaded tree is the same file
+    SceneFile::Save(copy.GetRootNode(), DamagedPath);
+    CPPLAB_CHECK(ReadFile(ScenePath) == ReadFile(DamagedPath));
+
+    DeleteSubtree(original.GetRootNode());
+    DeleteSubtree(copy.GetRootNode());
+}
+
+static void CheckOpenFails(const std::vector<char>& bytes) {
+    WriteFile(DamagedPath, bytes);
+    CPPLAB_CHECK_THROWS(SceneFile file(DamagedPath));
+}
+//opens, then fails while instantiating, the target is left as it was and nothing built is leaked
+static void CheckInstantiateFails(const std::vector<char>& bytes) {
+    WriteFile(DamagedPath, bytes);
+    ElementNode target;
+    SceneFile file(DamagedPath);
+    CPPLAB_CHECK_THROWS(file.InstantiateInto(&target));
+    CPPLAB_CHECK(target.RecursiveCountAllChildNodes() == 0);
+}
+
+static void TestDamagedFiles() {
+    ElementNode root;
+    BuildScene(&root);
+    SceneFile::Save(&root, ScenePath);
+    DeleteSubtree(&root);
+    const std::vector<char> good = ReadFile(ScenePath);
+    const SceneFileHeader header = HeaderOf(good);
+
+    CPPLAB_CHECK_THROWS(SceneFile file("scenefile_test_missing.scene"));
+    //shorter than a header, cut anywhere, one byte too many
+    CheckOpenFails(std::vector<char>(good.begin(), good.begin() + 16));
+    CheckOpenFails(std::vector<char>(good.begin(), good.end() - 1));
+    CheckOpenFails(std::vector<char>(good.begin(), good.begin() + good.size() / 2));
+    std::vector<char> longer = good;
+    longer.push_back(0);
+    CheckOpenFails(longer);
+
+    std::vector<char> bytes = good;
+    bytes[0] = 'X';
+    CheckOpenFails(bytes);
+    bytes = good;
+    Poke<uint32_t>(bytes, offsetof(SceneFileHeader, version), SceneFile::FormatVersion + 1);
+    CheckOpenFails(bytes);
+    bytes = good;
+    Poke<uint32_t>(bytes, offsetof(SceneFileHeader, byteOrder), 0x04030201u);
+    CheckOpenFails(bytes);
+    //sections past the end, counts larger than the section, offsets off the alignment
+    bytes = good;
+    Poke<uint64_t>(bytes, offsetof(SceneFileHeader, nodesOffset), good.size() + 8);
+    CheckOpenFails(bytes);
+    bytes = good;
+    Poke<uint32_t>(bytes, offsetof(SceneFileHeader, nodeCount), header.nodeCount + 1000);
+    CheckOpenFails(bytes);
+    bytes = good;
+    Poke<uint64_t>(bytes, offsetof(SceneFileHeader, charsSize), header.charsSize + good.size());
+    CheckOpenFails(bytes);
+    bytes = good;
+    Poke<uint64_t>(bytes, offsetof(SceneFileHeader, textsOffset), header.textsOffset + 4);
+    CheckOpenFails(bytes);
+
+    //records are checked as they are read, after some elements were already built
+    const size_t lastNode = header.nodesOffset + (header.nodeCount - 1) * sizeof(SceneNodeRecord);
+    bytes = good;
+    Poke<uint32_t>(bytes, lastNode + offsetof(SceneNodeRecord, parent), header.nodeCount - 1);
+    CheckInstantiateFails(bytes);
+    bytes = good;
+    Poke<uint32_t>(bytes, lastNode + offsetof(SceneNodeRecord, id), header.idCount);
+    CheckInstantiateFails(bytes);
+    bytes = good;
+    Poke<uint32_t>(bytes, lastNode + offsetof(SceneNodeRecord, type), 99u);
+    CheckInstantiateFails(bytes);
+    bytes = good;
+    Poke<uint32_t>(bytes, lastNode + offsetof(SceneNodeRecord, record), header.textCount);
+    CheckInstantiateFails(bytes);
+    bytes = good;
+    Poke<uint32_t>(bytes, header.textsOffset + offsetof(SceneTextRecord, text) + offsetof(SceneString, length), static_cast<uint32_t>(header.charsSize + 1));
+    CheckInstantiateFails(bytes);
+    bytes = good;
+    Poke<uint8_t>(bytes, header.textsOffset + offsetof(SceneTextRecord, hAlign), 200);
+    CheckInstantiateFails(bytes);
+    bytes = good;
+    Poke<uint32_t>(bytes, header.idsOffset + offsetof(SceneString, offset), static_cast<uint32_t>(header.namesSize));
+    CheckInstantiateFails(bytes);
+
+    //the untouched file still loads after all that
+    WriteFile(DamagedPath, good);
+    ElementNode target;
+    SceneFile(DamagedPath).InstantiateInto(&target);
+    CPPLAB_CHECK(target.RecursiveCountAllChildNodes() == 7);
+    DeleteSubtree(&target);
+}
+
+static void BenchmarkLoad(size_t nodeCount) {
+    //panels of 99 labels, what an app builds at startup
+    const auto build = [nodeCount](ElementNode* root) {
+        for (size_t p = 0; p * 100 < nodeCount; ++p) {
+            ElementNode* panel = new ElementNode(ElementNodeConfiguration().SetRelativePosition(vec2(0.f, static_cast<float>(p * 20))).SetHidden(false));
+            root->AddChildElement("panel" + std::to_string(p), panel);
+            for (size_t i = 1; i < 100 && p * 100 + i < nodeCount; ++i) {
+                TextElementConfiguration config;
+                config.setText(L"label " + std::to_wstring(i)).setBackgroundColor(Color(0.1f, 0.1f, 0.1f, 1.f));
+                config.SetRelativePosition(vec2(static_cast<float>(i * 10), 0.f)).SetDimension(vec2(10.f, 20.f)).SetHidden(false);
+                panel->AddChildElement("label" + std::to_string(i), new TextElement(config));
+            }
+        }
+    };
+
+    ElementNode built;
+    auto start = std::chrono::steady_clock::now();
+    build(&built);
+    const double buildMilliseconds = cpplab::testing::MillisecondsSince(start);
+    CPPLAB_CHECK(built.RecursiveCountAllChildNodes() == nodeCount);
+
+    start = std::chrono::steady_clock::now();
+    SceneFile::Save(&built, ScenePath);
+    const double saveMilliseconds = cpplab::testing::MillisecondsSince(start);
+    DeleteSubtree(&built);
+
+    ElementNode loaded;
+    start = std::chrono::steady_clock::now();
+    SceneFile file(ScenePath);
+    const double openMilliseconds = cpplab::testing::MillisecondsSince(start);
+    start = std::chrono::steady_clock::now();
+    file.InstantiateInto(&loaded);
+    const double loadMilliseconds = cpplab::testing::MillisecondsSince(start);
+    CPPLAB_CHECK(loaded.RecursiveCountAllChildNodes() == nodeCount);
+
+    std::printf("%zu nodes: built in code %.1f ms, saved %.1f ms (%ju KB), mapped %.3f ms, instantiated %.1f ms\n",
+        nodeCount, buildMilliseconds, saveMilliseconds, static_cast<uintmax_t>(std::filesystem::file_size(ScenePath) / 1024),
+        openMilliseconds, loadMilliseconds);
+    DeleteSubtree(&loaded);
+}
+
+int main(int argc, char** argv) {
+    TestRoundTrip();
+    TestDamagedFiles();
+    BenchmarkLoad(cpplab::testing::SizeArgument(argc, argv, 5000));
+    return 0;
+}
@@ -0,0 +1,168 @@
+//scroll list recycling, rows stay bound to a small pool and nothing shows outside the list
+//benchmark: scrolling through all rows, pass a row count as the first argument
+#include <string>
+#include <vector>
+#include "headlessengine.hpp"
+#include "check.hpp"
+
+using namespace cpplab;
+using namespace std::chrono_literals;
+
+namespace {
+    //rows are red boxes with a green marker child in their top left corner, the markers belong to the source
+    class RowSource : public IListDataSource {
+    public:
+        size_t count;
+        size_t created = 0;
+        size_t binds = 0;
+        std::vector<TextElement*> markers;
+
+        RowSource(size_t count) : count(count) {}
+        ~RowSource() {
+            for (TextElement* marker : this->markers) delete marker;
+        }
+        size_t GetRowCount() override {
+            return this->count;
+        }
+        ElementNode* CreateRow() override {
+            ++this->created;
+            TextElementConfiguration rowConfig;
+            rowConfig.setText(L"").setBackgroundColor(Color(1.f, 0.f, 0.f, 1.f));
+            TextElement* row = new TextElement(rowConfig);
+            TextElementConfiguration markerConfig;
+            markerConfig.setText(L"").setBackgroundColor(Color(0.f, 1.f, 0.f, 1.f));
+            markerConfig.SetDimension(vec2(5.f, 5.f)).SetHidden(false);
+            TextElement* marker = new TextElement(markerConfig);
+            row->AddChildElement("marker", marker);
+            this->markers.push_back(marker);
+            return row;
+        }
+        void BindRow(ElementNode* row, size_t rowIndex) override {
+            ++this->binds;
+            static_cast<TextElement*>(row)->setText(std::to_wstring(rowIndex));
+        }
+    };
+
+    constexpr float ListTop = 50.f;
+    constexpr float ListBottom = 150.f;
+}
+
+static std::wstring RowText(ElementNode* row) {
+    return static_cast<TextElement*>(row)->getText();
+}
+
+//every shown row overlaps the list, the rest are hidden
+static void CheckRowsInside(ScrollListElement* list) {
+    const size_t first = list->getFirstVisibleRow();
+    for (size_t rowIndex = first > 8 ? first - 8 : 0; rowIndex < (std::min)(list->getRowCount(), first + 16); ++rowIndex) {
+        ElementNode* row = list->getRowElement(rowIndex);
+        if (row == nullptr || row->isHidden()) continue;
+        const float top = row->getTruePosition().y;
+        CPPLAB_CHECK(top < ListBottom && top + list->getRowHeight() > ListTop);
+    }
+}
+
+static void TestRecycling() {
+    ManualFrameClock clock;
+    HeadlessEngine engine(400, 300, 96, &clock);
+    engine.GetScene().SetBackgroundColor(Color(0.f, 0.f, 0.f, 1.f));
+    RowSource source(1000);
+    ScrollListElement* list = new ScrollListElement(&source, 20.f, 2);
+    list->setDimensions(vec2(200.f, ListBottom - ListTop));
+    list->setRelativePosition(vec2(10.f, ListTop));
+    list->show();
+    engine.GetRootNode()->AddChildElement("list", list);
+    engine.GetScrollLists().Add(list);
+    engine.RunFrame();
+
+    ScrollListStats stats = list->getStats();
+    CPPLAB_CHECK(stats.visibleRows == 5 && stats.pooledRows == 10 && source.created == 10);
+    CPPLAB_CHECK(RowText(list->getRowElement(0)) == L"0" && list->getRowElement(6) != nullptr && list->getRowElement(7) == nullptr);
+    CPPLAB_CHECK(list->getRowElement(3)->getTruePosition().y == ListTop + 60.f);
+
+    //rows 1 to 6 show, cut by both edges, and only the two rows entering the window are bound
+    list->scrollBy(30.0);
+    engine.RunFrame();
+    stats = list->getStats();
+    CPPLAB_CHECK(stats.visibleRows == 6 && stats.lastRowsBound == 2 && RowText(list->getRowElement(7)) == L"7");
+    CPPLAB_CHECK(list->getRowElement(0)->isHidden() && !list->getRowElement(1)->isHidden());
+    CheckRowsInside(list);
+
+    //row 1 reaches 10 px above the list and row 6 10 px below it, both are cut at the edge
+    const SoftwareRenderDevice& device = engine.GetDevice();
+    const uint32_t background = device.GetPixel(100, 5);
+    CPPLAB_CHECK(device.GetPixel(100, 45) == background && device.GetPixel(100, 55) != background);
+    CPPLAB_CHECK(device.GetPixel(100, 155) == background && device.GetPixel(100, 145) != background);
+    //the marker of row 1 sits above the list, the clip covers children too
+    CPPLAB_CHECK(device.GetPixel(12, 42) == background);
+
+    //a scroll within a row only moves the content node
+    const uint64_t publishedBefore = ElementStore::Instance().GetStatesPublished();
+    list->scrollBy(5.0);
+    engine.RunFrame();
+    CPPLAB_CHECK(list->getStats().lastRowsBound == 0 && ElementStore::Instance().GetStatesPublished() - publishedBefore == 1);
+
+    //a far jump places the rows relative to a new anchor, the last row still lands exactly
+    list->setScrollOffset(1.0e9);
+    engine.RunFrame();
+    CPPLAB_CHECK(list->getScrollOffset() == 1000.0 * 20.0 - 100.0 && list->getFirstVisibleRow() == 995);
+    CPPLAB_CHECK(list->getRowElement(999)->getTruePosition().y == ListTop + 80.f && RowText(list->getRowElement(999)) == L"999");
+    CheckRowsInside(list);
+
+    //shrinking the data clamps the scroll position
+    source.count = 10;
+    list->dataChanged();
+    engine.RunFrame();
+    CPPLAB_CHECK(list->getScrollOffset() == 100.0 && RowText(list->getRowElement(9)) == L"9");
+
+    delete list;
+    engine.RunFrame();
+    CPPLAB_CHECK(engine.GetScrollLists().Size() == 0);
+}
+
+static void BenchmarkScroll(size_t rowCount) {
+    ManualFrameClock clock;
+    HeadlessEngine engine(400, 300, 96, &clock);
+    RowSource source(rowCount);
+    ScrollListElement* list = new ScrollListElement(&source, 20.f, 4);
+    list->setDimensions(vec2(400.f, ListBottom - ListTop));
+    list->setRelativePosition(vec2(0.f, ListTop));
+    list->show();
+    engine.GetRootNode()->AddChildElement("list", list);
+    engine.GetScrollLists().Add(list);
+    engine.RunFrame();
+
+    //ten rows a frame, half the list height
+    const size_t pool = list->getStats().pooledRows;
+    size_t frames = 0;
+    size_t peakElements = 0;
+    const auto start = std::chrono::steady_clock::now();
+    while (list->getScrollOffset() < list->getMaxScrollOffset()) {
+        clock.Advance(16ms);
+        list->scrollBy(200.0);
+        engine.RunFrame();
+        ++frames;
+        CPPLAB_CHECK(list->getStats().lastRowsBound <= pool);
+        if ((frames & 255) == 0) {
+            CheckRowsInside(list);
+            peakElements = (std::max)(peakElements, engine.GetRootNode()->RecursiveCountAllChildNodes());
+        }
+    }
+    const double milliseconds = cpplab::testing::MillisecondsSince(start);
+    const ScrollListStats stats = list->getStats();
+    std::printf("%zu rows: %zu frames, %.1f us a frame, pool %zu, %llu binds, %llu rebases, peak %zu elements\n",
+        rowCount, frames, milliseconds * 1000.0 / static_cast<double>(frames), stats.pooledRows,
+        static_cast<unsigned long long>(stats.rowsBound), static_cast<unsigned long long>(stats.rebases), peakElements);
+    //every row is bound about once on the way down, the pool never grows
+    CPPLAB_CHECK(stats.pooledRows == pool && source.created == pool);
+    CPPLAB_CHECK(stats.rowsBound <= rowCount + pool);
+    CPPLAB_CHECK(RowText(list->getRowElement(rowCount - 1)) == std::to_wstring(rowCount - 1));
+    CheckRowsInside(list);
+    delete list;
+}
+
+int main(int argc, char** argv) {
+    TestRecycling();
+    BenchmarkScroll(cpplab::testing::SizeArgument(argc, argv, 4000));
+    return 0;
+}
@@ -0,0 +1,134 @@
+//published snapshots, eight threads set properties and move nodes while the ui thread publishes and renders without locking
+//stress: run it from a thread sanitizer build, pass a change count per thread as the first argument
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "headlessengine.hpp"
+#include "check.hpp"
+
+using namespace cpplab;
+
+namespace {
+    constexpr int Threads = 8;
+    constexpr int LeavesPerThread = 8;
+
+    //a panel with a nested group, the leaves move between the two
+    struct Worker {
+        ElementNode* panel = nullptr;
+        ElementNode* group = nullptr;
+        std::vector<TextElement*> leaves;
+        std::vector<bool> inGroup;
+        std::vector<float> lastSize;
+    };
+}
+
+//every published block is a whole setter's change, never half of one
+static void CheckSnapshot(ElementStore& store, uint32_t rootIndex, std::vector<uint32_t>& indices, std::vector<bool>& seen) {
+    indices.clear();
+    store.CollectTreeIndices(rootIndex, indices);
+    CPPLAB_CHECK(indices.size() <= 1 + Threads * (2 + LeavesPerThread));
+    for (uint32_t index : indices) {
+        const ElementState* state = store.State(index);
+        CPPLAB_CHECK(state != nullptr && store.PublishedOwner(index) != nullptr);
+        //the root fills the device, every other node is square and on the diagonal
+        if (index == rootIndex) continue;
+        CPPLAB_CHECK(state->width == state->height && state->posX == state->posY);
+        CPPLAB_CHECK(store.Width(index) == state->width && store.PosX(index) == state->posX);
+    }
+    for (uint32_t index : indices) {
+        if (index >= seen.size()) seen.resize(index + 1);
+        CPPLAB_CHECK(!seen[index]);
+        seen[index] = true;
+    }
+    for (uint32_t index : indices) seen[index] = false;
+}
+
+static void TestConcurrentMutation(size_t changes) {
+    HeadlessEngine engine(320, 240);
+    ElementStore& store = ElementStore::Instance();
+    ElementNode* root = engine.GetRootNode();
+    std::vector<Worker> workers(Threads);
+    for (int w = 0; w < Threads; ++w) {
+        Worker& worker = workers[w];
+        worker.panel = new ElementNode();
+        worker.panel->setRelativePosition(vec2(static_cast<float>(w * 30), static_cast<float>(w * 30)));
+        worker.panel->show();
+        root->AddChildElement("panel" + std::to_string(w), worker.panel);
+        worker.group = new ElementNode();
+        worker.group->show();
+        worker.panel->AddChildElement("group", worker.group);
+        for (int i = 0; i < LeavesPerThread; ++i) {
+            TextElementConfiguration config;
+            config.setText(L"").setBackgroundColor(Color(0.f, 0.f, 1.f, 1.f));
+            config.SetHidden(false);
+            worker.leaves.push_back(new TextElement(config));
+            worker.panel->AddChildElement("leaf" + std::to_string(i), worker.leaves.back());
+            worker.inGroup.push_back(false);
+            worker.lastSize.push_back(0.f);
+        }
+    }
+    engine.RunFrame();
+
+    //each thread changes only its own panel, the threads still share the store, the id table and the root's tree
+    std::atomic<int> running = Threads;
+    std::vector<std::thread> threads;
+    for (int w = 0; w < Threads; ++w) {
+        threads.emplace_back([&, w] {
+            Worker& worker = workers[w];
+            for (size_t change = 0; change < changes; ++change) {
+                const size_t i = change % LeavesPerThread;
+                TextElement* leaf = worker.leaves[i];
+                const float size = static_cast<float>(change % 32 + 1);
+                leaf->setDimensions(vec2(size, size));
+                leaf->setRelativePosition(vec2(size, size));
+                leaf->setText(std::to_wstring(change));
+                worker.lastSize[i] = size;
+                if (change % 16 == 0) {
+                    //detached and attached again under the other parent, a publish in between leaves it out of the tree for a frame
+                    const std::string id = "leaf" + std::to_string(i);
+                    ElementNode* from = worker.inGroup[i] ? worker.group : worker.panel;
+                    ElementNode* to = worker.inGroup[i] ? worker.panel : worker.group;
+                    from->DeleteChildElement(id);
+                    to->AddChildElement(id, leaf);
+                    worker.inGroup[i] = !worker.inGroup[i];
+                }
+            }
+            running.fetch_sub(1);
+        });
+    }
+
+    const uint32_t rootIndex = root->getHandle().index;
+    std::vector<uint32_t> indices;
+    std::vector<bool> seen;
+    size_t frames = 0;
+    while (running.load() > 0) {
+        engine.RunFrame();
+        CheckSnapshot(store, rootIndex, indices, seen);
+        ++frames;
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    //the last publish shows the last change of every thread
+    engine.RunFrame();
+    CheckSnapshot(store, rootIndex, indices, seen);
+    CPPLAB_CHECK(indices.size() == 1 + Threads * (2 + LeavesPerThread));
+    for (const Worker& worker : workers) {
+        for (int i = 0; i < LeavesPerThread; ++i) {
+            const uint32_t index = worker.leaves[i]->getHandle().index;
+            CPPLAB_CHECK(store.Width(index) == worker.lastSize[i] && store.WorldX(index) == store.WorldX(worker.panel->getHandle().index) + worker.lastSize[i]);
+        }
+    }
+    std::printf("%d threads, %zu changes each, %zu frames published while they ran\n", Threads, changes, frames);
+
+    for (Worker& worker : workers) {
+        for (TextElement* leaf : worker.leaves) delete leaf;
+        delete worker.group;
+        delete worker.panel;
+    }
+}
+
+int main(int argc, char** argv) {
+    TestConcurrentMutation(cpplab::testing::SizeArgument(argc, argv, 20000));
+    return 0;
+}
@@ -0,0 +1,141 @@
+//hit test grid, every query matches a scan over all bounds through inserts, moves and removes
+//benchmark: grid queries against the scan they replace at 1k, 10k and 100k elements, pass the largest count as the first argument
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "spatialindex.hpp"
+#include "check.hpp"
+
+using namespace cpplab;
+
+namespace {
+    struct Box {
+        float left, top, right, bottom;
+        bool present;
+    };
+
+    //what the hit test did before the index, every element checked on every query
+    void ScanQuery(const std::vector<Box>& boxes, float x, float y, std::vector<uint32_t>& out) {
+        for (uint32_t id = 0; id < boxes.size(); ++id) {
+            const Box& box = boxes[id];
+            if (box.present && x >= box.left && x <= box.right && y >= box.top && y <= box.bottom) out.push_back(id);
+        }
+    }
+
+    Box RandomBox(std::mt19937& rng, float extent, float maxSize) {
+        std::uniform_real_distribution<float> position(-extent * 0.1f, extent);
+        std::uniform_real_distribution<float> size(0.f, maxSize);
+        const float left = position(rng);
+        const float top = position(rng);
+        return Box{ left, top, left + size(rng), top + size(rng), true };
+    }
+}
+
+static void CheckQueries(const SpatialGridIndex& index, const std::vector<Box>& boxes, std::mt19937& rng, float extent) {
+    std::uniform_real_distribution<float> point(-extent * 0.1f, extent * 1.1f);
+    std::vector<uint32_t> found;
+    std::vector<uint32_t> expected;
+    for (int query = 0; query < 200; ++query) {
+        const float x = point(rng);
+        const float y = point(rng);
+        found.clear();
+        expected.clear();
+        index.Query(x, y, found);
+        ScanQuery(boxes, x, y, expected);
+        std::sort(found.begin(), found.end());
+        CPPLAB_CHECK(found == expected);
+    }
+}
+
+static void TestAgainstScan() {
+    std::mt19937 rng(4);
+    const float extent = 2000.f;
+    SpatialGridIndex index;
+    std::vector<Box> boxes;
+    for (uint32_t id = 0; id < 3000; ++id) {
+        //one in fifty spans far more cells than an entry may take and goes to the large list
+        boxes.push_back(RandomBox(rng, extent, id % 50 == 0 ? 1500.f : 80.f));
+        const Box& box = boxes.back();
+        index.Update(id, box.left, box.top, box.right, box.bottom);
+    }
+    CPPLAB_CHECK(index.Size() == boxes.size() && index.LargeEntryCount() > 0);
+    CheckQueries(index, boxes, rng, extent);
+
+    //moves, resizes across the large limit both ways, and removes
+    for (int round = 0; round < 20; ++round) {
+        for (int change = 0; change < 100; ++change) {
+            const uint32_t id = static_cast<uint32_t>(rng() % boxes.size());
+            if (rng() % 4 == 0) {
+                boxes[id].present = false;
+                index.Remove(id);
+                continue;
+            }
+            boxes[id] = RandomBox(rng, extent, rng() % 10 == 0 ? 1500.f : 80.f);
+            index.Update(id, boxes[id].left, boxes[id].top, boxes[id].right, boxes[id].bottom);
+        }
+        CheckQueries(index, boxes, rng, extent);
+    }
+    const size_t present = static_cast<size_t>(std::count_if(boxes.begin(), boxes.end(), [](const Box& box) { return box.present; }));
+    CPPLAB_CHECK(index.Size() == present);
+
+    //borders count as inside, removing twice is harmless
+    SpatialGridIndex small;
+    small.Update(7, 0.f, 0.f, 64.f, 64.f);
+    std::vector<uint32_t> found;
+    small.Query(64.f, 64.f, found);
+    CPPLAB_CHECK(found.size() == 1 && found[0] == 7);
+    small.Remove(7);
+    small.Remove(7);
+    found.clear();
+    small.Query(10.f, 10.f, found);
+    CPPLAB_CHECK(found.empty() && small.Size() == 0);
+}
+
+static void BenchmarkQueries(size_t largestCount) {
+    for (size_t count = 1000; count <= largestCount; count *= 10) {
+        std::mt19937 rng(9);
+        //elements keep their size while the area grows with them, like a console with more panels
+        const float extent = 40.f * static_cast<float>(std::sqrt(static_cast<double>(count)));
+        SpatialGridIndex index;
+        std::vector<Box> boxes;
+        for (uint32_t id = 0; id < count; ++id) {
+            boxes.push_back(RandomBox(rng, extent, 60.f));
+            index.Update(id, boxes[id].left, boxes[id].top, boxes[id].right, boxes[id].bottom);
+        }
+
+        constexpr int Queries = 2000;
+        std::uniform_real_distribution<float> point(0.f, extent);
+        std::vector<std::pair<float, float>> points;
+        for (int i = 0; i < Queries; ++i) points.push_back({ point(rng), point(rng) });
+
+        std::vector<uint32_t> found;
+        size_t gridHits = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& [x, y] : points) {
+            found.clear();
+            index.Query(x, y, found);
+            gridHits += found.size();
+        }
+        const double gridMilliseconds = cpplab::testing::MillisecondsSince(start);
+
+        size_t scanHits = 0;
+        start = std::chrono::steady_clock::now();
+        for (const auto& [x, y] : points) {
+            found.clear();
+            ScanQuery(boxes, x, y, found);
+            scanHits += found.size();
+        }
+        const double scanMilliseconds = cpplab::testing::MillisecondsSince(start);
+        CPPLAB_CHECK(gridHits == scanHits);
+
+        std::printf("%zu elements: %.3f us a query with the grid, %.3f us scanning\n", count,
+            gridMilliseconds * 1000.0 / Queries, scanMilliseconds * 1000.0 / Queries);
+    }
+}
+
+int main(int argc, char** argv) {
+    TestAgainstScan();
+    BenchmarkQueries(cpplab::testing::SizeArgument(argc, argv, 10000));
+    return 0;
+}
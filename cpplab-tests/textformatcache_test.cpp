@@ -0,0 +1,114 @@
+//text format cache, elements with the same font, size and alignment share one format and the last release deletes it
+//benchmark: acquiring and releasing a shared format against creating one per element, pass a lookup count as the first argument
+#include <vector>
+#include "headlessengine.hpp"
+#include "textformatcache.hpp"
+#include "check.hpp"
+
+using namespace cpplab;
+
+static void TestAcquireRelease() {
+    SoftwareRenderDevice device(16, 16);
+    TextFormatCache cache;
+    TextFormatKey large;
+    large.pointSize = 24.f;
+    large.dpi = 192;
+    TextFormatKey centered;
+    centered.hAlign = HAlign::CENTER;
+
+    //the first user creates it through the device, the second gets the same one
+    RenderTextFormat* first = cache.Acquire(large, device);
+    RenderTextFormat* second = cache.Acquire(large, device);
+    CPPLAB_CHECK(first == second && static_cast<SoftwareTextFormat*>(first)->desc.size == 12.f);
+    CPPLAB_CHECK(cache.Acquire(centered, device) != first);
+    TextFormatCacheStats stats = cache.GetStats();
+    CPPLAB_CHECK(stats.lookups == 3 && stats.hits == 1 && stats.misses == 2 && stats.liveEntries == 2 && stats.liveReferences == 3);
+    CPPLAB_CHECK(stats.HitRate() == 1.0 / 3.0);
+
+    //a format stays while anyone holds it, the last release evicts it
+    cache.Release(large);
+    stats = cache.GetStats();
+    CPPLAB_CHECK(stats.released == 0 && stats.liveEntries == 2 && stats.liveReferences == 2);
+    cache.Release(large);
+    stats = cache.GetStats();
+    CPPLAB_CHECK(stats.released == 1 && stats.liveEntries == 1 && stats.liveReferences == 1);
+    //releasing a key nobody holds does nothing
+    cache.Release(large);
+    CPPLAB_CHECK(cache.GetStats().liveReferences == 1 && cache.Size() == 1);
+    //an evicted key is a miss again
+    cache.Acquire(large, device);
+    CPPLAB_CHECK(cache.GetStats().misses == 3 && cache.Size() == 2);
+
+    cache.ResetStats();
+    stats = cache.GetStats();
+    CPPLAB_CHECK(stats.lookups == 0 && stats.HitRate() == 0.0 && stats.liveEntries == 2);
+    cache.Clear();
+    CPPLAB_CHECK(cache.Size() == 0 && cache.GetStats().liveReferences == 0);
+}
+
+static void TestSharedByElements() {
+    HeadlessEngine engine(400, 300);
+    constexpr size_t LabelCount = 300;
+    const float sizes[] = { 10.f, 12.f, 16.f };
+    std::vector<TextElement*> labels;
+    for (size_t i = 0; i < LabelCount; ++i) {
+        TextElementConfiguration config;
+        config.setText(L"label").setTextSize(sizes[i % 3]);
+        config.SetRelativePosition(vec2(static_cast<float>(i % 20) * 20.f, static_cast<float>(i / 20) * 20.f)).SetDimension(vec2(18.f, 18.f));
+        labels.push_back(new TextElement(config));
+        engine.GetRootNode()->AddChildElement(std::to_string(i), labels.back());
+    }
+    engine.RunFrame();
+    //hundreds of labels on three combinations hold three formats
+    TextFormatCacheStats stats = engine.GetScene().GetTextFormatStats();
+    CPPLAB_CHECK(stats.liveEntries == 3 && stats.liveReferences == LabelCount && stats.misses == 3 && stats.hits == LabelCount - 3);
+
+    //a colour change does not look a format up
+    for (TextElement* label : labels) label->setTextColor(Color(1.f, 0.f, 0.f, 1.f));
+    engine.RunFrame();
+    CPPLAB_CHECK(engine.GetScene().GetTextFormatStats().lookups == stats.lookups);
+
+    //moving every 16 point label to 12 points shares the existing format and evicts the unused one
+    for (size_t i = 2; i < LabelCount; i += 3) labels[i]->setTextPointSize(12.f);
+    engine.RunFrame();
+    stats = engine.GetScene().GetTextFormatStats();
+    CPPLAB_CHECK(stats.misses == 3 && stats.released == 1 && stats.liveEntries == 2 && stats.liveReferences == LabelCount);
+
+    //deleted elements give their references back
+    for (TextElement* label : labels) delete label;
+    engine.RunFrame();
+    stats = engine.GetScene().GetTextFormatStats();
+    CPPLAB_CHECK(stats.liveEntries == 0 && stats.liveReferences == 0 && stats.released == 3);
+}
+
+static void BenchmarkLookups(size_t lookupCount) {
+    SoftwareRenderDevice device(16, 16);
+    TextFormatCache cache;
+    TextFormatKey key;
+    //one holder keeps the format alive so every other lookup is a hit
+    cache.Acquire(key, device);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lookupCount; ++i) {
+        cache.Acquire(key, device);
+        cache.Release(key);
+    }
+    const double sharedMilliseconds = cpplab::testing::MillisecondsSince(start);
+    CPPLAB_CHECK(cache.GetStats().hits == lookupCount && cache.Size() == 1);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lookupCount; ++i) {
+        delete device.CreateTextFormat(key.ToDesc());
+    }
+    const double createMilliseconds = cpplab::testing::MillisecondsSince(start);
+    //the software device's format is a plain struct, a directwrite format costs far more to create than this
+    std::printf("%zu lookups: shared %.1f ns each, created per element %.1f ns each\n",
+        lookupCount, sharedMilliseconds * 1e6 / static_cast<double>(lookupCount), createMilliseconds * 1e6 / static_cast<double>(lookupCount));
+    cache.Release(key);
+}
+
+int main(int argc, char** argv) {
+    TestAcquireRelease();
+    TestSharedByElements();
+    BenchmarkLookups(cpplab::testing::SizeArgument(argc, argv, 100000));
+    return 0;
+}
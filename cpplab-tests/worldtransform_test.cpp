@@ -0,0 +1,167 @@
+//dirty propagation and cached world positions, a change marks its ancestors once and a move costs one subtree pass
+//benchmark: position lookups at depths 1, 10 and 50, pass a lookup count as the first argument
+#include <string>
+#include <vector>
+#include "engineelements.hpp"
+#include "check.hpp"
+
+using namespace cpplab;
+
+//a chain of nodes each one step right and two down from its parent, the last node is returned
+static ElementNode* BuildChain(ElementNode* root, size_t depth, std::vector<ElementNode*>& chain) {
+    ElementNode* current = root;
+    for (size_t i = 0; i < depth; ++i) {
+        ElementNode* node = new ElementNode();
+        node->setRelativePosition(vec2(1.f, 2.f));
+        current->AddChildElement("c", node);
+        chain.push_back(node);
+        current = node;
+    }
+    return current;
+}
+static void DeleteChain(std::vector<ElementNode*>& chain) {
+    for (size_t i = chain.size(); i-- > 0;) {
+        delete chain[i];
+    }
+    chain.clear();
+}
+
+static void TestStagedPositions() {
+    ElementNode root;
+    std::vector<ElementNode*> chain;
+    ElementNode* last = BuildChain(&root, 50, chain);
+    CPPLAB_CHECK(last->getTruePosition() == vec2(50.f, 100.f));
+    chain[0]->setRelativePosition(vec2(11.f, 2.f));
+    CPPLAB_CHECK(last->getTruePosition() == vec2(60.f, 100.f));
+
+    //a detached subtree starts from its own origin and follows its new parent
+    ElementNode* other = new ElementNode();
+    other->setRelativePosition(vec2(100.f, 100.f));
+    root.AddChildElement("other", other);
+    chain[10]->DeleteChildElement("c");
+    CPPLAB_CHECK(chain[11]->getTruePosition() == vec2(1.f, 2.f));
+    other->AddChildElement("c", chain[11]);
+    CPPLAB_CHECK(chain[11]->getTruePosition() == vec2(101.f, 102.f));
+    CPPLAB_CHECK(last->getTruePosition() == vec2(139.f, 178.f));
+
+    delete other;
+    CPPLAB_CHECK(chain[11]->getTruePosition() == vec2(1.f, 2.f));
+    DeleteChain(chain);
+}
+
+static void TestDirtyPropagation() {
+    ElementStore& store = ElementStore::Instance();
+    ElementNode root;
+    const uint32_t rootIndex = root.getHandle().index;
+    std::vector<ElementNode*> nodes;
+    for (int i = 0; i < 1000; ++i) {
+        ElementNode* node = new ElementNode();
+        root.AddChildElement(std::to_string(i), node);
+        nodes.push_back(node);
+    }
+    ElementNode* deep = new ElementNode();
+    nodes[5]->AddChildElement("deep", deep);
+    CPPLAB_CHECK(store.IsSubtreeDirty(rootIndex));
+    CPPLAB_CHECK(store.Publish(rootIndex));
+    CPPLAB_CHECK(!store.IsSubtreeDirty(rootIndex) && !store.Publish(rootIndex));
+
+    //a change marks the node and its two ancestors, a second one on a marked ancestor writes nothing
+    store.ResetDirtyStats();
+    deep->setDepth(3.f);
+    CPPLAB_CHECK(store.GetDirtyStats().markSlotWrites == 3);
+    nodes[5]->setDepth(1.f);
+    CPPLAB_CHECK(store.GetDirtyStats().markSlotWrites == 3);
+    CPPLAB_CHECK(store.IsSubtreeDirty(rootIndex) && store.GetDirtyStats().checkSlotReads == 1);
+
+    //publishing walks the marked path only, not the thousand clean siblings
+    CPPLAB_CHECK(store.Publish(rootIndex));
+    CPPLAB_CHECK(store.GetDirtyStats().clearSlotVisits == 3);
+    CPPLAB_CHECK(store.Depth(deep->getHandle().index) == 3.f && !store.IsSubtreeDirty(rootIndex));
+
+    delete deep;
+    for (ElementNode* node : nodes) delete node;
+}
+
+static void TestSubtreeMove() {
+    ElementStore& store = ElementStore::Instance();
+    ElementNode root;
+    const uint32_t rootIndex = root.getHandle().index;
+    const uint32_t journal = store.RegisterBoundsJournal(rootIndex);
+    ElementNode* panel = new ElementNode();
+    root.AddChildElement("panel", panel);
+    std::vector<ElementNode*> descendants;
+    for (int i = 0; i < 50; ++i) {
+        ElementNode* group = new ElementNode();
+        group->setRelativePosition(vec2(static_cast<float>(i), 0.f));
+        panel->AddChildElement(std::to_string(i), group);
+        descendants.push_back(group);
+        for (int j = 0; j < 99; ++j) {
+            ElementNode* leaf = new ElementNode();
+            leaf->setRelativePosition(vec2(0.f, static_cast<float>(j)));
+            group->AddChildElement(std::to_string(j), leaf);
+            descendants.push_back(leaf);
+        }
+    }
+    store.Publish(rootIndex);
+    std::vector<uint32_t> changed;
+    store.DrainBoundsJournal(journal, changed);
+
+    //the panel is the only node marked, its 5000 descendants are recomputed in the same pass
+    store.ResetDirtyStats();
+    panel->setRelativePosition(vec2(1000.f, 2000.f));
+    CPPLAB_CHECK(store.Publish(rootIndex));
+    CPPLAB_CHECK(store.GetStatesPublished() > 0 && store.GetDirtyStats().clearSlotVisits == 2);
+    CPPLAB_CHECK(store.DrainBoundsJournal(journal, changed) && changed.size() == 5001);
+    const uint32_t leaf = descendants.back()->getHandle().index;
+    CPPLAB_CHECK(store.WorldX(leaf) == 1049.f && store.WorldY(leaf) == 2098.f);
+
+    //nothing changed, nothing recomputed
+    CPPLAB_CHECK(!store.Publish(rootIndex));
+    CPPLAB_CHECK(store.DrainBoundsJournal(journal, changed) && changed.empty());
+
+    store.UnregisterBoundsJournal(journal);
+    for (size_t i = descendants.size(); i-- > 0;) {
+        delete descendants[i];
+    }
+    delete panel;
+}
+
+static void BenchmarkLookups(size_t lookups) {
+    ElementStore& store = ElementStore::Instance();
+    for (size_t depth : { size_t(1), size_t(10), size_t(50) }) {
+        ElementNode root;
+        std::vector<ElementNode*> chain;
+        ElementNode* last = BuildChain(&root, depth, chain);
+        store.Publish(root.getHandle().index);
+        const uint32_t index = last->getHandle().index;
+
+        //the staged walk up the parents, what getTruePosition costs off the ui thread
+        double sum = 0.0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < lookups; ++i) {
+            sum += last->getTruePosition().x;
+        }
+        const double stagedMilliseconds = cpplab::testing::MillisecondsSince(start);
+        CPPLAB_CHECK(sum == static_cast<double>(depth) * static_cast<double>(lookups));
+
+        //the cached world position the renderer and hit test read
+        sum = 0.0;
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < lookups; ++i) {
+            sum += store.WorldX(index);
+        }
+        const double cachedMilliseconds = cpplab::testing::MillisecondsSince(start);
+        CPPLAB_CHECK(store.WorldX(index) == static_cast<float>(depth));
+
+        std::printf("depth %zu: %zu lookups, staged walk %.2f ms, cached %.2f ms (%.0f)\n", depth, lookups, stagedMilliseconds, cachedMilliseconds, sum);
+        DeleteChain(chain);
+    }
+}
+
+int main(int argc, char** argv) {
+    TestStagedPositions();
+    TestDirtyPropagation();
+    TestSubtreeMove();
+    BenchmarkLookups(cpplab::testing::SizeArgument(argc, argv, 20000));
+    return 0;
+}